@@ -41,6 +41,23 @@ BinaryThresholding::BinaryThresholding(float lowerThreshold, float upperThreshol
     setUpperThreshold(upperThreshold);
 }
 
+template <class T>
+static void executeAlgorithmOnHost(Image::pointer input, Image::pointer output, float lowerThreshold, float upperThreshold) {
+    auto inputAccess = input->getImageAccess(ACCESS_READ);
+    auto outputAccess = output->getImageAccess(ACCESS_READ_WRITE);
+    const T* inputData = (const T*)inputAccess->get();
+    uchar* outputData = (uchar*)outputAccess->get();
+
+    // Only the first channel is thresholded, same as the OpenCL kernels
+    const int channels = input->getNrOfChannels();
+    const int64_t size = (int64_t)input->getWidth()*input->getHeight()*input->getDepth();
+    #pragma omp parallel for
+    for(int64_t i = 0; i < size; ++i) {
+        const float value = inputData[i*channels];
+        outputData[i] = (value >= lowerThreshold && value <= upperThreshold) ? 1 : 0;
+    }
+}
+
 void BinaryThresholding::execute() {
     if(!mLowerThresholdSet && !mUpperThresholdSet) {
         throw Exception("BinaryThresholding need at least one threshold to be set.");
@@ -50,7 +67,12 @@ void BinaryThresholding::execute() {
     auto output = Image::createSegmentationFromImage(input);
 
     if(getMainDevice()->isHost()) {
-        throw Exception("Not implemented yet.");
+        // A threshold which is not set is replaced by infinity, which gives the same result as the OpenCL kernels using only one threshold
+        const float lowerThreshold = mLowerThresholdSet ? mLowerThreshold : -std::numeric_limits<float>::infinity();
+        const float upperThreshold = mUpperThresholdSet ? mUpperThreshold : std::numeric_limits<float>::infinity();
+        switch(input->getDataType()) {
+            fastSwitchTypeMacro(executeAlgorithmOnHost<FAST_TYPE>(input, output, lowerThreshold, upperThreshold));
+        }
     } else {
         OpenCLDevice::pointer device = std::dynamic_pointer_cast<OpenCLDevice>(getMainDevice());
         cl::Program program;
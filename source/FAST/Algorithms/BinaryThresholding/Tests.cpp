@@ -0,0 +1,26 @@
+#include <FAST/Testing.hpp>
+#include <FAST/Algorithms/BinaryThresholding/BinaryThresholding.hpp>
+#include <FAST/Importers/ImageFileImporter.hpp>
+#include <FAST/Data/Image.hpp>
+
+using namespace fast;
+
+TEST_CASE("BinaryThresholding on Host gives same result as OpenCL", "[fast][BinaryThresholding]") {
+    auto image = ImageFileImporter::create(Config::getTestDataPath() + "US/Heart/ApicalFourChamber/US-2D_0.mhd")
+            ->runAndGetOutputData<Image>();
+
+    for(auto thresholds : std::vector<std::pair<float, float>>{{50, 150}, {100, std::numeric_limits<float>::max()}}) {
+        auto thresholding = BinaryThresholding::create(thresholds.first, thresholds.second)->connect(image);
+        auto result = thresholding->runAndGetOutputData<Image>();
+
+        auto hostThresholding = BinaryThresholding::create(thresholds.first, thresholds.second)->connect(image);
+        hostThresholding->setMainDevice(Host::getInstance());
+        auto hostResult = hostThresholding->runAndGetOutputData<Image>();
+
+        REQUIRE(hostResult->getSize() == result->getSize());
+        REQUIRE(hostResult->getDataType() == TYPE_UINT8);
+        auto access = result->getImageAccess(ACCESS_READ);
+        auto hostAccess = hostResult->getImageAccess(ACCESS_READ);
+        CHECK(std::memcmp(access->get(), hostAccess->get(), result->getNrOfVoxels()) == 0);
+    }
+}
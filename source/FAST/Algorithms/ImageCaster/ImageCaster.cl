@@ -16,9 +16,9 @@ void writeImageAsFloat2D(__write_only image2d_t image, int2 position, float4 val
     if(dataType == CLK_FLOAT || dataType == CLK_SNORM_INT16 || dataType == CLK_UNORM_INT16) {
         write_imagef(image, position, value);
     } else if(dataType == CLK_SIGNED_INT16 || dataType == CLK_SIGNED_INT8) {
-        write_imagei(image, position, convert_int4(round(value)));
+        write_imagei(image, position, convert_int4_sat(round(value)));
     } else {
-        write_imageui(image, position, convert_uint4(round(value)));
+        write_imageui(image, position, convert_uint4_sat(round(value)));
     }
 }
 
@@ -1,5 +1,6 @@
 #include "ImageCaster.hpp"
 #include <FAST/Data/Image.hpp>
+#include <FAST/Utility.hpp>
 
 namespace fast {
 
@@ -14,6 +15,50 @@ ImageCaster::ImageCaster(DataType outputType, float scaleFactor) : ImageCaster()
     m_scaleFactor = scaleFactor;
 }
 
+// Read and write values the same way as the OpenCL kernel, which uses read_imagef/write_imagef for normalized types
+template <class T>
+static float readAsFloat(T value, DataType type) {
+    if(type == TYPE_UNORM_INT16)
+        return (float)value / 65535.0f;
+    if(type == TYPE_SNORM_INT16)
+        return std::max((float)value / 32767.0f, -1.0f);
+    return (float)value;
+}
+
+template <class T>
+static T writeFromFloat(float value, DataType type) {
+    if(type == TYPE_UNORM_INT16)
+        return saturate_cast<T>(std::round(value*65535.0f));
+    if(type == TYPE_SNORM_INT16)
+        return saturate_cast<T>(std::round(value*32767.0f));
+    if(type == TYPE_FLOAT)
+        return (T)value;
+    return saturate_cast<T>(std::round(value));
+}
+
+template <class InputType, class OutputType>
+static void executeAlgorithmOnHost(Image::pointer input, Image::pointer output, float scaleFactor) {
+    auto inputAccess = input->getImageAccess(ACCESS_READ);
+    auto outputAccess = output->getImageAccess(ACCESS_READ_WRITE);
+    const InputType* inputData = (const InputType*)inputAccess->get();
+    OutputType* outputData = (OutputType*)outputAccess->get();
+    const DataType inputType = input->getDataType();
+    const DataType outputType = output->getDataType();
+
+    const int64_t size = (int64_t)input->getWidth()*input->getHeight()*input->getNrOfChannels();
+    #pragma omp parallel for
+    for(int64_t i = 0; i < size; ++i) {
+        outputData[i] = writeFromFloat<OutputType>(readAsFloat(inputData[i], inputType)*scaleFactor, outputType);
+    }
+}
+
+template <class InputType>
+static void executeAlgorithmOnHost(Image::pointer input, Image::pointer output, float scaleFactor) {
+    switch(output->getDataType()) {
+        fastSwitchTypeMacro((executeAlgorithmOnHost<InputType, FAST_TYPE>(input, output, scaleFactor)));
+    }
+}
+
 void ImageCaster::execute() {
     auto input = getInputData<Image>();
     if(input->getDimensions() == 3)
@@ -21,6 +66,13 @@ void ImageCaster::execute() {
     auto output = Image::create(input->getSize(), m_outputType, input->getNrOfChannels());
     output->setSpacing(input->getSpacing());
     SceneGraph::setParentNode(output, input);
+    if(getMainDevice()->isHost()) {
+        switch(input->getDataType()) {
+            fastSwitchTypeMacro(executeAlgorithmOnHost<FAST_TYPE>(input, output, m_scaleFactor));
+        }
+        addOutputData(0, output);
+        return;
+    }
     auto device = std::dynamic_pointer_cast<OpenCLDevice>(getMainDevice());
 
     auto queue = device->getCommandQueue();
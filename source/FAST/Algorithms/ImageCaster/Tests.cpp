@@ -0,0 +1,40 @@
+#include <FAST/Testing.hpp>
+#include <FAST/Algorithms/ImageCaster/ImageCaster.hpp>
+#include <FAST/Importers/ImageFileImporter.hpp>
+#include <FAST/Data/Image.hpp>
+
+using namespace fast;
+
+TEST_CASE("ImageCaster on Host gives same result as OpenCL", "[fast][ImageCaster]") {
+    auto uint8Image = ImageFileImporter::create(Config::getTestDataPath() + "US/Heart/ApicalFourChamber/US-2D_0.mhd")
+            ->runAndGetOutputData<Image>();
+    const int width = 64;
+    const int height = 48;
+    auto floatData = std::make_unique<float[]>(width*height);
+    for(int i = 0; i < width*height; ++i)
+        floatData[i] = (float)(i % 301) / 100.0f - 1.5f;
+    auto floatImage = Image::create(width, height, TYPE_FLOAT, 1, floatData.get());
+
+    // Scaling of 8 bit images to float, and rounding and saturation of float images to integer types
+    struct Cast {
+        Image::pointer image;
+        DataType outputType;
+        float scaleFactor;
+    };
+    for(auto cast : {Cast{uint8Image, TYPE_FLOAT, 1.0f/255.0f}, Cast{uint8Image, TYPE_INT16, 2.0f},
+                     Cast{floatImage, TYPE_UINT8, 100.0f}, Cast{floatImage, TYPE_INT8, 100.0f}}) {
+        auto result = ImageCaster::create(cast.outputType, cast.scaleFactor)->connect(cast.image)->runAndGetOutputData<Image>();
+
+        auto hostCaster = ImageCaster::create(cast.outputType, cast.scaleFactor)->connect(cast.image);
+        hostCaster->setMainDevice(Host::getInstance());
+        auto hostResult = hostCaster->runAndGetOutputData<Image>();
+
+        REQUIRE(hostResult->getSize() == result->getSize());
+        REQUIRE(hostResult->getDataType() == cast.outputType);
+        REQUIRE(result->getDataType() == cast.outputType);
+        auto access = result->getImageAccess(ACCESS_READ);
+        auto hostAccess = hostResult->getImageAccess(ACCESS_READ);
+        for(int i = 0; i < result->getNrOfVoxels(); ++i)
+            CHECK(hostAccess->getScalar(i) == Approx(access->getScalar(i)).margin(1e-6));
+    }
+}
@@ -20,11 +20,12 @@ __kernel void invert3D(
     }
     value = (max - min) - value;
 
-    output[(pos.x + pos.y*get_image_width(input) + pos.z*get_image_width(input)*get_image_height(input))*outputChannels] = value.x;
+    // CONVERT_DATA_TYPE saturates integer types, the same as the host implementation
+    output[(pos.x + pos.y*get_image_width(input) + pos.z*get_image_width(input)*get_image_height(input))*outputChannels] = CONVERT_DATA_TYPE(value.x);
     if(outputChannels > 1)
-        output[(pos.x + pos.y*get_image_width(input) + pos.z*get_image_width(input)*get_image_height(input))*outputChannels + 1] = value.y;
+        output[(pos.x + pos.y*get_image_width(input) + pos.z*get_image_width(input)*get_image_height(input))*outputChannels + 1] = CONVERT_DATA_TYPE(value.y);
     if(outputChannels > 2)
-        output[(pos.x + pos.y*get_image_width(input) + pos.z*get_image_width(input)*get_image_height(input))*outputChannels + 2] = value.z;
+        output[(pos.x + pos.y*get_image_width(input) + pos.z*get_image_width(input)*get_image_height(input))*outputChannels + 2] = CONVERT_DATA_TYPE(value.z);
     if(outputChannels > 3)
-        output[(pos.x + pos.y*get_image_width(input) + pos.z*get_image_width(input)*get_image_height(input))*outputChannels + 3] = value.w;
+        output[(pos.x + pos.y*get_image_width(input) + pos.z*get_image_width(input)*get_image_height(input))*outputChannels + 3] = CONVERT_DATA_TYPE(value.w);
 }
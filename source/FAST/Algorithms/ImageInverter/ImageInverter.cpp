@@ -10,6 +10,20 @@ ImageInverter::ImageInverter() {
     createOpenCLProgram(Config::getKernelSourcePath() + "Algorithms/ImageInverter/ImageInverter.cl");
 }
 
+template <class T>
+static void executeAlgorithmOnHost(Image::pointer input, Image::pointer output, float min, float max) {
+    auto inputAccess = input->getImageAccess(ACCESS_READ);
+    auto outputAccess = output->getImageAccess(ACCESS_READ_WRITE);
+    const T* inputData = (const T*)inputAccess->get();
+    T* outputData = (T*)outputAccess->get();
+
+    const int64_t size = (int64_t)input->getWidth()*input->getHeight()*input->getDepth()*input->getNrOfChannels();
+    #pragma omp parallel for
+    for(int64_t i = 0; i < size; ++i) {
+        outputData[i] = saturate_cast<T>((max - min) - (float)inputData[i]);
+    }
+}
+
 void ImageInverter::execute() {
     auto input = getInputData<Image>();
 
@@ -19,10 +33,21 @@ void ImageInverter::execute() {
     auto output = Image::createFromImage(input);
     Vector3ui size = input->getSize();
 
+    if(getMainDevice()->isHost()) {
+        switch(input->getDataType()) {
+            fastSwitchTypeMacro(executeAlgorithmOnHost<FAST_TYPE>(input, output, min, max));
+        }
+        addOutputData(0, output);
+        return;
+    }
+
     OpenCLDevice::pointer device = std::dynamic_pointer_cast<OpenCLDevice>(getMainDevice());
     cl::CommandQueue queue = device->getCommandQueue();
 
-    std::string buildOptions = "-DDATA_TYPE=" + getCTypeAsString(output->getDataType());
+    const std::string type = getCTypeAsString(output->getDataType());
+    std::string buildOptions = "-DDATA_TYPE=" + type + " -DCONVERT_DATA_TYPE=convert_" + type;
+    if(output->getDataType() != TYPE_FLOAT)
+        buildOptions += "_sat";
     cl::Program program = getOpenCLProgram(device, "", buildOptions);
     cl::Kernel kernel(program, "invert3D");
 
@@ -0,0 +1,34 @@
+#include <FAST/Testing.hpp>
+#include <FAST/Algorithms/ImageInverter/ImageInverter.hpp>
+#include <FAST/Data/Image.hpp>
+
+using namespace fast;
+
+TEST_CASE("ImageInverter on Host gives same result as OpenCL", "[fast][ImageInverter]") {
+    // The minimum intensity is above zero, thus the highest intensities are inverted to negative values and saturated
+    const int width = 64;
+    const int height = 48;
+    auto data = std::make_unique<uchar[]>(width*height);
+    for(int i = 0; i < width*height; ++i)
+        data[i] = 10 + i % 241;
+    auto uint8Image = Image::create(width, height, TYPE_UINT8, 1, data.get());
+    auto floatData = std::make_unique<float[]>(width*height*3);
+    for(int i = 0; i < width*height*3; ++i)
+        floatData[i] = (float)(i % 97) / 7.0f - 2.0f;
+    auto floatImage = Image::create(width, height, TYPE_FLOAT, 3, floatData.get());
+
+    for(auto image : {uint8Image, floatImage}) {
+        auto result = ImageInverter::create()->connect(image)->runAndGetOutputData<Image>();
+
+        auto hostInverter = ImageInverter::create()->connect(image);
+        hostInverter->setMainDevice(Host::getInstance());
+        auto hostResult = hostInverter->runAndGetOutputData<Image>();
+
+        REQUIRE(hostResult->getSize() == result->getSize());
+        REQUIRE(hostResult->getDataType() == image->getDataType());
+        REQUIRE(hostResult->getNrOfChannels() == image->getNrOfChannels());
+        auto access = result->getImageAccess(ACCESS_READ);
+        auto hostAccess = hostResult->getImageAccess(ACCESS_READ);
+        CHECK(std::memcmp(access->get(), hostAccess->get(), getSizeOfDataType(image->getDataType(), image->getNrOfChannels())*width*height) == 0);
+    }
+}
@@ -0,0 +1,85 @@
+#include "BatchSplitter.hpp"
+#include <FAST/Data/Image.hpp>
+#include <FAST/Algorithms/NeuralNetwork/NeuralNetwork.hpp>
+
+namespace fast {
+
+BatchSplitter::BatchSplitter() {
+    createInputPort<DataObject>(0, false); // Can be Batch, Image or Tensor
+    createOutputPort<DataObject>(0); // Image or Tensor
+
+    mIsModified = true;
+}
+
+void BatchSplitter::generateStream() {
+    auto po = mParent->getProcessObject();
+    bool firstTime = true;
+    bool lastFrame = false;
+    while(!lastFrame) {
+        {
+            std::unique_lock<std::mutex> lock(m_stopMutex);
+            if(m_stop) {
+                m_streamIsStarted = false;
+                m_firstFrameIsInserted = false;
+                break;
+            }
+        }
+        DataObject::pointer data;
+        try {
+            if(!firstTime) // parent is execute the first time, thus drop it here
+                po->update(); // Make sure execute is called on previous
+            firstTime = false;
+            data = mParent->getNextFrame();
+        } catch(ThreadStopped &e) {
+            break;
+        }
+        lastFrame = data->isLastFrame();
+
+        std::vector<DataObject::pointer> dataList;
+        auto batch = std::dynamic_pointer_cast<Batch>(data);
+        if(batch) {
+            auto list = batch->get();
+            if(list.isImages()) {
+                for(auto&& image : list.getImages())
+                    dataList.push_back(image);
+            } else {
+                for(auto&& tensor : list.getTensors())
+                    dataList.push_back(tensor);
+            }
+        } else {
+            dataList.push_back(data);
+        }
+        if(dataList.empty())
+            continue;
+        if(lastFrame) {
+            for(auto&& streamer : data->getLastFrame())
+                dataList.back()->setLastFrame(streamer);
+        }
+
+        try {
+            for(auto&& item : dataList) {
+                addOutputData(0, item, false, false);
+                frameAdded();
+            }
+        } catch(ThreadStopped &e) {
+            break;
+        }
+    }
+}
+
+void BatchSplitter::execute() {
+    if(!m_streamIsStarted) {
+        m_streamIsStarted = true;
+        mParent = mInputConnections[0];
+        mInputConnections.clear();
+        m_thread = std::make_unique<std::thread>(std::bind(&BatchSplitter::generateStream, this));
+    }
+
+    waitForFirstFrame();
+}
+
+BatchSplitter::~BatchSplitter() {
+    stop();
+}
+
+}
@@ -0,0 +1,35 @@
+#pragma once
+
+#include <FAST/ProcessObject.hpp>
+#include <FAST/Streamers/Streamer.hpp>
+#include <thread>
+
+namespace fast {
+
+/**
+ * @brief Converts a stream of Batch data objects into a stream of images or tensors
+ *
+ * This is the inverse of ImageToBatchGenerator, and is used to get the output of a neural network
+ * executed on batches as one image or tensor per patch. Frame data, such as patch information,
+ * is kept on each image/tensor. Data which is not a Batch is passed through unchanged.
+ *
+ * @sa ImageToBatchGenerator
+ * @ingroup neural-network
+ */
+class FAST_EXPORT BatchSplitter : public Streamer {
+    FAST_PROCESS_OBJECT(BatchSplitter)
+    public:
+        /**
+         * @brief Create instance
+         * @return instance
+         */
+        FAST_CONSTRUCTOR(BatchSplitter)
+        ~BatchSplitter() override;
+    protected:
+        void execute() override;
+        void generateStream() override;
+
+        DataChannel::pointer mParent;
+};
+
+}
@@ -12,24 +12,72 @@ ImageToBatchGenerator::ImageToBatchGenerator() {
     mIsModified = true;
 
     createIntegerAttribute("max-batch-size", "Maximum batch size", "", m_maxBatchSize);
+    createFloatAttribute("max-latency", "Maximum latency", "Maximum time in milliseconds an image can wait for the batch to be filled. 0 means wait until the batch is full.", m_maxLatency);
 }
 
-ImageToBatchGenerator::ImageToBatchGenerator(int maxBatchSize) : ImageToBatchGenerator() {
+ImageToBatchGenerator::ImageToBatchGenerator(int maxBatchSize, float maxLatency) : ImageToBatchGenerator() {
     setMaxBatchSize(maxBatchSize);
+    setMaxLatency(maxLatency);
 }
 
 void ImageToBatchGenerator::loadAttributes() {
     setMaxBatchSize(getIntegerAttribute("max-batch-size"));
+    setMaxLatency(getFloatAttribute("max-latency"));
 }
 
-void ImageToBatchGenerator::generateStream() {
-    std::vector<Image::pointer> imageList;
-    imageList.reserve(m_maxBatchSize);
-    int i = 0;
-    bool lastFrame = false;
+void ImageToBatchGenerator::readInput(int batchSize) {
     // Update will eventually block, therefore we need to call this in a separate thread
     auto po = mParent->getProcessObject();
     bool firstTime = true;
+    bool lastFrame = false;
+    try {
+        while(!lastFrame) {
+            {
+                // Don't read further ahead than one batch
+                std::unique_lock<std::mutex> lock(m_pendingMutex);
+                m_pendingCondition.wait(lock, [this, batchSize]() {
+                    return m_stopBatching || m_pendingImages.size() < batchSize;
+                });
+                if(m_stopBatching)
+                    break;
+            }
+            if(!firstTime) // parent is execute the first time, thus drop it here
+                po->update(); // Make sure execute is called on previous
+            firstTime = false;
+            auto image = mParent->getNextFrame<Image>();
+            lastFrame = image->isLastFrame();
+            {
+                std::lock_guard<std::mutex> lock(m_pendingMutex);
+                m_pendingImages.push_back(std::make_pair(image, std::chrono::steady_clock::now()));
+            }
+            m_pendingCondition.notify_all();
+        }
+    } catch(ThreadStopped &e) {
+    }
+    {
+        std::lock_guard<std::mutex> lock(m_pendingMutex);
+        m_inputDone = true;
+    }
+    m_pendingCondition.notify_all();
+}
+
+void ImageToBatchGenerator::generateStream() {
+    int batchSize = m_maxBatchSize;
+    if(m_engine) {
+        const int engineMaxBatchSize = m_engine->getMaxBatchSize();
+        if(batchSize == -1 || engineMaxBatchSize < batchSize)
+            batchSize = engineMaxBatchSize;
+    }
+    {
+        std::lock_guard<std::mutex> lock(m_pendingMutex);
+        m_pendingImages.clear();
+        m_inputDone = false;
+    }
+    std::thread readThread(std::bind(&ImageToBatchGenerator::readInput, this, batchSize));
+
+    std::vector<Image::pointer> imageList;
+    imageList.reserve(batchSize);
+    bool lastFrame = false;
     while(!lastFrame) {
         {
             std::unique_lock<std::mutex> lock(m_stopMutex);
@@ -39,42 +87,67 @@ void ImageToBatchGenerator::generateStream() {
                 break;
             }
         }
-        if(!firstTime) // parent is execute the first time, thus drop it here
-            po->update(); // Make sure execute is called on previous
-        firstTime = false;
-        Image::pointer image;
+        {
+            std::unique_lock<std::mutex> lock(m_pendingMutex);
+            auto batchReady = [this, batchSize]() {
+                return m_stopBatching || m_inputDone || m_pendingImages.size() >= batchSize;
+            };
+            m_pendingCondition.wait(lock, [this, &batchReady]() {
+                return batchReady() || !m_pendingImages.empty();
+            });
+            if(m_maxLatency > 0.0f && !batchReady()) {
+                // Send an incomplete batch when the oldest image has waited too long
+                const auto deadline = m_pendingImages.front().second +
+                        std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<float, std::milli>(m_maxLatency));
+                m_pendingCondition.wait_until(lock, deadline, batchReady);
+            } else {
+                m_pendingCondition.wait(lock, batchReady);
+            }
+            if(m_stopBatching || m_pendingImages.empty())
+                break;
+            while(imageList.size() < batchSize && !m_pendingImages.empty()) {
+                imageList.push_back(m_pendingImages.front().first);
+                m_pendingImages.pop_front();
+            }
+        }
+        m_pendingCondition.notify_all();
+        lastFrame = imageList.back()->isLastFrame();
+        auto batch = Batch::create(imageList);
+        if(lastFrame)
+            batch->setLastFrame(getNameOfClass());
         try {
-            image = mParent->getNextFrame<Image>();
+            addOutputData(0, batch);
         } catch(ThreadStopped &e) {
             break;
         }
-        lastFrame = image->isLastFrame();
-        imageList.push_back(image);
-        if(imageList.size() == m_maxBatchSize || lastFrame) {
-            auto batch = Batch::create(imageList);
-            if(lastFrame)
-                batch->setLastFrame(getNameOfClass());
-            try {
-                addOutputData(0, batch);
-            } catch(ThreadStopped &e) {
-                break;
-            }
-            frameAdded();
-            imageList.clear();
-            i++;
-        }
+        frameAdded();
+        imageList.clear();
+    }
+
+    bool inputDone;
+    {
+        std::lock_guard<std::mutex> lock(m_pendingMutex);
+        m_stopBatching = true;
+        inputDone = m_inputDone;
     }
-    //updateThread.join();
+    m_pendingCondition.notify_all();
+    if(!inputDone) // Read thread may be blocking on the parent
+        mParent->stop("ImageToBatchGenerator was stopped");
+    readThread.join();
 }
 
 void ImageToBatchGenerator::execute() {
-    if(m_maxBatchSize == -1)
-        throw Exception("Max batch size must be given to the ImageToBatchGenerator");
+    if(m_maxBatchSize == -1 && !m_engine)
+        throw Exception("Max batch size or inference engine must be given to the ImageToBatchGenerator");
 
     if(!m_streamIsStarted) {
         m_streamIsStarted = true;
         mParent = mInputConnections[0];
         mInputConnections.clear();
+        {
+            std::lock_guard<std::mutex> lock(m_pendingMutex);
+            m_stopBatching = false;
+        }
         m_thread = std::make_unique<std::thread>(std::bind(&ImageToBatchGenerator::generateStream, this));
     }
 
@@ -88,8 +161,33 @@ void ImageToBatchGenerator::setMaxBatchSize(int size) {
     mIsModified = true;
 }
 
+void ImageToBatchGenerator::setMaxLatency(float milliseconds) {
+    if(milliseconds < 0.0f)
+        throw Exception("Max latency must be 0 or larger");
+    m_maxLatency = milliseconds;
+    mIsModified = true;
+}
+
+float ImageToBatchGenerator::getMaxLatency() const {
+    return m_maxLatency;
+}
+
+void ImageToBatchGenerator::setInferenceEngine(std::shared_ptr<InferenceEngine> engine) {
+    m_engine = engine;
+    mIsModified = true;
+}
+
+void ImageToBatchGenerator::stop() {
+    {
+        std::lock_guard<std::mutex> lock(m_pendingMutex);
+        m_stopBatching = true;
+    }
+    m_pendingCondition.notify_all();
+    Streamer::stop();
+}
+
 ImageToBatchGenerator::~ImageToBatchGenerator() {
     stop();
 }
 
-}
\ No newline at end of file
+}
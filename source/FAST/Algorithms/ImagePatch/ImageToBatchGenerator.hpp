@@ -2,17 +2,25 @@
 
 #include <FAST/ProcessObject.hpp>
 #include <FAST/Streamers/Streamer.hpp>
+#include <chrono>
+#include <deque>
 #include <thread>
 
 namespace fast {
 
 class Image;
+class InferenceEngine;
 
 /**
  * @brief Converts a stream of images into stream of Batch data objects
  *
  * This is used for doing batch processing on a stream of images.
+ * A batch is sent when it is full or, if a max latency is set, when the oldest image in the batch
+ * has waited longer than the max latency. Thus inference throughput can be traded for a bounded delay.
+ * If an inference engine is given, the batch size is limited by the max batch size of the engine.
+ * Use BatchSplitter after the neural network to convert the batches back to a stream of single patches.
  *
+ * @sa BatchSplitter
  * @ingroup neural-network
  */
 class FAST_EXPORT ImageToBatchGenerator : public Streamer {
@@ -21,20 +29,48 @@ class FAST_EXPORT ImageToBatchGenerator : public Streamer {
         /**
          * @brief Create instance
          * @param maxBatchSize Maximum batch size
+         * @param maxLatency Maximum time in milliseconds an image can wait for the batch to be filled.
+         *      If 0, the generator waits until the batch is full.
          * @return instance
          */
-        FAST_CONSTRUCTOR(ImageToBatchGenerator, int, maxBatchSize,);
+        FAST_CONSTRUCTOR(ImageToBatchGenerator,
+                         int, maxBatchSize,,
+                         float, maxLatency, = 0.0f
+        );
         void setMaxBatchSize(int size);
+        /**
+         * Set maximum time in milliseconds an image can wait for the batch to be filled.
+         * When the oldest image in a batch has waited this long, the batch is sent even if it is not full.
+         * @param milliseconds If 0, the generator waits until the batch is full.
+         */
+        void setMaxLatency(float milliseconds);
+        float getMaxLatency() const;
+        /**
+         * Limit the batch size to the max batch size of this inference engine.
+         * If no max batch size is set, the max batch size of the engine is used.
+         * @param engine
+         */
+        void setInferenceEngine(std::shared_ptr<InferenceEngine> engine);
+        void stop() override;
         ~ImageToBatchGenerator() override;
         void loadAttributes() override;
     protected:
         void execute() override;
         void generateStream() override;
+        void readInput(int batchSize);
         int m_maxBatchSize;
+        float m_maxLatency = 0.0f;
+        std::shared_ptr<InferenceEngine> m_engine;
 
         DataChannel::pointer mParent;
+        // Images received but not yet sent, and when they were received
+        std::deque<std::pair<std::shared_ptr<Image>, std::chrono::steady_clock::time_point>> m_pendingImages;
+        bool m_inputDone = false;
+        bool m_stopBatching = false;
+        std::mutex m_pendingMutex;
+        std::condition_variable m_pendingCondition;
     private:
         ImageToBatchGenerator();
 };
 
-}
\ No newline at end of file
+}
@@ -1,6 +1,9 @@
 #include <FAST/Data/ImagePyramid.hpp>
 #include <FAST/Data/Image.hpp>
 #include "PatchGenerator.hpp"
+#include <chrono>
+#include <condition_variable>
+#include <functional>
 
 namespace fast {
 
@@ -24,15 +27,17 @@ PatchGenerator::PatchGenerator() {
     createFloatAttribute("patch-overlap", "Patch overlap", "Patch overlap in percent", m_overlapPercent);
     createFloatAttribute("mask-threshold", "Mask threshold", "Threshold, in percent, for how much of the candidate patch must be inside the mask to be accepted", m_maskThreshold);
     createIntegerAttribute("padding-value", "Padding value", "Value to pad patches with when out-of-bounds. Default is negative, meaning it will use (white)255 for color images, and (black)0 for grayscale images", m_paddingValue);
+    createIntegerAttribute("patch-workers", "Patch workers", "Number of threads used to extract patches from image pyramids", m_workers);
 }
 
-PatchGenerator::PatchGenerator(int width, int height, int depth, int level, int magnification, float percent, float maskThreshold, int paddingValue) : PatchGenerator() {
+PatchGenerator::PatchGenerator(int width, int height, int depth, int level, int magnification, float percent, float maskThreshold, int paddingValue, int workers) : PatchGenerator() {
     setPatchSize(width, height, depth);
     setPatchLevel(level);
     setOverlap(percent);
     setMaskThreshold(maskThreshold);
     setPaddingValue(paddingValue);
     setPatchMagnification(magnification);
+    setNumberOfWorkers(workers);
 }
 
 void PatchGenerator::loadAttributes() {
@@ -50,21 +55,13 @@ void PatchGenerator::loadAttributes() {
     setMaskThreshold(getFloatAttribute("mask-threshold"));
     setPaddingValue(getIntegerAttribute("padding-value"));
     setPatchMagnification(getIntegerAttribute("patch-magnification"));
+    setNumberOfWorkers(getIntegerAttribute("patch-workers"));
 }
 
 PatchGenerator::~PatchGenerator() {
     stop();
 }
 
-template <typename T>
-std::string to_string_with_precision(const T a_value, const int n = 6)
-{
-    std::ostringstream out;
-    out.precision(n);
-    out << std::fixed << a_value;
-    return std::move(out).str();
-}
-
 void PatchGenerator::generateStream() {
     try {
         Image::pointer previousPatch;
@@ -102,127 +99,232 @@ void PatchGenerator::generateStream() {
             }
             const int patchesX = std::ceil((float) levelWidth / (float) patchWidthWithoutOverlap);
             const int patchesY = std::ceil((float) levelHeight / (float) patchHeightWithoutOverlap);
+            const int totalPatches = patchesX*patchesY;
+
+            int paddingValue = m_paddingValue;
+            if(m_paddingValue < 0) {
+                if(m_inputImagePyramid->getNrOfChannels() > 1) {
+                    paddingValue = 255;
+                } else {
+                    paddingValue = 0;
+                }
+            }
 
-            for(int patchY = 0; patchY < patchesY; ++patchY) {
-                for(int patchX = 0; patchX < patchesX; ++patchX) {
-                    mRuntimeManager->startRegularTimer("create patch");
-                    int patchWidth = m_width;
-                    if(patchX*patchWidthWithoutOverlap + patchWidth - overlapInPixelsX >= levelWidth) {
-                        patchWidth = levelWidth - patchX * patchWidthWithoutOverlap + overlapInPixelsX;
-                    }
-                    int patchHeight = m_height;
-                    if(patchY*patchHeightWithoutOverlap + patchHeight - overlapInPixelsY >= levelHeight) {
-                        patchHeight = levelHeight - patchY * patchHeightWithoutOverlap + overlapInPixelsY;
-                    }
-                    int patchOffsetX = patchX * patchWidthWithoutOverlap - overlapInPixelsX;
-                    if(patchX == 0 && overlapInPixelsX > 0) {
-                        patchOffsetX = 0;
-                    }
-                    int patchOffsetY = patchY * patchHeightWithoutOverlap - overlapInPixelsY;
-                    if(patchY == 0 && overlapInPixelsY > 0) {
-                        patchOffsetY = 0;
-                    }
+            // The mask image is shared by all workers, and its device data is lazily updated, so serialize the mask check
+            std::mutex maskMutex;
+            // Creates a single patch. Returns nullptr if the patch is rejected by the mask or too small.
+            // This is called from multiple worker threads at once, thus it must not touch any shared state.
+            auto createPatch = [&](int patchX, int patchY) -> Image::pointer {
+                int patchWidth = m_width;
+                if(patchX*patchWidthWithoutOverlap + patchWidth - overlapInPixelsX >= levelWidth) {
+                    patchWidth = levelWidth - patchX * patchWidthWithoutOverlap + overlapInPixelsX;
+                }
+                int patchHeight = m_height;
+                if(patchY*patchHeightWithoutOverlap + patchHeight - overlapInPixelsY >= levelHeight) {
+                    patchHeight = levelHeight - patchY * patchHeightWithoutOverlap + overlapInPixelsY;
+                }
+                int patchOffsetX = patchX * patchWidthWithoutOverlap - overlapInPixelsX;
+                if(patchX == 0 && overlapInPixelsX > 0) {
+                    patchOffsetX = 0;
+                }
+                int patchOffsetY = patchY * patchHeightWithoutOverlap - overlapInPixelsY;
+                if(patchY == 0 && overlapInPixelsY > 0) {
+                    patchOffsetY = 0;
+                }
 
-                    if(m_inputMask) {
-                        // If a mask exist, check if this patch should be included or not
-                        // At least half of the patch should be clasified as foreground
-                        auto access = m_inputMask->getImageAccess(ACCESS_READ);
-                        // Calculate physical position and size
-                        float x = patchOffsetX * m_inputImagePyramid->getLevelScale(level) * m_inputImagePyramid->getSpacing().x();
-                        float y = patchOffsetY * m_inputImagePyramid->getLevelScale(level) * m_inputImagePyramid->getSpacing().y();
-                        float width = patchWidth * m_inputImagePyramid->getLevelScale(level) * m_inputImagePyramid->getSpacing().x();
-                        float height = patchHeight * m_inputImagePyramid->getLevelScale(level) * m_inputImagePyramid->getSpacing().y();
-                        auto croppedMask = m_inputMask->crop(
-                                Vector2i(
-                                        round(x/m_inputMask->getSpacing().x()),
-                                        round(y/m_inputMask->getSpacing().y())
-                                        ),
-                                        Vector2i(
-                                                std::floor(width/m_inputMask->getSpacing().x()),
-                                                std::floor(height/m_inputMask->getSpacing().y())
-                                                )
-                                                );
-                        float average = croppedMask->calculateAverageIntensity();
-                        if(average < m_maskThreshold)  // A specific percentage of the mask has to be foreground to be assessed
-                            continue;
-                    }
-                    reportInfo() << "Generating patch " << patchX << " " << patchY << reportEnd();
+                if(m_inputMask) {
+                    // If a mask exist, check if this patch should be included or not
+                    // At least half of the patch should be clasified as foreground
+                    std::lock_guard<std::mutex> lock(maskMutex);
+                    // Calculate physical position and size
+                    float x = patchOffsetX * m_inputImagePyramid->getLevelScale(level) * m_inputImagePyramid->getSpacing().x();
+                    float y = patchOffsetY * m_inputImagePyramid->getLevelScale(level) * m_inputImagePyramid->getSpacing().y();
+                    float width = patchWidth * m_inputImagePyramid->getLevelScale(level) * m_inputImagePyramid->getSpacing().x();
+                    float height = patchHeight * m_inputImagePyramid->getLevelScale(level) * m_inputImagePyramid->getSpacing().y();
+                    auto croppedMask = m_inputMask->crop(
+                            Vector2i(
+                                    round(x/m_inputMask->getSpacing().x()),
+                                    round(y/m_inputMask->getSpacing().y())
+                                    ),
+                                    Vector2i(
+                                            std::floor(width/m_inputMask->getSpacing().x()),
+                                            std::floor(height/m_inputMask->getSpacing().y())
+                                            )
+                                            );
+                    float average = croppedMask->calculateAverageIntensity();
+                    if(average < m_maskThreshold)  // A specific percentage of the mask has to be foreground to be assessed
+                        return nullptr;
+                }
+                if(patchWidth < overlapInPixelsX*2 || patchHeight < overlapInPixelsY*2)
+                    return nullptr;
+                reportInfo() << "Generating patch " << patchX << " " << patchY << reportEnd();
+                Image::pointer patch;
+                {
                     auto access = m_inputImagePyramid->getAccess(ACCESS_READ);
-                    if(patchWidth < overlapInPixelsX*2 || patchHeight < overlapInPixelsY*2)
-                        continue;
-                    auto patch = access->getPatchAsImage(level,
-                                                         patchOffsetX,
-                                                         patchOffsetY,
-                                                         patchWidth,
-                                                         patchHeight);
-
-                    // If patch does not have correct size, pad it
-                    int paddingValue = m_paddingValue;
-                    if(m_paddingValue < 0) {
-                        if(m_inputImagePyramid->getNrOfChannels() > 1) {
-                            paddingValue = 255;
-                        } else {
-                            paddingValue = 0;
-                        }
-                    }
-                    if(patch->getWidth() != m_width || patch->getHeight() != m_height) {
-                        patch = patch->crop(Vector2i(0, 0), Vector2i(m_width, m_height), true, paddingValue);
-                    }
-                    if(m_overlapPercent > 0.0f && (patchX == 0 || patchY == 0)) {
-                        int offsetX = patchX == 0 ? -overlapInPixelsX : 0;
-                        int offsetY = patchY == 0 ? -overlapInPixelsY : 0;
-                        patch = patch->crop(Vector2i(offsetX, offsetY), Vector2i(m_width, m_height), true, paddingValue);
-                    }
+                    patch = access->getPatchAsImage(level,
+                                                    patchOffsetX,
+                                                    patchOffsetY,
+                                                    patchWidth,
+                                                    patchHeight);
+                }
 
-                    // Store some frame data useful for patch stitching
-                    patch->setFrameData("original-width", std::to_string(levelWidth));
-                    patch->setFrameData("original-height", std::to_string(levelHeight));
-                    patch->setFrameData("patchid-x", std::to_string(patchX));
-                    patch->setFrameData("patchid-y", std::to_string(patchY));
-                    // Target width/height of patches
-                    patch->setFrameData("patch-width", std::to_string(m_width));
-                    patch->setFrameData("patch-height", std::to_string(m_height));
-                    patch->setFrameData("patch-overlap-x", std::to_string(overlapInPixelsX));
-                    patch->setFrameData("patch-overlap-y", std::to_string(overlapInPixelsY));
-                    // Image patch spacing of a WSI can be very small, and std::to_string can round the numbers,
-                    // and there is no way to set the precision, so we use a custom function instead.
-                    patch->setFrameData("patch-spacing-x", to_string_with_precision(patch->getSpacing().x(), 32));
-                    patch->setFrameData("patch-spacing-y", to_string_with_precision(patch->getSpacing().y(), 32));
-                    patch->setFrameData("patch-level", std::to_string(level));
-                    m_progress = (float)(patchX+patchY*patchesX)/(patchesX*patchesY);
-                    patch->setFrameData("progress", std::to_string(m_progress));
+                // If patch does not have correct size, pad it
+                if(patch->getWidth() != m_width || patch->getHeight() != m_height) {
+                    patch = patch->crop(Vector2i(0, 0), Vector2i(m_width, m_height), true, paddingValue);
+                }
+                if(m_overlapPercent > 0.0f && (patchX == 0 || patchY == 0)) {
+                    int offsetX = patchX == 0 ? -overlapInPixelsX : 0;
+                    int offsetY = patchY == 0 ? -overlapInPixelsY : 0;
+                    patch = patch->crop(Vector2i(offsetX, offsetY), Vector2i(m_width, m_height), true, paddingValue);
+                }
 
-                    mRuntimeManager->stopRegularTimer("create patch");
-                    try {
-                        if(previousPatch) {
-                            addOutputData(0, previousPatch, false);
-                            frameAdded();
+                // Store some frame data useful for patch stitching
+                patch->setFrameData("original-width", levelWidth);
+                patch->setFrameData("original-height", levelHeight);
+                patch->setFrameData("patchid-x", patchX);
+                patch->setFrameData("patchid-y", patchY);
+                // Target width/height of patches
+                patch->setFrameData("patch-width", m_width);
+                patch->setFrameData("patch-height", m_height);
+                patch->setFrameData("patch-overlap-x", overlapInPixelsX);
+                patch->setFrameData("patch-overlap-y", overlapInPixelsY);
+                // Stored as floating point frame data, so the very small spacing of WSIs is not rounded
+                patch->setFrameData("patch-spacing-x", patch->getSpacing().x());
+                patch->setFrameData("patch-spacing-y", patch->getSpacing().y());
+                patch->setFrameData("patch-level", level);
+                return patch;
+            };
+
+            // Start worker threads which create patches in parallel. Patches are stored in a map indexed by
+            // their raster order, and this thread emits them in that order, so the output stream is identical to
+            // the single threaded case. Workers are not allowed to get too far ahead of the emitted patches,
+            // to keep the memory usage bounded.
+            const int workers = std::max(1, std::min(m_workers, totalPatches));
+            const int maxPatchesInFlight = workers*4;
+            std::mutex resultMutex;
+            std::condition_variable resultCondition;
+            std::map<int, Image::pointer> results; // nullptr means the patch was rejected
+            std::exception_ptr workerException;
+            int nextJob = 0;
+            int nextToEmit = 0;
+            bool abortWorkers = false;
+            std::vector<std::thread> workerThreads;
+            auto stopWorkers = [&]() {
+                {
+                    std::lock_guard<std::mutex> lock(resultMutex);
+                    abortWorkers = true;
+                }
+                resultCondition.notify_all();
+                for(auto& thread : workerThreads) {
+                    if(thread.joinable())
+                        thread.join();
+                }
+                workerThreads.clear();
+            };
+            // Make sure workers are joined also when an exception is thrown in this thread
+            struct WorkerGuard {
+                std::function<void()> stop;
+                ~WorkerGuard() { stop(); }
+            } workerGuard{stopWorkers};
+            if(workers > 1) {
+                reportInfo() << "Using " << workers << " worker threads to generate patches" << reportEnd();
+                for(int i = 0; i < workers; ++i) {
+                    workerThreads.emplace_back([&]() {
+                        while(true) {
+                            int job;
+                            {
+                                std::unique_lock<std::mutex> lock(resultMutex);
+                                resultCondition.wait(lock, [&]() {
+                                    return abortWorkers || nextJob >= totalPatches || nextJob < nextToEmit + maxPatchesInFlight;
+                                });
+                                if(abortWorkers || nextJob >= totalPatches)
+                                    return;
+                                job = nextJob;
+                                ++nextJob;
+                            }
+                            Image::pointer patch;
+                            auto start = std::chrono::high_resolution_clock::now();
+                            try {
+                                patch = createPatch(job % patchesX, job / patchesX);
+                            } catch(...) {
+                                {
+                                    std::lock_guard<std::mutex> lock(resultMutex);
+                                    if(!workerException)
+                                        workerException = std::current_exception();
+                                    abortWorkers = true;
+                                }
+                                resultCondition.notify_all();
+                                return;
+                            }
+                            std::chrono::duration<double, std::milli> duration = std::chrono::high_resolution_clock::now() - start;
+                            {
+                                std::lock_guard<std::mutex> lock(resultMutex);
+                                results[job] = patch;
+                                if(mRuntimeManager->isEnabled())
+                                    mRuntimeManager->getTiming("create patch")->addSample(duration.count());
+                            }
+                            resultCondition.notify_all();
                         }
-                    } catch(ThreadStopped &e) {
-                        std::unique_lock<std::mutex> lock(m_stopMutex);
-                        m_stop = true;
-                        break;
+                    });
+                }
+            }
+
+            for(int job = 0; job < totalPatches; ++job) {
+                const int patchX = job % patchesX;
+                const int patchY = job / patchesX;
+                Image::pointer patch;
+                if(workerThreads.empty()) {
+                    mRuntimeManager->startRegularTimer("create patch");
+                    patch = createPatch(patchX, patchY);
+                    mRuntimeManager->stopRegularTimer("create patch");
+                } else {
+                    std::unique_lock<std::mutex> lock(resultMutex);
+                    resultCondition.wait(lock, [&]() {
+                        return results.count(job) > 0 || workerException;
+                    });
+                    if(results.count(job) == 0)
+                        std::rethrow_exception(workerException);
+                    patch = results[job];
+                    results.erase(job);
+                    nextToEmit = job + 1;
+                    lock.unlock();
+                    resultCondition.notify_all();
+                }
+                if(!patch)
+                    continue;
+
+                m_progress = (float)(patchX+patchY*patchesX)/(patchesX*patchesY);
+                patch->setFrameData("progress", m_progress);
+
+                try {
+                    if(previousPatch) {
+                        addOutputData(0, previousPatch, false);
+                        frameAdded();
                     }
-                    previousPatch = patch;
+                } catch(ThreadStopped &e) {
                     std::unique_lock<std::mutex> lock(m_stopMutex);
-                    if(m_stop)
-                        break;
+                    m_stop = true;
+                    break;
                 }
+                previousPatch = patch;
+                std::unique_lock<std::mutex> lock(m_stopMutex);
+                if(m_stop)
+                    break;
+            }
+            stopWorkers();
+            {
                 std::unique_lock<std::mutex> lock(m_stopMutex);
                 if(m_stop) {
                     //m_streamIsStarted = false;
                     m_firstFrameIsInserted = false;
-                    break;
                 }
             }
         } else if(m_inputVolume) { // Could be 3D or 2D
             const int width = m_inputVolume->getWidth();
             const int height = m_inputVolume->getHeight();
             const int depth = m_inputVolume->getDepth();
-            auto transformData = SceneGraph::getEigenTransformFromData(m_inputVolume).data();
-            std::string transformString;
-            for(int i = 0; i < 16; ++i)
-                transformString += std::to_string(transformData[i]) + " ";
+            const auto transform = SceneGraph::getEigenTransformFromData(m_inputVolume);
+            std::vector<float> transformValues(transform.data(), transform.data() + 16);
 
             const int patchesX = std::ceil((float) width / (float) patchWidthWithoutOverlap);
             const int patchesY = std::ceil((float) height / (float) patchHeightWithoutOverlap);
@@ -260,28 +362,28 @@ void PatchGenerator::generateStream() {
                             }
                         }
                         auto patch = m_inputVolume->crop(Vector3i(x, y, z), Vector3i(m_width, m_height, m_depth), true, paddingValue);
-                        patch->setFrameData("original-width", std::to_string(width));
-                        patch->setFrameData("original-height", std::to_string(height));
-                        patch->setFrameData("original-depth", std::to_string(depth));
-                        patch->setFrameData("original-transform", transformString);
-                        patch->setFrameData("patch-offset-x", std::to_string(x));
-                        patch->setFrameData("patch-offset-y", std::to_string(y));
-                        patch->setFrameData("patch-offset-z", std::to_string(z));
-                        patch->setFrameData("patch-width", std::to_string(m_width));
-                        patch->setFrameData("patch-height", std::to_string(m_height));
-                        patch->setFrameData("patch-depth", std::to_string(m_depth));
-                        patch->setFrameData("patchid-x", std::to_string(patchX));
-                        patch->setFrameData("patchid-y", std::to_string(patchY));
-                        patch->setFrameData("patchid-z", std::to_string(patchZ));
-                        patch->setFrameData("patch-overlap-x", std::to_string(overlapInPixelsX));
-                        patch->setFrameData("patch-overlap-y", std::to_string(overlapInPixelsY));
-                        patch->setFrameData("patch-overlap-z", std::to_string(overlapInPixelsZ));
+                        patch->setFrameData("original-width", width);
+                        patch->setFrameData("original-height", height);
+                        patch->setFrameData("original-depth", depth);
+                        patch->setFrameData("original-transform", transformValues);
+                        patch->setFrameData("patch-offset-x", x);
+                        patch->setFrameData("patch-offset-y", y);
+                        patch->setFrameData("patch-offset-z", z);
+                        patch->setFrameData("patch-width", m_width);
+                        patch->setFrameData("patch-height", m_height);
+                        patch->setFrameData("patch-depth", m_depth);
+                        patch->setFrameData("patchid-x", patchX);
+                        patch->setFrameData("patchid-y", patchY);
+                        patch->setFrameData("patchid-z", patchZ);
+                        patch->setFrameData("patch-overlap-x", overlapInPixelsX);
+                        patch->setFrameData("patch-overlap-y", overlapInPixelsY);
+                        patch->setFrameData("patch-overlap-z", overlapInPixelsZ);
                         Vector3f spacing = m_inputVolume->getSpacing();
-                        patch->setFrameData("patch-spacing-x", std::to_string(spacing.x()));
-                        patch->setFrameData("patch-spacing-y", std::to_string(spacing.y()));
-                        patch->setFrameData("patch-spacing-z", std::to_string(spacing.z()));
+                        patch->setFrameData("patch-spacing-x", spacing.x());
+                        patch->setFrameData("patch-spacing-y", spacing.y());
+                        patch->setFrameData("patch-spacing-z", spacing.z());
                         m_progress = ((float)(patchX+patchY*patchesX+patchZ*patchesX*patchesY)/(patchesX*patchesY*patchesZ));
-                        patch->setFrameData("progress", std::to_string(m_progress));
+                        patch->setFrameData("progress", m_progress);
                         try {
                             if(previousPatch) {
                                 addOutputData(0, previousPatch, false);
@@ -374,6 +476,13 @@ void PatchGenerator::setPatchMagnification(int magnification) {
     setModified(true);
 }
 
+void PatchGenerator::setNumberOfWorkers(int workers) {
+    if(workers <= 0)
+        throw Exception("Number of patch workers must be > 0");
+    m_workers = workers;
+    setModified(true);
+}
+
 float PatchGenerator::getProgress() {
     return m_progress;
 }
@@ -38,6 +38,8 @@ class FAST_EXPORT PatchGenerator : public Streamer {
          * @param maskThreshold Threshold to accept a patch if the additional mask is provided.
          * @param paddingValue Value to pad patches with when out-of-bounds. Default is negative, meaning it will use
          *  (white)255 for color images, and (black)0 for grayscale images
+         * @param workers Number of threads used to extract patches from ImagePyramid inputs in parallel.
+         *  Patches are still emitted in the same order as with a single thread.
          * @return instance
          */
         FAST_CONSTRUCTOR(PatchGenerator,
@@ -48,7 +50,8 @@ class FAST_EXPORT PatchGenerator : public Streamer {
                          int, magnification, = -1,
                          float, overlapPercent, = 0.0f,
                          float, maskThreshold, = 0.5f,
-                         int, paddingValue, = -1
+                         int, paddingValue, = -1,
+                         int, workers, = 1
         )
         void setPatchSize(int width, int height, int depth = 1);
         /**
@@ -60,6 +63,14 @@ class FAST_EXPORT PatchGenerator : public Streamer {
         void setPatchMagnification(int magnification);
         void setMaskThreshold(float percent);
         void setPaddingValue(int paddingValue);
+        /**
+         * @brief Set number of threads used to extract patches from ImagePyramid inputs
+         *
+         * Patches are read and decoded concurrently by a pool of worker threads,
+         * but are always emitted in raster order.
+         * @param workers Number of worker threads. 1 means all work is done in the streaming thread.
+         */
+        void setNumberOfWorkers(int workers);
         ~PatchGenerator();
         void loadAttributes() override;
         /**
@@ -73,6 +84,7 @@ class FAST_EXPORT PatchGenerator : public Streamer {
         float m_maskThreshold = 0.5;
         int m_paddingValue = -1;
         int m_magnification = -1;
+        int m_workers = 1;
         float m_progress = 0.0f;
 
         std::shared_ptr<ImagePyramid> m_inputImagePyramid;
@@ -3,22 +3,99 @@
 #include <FAST/Data/Tensor.hpp>
 #include <FAST/Algorithms/NeuralNetwork/NeuralNetwork.hpp>
 #include <FAST/Algorithms/ImageResizer/ImageResizer.hpp>
+#include <FAST/Utility.hpp>
 #include "PatchStitcher.hpp"
 
 namespace fast {
 
-PatchStitcher::PatchStitcher(bool patchesAreCropped) {
+namespace {
+
+std::vector<float> createBlendingWindow(PatchBlending blending, int size, int overlap) {
+    std::vector<float> window(size, 1.0f);
+    for(int i = 0; i < size; ++i) {
+        if(blending == PatchBlending::LINEAR) {
+            // Neighbouring patches overlap by 2*overlap pixels, across which the weights of the two patches sum to 1
+            if(overlap > 0)
+                window[i] = std::min(1.0f, (std::min(i, size - 1 - i) + 0.5f) / (2.0f*overlap));
+        } else if(blending == PatchBlending::GAUSSIAN) {
+            const float sigma = size / 8.0f;
+            const float distance = i - (size - 1) / 2.0f;
+            window[i] = std::exp(-distance*distance / (2.0f*sigma*sigma));
+        }
+    }
+    return window;
+}
+
+template <class T>
+void accumulatePatch(const T* data, int patchWidth, int channels, int startX, int endX, int startY, int endY,
+                     const float* windowX, const float* windowY, float* sum, float* weight, int tileWidth) {
+    // Start and end are relative to the patch, and the tile starts at start
+    for(int y = startY; y < endY; ++y) {
+        for(int x = startX; x < endX; ++x) {
+            const float w = windowX[x]*windowY[y];
+            const int tilePos = (x - startX) + (y - startY)*tileWidth;
+            for(int c = 0; c < channels; ++c)
+                sum[tilePos*channels + c] += w*(float)data[(x + y*patchWidth)*channels + c];
+            weight[tilePos] += w;
+        }
+    }
+}
+
+template <class T>
+void normalizeBlendedTile(const float* sum, const float* weight, int tileWidth, int channels, int width, int height, T* output, int outputWidth, float scale) {
+    for(int y = 0; y < height; ++y) {
+        for(int x = 0; x < width; ++x) {
+            const float w = weight[x + y*tileWidth];
+            for(int c = 0; c < channels; ++c) {
+                const float value = w > 0.0f ? scale*sum[(x + y*tileWidth)*channels + c] / w : 0.0f;
+                output[(x + y*outputWidth)*channels + c] = std::is_floating_point<T>::value ? (T)value : saturate_cast<T>(std::round(value));
+            }
+        }
+    }
+}
+
+// Image pyramids store 8 bit data, thus float patches are scaled and quantized
+std::shared_ptr<Image> quantizePatch(std::shared_ptr<Image> patch, float scale) {
+    auto output = Image::create(patch->getWidth(), patch->getHeight(), TYPE_UINT8, patch->getNrOfChannels());
+    auto access = patch->getImageAccess(ACCESS_READ);
+    auto outputAccess = output->getImageAccess(ACCESS_READ_WRITE);
+    const float* data = (const float*)access->get();
+    uchar* outputData = (uchar*)outputAccess->get();
+    const std::size_t size = (std::size_t)patch->getWidth()*patch->getHeight()*patch->getNrOfChannels();
+    for(std::size_t i = 0; i < size; ++i)
+        outputData[i] = saturate_cast<uchar>(std::round(data[i]*scale));
+    return output;
+}
+
+}
+
+PatchStitcher::PatchStitcher(bool patchesAreCropped, std::string outputFilename, PatchBlending blending) {
     createInputPort<DataObject>(0); // Can be Image, Batch or Tensor
     createOutputPort<DataObject>(0); // Can be Image or Tensor
 
     createOpenCLProgram(Config::getKernelSourcePath() + "/Algorithms/ImagePatch/PatchStitcher2D.cl", "2D");
     createOpenCLProgram(Config::getKernelSourcePath() + "/Algorithms/ImagePatch/PatchStitcher3D.cl", "3D");
     createBooleanAttribute("patches-are-cropped", "Patches are cropped", "Indicate whether incomming patches are already cropped or not.", false);
+    createStringAttribute("output-filename", "Output filename", "Stream stitched image patches to a TIFF image pyramid with this filename", "");
+    createStringAttribute("blending", "Blending", "Blending of overlapping patches: none, linear or gaussian", "none");
     setPatchesAreCropped(patchesAreCropped);
+    setOutputFilename(outputFilename);
+    setBlending(blending);
 }
 
 void PatchStitcher::loadAttributes() {
     setPatchesAreCropped(getBooleanAttribute("patches-are-cropped"));
+    setOutputFilename(getStringAttribute("output-filename"));
+    const std::string blending = getStringAttribute("blending");
+    if(blending == "none") {
+        setBlending(PatchBlending::NONE);
+    } else if(blending == "linear") {
+        setBlending(PatchBlending::LINEAR);
+    } else if(blending == "gaussian") {
+        setBlending(PatchBlending::GAUSSIAN);
+    } else {
+        throw Exception("Unknown blending " + blending + " in PatchStitcher");
+    }
 }
 
 void PatchStitcher::execute() {
@@ -45,8 +122,16 @@ void PatchStitcher::execute() {
             processImage(imagePatch);
         }
     }
+    if(m_blending != PatchBlending::NONE && patch->isLastFrame())
+        finalizeBlendedTiles(std::numeric_limits<int>::max());
     mRuntimeManager->stopRegularTimer("stitch patch");
 
+    if(m_outputImagePyramid && patch->isLastFrame()) {
+        mRuntimeManager->startRegularTimer("update pyramid levels");
+        m_outputImagePyramid->getAccess(ACCESS_READ_WRITE)->updatePyramidLevels();
+        mRuntimeManager->stopRegularTimer("update pyramid levels");
+    }
+
     if(m_outputImage) {
         addOutputData(0, m_outputImage);
     } else if(m_outputTensor) {
@@ -59,14 +144,17 @@ void PatchStitcher::execute() {
 }
 
 void PatchStitcher::processTensor(std::shared_ptr<Tensor> patch) {
-    const int fullWidth = std::stoi(patch->getFrameData("original-width"));
-    const int fullHeight = std::stoi(patch->getFrameData("original-height"));
+    const int fullWidth = patch->getFrameData<int>("original-width");
+    const int fullHeight = patch->getFrameData<int>("original-height");
+
+    const int patchWidth = patch->getFrameData<int>("patch-width")- 2*patch->getFrameData<int>("patch-overlap-x");;
+    const int patchHeight = patch->getFrameData<int>("patch-height") - 2*patch->getFrameData<int>("patch-overlap-y");;
 
-    const int patchWidth = std::stoi(patch->getFrameData("patch-width"))- 2*std::stoi(patch->getFrameData("patch-overlap-x"));;
-    const int patchHeight = std::stoi(patch->getFrameData("patch-height")) - 2*std::stoi(patch->getFrameData("patch-overlap-y"));;
+    const float patchSpacingX = patch->getFrameData<float>("patch-spacing-x");
+    const float patchSpacingY = patch->getFrameData<float>("patch-spacing-y");
 
-    const float patchSpacingX = std::stof(patch->getFrameData("patch-spacing-x"));
-    const float patchSpacingY = std::stof(patch->getFrameData("patch-spacing-y"));
+    if(!m_outputFilename.empty())
+        throw Exception("PatchStitcher can only stream image patches to disk, not tensors");
 
     auto shape = patch->getShape();
     if(shape.getDimensions() != 1) {
@@ -77,39 +165,41 @@ void PatchStitcher::processTensor(std::shared_ptr<Tensor> patch) {
     if(!m_outputTensor) {
         // Create output tensor
         TensorShape fullShape({(int)std::ceil((float)fullHeight / patchHeight), (int)std::ceil((float)fullWidth / patchWidth), channels});
-        auto initializedData = std::make_unique<float[]>(fullShape.getTotalSize());
-        m_outputTensor = Tensor::create(std::move(initializedData), fullShape);
+        // Keep the data type of the patches, e.g. float16 or uint8 from a half precision or quantized network
+        m_outputTensor = Tensor::create(fullShape, patch->getDataType());
+        {
+            auto access = m_outputTensor->getAccess(ACCESS_READ_WRITE);
+            std::memset(access->get(), 0, fullShape.getTotalSize()*getSizeOfDataType(patch->getDataType(), 1));
+        }
         // TODO Use Y-X or X-Y ordering on spacing here? Changes will influence other objects
         m_outputTensor->setSpacing(Vector3f(patchHeight*patchSpacingY, patchWidth*patchSpacingX, 1.0f));
     }
     reportInfo() << "Stitching " << patch->getFrameData("patchid-x") << " " << patch->getFrameData("patchid-y") << reportEnd();
     reportInfo() << "Stitching data with spacing " << patch->getFrameData("patch-spacing-x") << " " << patch->getFrameData("patch-spacing-y") << reportEnd();
 
-    const int startX = std::stoi(patch->getFrameData("patchid-x"));
-    const int startY = std::stoi(patch->getFrameData("patchid-y"));
+    const int startX = patch->getFrameData<int>("patchid-x");
+    const int startY = patch->getFrameData<int>("patchid-y");
 
-    auto inputAccess = patch->getAccess(ACCESS_READ);
-    auto tensorData = inputAccess->getData<1>();
+    auto inputAccess = patch->toDataType(m_outputTensor->getDataType())->getAccess(ACCESS_READ);
     auto outputAccess = m_outputTensor->getAccess(ACCESS_READ_WRITE);
-    auto outputTensorData = outputAccess->getData<3>();
-
-    for(int i = 0; i < channels; ++i) {
-        outputTensorData(startY, startX, i) = tensorData(i);
-    }
+    const TensorShape outputShape = m_outputTensor->getShape();
+    const std::size_t elementSize = getSizeOfDataType(m_outputTensor->getDataType(), 1);
+    const std::size_t offset = ((std::size_t)startY*outputShape[1] + startX)*channels*elementSize;
+    std::memcpy((uchar*)outputAccess->get() + offset, inputAccess->get(), channels*elementSize);
 }
 
 void PatchStitcher::processImage(std::shared_ptr<Image> patch) {
-    const int fullWidth = std::stoi(patch->getFrameData("original-width"));
-    const int fullHeight = std::stoi(patch->getFrameData("original-height"));
-    const float patchSpacingX = std::stof(patch->getFrameData("patch-spacing-x"));
-    const float patchSpacingY = std::stof(patch->getFrameData("patch-spacing-y"));
+    const int fullWidth = patch->getFrameData<int>("original-width");
+    const int fullHeight = patch->getFrameData<int>("original-height");
+    const float patchSpacingX = patch->getFrameData<float>("patch-spacing-x");
+    const float patchSpacingY = patch->getFrameData<float>("patch-spacing-y");
 
     int fullDepth = 1;
     float patchSpacingZ = 1.0f;
     bool is3D = true;
     try {
-        fullDepth = std::stoi(patch->getFrameData("original-depth"));
-        patchSpacingZ = std::stof(patch->getFrameData("patch-spacing-z"));
+        fullDepth = patch->getFrameData<int>("original-depth");
+        patchSpacingZ = patch->getFrameData<float>("patch-spacing-z");
         if(fullDepth == 1)
             is3D = false;
     } catch(Exception &e) {
@@ -118,18 +208,27 @@ void PatchStitcher::processImage(std::shared_ptr<Image> patch) {
     }
 
     if(!m_outputImage && !m_outputImagePyramid) {
+        m_blendedTiles.clear();
         // Create output image
         if(is3D) {
+            if(!m_outputFilename.empty())
+                throw Exception("PatchStitcher can only stream 2D image patches to disk");
 			m_outputImage = Image::create(fullWidth, fullHeight, fullDepth, patch->getDataType(), patch->getNrOfChannels());
         } else {
-            if(fullWidth < 8192 && fullHeight < 8192) {
+            if(m_outputFilename.empty() && fullWidth < 8192 && fullHeight < 8192) {
                 reportInfo() << "Patch stitcher creating image with size " << fullWidth << " " << fullHeight << reportEnd();
 				m_outputImage = Image::create(fullWidth, fullHeight, patch->getDataType(), patch->getNrOfChannels());
             } else {
                 // Large image, create image pyramid instead
-                int patchWidth = std::stoi(patch->getFrameData("patch-width")) - 2*std::stoi(patch->getFrameData("patch-overlap-x"));
-                int patchHeight = std::stoi(patch->getFrameData("patch-height")) - 2*std::stoi(patch->getFrameData("patch-overlap-y"));
-                m_outputImagePyramid = ImagePyramid::create(fullWidth, fullHeight, patch->getNrOfChannels(), patchWidth, patchHeight);
+                if(patch->getDataType() != TYPE_UINT8 && patch->getDataType() != TYPE_FLOAT)
+                    throw Exception("PatchStitcher can only stitch uint8 and float image patches into an image pyramid, use ImageCaster to convert patches first");
+                // Image pyramids store 8 bit data. Float patches, such as probability maps, are quantized from [0, 1] to [0, 255].
+                m_pyramidScale = patch->getDataType() == TYPE_FLOAT ? 255.0f : 1.0f;
+                int patchWidth = patch->getFrameData<int>("patch-width") - 2*patch->getFrameData<int>("patch-overlap-x");
+                int patchHeight = patch->getFrameData<int>("patch-height") - 2*patch->getFrameData<int>("patch-overlap-y");
+                // Tiles are written to the pyramid as patches arrive. With an output filename this is a TIFF file, otherwise memory mapped files.
+                m_outputImagePyramid = ImagePyramid::create(fullWidth, fullHeight, patch->getNrOfChannels(), patchWidth, patchHeight, m_outputFilename);
+                m_pyramidPatchRow = -1;
                 reportInfo() << "Patch stitcher creating image PYRAMID with size " << fullWidth << " " << fullHeight << ", patch size: " <<
                     patchWidth << " " << patchHeight << " Levels: " << m_outputImagePyramid->getNrOfLevels() << reportEnd();
             }
@@ -142,11 +241,13 @@ void PatchStitcher::processImage(std::shared_ptr<Image> patch) {
             m_outputImagePyramid->setSpacing(Vector3f(patchSpacingX, patchSpacingY, patchSpacingZ));
         }
         try {
-            auto transformData = split(patch->getFrameData("original-transform"));
+            auto transformData = patch->getFrameData<std::vector<float>>("original-transform");
+            if(transformData.size() != 16)
+                throw Exception("Frame data original-transform must have 16 values");
             auto T = Transform::create();
             Affine3f transform;
             for(int i = 0; i < 16; ++i)
-                transform.matrix()(i) = std::stof(transformData[i]);
+                transform.matrix()(i) = transformData[i];
             T->set(transform);
             if(m_outputImage) {
                 m_outputImage->getSceneGraphNode()->setTransform(T);
@@ -160,17 +261,19 @@ void PatchStitcher::processImage(std::shared_ptr<Image> patch) {
 
     auto device = std::dynamic_pointer_cast<OpenCLDevice>(getMainDevice());
 
-    if(fullDepth == 1) {
+    if(fullDepth == 1 && m_blending != PatchBlending::NONE) {
+        processImageWithBlending(patch);
+    } else if(fullDepth == 1) {
         // 2D
 		reportInfo() << "Stitching 2D data " << patch->getFrameData("patchid-x") << " " << patch->getFrameData("patchid-y")
 			<< reportEnd();
 
-        const int patchOverlapX = std::stoi(patch->getFrameData("patch-overlap-x"));
-        const int patchOverlapY = std::stoi(patch->getFrameData("patch-overlap-y"));
+        const int patchOverlapX = patch->getFrameData<int>("patch-overlap-x");
+        const int patchOverlapY = patch->getFrameData<int>("patch-overlap-y");
         // Calculate offset. If this calculation is incorrect. Update in ImagePyramidPatchExporter as well.
         // Position of where to insert the (cropped) patch
-        const int startX = std::stoi(patch->getFrameData("patchid-x")) * (std::stoi(patch->getFrameData("patch-width")) - patchOverlapX*2); // TODO + overlap to compensate for start offset
-        const int startY = std::stoi(patch->getFrameData("patchid-y")) * (std::stoi(patch->getFrameData("patch-height")) - patchOverlapY*2);
+        const int startX = patch->getFrameData<int>("patchid-x") * (patch->getFrameData<int>("patch-width") - patchOverlapX*2); // TODO + overlap to compensate for start offset
+        const int startY = patch->getFrameData<int>("patchid-y") * (patch->getFrameData<int>("patch-height") - patchOverlapY*2);
         if(m_outputImage) {
             // 2D image
             cl::Program program = getOpenCLProgram(device, "2D");
@@ -214,15 +317,23 @@ void PatchStitcher::processImage(std::shared_ptr<Image> patch) {
                 int diffY = patch->getHeight() - m_outputImagePyramid->getLevelTileHeight(0);
                 patch = patch->crop(Vector2i(diffX/2, diffY/2), Vector2i(patch->getWidth()-diffX, patch->getHeight()-diffY));
             }
-            outputAccess->setPatch(0, startX, startY, patch);
+            // Only the full resolution level is written here. The coarser levels are built once a row of patches is done,
+            // instead of updating them for every patch.
+            const int patchRow = patch->getFrameData<int>("patchid-y");
+            if(m_pyramidPatchRow >= 0 && patchRow != m_pyramidPatchRow)
+                outputAccess->updatePyramidLevels();
+            m_pyramidPatchRow = patchRow;
+            if(patch->getDataType() == TYPE_FLOAT)
+                patch = quantizePatch(patch, m_pyramidScale);
+            outputAccess->setPatch(0, startX, startY, patch, false);
             mRuntimeManager->stopRegularTimer("copy patch");
         }
     } else {
         // 3D
         // TODO overlap not implemented for 3D
-        const int startX = std::stoi(patch->getFrameData("patch-offset-x"));
-        const int startY = std::stoi(patch->getFrameData("patch-offset-y"));
-        const int startZ = std::stoi(patch->getFrameData("patch-offset-z"));
+        const int startX = patch->getFrameData<int>("patch-offset-x");
+        const int startY = patch->getFrameData<int>("patch-offset-y");
+        const int startZ = patch->getFrameData<int>("patch-offset-z");
         const int endX = startX + patch->getWidth();
         const int endY = startY + patch->getHeight();
         reportInfo() << "Stitching " << startZ << reportEnd();
@@ -298,6 +409,94 @@ void PatchStitcher::processImage(std::shared_ptr<Image> patch) {
     }
 }
 
+void PatchStitcher::processImageWithBlending(std::shared_ptr<Image> patch) {
+    if(m_patchesAreCropped)
+        throw Exception("PatchStitcher can't blend patches which are cropped");
+    const int fullWidth = patch->getFrameData<int>("original-width");
+    const int fullHeight = patch->getFrameData<int>("original-height");
+    const int overlapX = patch->getFrameData<int>("patch-overlap-x");
+    const int overlapY = patch->getFrameData<int>("patch-overlap-y");
+    const int patchWidth = patch->getWidth();
+    const int patchHeight = patch->getHeight();
+    const int channels = patch->getNrOfChannels();
+    m_blendedTileWidth = patch->getFrameData<int>("patch-width") - 2*overlapX;
+    m_blendedTileHeight = patch->getFrameData<int>("patch-height") - 2*overlapY;
+    if(m_blendingWindowX.size() != patchWidth || m_blendingWindowY.size() != patchHeight) {
+        m_blendingWindowX = createBlendingWindow(m_blending, patchWidth, overlapX);
+        m_blendingWindowY = createBlendingWindow(m_blending, patchHeight, overlapY);
+    }
+
+    // Position of the patch in the full image, including overlap
+    const int originX = patch->getFrameData<int>("patchid-x")*m_blendedTileWidth - overlapX;
+    const int originY = patch->getFrameData<int>("patchid-y")*m_blendedTileHeight - overlapY;
+    const int firstTileX = std::max(originX, 0) / m_blendedTileWidth;
+    const int firstTileY = std::max(originY, 0) / m_blendedTileHeight;
+    const int lastTileX = (std::min(originX + patchWidth, fullWidth) - 1) / m_blendedTileWidth;
+    const int lastTileY = (std::min(originY + patchHeight, fullHeight) - 1) / m_blendedTileHeight;
+
+    // Patches arrive in row order, thus later patches can't overlap the tile rows above this patch
+    finalizeBlendedTiles(firstTileY - 1);
+
+    mRuntimeManager->startRegularTimer("blend patch");
+    auto access = patch->getImageAccess(ACCESS_READ);
+    const std::size_t tileSize = (std::size_t)m_blendedTileWidth*m_blendedTileHeight;
+    for(int tileY = firstTileY; tileY <= lastTileY; ++tileY) {
+        for(int tileX = firstTileX; tileX <= lastTileX; ++tileX) {
+            auto& tile = m_blendedTiles[std::make_pair(tileY, tileX)];
+            if(!tile.sum) {
+                tile.sum = std::make_unique<float[]>(tileSize*channels); // Initialized to zeros
+                tile.weight = std::make_unique<float[]>(tileSize);
+            }
+            // Region of the patch which covers this tile
+            const int startX = std::max(tileX*m_blendedTileWidth, originX) - originX;
+            const int startY = std::max(tileY*m_blendedTileHeight, originY) - originY;
+            const int endX = std::min({(tileX + 1)*m_blendedTileWidth, originX + patchWidth, fullWidth}) - originX;
+            const int endY = std::min({(tileY + 1)*m_blendedTileHeight, originY + patchHeight, fullHeight}) - originY;
+            const int offset = (startX + originX - tileX*m_blendedTileWidth) + (startY + originY - tileY*m_blendedTileHeight)*m_blendedTileWidth;
+            switch(patch->getDataType()) {
+                fastSwitchTypeMacro(accumulatePatch<FAST_TYPE>((const FAST_TYPE*)access->get(), patchWidth, channels,
+                                                               startX, endX, startY, endY,
+                                                               m_blendingWindowX.data(), m_blendingWindowY.data(),
+                                                               tile.sum.get() + offset*channels, tile.weight.get() + offset, m_blendedTileWidth));
+            }
+        }
+    }
+    mRuntimeManager->stopRegularTimer("blend patch");
+}
+
+void PatchStitcher::finalizeBlendedTiles(int lastTileRow) {
+    bool tilesWritten = false;
+    while(!m_blendedTiles.empty() && m_blendedTiles.begin()->first.first <= lastTileRow) {
+        const int tileX = m_blendedTiles.begin()->first.second;
+        const int tileY = m_blendedTiles.begin()->first.first;
+        const auto& tile = m_blendedTiles.begin()->second;
+        const int x = tileX*m_blendedTileWidth;
+        const int y = tileY*m_blendedTileHeight;
+        if(m_outputImagePyramid) {
+            const int channels = m_outputImagePyramid->getNrOfChannels();
+            auto data = std::make_unique<uchar[]>(m_blendedTileWidth*m_blendedTileHeight*channels);
+            normalizeBlendedTile(tile.sum.get(), tile.weight.get(), m_blendedTileWidth, channels, m_blendedTileWidth, m_blendedTileHeight, data.get(), m_blendedTileWidth, m_pyramidScale);
+            auto image = Image::create(m_blendedTileWidth, m_blendedTileHeight, TYPE_UINT8, channels, data.get());
+            m_outputImagePyramid->getAccess(ACCESS_READ_WRITE)->setPatch(0, x, y, image, false);
+        } else {
+            const int channels = m_outputImage->getNrOfChannels();
+            const int width = std::min(m_blendedTileWidth, m_outputImage->getWidth() - x);
+            const int height = std::min(m_blendedTileHeight, m_outputImage->getHeight() - y);
+            auto access = m_outputImage->getImageAccess(ACCESS_READ_WRITE);
+            const std::size_t offset = ((std::size_t)y*m_outputImage->getWidth() + x)*channels;
+            switch(m_outputImage->getDataType()) {
+                fastSwitchTypeMacro(normalizeBlendedTile(tile.sum.get(), tile.weight.get(), m_blendedTileWidth, channels, width, height,
+                                                         (FAST_TYPE*)access->get() + offset, m_outputImage->getWidth(), 1.0f));
+            }
+        }
+        m_blendedTiles.erase(m_blendedTiles.begin());
+        tilesWritten = true;
+    }
+    // Update the coarser levels of the pyramid with the finished rows
+    if(tilesWritten && m_outputImagePyramid)
+        m_outputImagePyramid->getAccess(ACCESS_READ_WRITE)->updatePyramidLevels();
+}
+
 void PatchStitcher::setPatchesAreCropped(bool cropped) {
     m_patchesAreCropped = cropped;
     setModified(true);
@@ -307,5 +506,23 @@ bool PatchStitcher::getPatchesAreCropped() const {
     return m_patchesAreCropped;
 }
 
+void PatchStitcher::setOutputFilename(std::string filename) {
+    m_outputFilename = filename;
+    setModified(true);
+}
+
+std::string PatchStitcher::getOutputFilename() const {
+    return m_outputFilename;
+}
+
+void PatchStitcher::setBlending(PatchBlending blending) {
+    m_blending = blending;
+    setModified(true);
+}
+
+PatchBlending PatchStitcher::getBlending() const {
+    return m_blending;
+}
+
 
 }
\ No newline at end of file
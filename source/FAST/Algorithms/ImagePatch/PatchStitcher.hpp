@@ -8,11 +8,33 @@ class Image;
 class ImagePyramid;
 class Tensor;
 
+/**
+ * @brief Weighting window used by PatchStitcher to blend overlapping patches
+ */
+enum class PatchBlending {
+    NONE, // Overlapping regions are cropped away
+    LINEAR, // Weights taper linearly towards the patch border across the overlap
+    GAUSSIAN, // Gaussian weights centered in the patch, with sigma 1/8 of the patch size
+};
+
 /**
  * @brief Stitch a stream of processed patches from the PatchGenerator
  *
  * This process object stitches a stream of processed Image/Tensor patches into an
  * ImagePyramid, 2D or 3D Image or Tensor depending on the patch source.
+ * When stitching into an ImagePyramid, the coarser levels of the pyramid are updated
+ * each time a row of patches is done, and when the last patch arrives.
+ *
+ * Image pyramids store 8 bit data. Thus when stitching into an ImagePyramid, float patches, such as probability maps,
+ * are quantized to uint8 by scaling [0, 1] to [0, 255] and rounding. Other data types than uint8 and float are not supported.
+ *
+ * If an output filename is given, 2D image patches are streamed directly to a tiled TIFF image pyramid
+ * at this path, regardless of the image size. Each patch is written to disk as soon as it arrives, and only the
+ * current row of patches is kept in memory, thus the full size image is never allocated.
+ *
+ * With blending enabled, the overlapping regions of 2D image patches are not thrown away. Instead a weighted sum
+ * and sum of weights is accumulated for each output tile. When no more patches can overlap a row of tiles,
+ * the tiles are normalized, written to the output and released.
  *
  * Inputs:
  * 0 - Image/Tensor: A stream of processed patches from PatchGenerator
@@ -27,9 +49,16 @@ class FAST_EXPORT PatchStitcher : public ProcessObject {
     public:
         /**
          * @brief Create instance
+         * @param patchesAreCropped Whether incoming patches are already cropped or not
+         * @param outputFilename If set, stream 2D image patches to a TIFF image pyramid with this filename
+         * @param blending Weighting window used to blend overlapping 2D image patches
          * @return instance
          */
-        FAST_CONSTRUCTOR(PatchStitcher, bool, patchesAreCropped, = false);
+        FAST_CONSTRUCTOR(PatchStitcher,
+                         bool, patchesAreCropped, = false,
+                         std::string, outputFilename, = "",
+                         PatchBlending, blending, = PatchBlending::NONE
+        );
         void loadAttributes() override;
         /**
          * @brief Set whether incoming patches are cropped or not
@@ -41,6 +70,24 @@ class FAST_EXPORT PatchStitcher : public ProcessObject {
          * @param cropped
          */
         bool getPatchesAreCropped() const;
+        /**
+         * @brief Stream stitched 2D image patches to a TIFF image pyramid file
+         *
+         * Patches are written to disk as they arrive, instead of being stitched in memory.
+         * Only supports 2D uint8 and float image patches with 1-4 channels. The file stores 8 bit data, thus float patches,
+         * such as probability maps, are quantized: values in [0, 1] are scaled to [0, 255] and rounded.
+         * @param filename Filename of TIFF file. Set to empty string to disable.
+         */
+        void setOutputFilename(std::string filename);
+        std::string getOutputFilename() const;
+        /**
+         * @brief Blend overlapping regions of 2D image patches with a weighting window
+         *
+         * Requires patches from PatchGenerator with overlap, which are not cropped.
+         * @param blending
+         */
+        void setBlending(PatchBlending blending);
+        PatchBlending getBlending() const;
     protected:
         void execute() override;
 
@@ -50,8 +97,27 @@ class FAST_EXPORT PatchStitcher : public ProcessObject {
 
         void processTensor(std::shared_ptr<Tensor> tensor);
         void processImage(std::shared_ptr<Image> tensor);
+        void processImageWithBlending(std::shared_ptr<Image> patch);
+        void finalizeBlendedTiles(int lastTileRow);
     private:
         bool m_patchesAreCropped = false;
+        std::string m_outputFilename;
+        PatchBlending m_blending = PatchBlending::NONE;
+        // Weighted sum of values and weights of output tiles still being blended, indexed by tile (y, x)
+        struct BlendedTile {
+            std::unique_ptr<float[]> sum;
+            std::unique_ptr<float[]> weight;
+        };
+        std::map<std::pair<int, int>, BlendedTile> m_blendedTiles;
+        std::vector<float> m_blendingWindowX;
+        std::vector<float> m_blendingWindowY;
+        // Output tile size, which is the patch size without overlap
+        int m_blendedTileWidth;
+        int m_blendedTileHeight;
+        // Current row of patches written to the image pyramid
+        int m_pyramidPatchRow = -1;
+        // Scale of values when quantizing float patches for the image pyramid
+        float m_pyramidScale = 1.0f;
 
 };
 
@@ -8,8 +8,12 @@
 #include <FAST/Algorithms/ImagePatch/PatchGenerator.hpp>
 #include <FAST/Algorithms/ImagePatch/PatchStitcher.hpp>
 #include <FAST/Algorithms/ImagePatch/ImageToBatchGenerator.hpp>
+#include <FAST/Algorithms/ImagePatch/BatchSplitter.hpp>
 #include <FAST/Algorithms/NeuralNetwork/NeuralNetwork.hpp>
 #include <FAST/Importers/ImageFileImporter.hpp>
+#include <FAST/Importers/TIFFImagePyramidImporter.hpp>
+#include <FAST/Algorithms/ImageCaster/ImageCaster.hpp>
+#include <cstdio>
 #include <FAST/Visualization/VolumeRenderer/AlphaBlendingVolumeRenderer.hpp>
 
 using namespace fast;
@@ -37,6 +41,31 @@ TEST_CASE("Patch generator for WSI", "[fast][wsi][PatchGenerator]") {
     REQUIRE(nrOfPatches == counter);
 }
 
+TEST_CASE("Patch generator for WSI with multiple workers", "[fast][wsi][PatchGenerator]") {
+    auto importer = WholeSlideImageImporter::create(Config::getTestDataPath() + "/WSI/A05.svs");
+    auto wsi = importer->runAndGetOutputData<ImagePyramid>();
+
+    const int level = 2;
+    const int width = 256;
+    const int height = 256;
+    auto generator = PatchGenerator::create(width, height, 1, level, -1, 0.0f, 0.5f, -1, 4)
+            ->connect(wsi);
+    auto stream = DataStream(generator);
+    const int patchesX = std::ceil((float)wsi->getLevelWidth(level)/width);
+    const int nrOfPatches = patchesX*std::ceil((float)wsi->getLevelHeight(level)/height);
+    int counter = 0;
+    while(!stream.isDone()) {
+        auto image = stream.getNextFrame<Image>();
+        REQUIRE(image->getWidth() == width);
+        REQUIRE(image->getHeight() == height);
+        // Patches should arrive in raster order
+        REQUIRE(image->getFrameData<int>("patchid-x") == counter % patchesX);
+        REQUIRE(image->getFrameData<int>("patchid-y") == counter / patchesX);
+        ++counter;
+    }
+    REQUIRE(nrOfPatches == counter);
+}
+
 TEST_CASE("Patch generator on 2D image", "[fast][PatchGenerator]") {
     auto importer = ImageFileImporter::create(Config::getTestDataPath() + "/US/US-2D.jpg");
     auto image = importer->runAndGetOutputData<Image>();
@@ -147,6 +176,85 @@ TEST_CASE("Patch generator and stitcher for WSI", "[fast][wsi][PatchStitcher][vi
     window->start();
 }
 
+TEST_CASE("Patch stitcher with blending of overlapping patches reproduces image", "[fast][PatchStitcher]") {
+    auto importer = ImageFileImporter::create(Config::getTestDataPath() + "/US/US-2D.jpg");
+    auto image = importer->runAndGetOutputData<Image>();
+
+    for(auto blending : {PatchBlending::LINEAR, PatchBlending::GAUSSIAN}) {
+        // Patches are not modified, thus the weighted average of overlapping patches should be equal to the image
+        auto generator = PatchGenerator::create(64, 64, 1, 0, -1, 0.125f)
+                ->connect(importer);
+        auto stitcher = PatchStitcher::create(false, "", blending)
+                ->connect(generator);
+        auto stream = DataStream(stitcher);
+        Image::pointer result;
+        while(!stream.isDone())
+            result = stream.getNextFrame<Image>();
+        REQUIRE(result->getWidth() == image->getWidth());
+        REQUIRE(result->getHeight() == image->getHeight());
+        REQUIRE(result->getNrOfChannels() == image->getNrOfChannels());
+        auto resultAccess = result->getImageAccess(ACCESS_READ);
+        auto imageAccess = image->getImageAccess(ACCESS_READ);
+        CHECK(std::memcmp(resultAccess->get(), imageAccess->get(), image->getWidth()*image->getHeight()*image->getNrOfChannels()) == 0);
+    }
+}
+
+TEST_CASE("Patch stitcher streams WSI patches to TIFF file", "[fast][wsi][PatchStitcher]") {
+    auto importer = WholeSlideImageImporter::create(Config::getTestDataPath() + "/WSI/A05.svs");
+    auto pyramid = importer->runAndGetOutputData<ImagePyramid>();
+
+    const std::string filename = "patch-stitcher-stream-test.tiff";
+    auto generator = PatchGenerator::create(512, 512, 1, 1)
+            ->connect(importer);
+    auto stitcher = PatchStitcher::create(false, filename)
+            ->connect(generator);
+    auto stream = DataStream(stitcher);
+    ImagePyramid::pointer result;
+    while(!stream.isDone())
+        result = stream.getNextFrame<ImagePyramid>();
+    CHECK(result->getTIFFPath() == filename);
+    CHECK(result->getFullWidth() == pyramid->getLevelWidth(1));
+    CHECK(result->getFullHeight() == pyramid->getLevelHeight(1));
+
+    // Tiles read back from the file should be equal to the stitched tiles
+    auto wsi = TIFFImagePyramidImporter::create(filename)->runAndGetOutputData<ImagePyramid>();
+    REQUIRE(wsi->getNrOfLevels() == result->getNrOfLevels());
+    for(int level = 0; level < wsi->getNrOfLevels(); ++level) {
+        const int x = (wsi->getLevelTilesX(level) / 2)*wsi->getLevelTileWidth(level);
+        const int y = (wsi->getLevelTilesY(level) / 2)*wsi->getLevelTileHeight(level);
+        auto expected = result->getAccess(ACCESS_READ)->getPatchData(level, x, y, 256, 256);
+        auto data = wsi->getAccess(ACCESS_READ)->getPatchData(level, x, y, 256, 256);
+        CHECK(std::memcmp(expected.get(), data.get(), 256*256*wsi->getNrOfChannels()) == 0);
+    }
+}
+
+TEST_CASE("Patch stitcher quantizes float patches streamed to TIFF file", "[fast][PatchStitcher]") {
+    auto image = ImageFileImporter::create(Config::getTestDataPath() + "US/US-2D.jpg")->runAndGetOutputData<Image>();
+    const int width = image->getWidth();
+    const int height = image->getHeight();
+    const int channels = image->getNrOfChannels();
+    for(auto blending : {PatchBlending::NONE, PatchBlending::LINEAR}) {
+        // Probability map like patches with values in [0, 1]
+        const std::string filename = "patch-stitcher-float-stream-test.tiff";
+        auto generator = PatchGenerator::create(64, 64, 1, 0, -1, 0.125f)->connect(image);
+        auto caster = ImageCaster::create(TYPE_FLOAT, 1.0f/255.0f)->connect(generator);
+        auto stitcher = PatchStitcher::create(false, filename, blending)->connect(caster);
+        auto stream = DataStream(stitcher);
+        ImagePyramid::pointer result;
+        while(!stream.isDone())
+            result = stream.getNextFrame<ImagePyramid>();
+        REQUIRE(result->getFullWidth() == width);
+        REQUIRE(result->getFullHeight() == height);
+
+        // Quantizing the probabilities to 8 bit gives the original image
+        auto wsi = TIFFImagePyramidImporter::create(filename)->runAndGetOutputData<ImagePyramid>();
+        auto data = wsi->getAccess(ACCESS_READ)->getPatchData(0, 0, 0, width, height);
+        auto access = image->getImageAccess(ACCESS_READ);
+        CHECK(std::memcmp(access->get(), data.get(), width*height*channels) == 0);
+        std::remove(filename.c_str());
+    }
+}
+
 TEST_CASE("Patch generator, sticher and image to batch generator for WSI", "[fast][wsi][ImageToBatchGenerator]") {
     auto importer = WholeSlideImageImporter::create(Config::getTestDataPath() + "/WSI/A05.svs");
 
@@ -163,4 +271,29 @@ TEST_CASE("Patch generator, sticher and image to batch generator for WSI", "[fas
         std::cout << "Got a batch" << std::endl;
     }
     std::cout << "Done" << std::endl;
-}
\ No newline at end of file
+}
+
+TEST_CASE("Image to batch generator with max latency and batch splitter", "[fast][ImageToBatchGenerator][BatchSplitter]") {
+    auto importer = ImageFileImporter::create(Config::getTestDataPath() + "/US/US-2D.jpg");
+    auto image = importer->runAndGetOutputData<Image>();
+
+    const int width = 33;
+    const int height = 33;
+    const int nrOfPatches = std::ceil((float)image->getWidth()/width)*std::ceil((float)image->getHeight()/height);
+    auto generator = PatchGenerator::create(width, height)
+            ->connect(importer);
+    auto batchGenerator = ImageToBatchGenerator::create(8, 5.0f)
+            ->connect(generator);
+    auto splitter = BatchSplitter::create()
+            ->connect(batchGenerator);
+
+    auto stream = DataStream(splitter);
+    int counter = 0;
+    while(!stream.isDone()) {
+        auto patch = stream.getNextFrame<Image>();
+        REQUIRE(patch->getWidth() == width);
+        CHECK(patch->hasFrameData("patchid-x"));
+        ++counter;
+    }
+    REQUIRE(nrOfPatches == counter);
+}
@@ -40,8 +40,8 @@ __kernel void sharpen(
     if(outputDataType == CLK_FLOAT) {
         write_imagef(output, pos, result);
     } else if(outputDataType == CLK_UNSIGNED_INT8 || outputDataType == CLK_UNSIGNED_INT16) {
-        write_imageui(output, pos, convert_uint4(round(result)));
+        write_imageui(output, pos, convert_uint4_sat(round(result)));
     } else {
-        write_imagei(output, pos, convert_int4(round(result)));
+        write_imagei(output, pos, convert_int4_sat(round(result)));
     }
 }
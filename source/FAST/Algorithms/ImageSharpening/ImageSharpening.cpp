@@ -1,4 +1,5 @@
 #include "ImageSharpening.hpp"
+#include <FAST/Utility.hpp>
 
 namespace fast {
 
@@ -18,6 +19,64 @@ void ImageSharpening::setGain(float gain) {
     setModified(true);
 }
 
+template <class InputType, class OutputType>
+static void executeAlgorithmOnHost(Image::pointer input, Image::pointer output, int halfSize, float stdDev, float gain) {
+    auto inputAccess = input->getImageAccess(ACCESS_READ);
+    auto outputAccess = output->getImageAccess(ACCESS_READ_WRITE);
+    const InputType* inputData = (const InputType*)inputAccess->get();
+    OutputType* outputData = (OutputType*)outputAccess->get();
+    const int width = input->getWidth();
+    const int height = input->getHeight();
+    const int channels = input->getNrOfChannels();
+    const int maskSize = halfSize*2 + 1;
+
+    // Same weights and summation order as the OpenCL kernel
+    std::vector<float> mask(maskSize*maskSize);
+    for(int x = -halfSize; x <= halfSize; ++x) {
+        for(int y = -halfSize; y <= halfSize; ++y) {
+            mask[(x + halfSize)*maskSize + y + halfSize] = exp(-(float)(x*x+y*y)/(2.0f*stdDev*stdDev));
+        }
+    }
+    float gaussianSum = 0.0f;
+    for(float weight : mask)
+        gaussianSum += weight;
+
+    #pragma omp parallel for
+    for(int y = 0; y < height; ++y) {
+        std::vector<float> sum(channels);
+        for(int x = 0; x < width; ++x) {
+            std::fill(sum.begin(), sum.end(), 0.0f);
+            for(int a = -halfSize; a <= halfSize; ++a) {
+                // Clamp to edge, same as the sampler of the OpenCL kernel
+                const int nx = std::min(std::max(x + a, 0), width - 1);
+                for(int b = -halfSize; b <= halfSize; ++b) {
+                    const int ny = std::min(std::max(y + b, 0), height - 1);
+                    const float weight = mask[(a + halfSize)*maskSize + b + halfSize];
+                    const InputType* pixel = &inputData[(nx + ny*width)*channels];
+                    for(int c = 0; c < channels; ++c)
+                        sum[c] += weight*(float)pixel[c];
+                }
+            }
+            for(int c = 0; c < channels; ++c) {
+                const float pixel = inputData[(x + y*width)*channels + c];
+                const float result = pixel + gain*(pixel - sum[c]/gaussianSum);
+                if constexpr(std::is_floating_point<OutputType>::value) {
+                    outputData[(x + y*width)*channels + c] = result;
+                } else {
+                    outputData[(x + y*width)*channels + c] = saturate_cast<OutputType>(std::round(result));
+                }
+            }
+        }
+    }
+}
+
+template <class InputType>
+static void executeAlgorithmOnHost(Image::pointer input, Image::pointer output, int halfSize, float stdDev, float gain) {
+    switch(output->getDataType()) {
+        fastSwitchTypeMacro((executeAlgorithmOnHost<InputType, FAST_TYPE>(input, output, halfSize, stdDev, gain)));
+    }
+}
+
 void ImageSharpening::execute() {
     auto input = getInputData<Image>(0);
 
@@ -43,9 +102,16 @@ void ImageSharpening::execute() {
     mOutputType = output->getDataType();
     SceneGraph::setParentNode(output, input);
 
-	auto clDevice = std::static_pointer_cast<OpenCLDevice>(getMainDevice());
-
     const auto halfSize = (maskSize-1)/2;
+    if(getMainDevice()->isHost()) {
+        switch(input->getDataType()) {
+            fastSwitchTypeMacro(executeAlgorithmOnHost<FAST_TYPE>(input, output, halfSize, mStdDev, m_gain));
+        }
+        addOutputData(0, output);
+        return;
+    }
+
+	auto clDevice = std::static_pointer_cast<OpenCLDevice>(getMainDevice());
     cl::Kernel kernel(getOpenCLProgram(clDevice, "", "-DHALF_SIZE=" + std::to_string(halfSize)), "sharpen");
 
 	auto inputAccess = input->getOpenCLImageAccess(ACCESS_READ, clDevice);
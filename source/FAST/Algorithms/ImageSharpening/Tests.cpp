@@ -1,14 +1,19 @@
 #include <FAST/Testing.hpp>
 #include <FAST/Algorithms/ImageSharpening/ImageSharpening.hpp>
+#include <FAST/Importers/ImageFileImporter.hpp>
+#include <FAST/Data/Image.hpp>
+#ifdef FAST_MODULE_WSI
 #include <FAST/Importers/ImageImporter.hpp>
 #include <FAST/Visualization/ImageRenderer/ImageRenderer.hpp>
 #include <FAST/Visualization/DualViewWindow.hpp>
 #include <FAST/Importers/WholeSlideImageImporter.hpp>
 #include <FAST/Algorithms/ImagePatch/PatchGenerator.hpp>
 #include <FAST/Algorithms/TissueSegmentation/TissueSegmentation.hpp>
+#endif
 
 using namespace fast;
 
+#ifdef FAST_MODULE_WSI
 TEST_CASE("Image sharpen", "[fast][ImageSharpening][visual]") {
 	auto importer = WholeSlideImageImporter::New();
 	importer->setFilename(Config::getTestDataPath() + "/WSI/A05.svs");
@@ -41,4 +46,31 @@ TEST_CASE("Image sharpen", "[fast][ImageSharpening][visual]") {
 	window->run();
 	filter->getRuntime()->print();
 
-}
\ No newline at end of file
+}
+#endif
+
+TEST_CASE("ImageSharpening on Host gives same result as OpenCL", "[fast][ImageSharpening]") {
+    auto image = ImageFileImporter::create(Config::getTestDataPath() + "US/Heart/ApicalFourChamber/US-2D_0.mhd")
+            ->runAndGetOutputData<Image>();
+
+    for(DataType outputType : {TYPE_UINT8, TYPE_FLOAT}) {
+        auto sharpening = ImageSharpening::create(1.5f, 1.0f)->connect(image);
+        sharpening->setOutputType(outputType);
+        auto result = sharpening->runAndGetOutputData<Image>();
+
+        auto hostSharpening = ImageSharpening::create(1.5f, 1.0f)->connect(image);
+        hostSharpening->setOutputType(outputType);
+        hostSharpening->setMainDevice(Host::getInstance());
+        auto hostResult = hostSharpening->runAndGetOutputData<Image>();
+
+        REQUIRE(hostResult->getSize() == result->getSize());
+        REQUIRE(hostResult->getDataType() == result->getDataType());
+        auto access = result->getImageAccess(ACCESS_READ);
+        auto hostAccess = hostResult->getImageAccess(ACCESS_READ);
+        // The Gaussian weights are computed with the exp function of the device, thus results may differ slightly
+        float maxDifference = 0.0f;
+        for(int i = 0; i < result->getNrOfVoxels(); ++i)
+            maxDifference = std::max(maxDifference, std::fabs(access->getScalar(i) - hostAccess->getScalar(i)));
+        CHECK(maxDifference <= (outputType == TYPE_UINT8 ? 1.0f : 0.01f));
+    }
+}
@@ -1,5 +1,6 @@
 #include "IntensityClipping.hpp"
 #include <FAST/Data/Image.hpp>
+#include <FAST/Utility.hpp>
 
 namespace fast {
 
@@ -29,10 +30,31 @@ void IntensityClipping::setMaxValue(float value) {
     setModified(true);
 }
 
+template <class T>
+static void executeAlgorithmOnHost(Image::pointer input, Image::pointer output, float min, float max) {
+    auto inputAccess = input->getImageAccess(ACCESS_READ);
+    auto outputAccess = output->getImageAccess(ACCESS_READ_WRITE);
+    const T* inputData = (const T*)inputAccess->get();
+    T* outputData = (T*)outputAccess->get();
+
+    const int64_t size = (int64_t)input->getWidth()*input->getHeight()*input->getDepth()*input->getNrOfChannels();
+    #pragma omp parallel for
+    for(int64_t i = 0; i < size; ++i) {
+        outputData[i] = saturate_cast<T>(std::min(std::max((float)inputData[i], min), max));
+    }
+}
+
 void IntensityClipping::execute() {
     auto input = getInputData<Image>();
     auto output = Image::createFromImage(input);
     output->setSpacing(input->getSpacing());
+    if(getMainDevice()->isHost()) {
+        switch(input->getDataType()) {
+            fastSwitchTypeMacro(executeAlgorithmOnHost<FAST_TYPE>(input, output, m_min, m_max));
+        }
+        addOutputData(0, output);
+        return;
+    }
     auto device = std::dynamic_pointer_cast<OpenCLDevice>(getMainDevice());
 
     auto queue = device->getCommandQueue();
@@ -0,0 +1,31 @@
+#include <FAST/Testing.hpp>
+#include <FAST/Algorithms/IntensityClipping/IntensityClipping.hpp>
+#include <FAST/Importers/ImageFileImporter.hpp>
+#include <FAST/Data/Image.hpp>
+
+using namespace fast;
+
+TEST_CASE("IntensityClipping on Host gives same result as OpenCL", "[fast][IntensityClipping]") {
+    auto uint8Image = ImageFileImporter::create(Config::getTestDataPath() + "US/Heart/ApicalFourChamber/US-2D_0.mhd")
+            ->runAndGetOutputData<Image>();
+    const int width = 64;
+    const int height = 48;
+    auto floatData = std::make_unique<float[]>(width*height);
+    for(int i = 0; i < width*height; ++i)
+        floatData[i] = (float)(i % 400) - 50.0f;
+    auto floatImage = Image::create(width, height, TYPE_FLOAT, 1, floatData.get());
+
+    for(auto image : {uint8Image, floatImage}) {
+        auto result = IntensityClipping::create(50, 150)->connect(image)->runAndGetOutputData<Image>();
+
+        auto hostClipping = IntensityClipping::create(50, 150)->connect(image);
+        hostClipping->setMainDevice(Host::getInstance());
+        auto hostResult = hostClipping->runAndGetOutputData<Image>();
+
+        REQUIRE(hostResult->getSize() == result->getSize());
+        REQUIRE(hostResult->getDataType() == image->getDataType());
+        auto access = result->getImageAccess(ACCESS_READ);
+        auto hostAccess = hostResult->getImageAccess(ACCESS_READ);
+        CHECK(std::memcmp(access->get(), hostAccess->get(), getSizeOfDataType(image->getDataType(), image->getNrOfChannels())*image->getNrOfVoxels()) == 0);
+    }
+}
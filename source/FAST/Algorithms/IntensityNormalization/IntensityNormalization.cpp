@@ -23,6 +23,21 @@ void IntensityNormalization::setHighestValue(float value) {
     setModified(true);
 }
 
+template <class T>
+static void executeAlgorithmOnHost(Image::pointer input, Image::pointer output, float min, float max, float low, float high) {
+    auto inputAccess = input->getImageAccess(ACCESS_READ);
+    auto outputAccess = output->getImageAccess(ACCESS_READ_WRITE);
+    const T* inputData = (const T*)inputAccess->get();
+    float* outputData = (float*)outputAccess->get();
+
+    const int64_t size = (int64_t)input->getWidth()*input->getHeight()*input->getDepth()*input->getNrOfChannels();
+    #pragma omp parallel for
+    for(int64_t i = 0; i < size; ++i) {
+        const float value = ((float)inputData[i] - min) / (max - min);
+        outputData[i] = value*(high - low) + low;
+    }
+}
+
 void IntensityNormalization::execute() {
     if(mHigh <= mLow)
         throw Exception("The high value must be higher than the low value in IntensityNormalization.");
@@ -42,6 +57,16 @@ void IntensityNormalization::execute() {
     if(std::isnan(maximum)) {
         maximum = input->calculateMaximumIntensity();
     }
+    if(getMainDevice()->isHost()) {
+        auto output = Image::create(input->getSize(), TYPE_FLOAT, input->getNrOfChannels());
+        switch(input->getDataType()) {
+            fastSwitchTypeMacro(executeAlgorithmOnHost<FAST_TYPE>(input, output, minimum, maximum, mLow, mHigh));
+        }
+        output->setSpacing(input->getSpacing());
+        SceneGraph::setParentNode(output, input);
+        addOutputData(0, output);
+        return;
+    }
     OpenCLDevice::pointer device = std::dynamic_pointer_cast<OpenCLDevice>(getMainDevice());
     cl::Program program = getOpenCLProgram(device);
     cl::Kernel kernel;
@@ -70,6 +70,29 @@ TEST_CASE("IntensityNormalization image 3D with high and low set", "[fast][Inten
     CHECK(result->calculateMaximumIntensity() == Approx(10));
 }
 
+TEST_CASE("IntensityNormalization on Host gives same result as OpenCL", "[fast][IntensityNormalization]") {
+    auto image = ImageFileImporter::create(Config::getTestDataPath() + "/CT/CT-Abdomen.mhd")
+            ->runAndGetOutputData<Image>();
+
+    auto normalize = IntensityNormalization::create(-2, 10)->connect(image);
+    auto result = normalize->runAndGetOutputData<Image>();
+
+    auto hostNormalize = IntensityNormalization::create(-2, 10)->connect(image);
+    hostNormalize->setMainDevice(Host::getInstance());
+    auto hostResult = hostNormalize->runAndGetOutputData<Image>();
+
+    REQUIRE(hostResult->getSize() == result->getSize());
+    REQUIRE(hostResult->getDataType() == TYPE_FLOAT);
+    auto access = result->getImageAccess(ACCESS_READ);
+    auto hostAccess = hostResult->getImageAccess(ACCESS_READ);
+    const float* data = (const float*)access->get();
+    const float* hostData = (const float*)hostAccess->get();
+    for(int i = 0; i < result->getNrOfVoxels(); ++i) {
+        if(data[i] != Approx(hostData[i]))
+            FAIL("Voxel " + std::to_string(i) + " is different: " + std::to_string(data[i]) + " " + std::to_string(hostData[i]));
+    }
+}
+
 TEST_CASE("ZeroMeanUnitVariance 2D", "[fast][ZeroMeanUnitVariance]") {
     auto importer = ImageFileImporter::create(Config::getTestDataPath() + "US/CarotidArtery/Right/US-2D_0.mhd");
 
@@ -26,6 +26,50 @@ void Dilation::setStructuringElementSize(int size) {
     mSize = size;
 }
 
+// Dilation is done by gathering instead of scattering as in the OpenCL kernel, so that each output pixel
+// is written by only one thread. The result is the same.
+static void executeAlgorithmOnHost(Image::pointer input, Image::pointer output, int size) {
+    auto inputAccess = input->getImageAccess(ACCESS_READ);
+    auto outputAccess = output->getImageAccess(ACCESS_READ_WRITE);
+    const uchar* inputData = (const uchar*)inputAccess->get();
+    uchar* outputData = (uchar*)outputAccess->get();
+    const int width = input->getWidth();
+    const int height = input->getHeight();
+    const int depth = input->getDepth();
+
+    // Offsets of disk/sphere structuring element
+    std::vector<Vector3i> offsets;
+    for(int c = (depth > 1 ? -size : 0); c <= (depth > 1 ? size : 0); ++c) {
+        for(int b = -size; b <= size; ++b) {
+            for(int a = -size; a <= size; ++a) {
+                if(a*a + b*b + c*c <= size*size)
+                    offsets.push_back(Vector3i(a, b, c));
+            }
+        }
+    }
+
+    #pragma omp parallel for
+    for(int z = 0; z < depth; ++z) {
+        for(int y = 0; y < height; ++y) {
+            for(int x = 0; x < width; ++x) {
+                uchar value = 0;
+                for(const auto& offset : offsets) {
+                    const int nx = x + offset.x();
+                    const int ny = y + offset.y();
+                    const int nz = z + offset.z();
+                    if(nx < 0 || ny < 0 || nz < 0 || nx >= width || ny >= height || nz >= depth)
+                        continue;
+                    if(inputData[nx + ny*width + nz*width*height] == 1) {
+                        value = 1;
+                        break;
+                    }
+                }
+                outputData[x + y*width + z*width*height] = value;
+            }
+        }
+    }
+}
+
 void Dilation::execute() {
     auto input = getInputData<Image>();
     if(input->getDataType() != TYPE_UINT8) {
@@ -34,6 +78,12 @@ void Dilation::execute() {
 
     auto output = Image::createFromImage(input);
     SceneGraph::setParentNode(output, input);
+
+    if(getMainDevice()->isHost()) {
+        executeAlgorithmOnHost(input, output, mSize / 2);
+        addOutputData(0, output);
+        return;
+    }
     output->fill(0);
 
     OpenCLDevice::pointer device = std::dynamic_pointer_cast<OpenCLDevice>(getMainDevice());
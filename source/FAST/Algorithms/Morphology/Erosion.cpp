@@ -26,6 +26,50 @@ void Erosion::setStructuringElementSize(int size) {
     mSize = size;
 }
 
+static void executeAlgorithmOnHost(Image::pointer input, Image::pointer output, int size) {
+    auto inputAccess = input->getImageAccess(ACCESS_READ);
+    auto outputAccess = output->getImageAccess(ACCESS_READ_WRITE);
+    const uchar* inputData = (const uchar*)inputAccess->get();
+    uchar* outputData = (uchar*)outputAccess->get();
+    const int width = input->getWidth();
+    const int height = input->getHeight();
+    const int depth = input->getDepth();
+
+    // Offsets of disk/sphere structuring element
+    std::vector<Vector3i> offsets;
+    for(int c = (depth > 1 ? -size : 0); c <= (depth > 1 ? size : 0); ++c) {
+        for(int b = -size; b <= size; ++b) {
+            for(int a = -size; a <= size; ++a) {
+                if(a*a + b*b + c*c <= size*size)
+                    offsets.push_back(Vector3i(a, b, c));
+            }
+        }
+    }
+
+    #pragma omp parallel for
+    for(int z = 0; z < depth; ++z) {
+        for(int y = 0; y < height; ++y) {
+            for(int x = 0; x < width; ++x) {
+                uchar value = 0;
+                if(inputData[x + y*width + z*width*height] == 1) {
+                    value = 1;
+                    for(const auto& offset : offsets) {
+                        // Clamp to edge, same as the sampler of the OpenCL kernel
+                        const int nx = std::min(std::max(x + offset.x(), 0), width - 1);
+                        const int ny = std::min(std::max(y + offset.y(), 0), height - 1);
+                        const int nz = std::min(std::max(z + offset.z(), 0), depth - 1);
+                        if(inputData[nx + ny*width + nz*width*height] != 1) {
+                            value = 0;
+                            break;
+                        }
+                    }
+                }
+                outputData[x + y*width + z*width*height] = value;
+            }
+        }
+    }
+}
+
 void Erosion::execute() {
     auto input = getInputData<Image>();
     if(input->getDataType() != TYPE_UINT8) {
@@ -34,6 +78,12 @@ void Erosion::execute() {
 
     auto output = Image::createFromImage(input);
     SceneGraph::setParentNode(output, input);
+
+    if(getMainDevice()->isHost()) {
+        executeAlgorithmOnHost(input, output, mSize / 2);
+        addOutputData(0, output);
+        return;
+    }
     output->fill(0);
 
     OpenCLDevice::pointer device = std::dynamic_pointer_cast<OpenCLDevice>(getMainDevice());
@@ -0,0 +1,32 @@
+#include <FAST/Testing.hpp>
+#include <FAST/Algorithms/Morphology/Dilation.hpp>
+#include <FAST/Algorithms/Morphology/Erosion.hpp>
+#include <FAST/Algorithms/BinaryThresholding/BinaryThresholding.hpp>
+#include <FAST/Importers/ImageFileImporter.hpp>
+#include <FAST/Data/Image.hpp>
+
+using namespace fast;
+
+static bool isEqual(Image::pointer a, Image::pointer b) {
+    if(a->getSize() != b->getSize())
+        return false;
+    auto accessA = a->getImageAccess(ACCESS_READ);
+    auto accessB = b->getImageAccess(ACCESS_READ);
+    return std::memcmp(accessA->get(), accessB->get(), a->getNrOfVoxels()) == 0;
+}
+
+TEST_CASE("Dilation and erosion on Host gives same result as OpenCL", "[fast][Dilation][Erosion]") {
+    auto segmentation = BinaryThresholding::create(100)
+            ->connect(ImageFileImporter::create(Config::getTestDataPath() + "US/Heart/ApicalFourChamber/US-2D_0.mhd"))
+            ->runAndGetOutputData<Image>();
+
+    auto dilation = Dilation::create(5)->connect(segmentation);
+    auto hostDilation = Dilation::create(5)->connect(segmentation);
+    hostDilation->setMainDevice(Host::getInstance());
+    CHECK(isEqual(dilation->runAndGetOutputData<Image>(), hostDilation->runAndGetOutputData<Image>()));
+
+    auto erosion = Erosion::create(5)->connect(segmentation);
+    auto hostErosion = Erosion::create(5)->connect(segmentation);
+    hostErosion->setMainDevice(Host::getInstance());
+    CHECK(isEqual(erosion->runAndGetOutputData<Image>(), hostErosion->runAndGetOutputData<Image>()));
+}
@@ -7,17 +7,7 @@ namespace fast {
 void BoundingBoxNetwork::loadAttributes() {
 	setThreshold(getFloatAttribute("threshold"));
 
-    std::vector<std::vector<Vector2f>> anchors;
-    const auto level = split(getStringAttribute("anchors"), ";");
-    for(auto&& part : level) {
-        const auto parts = split(part, ",");
-        std::vector<Vector2f> levelAnchors;
-        for(int i = 0; i < parts.size(); i += 2) {
-            levelAnchors.push_back(Vector2f(std::stof(parts[i]), std::stof(parts[i+1])));
-        }
-        anchors.push_back(levelAnchors);
-    }
-    setAnchors(anchors);
+    setAnchors(TensorToBoundingBoxSet::parseAnchors(getStringAttribute("anchors")));
 
 	NeuralNetwork::loadAttributes();
 }
@@ -56,10 +46,9 @@ void BoundingBoxNetwork::execute() {
 
     mRuntimeManager->startRegularTimer("output_processing");
     m_tensorToBoundingBoxSet->setNrOfInputNodes(m_processedOutputData.size());
-    for(auto node : m_processedOutputData) {
-        auto tensor = std::dynamic_pointer_cast<Tensor>(node.second);
-        m_tensorToBoundingBoxSet->setInputData(node.first, tensor);
-    }
+    // Output is a tensor, or a batch of tensors which is decoded in one pass
+    for(auto node : m_processedOutputData)
+        m_tensorToBoundingBoxSet->setInputData(node.first, node.second);
     addOutputData(m_tensorToBoundingBoxSet->updateAndGetOutputData<BoundingBoxSet>());
     mRuntimeManager->stopRegularTimer("output_processing");
 }
@@ -1,5 +1,10 @@
 #include "InferenceEngine.hpp"
 #include <FAST/Utility.hpp>
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
 
 namespace fast {
 
@@ -65,10 +70,57 @@ std::shared_ptr<fast::Tensor> InferenceEngine::getOutputData(std::string nodeNam
     return mOutputNodes.at(nodeName).data;
 }
 
+int InferenceEngine::submit() {
+    run();
+    std::map<std::string, std::shared_ptr<Tensor>> outputs;
+    for(auto&& outputNode : mOutputNodes)
+        outputs[outputNode.first] = outputNode.second.data;
+    const int request = m_nextRequest++;
+    m_finishedRequests[request] = outputs;
+    return request;
+}
+
+bool InferenceEngine::poll(int request) {
+    if(m_finishedRequests.count(request) == 0)
+        throw Exception("Unknown inference request " + std::to_string(request));
+    return true;
+}
+
+void InferenceEngine::wait(int request) {
+    if(m_finishedRequests.count(request) == 0)
+        throw Exception("Unknown inference request " + std::to_string(request));
+    for(auto&& output : m_finishedRequests[request]) {
+        auto& node = mOutputNodes.at(output.first);
+        node.data = output.second;
+        if(output.second)
+            node.shape = output.second->getShape();
+    }
+    m_finishedRequests.erase(request);
+}
+
+void InferenceEngine::setMaxRequestsInFlight(int requests) {
+    if(requests < 0)
+        throw Exception("Max requests in flight must be >= 0");
+    // Engines without asynchronous inference run one request at a time
+    m_maxRequestsInFlight = std::max(requests, 1);
+}
+
+int InferenceEngine::getMaxRequestsInFlight() const {
+    return m_maxRequestsInFlight;
+}
+
 void InferenceEngine::setDeviceType(InferenceDeviceType type) {
     m_deviceType = type;
 }
 
+InferenceDeviceType InferenceEngine::getDeviceType() const {
+    return m_deviceType;
+}
+
+bool InferenceEngine::runsOnCPU() const {
+    return m_runsOnCPU || m_deviceType == InferenceDeviceType::CPU;
+}
+
 void InferenceEngine::setDevice(int index, InferenceDeviceType type) {
     m_deviceIndex = index;
     m_deviceType = type;
@@ -90,6 +142,92 @@ void InferenceEngine::loadCustomPlugins(std::vector<std::string> filenames) {
     throw NotImplementedException();
 }
 
+void InferenceEngine::setCachePath(std::string path) {
+    m_cachePath = path;
+}
+
+std::string InferenceEngine::getCachePath() const {
+    return m_cachePath;
+}
+
+/**
+ * 64 bit FNV-1a hash. Unlike std::hash, the value is the same across processes and platforms.
+ */
+static uint64_t hashBytes(const char* data, std::size_t size, uint64_t hash = 14695981039346656037ULL) {
+    for(std::size_t i = 0; i < size; ++i) {
+        hash ^= (uint8_t)data[i];
+        hash *= 1099511628211ULL;
+    }
+    return hash;
+}
+
+std::string InferenceEngine::getCacheFilename(std::string extension) const {
+    if(m_cachePath.empty() || m_filename.empty())
+        return "";
+    // Hash the contents of the model file, so that a changed model is never loaded from the cache,
+    // while a copy of the model at another path is
+    std::ifstream file(m_filename, std::ios::binary);
+    if(!file.is_open())
+        throw Exception("Unable to open model file " + m_filename);
+    uint64_t hash = hashBytes(nullptr, 0);
+    std::vector<char> buffer(1 << 20);
+    while(file) {
+        file.read(buffer.data(), buffer.size());
+        hash = hashBytes(buffer.data(), file.gcount(), hash);
+    }
+    std::string key = getName() + ";" + std::to_string((int)m_deviceType) + ";" + std::to_string(m_maxBatchSize);
+    for(auto&& node : mInputNodes)
+        key += ";" + node.first + ":" + node.second.shape.toString();
+    hash = hashBytes(key.data(), key.size(), hash);
+    std::stringstream hex;
+    hex << std::hex << std::setw(16) << std::setfill('0') << hash;
+    return join(m_cachePath, getFileName(m_filename) + "_" + hex.str() + "." + extension);
+}
+
+void InferenceEngine::warmUp(std::vector<int> batchSizes, int iterations) {
+    if(!isLoaded())
+        throw Exception("Inference engine must be loaded before warm up");
+    if(batchSizes.empty()) {
+        batchSizes.push_back(1);
+        if(m_maxBatchSize > 1)
+            batchSizes.push_back(m_maxBatchSize);
+    }
+    for(int batchSize : batchSizes) {
+        for(auto&& node : mInputNodes) {
+            TensorShape shape = node.second.shape;
+            if(shape.empty())
+                shape = !node.second.optShape.empty() ? node.second.optShape : node.second.maxShape;
+            if(shape.empty())
+                throw Exception("Unable to warm up inference engine, shape of input node " + node.first + " is unknown");
+            if(shape[0] <= 0)
+                shape[0] = batchSize;
+            for(int i = 1; i < shape.getDimensions(); ++i) {
+                if(shape[i] > 0)
+                    continue;
+                const int opt = node.second.optShape.getDimensions() > i ? node.second.optShape[i] : -1;
+                const int max = node.second.maxShape.getDimensions() > i ? node.second.maxShape[i] : -1;
+                if(opt <= 0 && max <= 0)
+                    throw Exception("Unable to warm up inference engine, input node " + node.first + " has unknown shape " + node.second.shape.toString() + ". Set the optimal or maximum shape of the node.");
+                shape[i] = opt > 0 ? opt : max;
+            }
+            auto tensor = Tensor::create(shape, node.second.dataType);
+            {
+                auto access = tensor->getAccess(ACCESS_READ_WRITE);
+                std::memset(access->get(), 0, shape.getTotalSize()*getSizeOfDataType(node.second.dataType, 1));
+            }
+            setInputData(node.first, tensor);
+        }
+        reportInfo() << "Warming up inference engine " << getName() << " with batch size " << batchSize << reportEnd();
+        for(int i = 0; i < iterations; ++i)
+            run();
+    }
+    // Don't keep the dummy data
+    for(auto&& node : mInputNodes)
+        node.second.data.reset();
+    for(auto&& node : mOutputNodes)
+        node.second.data.reset();
+}
+
 std::string getModelFileExtension(ModelFormat format) {
     std::map<ModelFormat, std::string> map = {
         {ModelFormat::PROTOBUF, "pb"},
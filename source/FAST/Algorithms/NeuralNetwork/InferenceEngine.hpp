@@ -80,6 +80,7 @@ public:
     fast::TensorShape optShape;
     fast::TensorShape minShape;
     fast::TensorShape maxShape;
+    DataType dataType = TYPE_FLOAT; // Data type of node in the model, set by the inference engine when loading
     std::shared_ptr<fast::Tensor> data;
 };
 /**
@@ -119,7 +120,43 @@ class FAST_EXPORT InferenceEngine : public Object {
         virtual void setFilename(std::string filename);
         virtual void setModelAndWeights(std::vector<uint8_t> model, std::vector<uint8_t> weights);
         virtual std::string getFilename() const;
+        /**
+         * Run inference on the current input data, and set the output data of the output nodes. Blocks until done.
+         */
         virtual void run() = 0;
+        /**
+         * @brief Start inference on the current input data asynchronously
+         *
+         * The request keeps the current input data, thus setInputData can be called for the next request right away.
+         * If the max number of requests are in flight, this blocks until the oldest request is done.
+         * The default implementation runs inference synchronously.
+         *
+         * @return request id to use with poll() and wait()
+         */
+        virtual int submit();
+        /**
+         * @brief Check if a submitted request is done, without blocking
+         * @param request Request id returned by submit()
+         * @return true if done
+         */
+        virtual bool poll(int request);
+        /**
+         * @brief Wait for a submitted request to finish, and set the output data of the output nodes to its result.
+         * Any exception thrown during inference is rethrown here.
+         * @param request Request id returned by submit()
+         */
+        virtual void wait(int request);
+        /**
+         * @brief Set the max number of inference requests which can be in flight at the same time
+         *
+         * Engines with asynchronous inference allocate one inference request for each.
+         * If the engine is already loaded, it will be loaded again the next time it is used.
+         *
+         * @param requests If 0, the optimal number of requests for the device is used. Engines with asynchronous inference
+         *      set this when the engine is loaded, other engines use 1.
+         */
+        virtual void setMaxRequestsInFlight(int requests);
+        virtual int getMaxRequestsInFlight() const;
         virtual void addInputNode(NeuralNetworkNode node);
         virtual void addOutputNode(NeuralNetworkNode node);
         virtual void setInputNodeShape(std::string name, TensorShape shape);
@@ -143,6 +180,16 @@ class FAST_EXPORT InferenceEngine : public Object {
          * @param type
          */
         virtual void setDeviceType(InferenceDeviceType type);
+        InferenceDeviceType getDeviceType() const;
+        /**
+         * @brief Whether the engine runs inference on the CPU
+         *
+         * This is the device the engine resolved to when it was loaded. E.g. an engine with device type ANY
+         * runs on the CPU when no GPU execution provider was available. Only valid after load().
+         *
+         * @return true if inference runs on the CPU
+         */
+        bool runsOnCPU() const;
         /**
          * Specify which device index and/or device type to use
          * @param index Index of the device to use. -1 means any device can be used
@@ -171,6 +218,29 @@ class FAST_EXPORT InferenceEngine : public Object {
          * @param ordering
          */
         virtual void setImageOrdering(ImageOrdering ordering);
+        /**
+         * @brief Set path of the folder where compiled/optimized models are cached on disk
+         *
+         * Engines which support it store the compiled model here, so that loading the same model
+         * with the same shapes on the same device again is fast. Must be called before load().
+         *
+         * @param path Path to folder. Empty string disables caching.
+         */
+        virtual void setCachePath(std::string path);
+        virtual std::string getCachePath() const;
+        /**
+         * @brief Run inference on dummy input data to warm up the engine
+         *
+         * The first inferences of an engine are usually slow, because of lazy memory allocation and
+         * kernel selection. Warming up removes this latency from the first real input data.
+         * Input nodes with unknown dimensions use the optimal or maximum shape of the node.
+         * The engine must be loaded.
+         *
+         * @param batchSizes Batch sizes to warm up, for input nodes with an unknown batch dimension.
+         *      If empty, 1 and the max batch size are used.
+         * @param iterations Number of inferences for each shape
+         */
+        virtual void warmUp(std::vector<int> batchSizes = std::vector<int>(), int iterations = 1);
         /**
          * @brief Detect node type from shape
          * @param shape
@@ -186,17 +256,35 @@ class FAST_EXPORT InferenceEngine : public Object {
         static ImageOrdering detectImageOrdering(const TensorShape& shape, bool hasBatchDim = true);
     protected:
         virtual void setIsLoaded(bool loaded);
+        /**
+         * @brief Get filename in the cache path for a compiled/optimized model
+         *
+         * The filename is unique for the contents of the model file, the input node shapes,
+         * the max batch size, the device type and the engine. It does not depend on the path of the model file,
+         * and is the same in every process.
+         *
+         * @param extension File extension
+         * @return filename, or empty string if caching is disabled
+         */
+        std::string getCacheFilename(std::string extension) const;
 
         std::map<std::string, NeuralNetworkNode> mInputNodes;
         std::map<std::string, NeuralNetworkNode> mOutputNodes;
 
         int m_deviceIndex = -1;
         InferenceDeviceType m_deviceType = InferenceDeviceType::ANY;
+        // Set by engines in load() when they resolve device type ANY, or a failed GPU device, to the CPU
+        bool m_runsOnCPU = false;
         int m_maxBatchSize = 1;
+        int m_maxRequestsInFlight = 1;
+        int m_nextRequest = 0;
+        // Output data of requests which are done, but not yet collected with wait()
+        std::map<int, std::map<std::string, std::shared_ptr<Tensor>>> m_finishedRequests;
 
         std::vector<uint8_t> m_model;
         std::vector<uint8_t> m_weights;
         ImageOrdering m_imageOrdering;
+        std::string m_cachePath = "";
     private:
         std::string m_filename = "";
         bool m_isLoaded = false;
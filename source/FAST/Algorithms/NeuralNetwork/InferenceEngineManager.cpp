@@ -200,6 +200,8 @@ namespace fast {
 
 bool InferenceEngineManager::m_loaded = false;
 std::unordered_map<std::string, std::function<InferenceEngine*()>> InferenceEngineManager::m_engines;
+bool InferenceEngineManager::m_cachePathSet = false;
+std::string InferenceEngineManager::m_cachePath;
 
 #ifdef WIN32
 //Returns the last Win32 error, in string format. Returns an empty string if there is no error.
@@ -382,7 +384,20 @@ std::shared_ptr<InferenceEngine> InferenceEngineManager::loadEngine(std::string
     if(m_engines.count(name) == 0)
         throw Exception("Inference engine with name " + name + " is not available");
     // Call the load function which the map stores a handle to
-    return std::shared_ptr<InferenceEngine>(m_engines.at(name)());
+    auto engine = std::shared_ptr<InferenceEngine>(m_engines.at(name)());
+    engine->setCachePath(getCachePath());
+    return engine;
+}
+
+void InferenceEngineManager::setCachePath(std::string path) {
+    m_cachePath = path;
+    m_cachePathSet = true;
+}
+
+std::string InferenceEngineManager::getCachePath() {
+    if(!m_cachePathSet)
+        return join(Config::getKernelBinaryPath(), "inference_engines");
+    return m_cachePath;
 }
 
 }
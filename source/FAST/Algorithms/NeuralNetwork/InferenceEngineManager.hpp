@@ -15,8 +15,20 @@ class FAST_EXPORT InferenceEngineManager {
         static std::shared_ptr<InferenceEngine> loadBestAvailableEngine();
         static std::shared_ptr<InferenceEngine> loadBestAvailableEngine(ModelFormat modelFormat);
         static bool isEngineAvailable(std::string name);
+        /**
+         * @brief Set path of the folder where inference engines cache compiled/optimized models
+         *
+         * Engines loaded by this manager after this call will use this path.
+         * The default is a subfolder of the kernel binary path.
+         *
+         * @param path Path to folder. Empty string disables caching.
+         */
+        static void setCachePath(std::string path);
+        static std::string getCachePath();
     private:
         static bool m_loaded;
+        static bool m_cachePathSet;
+        static std::string m_cachePath;
         static std::unordered_map<std::string, std::function<InferenceEngine*()>> m_engines;
 };
 
@@ -8,6 +8,8 @@
 #endif
 
 #include <FAST/Config.hpp>
+#include <FAST/Utility.hpp>
+#include <thread>
 
 namespace fast {
 
@@ -21,16 +23,50 @@ std::string print_shape(const std::vector<int64_t>& v) {
 }
 
 
+static ONNXTensorElementDataType getONNXDataType(DataType type) {
+    const std::map<DataType, ONNXTensorElementDataType> types = {
+            {TYPE_FLOAT, ONNX_TENSOR_ELEMENT_DATA_TYPE_FLOAT},
+            {TYPE_FLOAT16, ONNX_TENSOR_ELEMENT_DATA_TYPE_FLOAT16},
+            {TYPE_INT8, ONNX_TENSOR_ELEMENT_DATA_TYPE_INT8},
+            {TYPE_UINT8, ONNX_TENSOR_ELEMENT_DATA_TYPE_UINT8},
+            {TYPE_INT16, ONNX_TENSOR_ELEMENT_DATA_TYPE_INT16},
+            {TYPE_UINT16, ONNX_TENSOR_ELEMENT_DATA_TYPE_UINT16},
+            {TYPE_INT32, ONNX_TENSOR_ELEMENT_DATA_TYPE_INT32},
+    };
+    if(types.count(type) == 0)
+        throw Exception("Data type " + getCTypeAsString(type) + " is not supported by ONNXRuntimeEngine");
+    return types.at(type);
+}
+
+static DataType getFASTDataType(ONNXTensorElementDataType type) {
+    const std::map<ONNXTensorElementDataType, DataType> types = {
+            {ONNX_TENSOR_ELEMENT_DATA_TYPE_FLOAT, TYPE_FLOAT},
+            {ONNX_TENSOR_ELEMENT_DATA_TYPE_FLOAT16, TYPE_FLOAT16},
+            {ONNX_TENSOR_ELEMENT_DATA_TYPE_INT8, TYPE_INT8},
+            {ONNX_TENSOR_ELEMENT_DATA_TYPE_UINT8, TYPE_UINT8},
+            {ONNX_TENSOR_ELEMENT_DATA_TYPE_INT16, TYPE_INT16},
+            {ONNX_TENSOR_ELEMENT_DATA_TYPE_UINT16, TYPE_UINT16},
+            {ONNX_TENSOR_ELEMENT_DATA_TYPE_INT32, TYPE_INT32},
+    };
+    if(types.count(type) == 0)
+        throw Exception("ONNX tensor element data type " + std::to_string(type) + " is not supported by FAST");
+    return types.at(type);
+}
+
 void ONNXRuntimeEngine::run() {
+    wait(submit());
+}
+
+std::map<std::string, std::shared_ptr<Tensor>> ONNXRuntimeEngine::runSession(std::map<std::string, std::shared_ptr<Tensor>> inputs) {
 	//auto start = std::chrono::high_resolution_clock::now();
     std::vector<const char*> inputNames;
     std::vector<Ort::Value> inputTensors;
 	// Important to use reference here, as we are using c_str() which does not copy string, and will be deleted if std::string is deleted.
-    for (const auto& inputNode : mInputNodes) {
-        auto tensor = inputNode.second.data;
+    for (const auto& input : inputs) {
+        auto tensor = input.second;
         auto access = tensor->getAccess(ACCESS_READ);
-		inputNames.push_back(strdup(inputNode.first.c_str()));
-        float* tensorData = access->getRawData();
+		inputNames.push_back(input.first.c_str());
+        void* tensorData = access->get();
         reportInfo() << "ONNXRuntime: Creating memory info.." << reportEnd();
         Ort::MemoryInfo info = Ort::MemoryInfo::CreateCpu(OrtAllocatorType::OrtArenaAllocator, OrtMemType::OrtMemTypeCPU); // Must be TypeCPU to work on CPU
         auto shape = tensor->getShape();
@@ -38,36 +74,140 @@ void ONNXRuntimeEngine::run() {
         std::vector<int64_t> dims;
         for (int x : shape.getAll())
             dims.push_back(x);
-        inputTensors.emplace_back(Ort::Value::CreateTensor<float>(info, tensorData, shape.getTotalSize(), dims.data(), shape.getDimensions()));
+        inputTensors.emplace_back(Ort::Value::CreateTensor(info, tensorData, shape.getTotalSize()*getSizeOfDataType(tensor->getDataType(), 1),
+                                                           dims.data(), shape.getDimensions(), getONNXDataType(tensor->getDataType())));
     }
-    std::vector<const char*> outputNames;
-	// Important to use reference here, as we are using c_str() which does not copy string, and will be deleted if std::string is deleted.
+    Ort::IoBinding binding(*m_session);
+    for(int i = 0; i < inputNames.size(); ++i)
+        binding.BindInput(inputNames[i], inputTensors[i]);
+
+    // Let ONNX Runtime write the output directly to new FAST tensors when the output shape is known before
+    // inference, that is when only the batch dimension is dynamic. This avoids copying the output.
+    const int64_t batchSize = inputs.empty() ? -1 : inputs.begin()->second->getShape()[0];
+    Ort::MemoryInfo outputInfo = Ort::MemoryInfo::CreateCpu(OrtAllocatorType::OrtArenaAllocator, OrtMemType::OrtMemTypeCPU);
+    std::map<std::string, std::shared_ptr<Tensor>> boundOutputs;
+    std::vector<Ort::Value> outputTensors;
+    outputTensors.reserve(mOutputNodes.size());
     for (const auto& outputNode : mOutputNodes) {
-        outputNames.push_back(outputNode.first.c_str());
+        std::vector<int64_t> dims = m_outputShapes.at(outputNode.first);
+        bool shapeKnown = !dims.empty();
+        for(int i = 0; i < dims.size(); ++i) {
+            if(dims[i] < 0) {
+                if(i == 0 && batchSize > 0) {
+                    dims[i] = batchSize;
+                } else {
+                    shapeKnown = false;
+                }
+            }
+        }
+        if(shapeKnown) {
+            TensorShape shape;
+            for(auto x : dims)
+                shape.addDimension(x);
+            const DataType type = outputNode.second.dataType;
+            auto tensor = Tensor::create(shape, type);
+            void* tensorData = tensor->getAccess(ACCESS_READ_WRITE)->get();
+            outputTensors.emplace_back(Ort::Value::CreateTensor(outputInfo, tensorData, shape.getTotalSize()*getSizeOfDataType(type, 1),
+                                                                dims.data(), dims.size(), getONNXDataType(type)));
+            binding.BindOutput(outputNode.first.c_str(), outputTensors.back());
+            boundOutputs[outputNode.first] = tensor;
+        } else {
+            binding.BindOutput(outputNode.first.c_str(), outputInfo);
+        }
     }
-		
+
     Ort::RunOptions runOptions;
     reportInfo() << "Running ONNX runtime .." << reportEnd();
-    std::vector<Ort::Value> output = m_session->Run(runOptions, inputNames.data(), inputTensors.data(), inputNames.size(), outputNames.data(), outputNames.size());
+    m_session->Run(runOptions, binding);
     reportInfo() << "Finished run ONNX runtime" << reportEnd();
     //std::chrono::duration<float, std::milli> duration = std::chrono::high_resolution_clock::now() - start;
     //std::cout << "Run: " << duration.count() << std::endl;
 
-    // Copy output data to FAST
+    // Copy output data to FAST, if it was not written directly to a FAST tensor
+    std::vector<Ort::Value> output = binding.GetOutputValues();
+    std::map<std::string, std::shared_ptr<Tensor>> outputs;
     int counter = 0;
-    for(auto& outputNode : mOutputNodes) {
-        const float* data = output[counter].GetTensorData<float>();
+    for(const auto& outputNode : mOutputNodes) {
+        if(boundOutputs.count(outputNode.first) > 0) {
+            outputs[outputNode.first] = boundOutputs[outputNode.first];
+            ++counter;
+            continue;
+        }
+        const void* data = output[counter].GetTensorData<void>();
         // Get shape of output tensor
+        auto info = output[counter].GetTensorTypeAndShapeInfo();
         auto shape = TensorShape();
-        for(int x : output[counter].GetTensorTypeAndShapeInfo().GetShape()) {
+        for(int x : info.GetShape()) {
             shape.addDimension(x);
         }
-        const auto name = outputNode.first;
-        outputNode.second.shape = shape;
-        auto outputTensor = Tensor::create(data, shape);
-        outputNode.second.data = outputTensor;
+        outputs[outputNode.first] = Tensor::create(data, shape, getFASTDataType(info.GetElementType()));
         ++counter;
     }
+    return outputs;
+}
+
+int ONNXRuntimeEngine::submit() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if(m_inFlight.size() >= m_maxRequestsInFlight) {
+        // Wait for the oldest request
+        finishRequest(m_inFlight.begin()->first);
+    }
+    std::map<std::string, std::shared_ptr<Tensor>> inputs;
+    for(const auto& inputNode : mInputNodes)
+        inputs[inputNode.first] = inputNode.second.data;
+    const int id = m_nextRequest++;
+    m_inFlight[id] = std::async(std::launch::async, &ONNXRuntimeEngine::runSession, this, std::move(inputs));
+    return id;
+}
+
+void ONNXRuntimeEngine::finishRequest(int request) {
+    auto future = std::move(m_inFlight.at(request));
+    m_inFlight.erase(request);
+    try {
+        m_finishedRequests[request] = future.get();
+    } catch(Ort::Exception &e) {
+        throw Exception("ONNXRuntime exception caught: " + std::string(e.what()));
+    }
+}
+
+bool ONNXRuntimeEngine::poll(int request) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if(m_inFlight.count(request) > 0)
+        return m_inFlight[request].wait_for(std::chrono::seconds(0)) == std::future_status::ready;
+    return InferenceEngine::poll(request);
+}
+
+void ONNXRuntimeEngine::wait(int request) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if(m_inFlight.count(request) > 0)
+        finishRequest(request);
+    InferenceEngine::wait(request);
+}
+
+void ONNXRuntimeEngine::setMaxRequestsInFlight(int requests) {
+    if(requests != m_maxRequestsInFlight && isLoaded()) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if(!m_inFlight.empty())
+            throw Exception("Can't change the max requests in flight of ONNXRuntimeEngine while requests are in flight");
+        // Session has to be created again with new thread settings
+        setIsLoaded(false);
+    }
+    InferenceEngine::setMaxRequestsInFlight(requests);
+    // 0 is resolved to the optimal number of requests when the session is created in load()
+    m_maxRequestsInFlight = requests;
+}
+
+/**
+ * Split the CPU threads between the requests in flight, instead of each request using all threads.
+ */
+static Ort::SessionOptions createSessionOptions(int requestsInFlight) {
+    Ort::SessionOptions options;
+    if(requestsInFlight > 1) {
+        options.SetIntraOpNumThreads(std::max<int>(std::thread::hardware_concurrency() / requestsInFlight, 1));
+        options.SetInterOpNumThreads(1);
+        options.SetExecutionMode(ExecutionMode::ORT_SEQUENTIAL);
+    }
+    return options;
 }
 
 void ONNXRuntimeEngine::load() {
@@ -75,19 +215,57 @@ void ONNXRuntimeEngine::load() {
     std::wstring wideStr(filename.begin(), filename.end());
 
 	reportInfo() << "Setting up ONNX Runtime" << reportEnd();
+    if(m_maxRequestsInFlight == 0) {
+        // ONNX Runtime has no optimal number of requests, two is enough to overlap inference with input and output processing
+        m_maxRequestsInFlight = 2;
+    }
     //auto start = std::chrono::high_resolution_clock::now();
 	m_env = std::make_unique<Ort::Env>(ORT_LOGGING_LEVEL_WARNING, "ONNXRuntime");
-    if(m_deviceType == InferenceDeviceType::CPU) {
-		Ort::SessionOptions session_options;
+    // The optimized model of CPU sessions is cached on disk, and loaded without optimizing it again the next time.
+    // Sessions with other execution providers are not cached, as their optimized models contain nodes compiled for the device.
+    const std::string cacheFilename = getCacheFilename(std::string(OrtGetApiBase()->GetVersionString()) + ".onnx");
+    auto createCPUSession = [&]() {
+        // No GPU execution provider is appended to CPU sessions
+        m_runsOnCPU = true;
+        if(!cacheFilename.empty() && fileExists(cacheFilename)) {
+            reportInfo() << "Loading optimized ONNX model from cache " << cacheFilename << reportEnd();
+            Ort::SessionOptions session_options = createSessionOptions(m_maxRequestsInFlight);
+            session_options.SetGraphOptimizationLevel(GraphOptimizationLevel::ORT_DISABLE_ALL);
+            try {
 #ifdef WIN32
-		m_session = std::make_unique<Ort::Session>(*m_env.get(), wideStr.c_str(), session_options);
+                std::wstring wideCacheFilename(cacheFilename.begin(), cacheFilename.end());
+                m_session = std::make_unique<Ort::Session>(*m_env.get(), wideCacheFilename.c_str(), session_options);
 #else
-		m_session = std::make_unique<Ort::Session>(*m_env.get(), filename.c_str(), session_options);
+                m_session = std::make_unique<Ort::Session>(*m_env.get(), cacheFilename.c_str(), session_options);
 #endif
+                return;
+            } catch(Ort::Exception& e) {
+                reportWarning() << "Failed to load cached ONNX model " << cacheFilename << ": " << e.what() << ". Optimizing model again." << reportEnd();
+            }
+        }
+        Ort::SessionOptions session_options = createSessionOptions(m_maxRequestsInFlight);
+        if(!cacheFilename.empty()) {
+            createDirectories(getCachePath());
+#ifdef WIN32
+            std::wstring wideCacheFilename(cacheFilename.begin(), cacheFilename.end());
+            session_options.SetOptimizedModelFilePath(wideCacheFilename.c_str());
+#else
+            session_options.SetOptimizedModelFilePath(cacheFilename.c_str());
+#endif
+        }
+#ifdef WIN32
+        m_session = std::make_unique<Ort::Session>(*m_env.get(), wideStr.c_str(), session_options);
+#else
+        m_session = std::make_unique<Ort::Session>(*m_env.get(), filename.c_str(), session_options);
+#endif
+    };
+    m_runsOnCPU = false;
+    if(m_deviceType == InferenceDeviceType::CPU) {
+        createCPUSession();
     } else {
 #ifdef WIN32
         try {
-            Ort::SessionOptions session_options;
+            Ort::SessionOptions session_options = createSessionOptions(m_maxRequestsInFlight);
             SetDllDirectory(Config::getLibraryPath().c_str()); // Make sure delay-load dlls are found (directml.dll) etc.
             Ort::ThrowOnError(OrtSessionOptionsAppendExecutionProvider_DML(session_options, 0));
             session_options.DisableMemPattern();
@@ -96,26 +274,23 @@ void ONNXRuntimeEngine::load() {
         }
         catch (Ort::Exception& e) {
             reportWarning() << "Exception occured while trying to load DirectML for ONNXRuntime with message: (" << e.GetOrtErrorCode() << ") " << e.what()  << ". Falling back to CPU." << reportEnd();
-            Ort::SessionOptions session_options;
-            m_session = std::make_unique<Ort::Session>(*m_env.get(), wideStr.c_str(), session_options);
+            createCPUSession();
         }
 #elif defined(__APPLE__) || defined(__MACOSX)
         // APPLE
         try {
-            Ort::SessionOptions session_options;
+            Ort::SessionOptions session_options = createSessionOptions(m_maxRequestsInFlight);
             uint32_t coreml_flags = 0;
             Ort::ThrowOnError(OrtSessionOptionsAppendExecutionProvider_CoreML(session_options, coreml_flags));
             m_session = std::make_unique<Ort::Session>(*m_env.get(), filename.c_str(), session_options);
         }
         catch (Ort::Exception& e) {
             reportWarning() << "Exception occured while trying to load CoreML for ONNXRuntime with message: (" << e.GetOrtErrorCode() << ") " << e.what() << ". Falling back to CPU." << reportEnd();
-            Ort::SessionOptions session_options;
-            m_session = std::make_unique<Ort::Session>(*m_env.get(), filename.c_str(), session_options);
+            createCPUSession();
         }
 #else
         // LINUX (only CPU available)
-        Ort::SessionOptions session_options;
-        m_session = std::make_unique<Ort::Session>(*m_env.get(), filename.c_str(), session_options);
+        createCPUSession();
 #endif
     }
 	Ort::AllocatorWithDefaultOptions allocator;
@@ -145,11 +320,14 @@ void ONNXRuntimeEngine::load() {
 				reportInfo() << "Node was defined by user at id " << mInputNodes[name].id  << reportEnd();
 				if(mInputNodes[name].shape.empty())
 					mInputNodes[name].shape = shape;
+				mInputNodes[name].dataType = getFASTDataType(m_session->GetInputTypeInfo(i).GetTensorTypeAndShapeInfo().GetElementType());
 			} else {
 				reportInfo() << "Ignored input node " << name << " because input nodes were specified, but not this one." << reportEnd();
 			}
 		} else {
-			addInputNode(NeuralNetworkNode(name, type, shape, inputCount));
+			NeuralNetworkNode node(name, type, shape, inputCount);
+			node.dataType = getFASTDataType(m_session->GetInputTypeInfo(i).GetTensorTypeAndShapeInfo().GetElementType());
+			addInputNode(node);
 			++inputCount;
 		}
 	}
@@ -161,6 +339,7 @@ void ONNXRuntimeEngine::load() {
 		for (int x : m_session->GetOutputTypeInfo(i).GetTensorTypeAndShapeInfo().GetShape()) {
 			shape.addDimension(x);
 		}
+		m_outputShapes[name] = m_session->GetOutputTypeInfo(i).GetTensorTypeAndShapeInfo().GetShape();
 		NodeType type = detectNodeType(shape);
 		if(outputsDefined) {
 			if(mOutputNodes.count(name) > 0) {
@@ -169,11 +348,14 @@ void ONNXRuntimeEngine::load() {
 					reportInfo() << "Shape was empty, setting it to " << shape.toString() << reportEnd();
 					mOutputNodes[name].shape = shape;
 				}
+				mOutputNodes[name].dataType = getFASTDataType(m_session->GetOutputTypeInfo(i).GetTensorTypeAndShapeInfo().GetElementType());
 			} else {
 				reportInfo() << "Ignored output node " << name << " because output nodes were specified, but not this one." << reportEnd();
 			}
 		} else {
-			addOutputNode(NeuralNetworkNode(name, type, shape, outputCount));
+			NeuralNetworkNode node(name, type, shape, outputCount);
+			node.dataType = getFASTDataType(m_session->GetOutputTypeInfo(i).GetTensorTypeAndShapeInfo().GetElementType());
+			addOutputNode(node);
 			++outputCount;
 		}
   }
@@ -2,6 +2,8 @@
 
 #include <FAST/Algorithms/NeuralNetwork/InferenceEngine.hpp>
 #include <ONNXRuntimeExport.hpp>
+#include <future>
+#include <mutex>
 
 namespace Ort {
 	class Session;
@@ -25,6 +27,14 @@ class INFERENCEENGINEONNXRUNTIME_EXPORT ONNXRuntimeEngine : public InferenceEngi
 public:
 	void run() override;
 	void load() override;
+	/**
+	 * Start inference asynchronously. Sessions can be run from several threads at the same time,
+	 * thus each request in flight runs the session in its own thread.
+	 */
+	int submit() override;
+	bool poll(int request) override;
+	void wait(int request) override;
+	void setMaxRequestsInFlight(int requests) override;
 	ImageOrdering getPreferredImageOrdering() const override;
 	std::string getName() const override;
 	std::vector<ModelFormat> getSupportedModelFormats() const {
@@ -44,8 +54,14 @@ public:
 	 */
 	std::vector<InferenceDeviceInfo> getDeviceList() override;
 private:
+	std::map<std::string, std::shared_ptr<Tensor>> runSession(std::map<std::string, std::shared_ptr<Tensor>> inputs);
+	void finishRequest(int request);
+
 	std::unique_ptr<Ort::Session> m_session;
 	std::unique_ptr<Ort::Env> m_env;
+	std::map<int, std::future<std::map<std::string, std::shared_ptr<Tensor>>>> m_inFlight;
+	std::mutex m_mutex;
+	std::map<std::string, std::vector<int64_t>> m_outputShapes; // Shapes of output nodes in model, -1 is dynamic
 };
 
 DEFINE_INFERENCE_ENGINE(ONNXRuntimeEngine, INFERENCEENGINEONNXRUNTIME_EXPORT)
@@ -1,54 +1,194 @@
 #include "OpenVINOEngine.hpp"
 #include <openvino/openvino.hpp>
 #include <FAST/Utility.hpp>
+#include <algorithm>
 
 namespace fast {
 
 class OpenVINOInfer {
 public:
-    ov::InferRequest request;
+    std::vector<ov::InferRequest> requests;
+    std::vector<int> freeRequests;
+    struct InFlight {
+        int index; // Index of infer request
+        std::vector<std::shared_ptr<Tensor>> inputs; // Input data must be kept alive until the request is done
+        std::map<std::string, std::shared_ptr<Tensor>> outputs; // Tensors bound as output buffers of the request
+    };
+    std::map<int, InFlight> inFlight; // Request ids are increasing, thus the first is the oldest
+    std::map<int, ov::PartialShape> outputShapes; // Output shapes of compiled model
 };
 
+/**
+ * Get the shape of an output before running inference. This is possible if only the batch dimension is dynamic.
+ */
+static bool getOutputShape(const ov::PartialShape& partialShape, int batchSize, ov::Shape& shape) {
+    if(partialShape.rank().is_dynamic() || partialShape.rank().get_length() == 0)
+        return false;
+    shape.clear();
+    for(int i = 0; i < partialShape.rank().get_length(); ++i) {
+        if(partialShape[i].is_static()) {
+            shape.push_back(partialShape[i].get_length());
+        } else if(i == 0 && batchSize > 0) {
+            shape.push_back(batchSize);
+        } else {
+            return false;
+        }
+    }
+    return true;
+}
+
+static ov::element::Type getOpenVINODataType(DataType type) {
+    const std::map<DataType, ov::element::Type> types = {
+            {TYPE_FLOAT, ov::element::f32},
+            {TYPE_FLOAT16, ov::element::f16},
+            {TYPE_INT8, ov::element::i8},
+            {TYPE_UINT8, ov::element::u8},
+            {TYPE_INT16, ov::element::i16},
+            {TYPE_UINT16, ov::element::u16},
+            {TYPE_INT32, ov::element::i32},
+    };
+    if(types.count(type) == 0)
+        throw Exception("Data type " + getCTypeAsString(type) + " is not supported by OpenVINOEngine");
+    return types.at(type);
+}
+
+static DataType getFASTDataType(const ov::element::Type& type) {
+    const std::map<ov::element::Type_t, DataType> types = {
+            {ov::element::f32, TYPE_FLOAT},
+            {ov::element::f16, TYPE_FLOAT16},
+            {ov::element::i8, TYPE_INT8},
+            {ov::element::u8, TYPE_UINT8},
+            {ov::element::i16, TYPE_INT16},
+            {ov::element::u16, TYPE_UINT16},
+            {ov::element::i32, TYPE_INT32},
+    };
+    if(types.count(type) == 0)
+        throw Exception("OpenVINO element type " + type.get_type_name() + " is not supported by FAST");
+    return types.at(type);
+}
 
 void OpenVINOEngine::run() {
+    wait(submit());
+}
+
+int OpenVINOEngine::submit() {
     std::lock_guard<std::mutex> lock(m_mutex);
 
+    if(m_infer->freeRequests.empty()) {
+        // All requests are in flight, wait for the oldest
+        finishRequest(m_infer->inFlight.begin()->first);
+    }
+    const int index = m_infer->freeRequests.back();
+    m_infer->freeRequests.pop_back();
+    auto& request = m_infer->requests[index];
+
     // Copy input data
     reportInfo() << "OpenVINO processing input nodes." << reportEnd();
+    OpenVINOInfer::InFlight inFlight;
+    inFlight.index = index;
     for(auto inputNode : mInputNodes) {
-        const auto index = m_inputIndices[inputNode.first];
+        const auto inputIndex = m_inputIndices[inputNode.first];
         auto tensor = inputNode.second.data;
         auto access = tensor->getAccess(ACCESS_READ);
-        float* tensorData = access->getRawData();
+        void* tensorData = access->get();
         ov::Shape shape;
         for(int x : tensor->getShape().getAll()) {
             shape.push_back(x);
         }
-        m_infer->request.set_input_tensor(index, ov::Tensor(ov::element::f32, shape, tensorData));
+        request.set_input_tensor(inputIndex, ov::Tensor(getOpenVINODataType(tensor->getDataType()), shape, tensorData));
+        inFlight.inputs.push_back(tensor);
     }
     reportInfo() << "OpenVINO input data added." << reportEnd();
 
-    // Run inference
-    m_infer->request.infer();
-    reportInfo() << "OpenVINO inference done." << reportEnd();
-
-    // Get output data
-    reportInfo() << "OpenVINO processing output nodes." << reportEnd();
-    for(auto& outputNode : mOutputNodes) {
-        const auto index = m_outputIndices[outputNode.first];
-        ov::Tensor ovTensor = m_infer->request.get_output_tensor(index);
-        const float* data = ovTensor.data<float>();
-        // Get shape of output tensor
-        auto shape = TensorShape();
-        for(int x : ovTensor.get_shape()) {
-            shape.addDimension(x);
+    // Start inference
+    try {
+        // Let OpenVINO write the output directly to new FAST tensors, to avoid copying the output
+        const int batchSize = mInputNodes.empty() ? -1 : mInputNodes.begin()->second.data->getShape()[0];
+        for(auto& outputNode : mOutputNodes) {
+            const auto outputIndex = m_outputIndices[outputNode.first];
+            ov::Shape shape;
+            if(!getOutputShape(m_infer->outputShapes[outputIndex], batchSize, shape))
+                continue;
+            TensorShape tensorShape;
+            for(auto x : shape)
+                tensorShape.addDimension(x);
+            const DataType type = outputNode.second.dataType;
+            auto tensor = Tensor::create(tensorShape, type);
+            void* tensorData = tensor->getAccess(ACCESS_READ_WRITE)->get();
+            request.set_output_tensor(outputIndex, ov::Tensor(getOpenVINODataType(type), shape, tensorData));
+            inFlight.outputs[outputNode.first] = tensor;
+        }
+        request.start_async();
+    } catch(ov::Exception &e) {
+        m_infer->freeRequests.push_back(index);
+        throw Exception("OpenVINO exception caught: " + std::string(e.what()));
+    }
+    const int id = m_nextRequest++;
+    m_infer->inFlight[id] = inFlight;
+    return id;
+}
+
+void OpenVINOEngine::finishRequest(int id) {
+    auto inFlight = m_infer->inFlight.at(id);
+    m_infer->inFlight.erase(id);
+    auto& request = m_infer->requests[inFlight.index];
+    std::map<std::string, std::shared_ptr<Tensor>> outputs;
+    try {
+        request.wait();
+        reportInfo() << "OpenVINO inference done." << reportEnd();
+
+        // Get output data
+        reportInfo() << "OpenVINO processing output nodes." << reportEnd();
+        for(auto& outputNode : mOutputNodes) {
+            if(inFlight.outputs.count(outputNode.first) > 0) {
+                // Output was written directly to this tensor
+                outputs[outputNode.first] = inFlight.outputs[outputNode.first];
+                continue;
+            }
+            const auto index = m_outputIndices[outputNode.first];
+            ov::Tensor ovTensor = request.get_output_tensor(index);
+            const void* data = ovTensor.data();
+            // Get shape of output tensor
+            auto shape = TensorShape();
+            for(int x : ovTensor.get_shape()) {
+                shape.addDimension(x);
+            }
+            outputs[outputNode.first] = Tensor::create(data, shape, getFASTDataType(ovTensor.get_element_type()));
         }
-        const auto name = outputNode.first;
-        outputNode.second.shape = shape;
-        auto outputTensor = Tensor::create(data, shape);
-        outputNode.second.data = outputTensor;
+        reportInfo() << "OpenVINO processing output nodes done." << reportEnd();
+    } catch(ov::Exception &e) {
+        m_infer->freeRequests.push_back(inFlight.index);
+        throw Exception("OpenVINO exception caught: " + std::string(e.what()));
     }
-    reportInfo() << "OpenVINO processing output nodes done." << reportEnd();
+    m_infer->freeRequests.push_back(inFlight.index);
+    m_finishedRequests[id] = outputs;
+}
+
+bool OpenVINOEngine::poll(int request) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if(m_infer->inFlight.count(request) > 0)
+        return m_infer->requests[m_infer->inFlight[request].index].wait_for(std::chrono::milliseconds(0));
+    return InferenceEngine::poll(request);
+}
+
+void OpenVINOEngine::wait(int request) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if(m_infer->inFlight.count(request) > 0)
+        finishRequest(request);
+    InferenceEngine::wait(request);
+}
+
+void OpenVINOEngine::setMaxRequestsInFlight(int requests) {
+    if(requests != m_maxRequestsInFlight && isLoaded()) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if(!m_infer->inFlight.empty())
+            throw Exception("Can't change the max requests in flight of OpenVINOEngine while requests are in flight");
+        // Model has to be compiled again
+        setIsLoaded(false);
+    }
+    InferenceEngine::setMaxRequestsInFlight(requests);
+    // 0 is resolved to the optimal number of requests when the model is compiled in load()
+    m_maxRequestsInFlight = requests;
 }
 
 void OpenVINOEngine::load() {
@@ -95,6 +235,7 @@ void OpenVINOEngine::load() {
                     reportInfo() << "Node was defined by user at id " << mInputNodes[name].id  << reportEnd();
                     if(mInputNodes[name].shape.empty())
                         mInputNodes[name].shape = shape;
+                    mInputNodes[name].dataType = getFASTDataType(inputNode.get_element_type());
                     auto node = mInputNodes[name];
                     if(dynamicInputShapes) {
                         if(!node.minShape.empty() && node.minShape.getUnknownDimensions() == 0 &&
@@ -130,7 +271,9 @@ void OpenVINOEngine::load() {
                     }
                     reshapeMap[name] = ov::PartialShape(dims);
                 }
-                addInputNode(NeuralNetworkNode(name, type, shape, inputCount));
+                NeuralNetworkNode node(name, type, shape, inputCount);
+                node.dataType = getFASTDataType(inputNode.get_element_type());
+                addInputNode(node);
                 ++inputCount;
             }
         }
@@ -155,11 +298,14 @@ void OpenVINOEngine::load() {
                     reportInfo() << "Node was defined by user at id " << mOutputNodes[name].id  << reportEnd();
                     if(mOutputNodes[name].shape.empty())
                         mOutputNodes[name].shape = shape;
+                    mOutputNodes[name].dataType = getFASTDataType(outputNode.get_element_type());
                 } else {
                     reportInfo() << "Ignored output node " << name << " because output nodes were specified, but not this one." << reportEnd();
                 }
             } else {
-                addOutputNode(NeuralNetworkNode(name, type, shape, outputCount));
+                NeuralNetworkNode node(name, type, shape, outputCount);
+                node.dataType = getFASTDataType(outputNode.get_element_type());
+                addOutputNode(node);
                 ++outputCount;
             }
         }
@@ -175,14 +321,37 @@ void OpenVINOEngine::load() {
                 {InferenceDeviceType::CPU, "AUTO:CPU"},
                 {InferenceDeviceType::VPU, "AUTO:MYRIAD"},
                 };
-        ov::CompiledModel compiled_model = m_core->compile_model(model, deviceMap[m_deviceType]);
+        // With several requests in flight, optimize for throughput instead of latency of a single request
+        const auto performanceMode = m_maxRequestsInFlight == 1 ? ov::hint::PerformanceMode::LATENCY : ov::hint::PerformanceMode::THROUGHPUT;
+        if(!getCachePath().empty()) {
+            // OpenVINO caches compiled models by itself, for each model, device and configuration
+            const std::string cachePath = join(getCachePath(), "openvino");
+            createDirectories(cachePath);
+            m_core->set_property(ov::cache_dir(cachePath));
+        }
+        ov::CompiledModel compiled_model = m_core->compile_model(model, deviceMap[m_deviceType], ov::hint::performance_mode(performanceMode));
         reportInfo() << "OpenVINO successfully compiled model" << reportEnd();
-        ov::Any execution_devices = compiled_model.get_property(ov::execution_devices);
-        reportInfo() << "OpenVINO is running network on " << execution_devices->to_string() << reportEnd();
+        const std::vector<std::string> executionDevices = compiled_model.get_property(ov::execution_devices);
+        // AUTO resolves to the CPU when there is no other device, e.g. on CPU-only inference nodes
+        m_runsOnCPU = !executionDevices.empty() && std::all_of(executionDevices.begin(), executionDevices.end(),
+                [](const std::string& device) { return device.rfind("CPU", 0) == 0; });
+        std::string executionDevicesString;
+        for(const auto& device : executionDevices)
+            executionDevicesString += (executionDevicesString.empty() ? "" : ", ") + device;
+        reportInfo() << "OpenVINO is running network on " << executionDevicesString << reportEnd();
 
-        // Create infer request
+        // Create infer requests
+        if(m_maxRequestsInFlight == 0) {
+            m_maxRequestsInFlight = std::max<int>(compiled_model.get_property(ov::optimal_number_of_infer_requests), 1);
+            reportInfo() << "OpenVINO optimal number of infer requests is " << m_maxRequestsInFlight << reportEnd();
+        }
         m_infer = std::make_shared<OpenVINOInfer>();
-        m_infer->request = compiled_model.create_infer_request();
+        for(int i = 0; i < compiled_model.outputs().size(); ++i)
+            m_infer->outputShapes[i] = compiled_model.output(i).get_partial_shape();
+        for(int i = 0; i < m_maxRequestsInFlight; ++i) {
+            m_infer->requests.push_back(compiled_model.create_infer_request());
+            m_infer->freeRequests.push_back(i);
+        }
 
         setIsLoaded(true);
     } catch(ov::Exception &e) {
@@ -22,6 +22,11 @@ class INFERENCEENGINEOPENVINO_EXPORT OpenVINOEngine : public InferenceEngine {
 
         void load() override;
 
+        int submit() override;
+        bool poll(int request) override;
+        void wait(int request) override;
+        void setMaxRequestsInFlight(int requests) override;
+
         ImageOrdering getPreferredImageOrdering() const override;
 
         std::string getName() const override;
@@ -50,6 +55,8 @@ class INFERENCEENGINEOPENVINO_EXPORT OpenVINOEngine : public InferenceEngine {
 
         ~OpenVINOEngine();
     private:
+        void finishRequest(int request);
+
         std::shared_ptr<OpenVINOInfer> m_infer;
 
         // This mutex is used to ensure only one thread is using this OpenVINO instance at the same time
@@ -70,7 +70,7 @@ TensorFlowTensor::~TensorFlowTensor() {
     delete m_tensorflowTensor;
 }
 
-float* TensorFlowTensor::getHostDataPointer() {
+void* TensorFlowTensor::getHostDataPointer() {
     return m_tensorflowTensor->tensor.flat<float>().data();
 }
 
@@ -186,6 +186,11 @@ void TensorFlowEngine::load() {
     } else if (m_deviceIndex >= 0) {
         config.mutable_gpu_options()->set_visible_device_list(std::to_string(m_deviceIndex)); // Use specific GPU
     }
+#if defined(FAST_TENSORFLOW_CUDA) || defined(FAST_TENSORFLOW_ROCM)
+    m_runsOnCPU = false;
+#else
+    m_runsOnCPU = true; // TensorFlow built without GPU support
+#endif
 
 	tensorflow::GraphDef tensorflow_graph;
 
@@ -145,7 +145,7 @@ void TensorRTEngine::run() {
 
     // Allocate data for each input and copy data to it
     for(const auto& inputNode : mInputNodes) {
-        auto tensor = inputNode.second.data;
+        auto tensor = inputNode.second.data->toDataType(TYPE_FLOAT);
         auto access = tensor->getAccess(ACCESS_READ);
         float* tensorData = access->getRawData();
         const int index = m_inputIndexes.at(inputNode.first);
@@ -43,7 +43,7 @@ __kernel void normalize2DInput(
 	const int width = get_global_size(0);
 	const int height = get_global_size(1);
     if(channelFirst == 0) {
-        int position = (pos.x + pos.y*width)*channels;
+        int position = (x + pos.y*width)*channels;
         output[position] = value.x;
         if(channels > 1)
             output[position+1] = value.y;
@@ -52,7 +52,7 @@ __kernel void normalize2DInput(
         if(channels > 3)
             output[position+3] = value.w;
     } else {
-        int position = pos.x + pos.y*width;
+        int position = x + pos.y*width;
         output[position] = value.x;
         if(channels > 1)
             output[position + 1*width*height] = value.y;
@@ -3,6 +3,7 @@
 #include "FAST/Data/Tensor.hpp"
 #include "FAST/Algorithms/ImageResizer/ImageResizer.hpp"
 #include "InferenceEngineManager.hpp"
+#include "FAST/Streamers/Streamer.hpp"
 
 
 namespace fast {
@@ -64,6 +65,8 @@ void NeuralNetwork::loadAttributes() {
     setSignedInputNormalization(getBooleanAttribute("signed-input-normalization"));
     setPreserveAspectRatio(getBooleanAttribute("preserve-aspect"));
 
+    setMaxFramesInFlight(getIntegerAttribute("frames-in-flight"));
+
     // Load network here so that input and output nodes are readily defined after loadAttributes()
 	load(getStringAttribute("model"));
 }
@@ -135,6 +138,7 @@ NeuralNetwork::NeuralNetwork() {
 	createBooleanAttribute("signed-input-normalization", "Signed input normalization", "Normalize input to -1 and 1 instead of 0 to 1.", false);
     createBooleanAttribute("preserve-aspect", "Preserve aspect ratio of input images", "", mPreserveAspectRatio);
     createStringAttribute("dimension-ordering", "Dimension ordering", "Dimension ordering (channel-last or channel-first), will override auto detecting if set.", "");
+    createIntegerAttribute("frames-in-flight", "Frames in flight", "Max number of frames in flight in the inference engine. 0 means the optimal number of the engine.", 1);
 
 	m_engine = InferenceEngineManager::loadBestAvailableEngine();
 	reportInfo() << "Inference engine " << m_engine->getName() << " selected" << reportEnd();
@@ -143,6 +147,8 @@ NeuralNetwork::NeuralNetwork() {
 std::unordered_map<std::string, Tensor::pointer> NeuralNetwork::processInputData() {
     std::unordered_map<std::string, Tensor::pointer> tensors;
     m_batchSize = -1;
+    m_batchInput = false;
+    mInputTensors.clear();
     for(auto inputNode : m_engine->getInputNodes()) {
         auto shape = inputNode.second.shape;
         if(shape.getDimensions() == 0)
@@ -170,6 +176,7 @@ std::unordered_map<std::string, Tensor::pointer> NeuralNetwork::processInputData
             std::vector<Image::pointer> inputImages;
             std::vector<Tensor::pointer> inputTensors;
             if(batch) {
+                m_batchInput = true;
                 auto dataList = batch->get();
                 if(dataList.isImages()) {
                     inputImages = dataList.getImages();
@@ -276,6 +283,10 @@ std::unordered_map<std::string, Tensor::pointer> NeuralNetwork::processInputData
                     }
                     shape[0] = m_batchSize;
                     tensors[inputNode.first] = convertImagesToTensor(inputImages, shape, containsSequence);
+                } else if(isPreprocessingOnHost()) {
+                    // Images are resized while being converted to a tensor
+                    shape[0] = m_batchSize;
+                    tensors[inputNode.first] = convertImagesToTensor(inputImages, shape, containsSequence);
                 } else {
                     auto inputImages2 = resizeImages(inputImages, width, height, depth);
                     // Convert images to tensors
@@ -287,16 +298,19 @@ std::unordered_map<std::string, Tensor::pointer> NeuralNetwork::processInputData
                 mInputTensors[inputNode.first] = inputTensors;
                 // We have a list of tensors, convert the list of tensors into a single tensor
                 auto shape = inputTensors.front()->getShape();
-                m_batchSize = shape[0];
                 shape.insertDimension(0, inputTensors.size());
-                auto tensor = Tensor::create(shape);
-                auto access = tensor->getAccess(ACCESS_READ_WRITE);
-                float* data = access->getRawData();
-                for(int i = 0; i < inputTensors.size(); ++i) {
-                    auto accessRead = inputTensors[i]->getAccess(ACCESS_READ);
-                    const int totalSize = accessRead->getShape().getTotalSize();
-                    std::memcpy(&data[i*totalSize], accessRead->getRawData(), totalSize*sizeof(float));
+                const DataType type = inputTensors.front()->getDataType();
+                auto tensor = Tensor::create(shape, type);
+                {
+                    auto access = tensor->getAccess(ACCESS_READ_WRITE);
+                    uchar* data = (uchar*)access->get();
+                    for(int i = 0; i < inputTensors.size(); ++i) {
+                        auto accessRead = inputTensors[i]->toDataType(type)->getAccess(ACCESS_READ);
+                        const std::size_t bytes = accessRead->getShape().getTotalSize()*getSizeOfDataType(type, 1);
+                        std::memcpy(&data[i*bytes], accessRead->get(), bytes);
+                    }
                 }
+                tensors[inputNode.first] = tensor;
             }
         } else {
             // TODO fix ordering if necessary. We are now assuming that input tensors are in correct ordering.
@@ -304,6 +318,8 @@ std::unordered_map<std::string, Tensor::pointer> NeuralNetwork::processInputData
             tensors[inputNode.first] = tensor;
             mInputTensors[inputNode.first].push_back(tensor);
         }
+        // Convert to the data type of the input node, e.g. uint8 for a model which normalizes the input itself
+        tensors[inputNode.first] = tensors[inputNode.first]->toDataType(inputNode.second.dataType);
         mRuntimeManager->stopRegularTimer("input_processing");
 	}
 
@@ -323,27 +339,39 @@ inline int getPosition(int x, int nrOfClasses, int j, int size, ImageOrdering or
     return ordering == ImageOrdering::ChannelLast ? x*nrOfClasses + j : x + j*size;
 }
 
+template <class T>
+static void convertToChannelLast(const void* input, void* output, int size, int nrOfClasses) {
+    const T* inputData = (const T*)input;
+    T* outputData = (T*)output;
+    for(int x = 0; x < size; ++x) {
+        for(int j = 0; j < nrOfClasses; ++j) {
+            outputData[getPosition(x, nrOfClasses, j, size, ImageOrdering::ChannelLast)] = inputData[getPosition(x, nrOfClasses, j, size, ImageOrdering::ChannelFirst)];
+        }
+    }
+}
+
 Tensor::pointer NeuralNetwork::standardizeOutputTensorData(Tensor::pointer tensor, int sample) {
     // Transform tensor to channel last if necessary
-    if(m_engine->getPreferredImageOrdering() == ImageOrdering::ChannelFirst) {
+    if(m_engine->getPreferredImageOrdering() == ImageOrdering::ChannelFirst && m_channelLastOutput) {
         // Convert to channel last
         const int nrOfClasses = tensor->getShape()[0];
         const int size = tensor->getShape().getTotalSize()/nrOfClasses;
-        auto newTensorData = make_uninitialized_unique<float[]>(size*nrOfClasses);
-        auto tensorAccess = tensor->getAccess(ACCESS_READ);
-        const float* tensorData = tensorAccess->getRawData();
-        // TODO move to GPU (if tensor is large)
-        for(int x = 0; x < size; ++x) {
-            for(uchar j = 0; j < nrOfClasses; ++j) {
-                newTensorData[getPosition(x, nrOfClasses, j, size, ImageOrdering::ChannelLast)] = tensorData[getPosition(x, nrOfClasses, j, size, ImageOrdering::ChannelFirst)];
-            }
-        }
         auto oldShape = tensor->getShape();
         TensorShape newShape;
         for(int i = 1; i < oldShape.getDimensions(); ++i)
             newShape.addDimension(oldShape[i]);
         newShape.addDimension(oldShape[0]);
-        auto newTensor = Tensor::create(std::move(newTensorData), newShape);
+        auto newTensor = Tensor::create(newShape, tensor->getDataType());
+        {
+            auto tensorAccess = tensor->getAccess(ACCESS_READ);
+            auto newTensorAccess = newTensor->getAccess(ACCESS_READ_WRITE);
+            // TODO move to GPU (if tensor is large)
+            switch(tensor->getDataType()) {
+                fastSwitchTensorTypeMacro(convertToChannelLast<FAST_TYPE>(tensorAccess->get(), newTensorAccess->get(), size, nrOfClasses));
+                default:
+                    break;
+            }
+        }
         newTensor->setSpacing(tensor->getSpacing());
         tensor = newTensor;
     }
@@ -351,19 +379,17 @@ Tensor::pointer NeuralNetwork::standardizeOutputTensorData(Tensor::pointer tenso
     // Transfer frame data and spacing information from input to output data
     for(auto& inputNode : m_engine->getInputNodes()) {
         if(mInputImages.count(inputNode.first) > 0) {
-            for(auto &&frameData : mInputImages[inputNode.first][sample]->getFrameData())
-                tensor->setFrameData(frameData.first, frameData.second);
+            tensor->mergeFrameData(mInputImages[inputNode.first][sample]->getFrameDataStore());
             for(auto &&lastFrame : mInputImages[inputNode.first][sample]->getLastFrame())
                 tensor->setLastFrame(lastFrame);
             // TODO will cause issue if multiple input images:
             tensor->setSpacing(mNewInputSpacing);
-            tensor->setFrameData("network-input-size-x", std::to_string(m_newInputSize.x()));
-            tensor->setFrameData("network-input-size-y", std::to_string(m_newInputSize.y()));
-            tensor->setFrameData("network-input-size-z", std::to_string(m_newInputSize.z()));
+            tensor->setFrameData("network-input-size-x", m_newInputSize.x());
+            tensor->setFrameData("network-input-size-y", m_newInputSize.y());
+            tensor->setFrameData("network-input-size-z", m_newInputSize.z());
             SceneGraph::setParentNode(tensor, mInputImages[inputNode.first][sample]);
         } else {
-            for(auto &&frameData : mInputTensors[inputNode.first][sample]->getFrameData())
-                tensor->setFrameData(frameData.first, frameData.second);
+            tensor->mergeFrameData(mInputTensors[inputNode.first][sample]->getFrameDataStore());
             for(auto &&lastFrame : mInputTensors[inputNode.first][sample]->getLastFrame())
                 tensor->setLastFrame(lastFrame);
             SceneGraph::setParentNode(tensor, mInputTensors[inputNode.first][sample]);
@@ -378,6 +404,11 @@ void NeuralNetwork::runNeuralNetwork() {
     if(!m_engine->isLoaded())
         m_engine->load();
 
+    if(m_engine->getMaxRequestsInFlight() != 1 || !m_framesInFlight.empty()) {
+        runNeuralNetworkWithFramesInFlight();
+        return;
+    }
+
     // Prepare input data
 	auto inputTensors = processInputData();
 	// Give input tensors to inference engine
@@ -393,12 +424,74 @@ void NeuralNetwork::runNeuralNetwork() {
     processOutputTensors();
 }
 
+void NeuralNetwork::submitFrame() {
+    auto inputTensors = processInputData();
+    for(const auto &node : m_engine->getInputNodes()) {
+        m_engine->setInputData(node.first, inputTensors[node.first]);
+    }
+
+    FrameInFlight frame;
+    frame.request = m_engine->submit();
+    frame.batchSize = m_batchSize;
+    frame.batchInput = m_batchInput;
+    frame.inputImages = mInputImages;
+    frame.inputTensors = mInputTensors;
+    frame.inputSpacing = mNewInputSpacing;
+    frame.inputSize = m_newInputSize;
+    frame.frameData = m_frameData;
+    frame.lastFrame = m_lastFrame;
+    m_framesInFlight.push_back(std::move(frame));
+    // If the input is not a stream, no more frames will arrive
+    m_lastFrameInFlight = !m_lastFrame.empty() || !m_frameData.has("streaming");
+}
+
+void NeuralNetwork::runNeuralNetworkWithFramesInFlight() {
+    if(mTemporalWindow > 0 || !m_temporalStateLinks.empty())
+        throw Exception("Frames in flight is not supported for temporal neural networks");
+
+    if(!m_lastFrameInFlight) {
+        // Submit the current frame. If all inputs are streamers processing all frames, the next frames are queued in the
+        // input data channels by the streamer threads, thus they are pulled from there until the max number of frames are in flight.
+        // Other parents have to be executed by the pipeline to produce the next frame, and are never updated from here.
+        submitFrame();
+        bool inputsAreQueued = true;
+        for(auto&& input : mInputConnections) {
+            auto streamer = std::dynamic_pointer_cast<Streamer>(input.second->getProcessObject());
+            if(!streamer || streamer->getStreamingMode() != StreamingMode::ProcessAllFrames)
+                inputsAreQueued = false;
+        }
+        while(inputsAreQueued && !m_lastFrameInFlight && m_framesInFlight.size() < m_engine->getMaxRequestsInFlight())
+            submitFrame();
+    }
+
+    // Process output of the oldest frame, with the input state of that frame
+    auto frame = std::move(m_framesInFlight.front());
+    m_framesInFlight.pop_front();
+    mRuntimeManager->startRegularTimer("inference");
+    m_engine->wait(frame.request);
+    mRuntimeManager->stopRegularTimer("inference");
+    m_batchSize = frame.batchSize;
+    m_batchInput = frame.batchInput;
+    mInputImages = std::move(frame.inputImages);
+    mInputTensors = std::move(frame.inputTensors);
+    mNewInputSpacing = frame.inputSpacing;
+    m_newInputSize = frame.inputSize;
+    m_frameData = frame.frameData;
+    m_lastFrame = frame.lastFrame;
+    processOutputTensors();
+
+    if(m_framesInFlight.empty()) {
+        m_lastFrameInFlight = false;
+    } else if(m_lastFrameInFlight) {
+        // No more input will arrive, thus execute again for the remaining frames
+        mIsModified = true;
+    }
+}
+
 void NeuralNetwork::processOutputTensors() {
     mRuntimeManager->startRegularTimer("output_processing");
     // Collect output data of network and add to output ports
     for(const auto &node : m_engine->getOutputNodes()) {
-        // TODO if input was a batch, the output should be converted to a batch as well
-        // TODO and any frame data (such as patch info should be transferred)
         auto tensor = m_engine->getOutputData(node.first);
 
         if(m_temporalStateNodes.count(node.first) > 0) {
@@ -406,24 +499,12 @@ void NeuralNetwork::processOutputTensors() {
             continue;
         }
 
-        if(m_batchSize > 1) {
-            // Create a batch of tensors
+        if(m_batchSize > 1 || m_batchInput) {
+            // Create a batch of tensors. This is also done for batches of size 1, which can
+            // occur when batches are dynamic. Each tensor is a view of the output tensor, thus no data is copied.
             std::vector<Tensor::pointer> tensorList;
-            auto tensorAccess = tensor->getAccess(ACCESS_READ);
-            const float* rawTensorData = tensorAccess->getRawData();
-            // Calculate sample size
-            auto shape = tensor->getShape();
-            int size = 1;
-            auto newShape = TensorShape();
-            for(int i = 1; i < shape.getDimensions(); ++i) {
-                size *= shape[i];
-                newShape.addDimension(shape[i]);
-            }
-
             for(int i = 0; i < m_batchSize; ++i) {
-                auto newData = make_uninitialized_unique<float[]>(size);
-                std::memcpy(newData.get(), &(rawTensorData[i*size]), size*sizeof(float));
-                auto newTensor = Tensor::create(std::move(newData), newShape);
+                auto newTensor = tensor->getView(i);
                 newTensor = standardizeOutputTensorData(newTensor, i);
                 tensorList.push_back(newTensor);
             }
@@ -460,8 +541,6 @@ Tensor::pointer NeuralNetwork::convertImagesToTensor(std::vector<Image::pointer>
     // Create input tensor
     auto values = make_uninitialized_unique<float[]>(shape.getTotalSize());
 
-    OpenCLDevice::pointer device = std::dynamic_pointer_cast<OpenCLDevice>(getMainDevice());
-    cl::Program program = getOpenCLProgram(device);
     int depth = 1;
     int timesteps = 0;
     std::string kernelName;
@@ -497,8 +576,15 @@ Tensor::pointer NeuralNetwork::convertImagesToTensor(std::vector<Image::pointer>
             depth = shape[dims - 4];
         }
     }
-    cl::Kernel kernel(program, kernelName.c_str());
     const std::size_t size = width*height*depth*channels; // nr of elements per image
+    if(isPreprocessingOnHost()) {
+        convertImagesToTensorOnHost(images, values.get(), width, height, depth, channels);
+        return Tensor::create(std::move(values), shape);
+    }
+
+    OpenCLDevice::pointer device = std::dynamic_pointer_cast<OpenCLDevice>(getMainDevice());
+    cl::Program program = getOpenCLProgram(device);
+    cl::Kernel kernel(program, kernelName.c_str());
     for(int i = 0; i < images.size(); ++i) {
         auto image = images[i];
         if(image->getWidth() != width ||
@@ -553,6 +639,203 @@ Tensor::pointer NeuralNetwork::convertImagesToTensor(std::vector<Image::pointer>
     return tensor;
 }
 
+bool NeuralNetwork::isPreprocessingOnHost() {
+    auto device = getMainDevice();
+    if(device->isHost() || m_engine->runsOnCPU())
+        return true;
+    // OpenCL CPU devices, e.g. PoCL, run on the same cores as the host code
+    auto openCLDevice = std::dynamic_pointer_cast<OpenCLDevice>(device);
+    return openCLDevice->getDevice().getInfo<CL_DEVICE_TYPE>() == CL_DEVICE_TYPE_CPU;
+}
+
+namespace {
+/**
+ * Input positions and weights for linear interpolation along one axis when resizing.
+ * Samples the same positions as the OpenCL linear sampler with normalized coordinates
+ * and clamp to edge addressing used by ImageResizer.
+ */
+struct SamplePositions {
+    std::vector<int> first;
+    std::vector<int> second;
+    std::vector<float> weight; // of second
+};
+
+SamplePositions getSamplePositions(int outputSize, int inputSize, int scaledSize) {
+    SamplePositions samples;
+    samples.first.resize(outputSize);
+    samples.second.resize(outputSize);
+    samples.weight.resize(outputSize);
+    for(int i = 0; i < outputSize; ++i) {
+        const float position = ((float)i + 0.5f)*inputSize/scaledSize - 0.5f;
+        const int first = (int)std::floor(position);
+        samples.first[i] = std::min(std::max(first, 0), inputSize - 1);
+        samples.second[i] = std::min(std::max(first + 1, 0), inputSize - 1);
+        samples.weight[i] = position - first;
+    }
+    return samples;
+}
+
+struct HostNormalization {
+    // Normalized value is value*scale + offset
+    float scale;
+    float offset;
+    bool clip;
+    float minIntensity;
+    float maxIntensity;
+    bool channelFirst;
+    bool horizontalFlip;
+};
+
+/**
+ * Resize, cast, normalize and reorder one image directly into the input tensor.
+ * Rows are processed in parallel, and the per-row loops over pixels are kept simple so that the compiler
+ * can vectorize them.
+ */
+template <class T>
+void convertImageToTensorOnHost(Image::pointer image, float* output, int width, int height, int depth, int scaledHeight, const HostNormalization& normalization) {
+    auto access = image->getImageAccess(ACCESS_READ);
+    const T* input = (const T*)access->get();
+    const int channels = image->getNrOfChannels();
+    const int inputWidth = image->getWidth();
+    const int inputHeight = image->getHeight();
+    const int inputDepth = image->getDepth();
+    const bool resize = inputWidth != width || inputHeight != height || inputDepth != depth;
+    SamplePositions xSamples, ySamples, zSamples;
+    if(resize) {
+        xSamples = getSamplePositions(width, inputWidth, width);
+        ySamples = getSamplePositions(height, inputHeight, scaledHeight);
+        zSamples = getSamplePositions(depth, inputDepth, depth);
+    }
+    const int64_t volumeSize = (int64_t)width*height*depth;
+    const int rowSize = width*channels;
+    const int rows = height*depth;
+
+    #pragma omp parallel
+    {
+        std::vector<float> values(rowSize);
+        #pragma omp for
+        for(int row = 0; row < rows; ++row) {
+            const int y = row % height;
+            const int z = row / height;
+            if(y >= scaledHeight) {
+                // Padding when preserving aspect ratio
+                std::fill(values.begin(), values.end(), 0.0f);
+            } else if(!resize) {
+                const T* inputRow = input + ((int64_t)z*inputHeight + y)*inputWidth*channels;
+                for(int i = 0; i < rowSize; ++i)
+                    values[i] = (float)inputRow[i];
+            } else {
+                const int64_t rowOffsets[4] = {
+                    ((int64_t)zSamples.first[z]*inputHeight + ySamples.first[y])*inputWidth,
+                    ((int64_t)zSamples.first[z]*inputHeight + ySamples.second[y])*inputWidth,
+                    ((int64_t)zSamples.second[z]*inputHeight + ySamples.first[y])*inputWidth,
+                    ((int64_t)zSamples.second[z]*inputHeight + ySamples.second[y])*inputWidth,
+                };
+                const float yWeight = ySamples.weight[y];
+                const float zWeight = zSamples.weight[z];
+                const float rowWeights[4] = {
+                    (1.0f - yWeight)*(1.0f - zWeight),
+                    yWeight*(1.0f - zWeight),
+                    (1.0f - yWeight)*zWeight,
+                    yWeight*zWeight,
+                };
+                for(int x = 0; x < width; ++x) {
+                    const float xWeight = xSamples.weight[x];
+                    for(int c = 0; c < channels; ++c) {
+                        float value = 0.0f;
+                        for(int i = 0; i < 4; ++i) {
+                            const T* inputRow = input + rowOffsets[i]*channels;
+                            value += rowWeights[i]*((1.0f - xWeight)*inputRow[xSamples.first[x]*channels + c] +
+                                    xWeight*inputRow[xSamples.second[x]*channels + c]);
+                        }
+                        // The resized image has the same data type as the input
+                        values[x*channels + c] = std::is_integral<T>::value ? std::trunc(value) : value;
+                    }
+                }
+            }
+
+            if(normalization.clip) {
+                for(int i = 0; i < rowSize; ++i)
+                    values[i] = std::min(std::max(values[i], normalization.minIntensity), normalization.maxIntensity);
+            }
+            for(int i = 0; i < rowSize; ++i)
+                values[i] = values[i]*normalization.scale + normalization.offset;
+
+            if(normalization.channelFirst) {
+                for(int c = 0; c < channels; ++c) {
+                    float* outputRow = output + c*volumeSize + (int64_t)row*width;
+                    if(normalization.horizontalFlip) {
+                        for(int x = 0; x < width; ++x)
+                            outputRow[width - x - 1] = values[x*channels + c];
+                    } else {
+                        for(int x = 0; x < width; ++x)
+                            outputRow[x] = values[x*channels + c];
+                    }
+                }
+            } else {
+                float* outputRow = output + (int64_t)row*rowSize;
+                if(normalization.horizontalFlip) {
+                    for(int x = 0; x < width; ++x) {
+                        for(int c = 0; c < channels; ++c)
+                            outputRow[(width - x - 1)*channels + c] = values[x*channels + c];
+                    }
+                } else {
+                    std::memcpy(outputRow, values.data(), rowSize*sizeof(float));
+                }
+            }
+        }
+    }
+}
+}
+
+void NeuralNetwork::convertImagesToTensorOnHost(const std::vector<std::shared_ptr<Image>>& images, float* values, int width, int height, int depth, int channels) {
+    mRuntimeManager->startRegularTimer("host input preprocessing");
+    HostNormalization normalization;
+    normalization.scale = mScaleFactor/mStd;
+    normalization.offset = -mMean*mScaleFactor/mStd;
+    if(mSignedInputNormalization) {
+        normalization.scale *= 2.0f;
+        normalization.offset = normalization.offset*2.0f - 1.0f;
+    }
+    normalization.clip = mMinAndMaxIntensitySet;
+    normalization.minIntensity = mMinIntensity;
+    normalization.maxIntensity = mMaxIntensity;
+    normalization.channelFirst = m_engine->getPreferredImageOrdering() == ImageOrdering::ChannelFirst;
+    normalization.horizontalFlip = mHorizontalImageFlipping;
+
+    m_newInputSize = Vector3i(width, height, depth);
+    const std::size_t size = (std::size_t)width*height*depth*channels; // nr of elements per image
+    for(int i = 0; i < images.size(); ++i) {
+        auto image = images[i];
+        if(image->getNrOfChannels() != channels)
+            throw Exception("Input image sent to executeNetwork has incorrect nr of channels: " +
+                    std::to_string(image->getNrOfChannels())+ ". Expected: " + std::to_string(channels) + ".");
+        // Resize the same way as ImageResizer in resizeImages
+        Vector3f spacing = image->getSpacing();
+        int scaledHeight = height;
+        if(width != image->getWidth() || height != image->getHeight() || depth != image->getDepth()) {
+            if(mPreserveAspectRatio) {
+                if(image->getDimensions() == 3)
+                    throw NotImplementedException();
+                const float scale = (float)image->getWidth() / width;
+                scaledHeight = (int)std::round(image->getHeight()/scale);
+                spacing = Vector3f(spacing.x()*scale, spacing.y()*scale, 1.0f);
+            } else {
+                spacing = Vector3f(
+                        spacing.x()*((float)image->getWidth()/width),
+                        spacing.y()*((float)image->getHeight()/height),
+                        image->getDimensions() == 2 ? 1.0f : spacing.z()*((float)image->getDepth()/depth)
+                );
+            }
+        }
+        mNewInputSpacing = spacing;
+        switch(image->getDataType()) {
+            fastSwitchTypeMacro(convertImageToTensorOnHost<FAST_TYPE>(image, values + i*size, width, height, depth, scaledHeight, normalization));
+        }
+    }
+    mRuntimeManager->stopRegularTimer("host input preprocessing");
+}
+
 std::vector<std::shared_ptr<Image>> NeuralNetwork::resizeImages(const std::vector<std::shared_ptr<Image>> &images, int width, int height, int depth) {
     m_newInputSize = Vector3i(width, height, depth);
     mRuntimeManager->startRegularTimer("image input resize");
@@ -588,6 +871,27 @@ void NeuralNetwork::setTemporalWindow(uint window) {
 	mTemporalWindow = window;
 }
 
+void NeuralNetwork::setMaxFramesInFlight(int frames) {
+    if(frames < 0)
+        throw Exception("Max frames in flight must be >= 0");
+    if(!m_framesInFlight.empty())
+        throw Exception("Can't change max frames in flight while frames are in flight");
+    m_engine->setMaxRequestsInFlight(frames);
+    mIsModified = true;
+}
+
+int NeuralNetwork::getMaxFramesInFlight() const {
+    return m_engine->getMaxRequestsInFlight();
+}
+
+void NeuralNetwork::warmUp(std::vector<int> batchSizes, int iterations) {
+    if(!m_engine->isLoaded())
+        m_engine->load();
+    mRuntimeManager->startRegularTimer("warm-up");
+    m_engine->warmUp(batchSizes, iterations);
+    mRuntimeManager->stopRegularTimer("warm-up");
+}
+
 void NeuralNetwork::setSignedInputNormalization(bool signedInputNormalization) {
 	mSignedInputNormalization = signedInputNormalization;
 }
@@ -742,8 +1046,11 @@ void NeuralNetwork::addTemporalState(std::string inputNodeName, std::string outp
 
     // TODO Support batch size other than 1?
     node.shape[0] = 1;
-    auto zeros = std::make_unique<float[]>(node.shape.getTotalSize());
-    auto tensor = Tensor::create(std::move(zeros), node.shape);
+    auto tensor = Tensor::create(node.shape, node.dataType);
+    {
+        auto access = tensor->getAccess(ACCESS_READ_WRITE);
+        std::memset(access->get(), 0, node.shape.getTotalSize()*getSizeOfDataType(node.dataType, 1));
+    }
 
     m_temporalStateNodes[inputNodeName] = tensor;
     m_temporalStateNodes[outputNodeName] = nullptr;
@@ -4,6 +4,7 @@
 #include <FAST/Data/Tensor.hpp>
 #include <FAST/Data/SimpleDataObject.hpp>
 #include "InferenceEngine.hpp"
+#include <deque>
 
 namespace fast {
 
@@ -242,6 +243,39 @@ class FAST_EXPORT NeuralNetwork : public ProcessObject {
 
         virtual void setInputSize(std::string name, std::vector<int> size);
 
+        /**
+         * @brief Set max number of frames in flight in the inference engine
+         *
+         * With more than one frame in flight, the input of the next frames of a stream is processed while
+         * the inference engine runs the previous frames. The output of each frame is thus delayed until the following
+         * frames have been submitted. The next frames are pulled from the input queues, thus this is only done when
+         * all inputs are connected directly to streamers processing all frames. Otherwise, one frame is processed at a time.
+         * This only gives a speedup with inference engines supporting asynchronous
+         * inference, such as OpenVINO and ONNXRuntime. Temporal neural networks are not supported.
+         *
+         * @param frames 1 means one frame at a time. If 0, the optimal number of requests of the inference engine is used.
+         */
+        void setMaxFramesInFlight(int frames);
+        int getMaxFramesInFlight() const;
+        /**
+         * @brief Load the inference engine, if not already loaded, and warm it up with dummy input data
+         *
+         * Call this before processing starts, to avoid the latency of loading and warming up
+         * the inference engine on the first frames. See InferenceEngine::warmUp.
+         *
+         * @param batchSizes Batch sizes to warm up. If empty, 1 and the max batch size are used.
+         * @param iterations Number of inferences for each batch size
+         */
+        void warmUp(std::vector<int> batchSizes = std::vector<int>(), int iterations = 1);
+        /**
+         * @brief Whether input images are resized, normalized and converted to tensors on the host
+         *
+         * This is done instead of on the OpenCL device when the main device is the host or an OpenCL CPU device,
+         * or when the loaded inference engine runs on the CPU, to avoid a round trip to the OpenCL device.
+         * The inference engine must be loaded.
+         */
+        bool isPreprocessingOnHost();
+
         void loadAttributes();
 
         virtual ~NeuralNetwork();
@@ -252,6 +286,7 @@ class FAST_EXPORT NeuralNetwork : public ProcessObject {
         bool mSignedInputNormalization = false;
         int mTemporalWindow = 0;
         int m_batchSize;
+        bool m_batchInput = false; // Input was a Batch, thus output should be a Batch as well
         float mScaleFactor, mMean, mStd, mMinIntensity, mMaxIntensity;
         bool mMinAndMaxIntensitySet = false;
         Vector3f mNewInputSpacing;
@@ -270,9 +305,34 @@ class FAST_EXPORT NeuralNetwork : public ProcessObject {
         std::vector<std::pair<std::string, std::string>> m_temporalStateLinks;
 
         std::unordered_map<std::string, Tensor::pointer> processInputData();
+
+        /**
+         * Input state of a frame submitted to the inference engine, needed to process its output
+         */
+        struct FrameInFlight {
+            int request;
+            int batchSize;
+            bool batchInput;
+            std::unordered_map<std::string, std::vector<std::shared_ptr<Image>>> inputImages;
+            std::unordered_map<std::string, std::vector<std::shared_ptr<Tensor>>> inputTensors;
+            Vector3f inputSpacing;
+            Vector3i inputSize;
+            FrameData frameData;
+            std::unordered_set<std::string> lastFrame;
+        };
+        std::deque<FrameInFlight> m_framesInFlight;
+        bool m_lastFrameInFlight = false; // Last input frame has been submitted
+        void submitFrame();
+        void runNeuralNetworkWithFramesInFlight();
         std::vector<std::shared_ptr<Image>> resizeImages(const std::vector<std::shared_ptr<Image>>& images, int width, int height, int depth);
         Tensor::pointer convertImagesToTensor(std::vector<std::shared_ptr<Image>> image, const TensorShape& shape, bool temporal);
+        void convertImagesToTensorOnHost(const std::vector<std::shared_ptr<Image>>& images, float* values, int width, int height, int depth, int channels);
 
+        /**
+         * Whether output tensors of channel first inference engines are converted to channel last.
+         * Subclasses which can use channel first output directly can disable this to skip the transpose.
+         */
+        bool m_channelLastOutput = true;
         /**
          * Converts a tensor to channel last image ordering and takes care of frame data and spacing
          * @param tensor
@@ -73,12 +73,15 @@ void SegmentationNetwork::setResizeBackToOriginalSize(bool resize) {
 }
 
 void SegmentationNetwork::execute() {
+    // TensorToSegmentation reads channel first tensors directly, thus only heatmaps need to be channel last
+    m_channelLastOutput = mHeatmapOutput;
     runNeuralNetwork();
 
     auto data = m_processedOutputData[0];
     if(mHeatmapOutput) {
         addOutputData(0, data);
     } else {
+        m_tensorToSegmentation->setChannelOrdering(m_engine->getPreferredImageOrdering());
         m_tensorToSegmentation->setInputData(data);
         auto image = m_tensorToSegmentation->updateAndGetOutputData<Image>();
         if(m_resizeBackToOriginalSize) {
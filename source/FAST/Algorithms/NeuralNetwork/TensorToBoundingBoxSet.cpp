@@ -1,24 +1,27 @@
 #include <FAST/Data/Tensor.hpp>
 #include "TensorToBoundingBoxSet.hpp"
 #include <FAST/Data/BoundingBox.hpp>
+#include "NeuralNetwork.hpp"
 
 namespace fast {
 
-void TensorToBoundingBoxSet::loadAttributes() {
-    setThreshold(getFloatAttribute("threshold"));
-
-    // Duplicate of BoundingBoxNetwork
+std::vector<std::vector<Vector2f>> TensorToBoundingBoxSet::parseAnchors(std::string anchorString) {
     std::vector<std::vector<Vector2f>> anchors;
-    const auto level = split(getStringAttribute("anchors"), ";");
+    const auto level = split(anchorString, ";");
     for(auto&& part : level) {
         const auto parts = split(part, ",");
         std::vector<Vector2f> levelAnchors;
-        for(int i = 0; i < parts.size(); i += 2) {
+        for(int i = 0; i + 1 < parts.size(); i += 2) {
             levelAnchors.push_back(Vector2f(std::stof(parts[i]), std::stof(parts[i+1])));
         }
         anchors.push_back(levelAnchors);
     }
-    setAnchors(anchors);
+    return anchors;
+}
+
+void TensorToBoundingBoxSet::loadAttributes() {
+    setThreshold(getFloatAttribute("threshold"));
+    setAnchors(parseAnchors(getStringAttribute("anchors")));
 }
 
 TensorToBoundingBoxSet::TensorToBoundingBoxSet(BoundingBoxNetworkType type, float threshold,
@@ -32,92 +35,122 @@ TensorToBoundingBoxSet::TensorToBoundingBoxSet(BoundingBoxNetworkType type, floa
     setAnchors(anchors);
 }
 
-/**
- * Calculate array position based on image ordering
- * @param x
- * @param nrOfClasses
- * @param j
- * @param size
- * @param ordering
- * @return
- */
-inline int getPosition(int x, int y, int nrOfClasses, int j, int width, int height) {
-    return j + x*nrOfClasses + y*nrOfClasses*width;
+void TensorToBoundingBoxSet::Detections::clear() {
+    // Keeps the allocated memory
+    coordinates.clear();
+    labels.clear();
+    scores.clear();
+    lines.clear();
+    minimumSize = std::numeric_limits<float>::max();
+}
+
+void TensorToBoundingBoxSet::Detections::add(float x, float y, float width, float height, uchar label, float score) {
+    const uint count = coordinates.size() / 3;
+    const float boxCoordinates[12] = {
+        x, y, 0,
+        x + width, y, 0,
+        x + width, y + height, 0,
+        x, y + height, 0
+    };
+    coordinates.insert(coordinates.end(), boxCoordinates, boxCoordinates + 12);
+    const uint boxLines[8] = {count, count + 1, count + 1, count + 2, count + 2, count + 3, count + 3, count};
+    lines.insert(lines.end(), boxLines, boxLines + 8);
+    labels.insert(labels.end(), 4, label);
+    scores.push_back(score);
+    minimumSize = std::min(minimumSize, std::min(width, height));
 }
 
 inline float sigmoid(float x) {
     return 1.0f / (1.0f + std::exp(-x));
 }
-void TensorToBoundingBoxSet::execute() {
-
-    std::map<int, Tensor::pointer> outputNodes; // Neural network output nodes
-    for(int i = 0; i < getNrOfInputConnections(); ++i) {
-        outputNodes[i] = getInputData<Tensor>(i);
-    }
-
-    //auto inputShape = outputNodes.begin()->second->getShape(); // TODO this should be size of input to network
-    int inputHeight = 256;//inputShape[0]; // TODO fix
-    int inputWidth = 256;//inputShape[1]; // TODO fix
 
-    auto bbset = BoundingBoxSet::create();
-    auto outputAccess = bbset->getAccess(ACCESS_READ_WRITE);
-    int nodeIdx = 0;
-    for(auto node : outputNodes) {
-        auto tensor = std::dynamic_pointer_cast<Tensor>(node.second);
-        Vector3f spacing = tensor->getSpacing();
-        if(!tensor)
-            throw Exception("Output data " + std::to_string(node.first) + " was not a tensor");
-        const auto shape = tensor->getShape();
-        auto access = tensor->getAccess(ACCESS_READ);
-        const int dims = shape.getDimensions();
-        if(dims != 3)
-            throw Exception("Expected nr of output dimensions to be 3");
-
-        int outputHeight;
-        int outputWidth;
-        int channels;
-        outputHeight = shape[0];
-        outputWidth = shape[1];
-        channels = shape[2];
-        float* tensorData = access->getRawData();
-        // Output tensor is 8x8x18, or 8x8x (Anchors * (classes + 5))
-        const int classes = channels / (int)m_anchors[nodeIdx].size() - 5;
-
-        // Loop over grid
-        for(int y = 0; y < outputHeight; ++y) {
-            for(int x = 0; x < outputWidth; ++x) {
-                for(int a = 0; a < m_anchors[nodeIdx].size(); ++a) {
-                    float bestScore = 0.0f;
-                    uchar bestClass = 0;
-                    // Find best class
-                    float objectness = sigmoid(tensorData[getPosition(x, y, channels, a * 6 + 4, outputWidth, outputHeight)]);
-                    for(int classIdx = 0; classIdx < classes; ++classIdx) {
-                        float classPrediction = tensorData[getPosition(x, y, channels, a * 6 + 5 + classIdx, outputWidth, outputHeight)];
-                        float score = objectness * sigmoid(classPrediction);
-                        if(score >= m_threshold && score > bestScore) {
-                            bestClass = classIdx;
-                            bestScore = score;
-                        }
-                    }
-
-                    float t_x = tensorData[getPosition(x, y, channels, a * 6 + 0, outputWidth, outputHeight)];
-                    float t_y = tensorData[getPosition(x, y, channels, a * 6 + 1, outputWidth, outputHeight)];
-                    float t_w = tensorData[getPosition(x, y, channels, a * 6 + 2, outputWidth, outputHeight)];
-                    float t_h = tensorData[getPosition(x, y, channels, a * 6 + 3, outputWidth, outputHeight)];
-                    float b_w = m_anchors[nodeIdx][a].x() * std::exp(t_w);
-                    float b_h = m_anchors[nodeIdx][a].y() * std::exp(t_h);
-                    // Position is center
-                    float b_x = ((sigmoid(t_x) + x) / outputWidth) * inputWidth - 0.5f * b_w;
-                    float b_y = ((sigmoid(t_y) + y) / outputHeight) * inputHeight - 0.5f * b_h;
-                    // Check if the bbox is properly inside the patch (at least 0.5 should be inside patch)
-                    //float intersectionArea = (std::min(b_x + b_w, (float)inputWidth) - std::max(b_x, 0.0f)) * (std::min(b_y + b_h, (float)inputHeight) - std::max(b_y, 0.0f));
-                    if (bestScore >= m_threshold/* && intersectionArea/(b_w*b_h) >= 0.5*/) {
-                        outputAccess->addBoundingBox(Vector2f(b_x*spacing.x(), b_y*spacing.y()), Vector2f(b_w*spacing.x(), b_h*spacing.y()), bestClass + 1, bestScore);
+void TensorToBoundingBoxSet::decode(const float* data, const TensorShape& shape, const std::vector<Vector2f>& anchors,
+                                    Vector2f inputSize, Vector3f spacing, Vector2f offset) {
+    if(shape.getDimensions() != 3)
+        throw Exception("Expected nr of output dimensions to be 3");
+    if(anchors.empty())
+        throw Exception("No anchors given to TensorToBoundingBoxSet");
+    const int outputHeight = shape[0];
+    const int outputWidth = shape[1];
+    const int channels = shape[2];
+    // Output tensor is height x width x (anchors * (classes + 5))
+    const int nrOfAnchors = anchors.size();
+    const int anchorChannels = channels / nrOfAnchors;
+    const int classes = anchorChannels - 5;
+    if(classes < 1)
+        throw Exception("Output tensor of bounding box network has too few channels for the given anchors");
+    // Score is sigmoid(objectness)*sigmoid(class), thus sigmoid(objectness) must be above the threshold.
+    // Compare logits to avoid computing the sigmoid of every cell.
+    const float objectnessThreshold = m_threshold <= 0.0f ? std::numeric_limits<float>::lowest() :
+            (m_threshold >= 1.0f ? std::numeric_limits<float>::max() : std::log(m_threshold / (1.0f - m_threshold)));
+
+    for(int y = 0; y < outputHeight; ++y) {
+        for(int x = 0; x < outputWidth; ++x) {
+            const float* cell = data + ((std::size_t)y*outputWidth + x)*channels;
+            for(int a = 0; a < nrOfAnchors; ++a) {
+                const float* prediction = cell + a*anchorChannels;
+                if(prediction[4] < objectnessThreshold)
+                    continue;
+                // Sigmoid is monotonic, thus the best class is the one with the largest logit
+                int bestClass = 0;
+                float bestLogit = prediction[5];
+                for(int classIdx = 1; classIdx < classes; ++classIdx) {
+                    if(prediction[5 + classIdx] > bestLogit) {
+                        bestLogit = prediction[5 + classIdx];
+                        bestClass = classIdx;
                     }
                 }
+                const float score = sigmoid(prediction[4]) * sigmoid(bestLogit);
+                if(score < m_threshold)
+                    continue;
+
+                const float b_w = anchors[a].x() * std::exp(prediction[2]);
+                const float b_h = anchors[a].y() * std::exp(prediction[3]);
+                // Position is center
+                const float b_x = ((sigmoid(prediction[0]) + x) / outputWidth) * inputSize.x() - 0.5f * b_w;
+                const float b_y = ((sigmoid(prediction[1]) + y) / outputHeight) * inputSize.y() - 0.5f * b_h;
+                m_detections.add(b_x*spacing.x() + offset.x(), b_y*spacing.y() + offset.y(), b_w*spacing.x(), b_h*spacing.y(), bestClass + 1, score);
+            }
+        }
+    }
+}
+
+void TensorToBoundingBoxSet::execute() {
+    m_detections.clear();
+    for(int i = 0; i < getNrOfInputConnections(); ++i) {
+        if(i >= m_anchors.size())
+            throw Exception("Missing anchors for output node " + std::to_string(i) + " in TensorToBoundingBoxSet");
+        auto data = getInputData<DataObject>(i);
+        std::vector<Tensor::pointer> tensors;
+        Vector2f offset = Vector2f::Zero();
+        bool isBatch = false;
+        if(auto batch = std::dynamic_pointer_cast<Batch>(data)) {
+            tensors = batch->get().getTensors();
+            isBatch = true;
+        } else if(auto tensor = std::dynamic_pointer_cast<Tensor>(data)) {
+            tensors.push_back(tensor);
+        } else {
+            throw Exception("Output data " + std::to_string(i) + " was not a tensor or batch");
+        }
+        for(auto tensor : tensors) {
+            // Boxes are given in pixels of the network input
+            Vector2f inputSize(256, 256);
+            if(tensor->hasFrameData("network-input-size-x")) {
+                inputSize = Vector2f(tensor->getFrameData<int>("network-input-size-x"), tensor->getFrameData<int>("network-input-size-y"));
             }
+            if(isBatch)
+                offset = BoundingBoxSetAccumulator::getPatchOffset(tensor);
+            // Output of half precision and quantized networks are converted to float
+            auto floatTensor = tensor->toDataType(TYPE_FLOAT);
+            auto access = floatTensor->getAccess(ACCESS_READ);
+            decode(access->getRawData(), floatTensor->getShape(), m_anchors[i], inputSize, tensor->getSpacing(), offset);
         }
-        ++nodeIdx;
+    }
+
+    auto bbset = BoundingBoxSet::create();
+    if(!m_detections.scores.empty()) {
+        auto outputAccess = bbset->getAccess(ACCESS_READ_WRITE);
+        outputAccess->addBoundingBoxes(m_detections.coordinates, m_detections.lines, m_detections.labels, m_detections.scores, m_detections.minimumSize);
     }
     addOutputData(0, bbset);
 }
@@ -18,6 +18,12 @@ enum class BoundingBoxNetworkType {
  * @brief Convert a tensor to a set of bounding boxes
  *
  * Used in BoundingBoxNetwork to convert a tensor to a set of bounding boxes.
+ * Cells are first culled on objectness, and only the class with the highest logit is considered for the rest,
+ * thus only a few exponentials are computed per output tensor.
+ *
+ * The input can also be a Batch of tensors, which are decoded in one pass. The output is then a single
+ * bounding box set, where the bounding boxes of each sample is moved to the position of its patch in the full image,
+ * using the patch frame data from PatchGenerator.
  *
  * @sa BoundingBoxNetwork BoundingBoxNetworkType
  * @ingroup neural-network bounding-box
@@ -41,13 +47,34 @@ class FAST_EXPORT TensorToBoundingBoxSet : public ProcessObject {
         void setType(BoundingBoxNetworkType type);
         void setThreshold(float threshold);
         void setAnchors(std::vector<std::vector<Vector2f>> anchors);
+        /**
+         * @brief Parse anchors from string
+         * @param anchors Formatted like: x1,y1,x2,y2;x1,y1,x2,y2 where ; separates the levels
+         * @return anchors for each level
+         */
+        static std::vector<std::vector<Vector2f>> parseAnchors(std::string anchors);
         void setInputConnection(DataChannel::pointer channel) override;
         void setInputConnection(uint portID, DataChannel::pointer channel) override;
         void setNrOfInputNodes(int nr);
         void loadAttributes() override;
     private:
         void execute() override;
+        /**
+         * Bounding boxes as a structure of arrays, which is reused between executions to avoid allocations
+         */
+        struct Detections {
+            std::vector<float> coordinates; // 4 vertices with 3 coordinates for each bounding box
+            std::vector<uchar> labels; // 4 labels for each bounding box, one for each vertex
+            std::vector<float> scores;
+            std::vector<uint> lines;
+            float minimumSize = std::numeric_limits<float>::max();
+            void clear();
+            void add(float x, float y, float width, float height, uchar label, float score);
+        };
+        void decode(const float* data, const TensorShape& shape, const std::vector<Vector2f>& anchors,
+                    Vector2f inputSize, Vector3f spacing, Vector2f offset);
 
+        Detections m_detections;
         BoundingBoxNetworkType m_type;
         std::vector<std::vector<Vector2f>> m_anchors;
         float m_threshold = 0.5;
@@ -13,7 +13,8 @@ TensorToImage::TensorToImage(std::vector<int> channels) {
 }
 
 void TensorToImage::execute() {
-    auto tensor = getInputData<Tensor>();
+    // Half precision and quantized tensors are converted to float
+    auto tensor = getInputData<Tensor>()->toDataType(TYPE_FLOAT);
     const auto shape = tensor->getShape();
     auto access = tensor->getAccess(ACCESS_READ);
     const int dims = shape.getDimensions();
@@ -6,109 +6,174 @@
 
 namespace fast {
 
-/**
- * Calculate array position based on image ordering
- * @param x
- * @param nrOfClasses
- * @param j
- * @param size
- * @param ordering
- * @return
- */
-inline int getPosition(int x, int nrOfClasses, int j) {
-    return x*nrOfClasses + j;
-}
-
 TensorToSegmentation::TensorToSegmentation(float threshold, bool hasBackgroundClass, std::vector<int> channelsToIgnore) {
     createInputPort<Tensor>(0);
     createOutputPort<Image>(0);
+    createOutputPort<Image>(1);
 
     createFloatAttribute("threshold", "Segmentation threshold", "Lower threshold of accepting a label", m_threshold);
+    createIntegerAttribute("probability-output-channel", "Probability output channel", "Channel to output as a probability map on output port 1. -1 means disabled", m_probabilityOutputChannel);
     setThreshold(threshold);
     setBackgroundClass(hasBackgroundClass);
     setChannelsToIgnore(channelsToIgnore);
 }
 
+/**
+ * Find the class with the highest value above the threshold for each pixel.
+ * Pixels are processed in blocks, one class at a time, with branch free updates of the best value and class of
+ * each pixel. The channel ordering is a template parameter. With channel first, each class is read with a literal
+ * stride of 1, and the inner loop vectorizes with contiguous loads. With channel last, the classes of a pixel are
+ * interleaved, so each vector is assembled from loads with a stride of nrOfClasses. Only the compare and select are
+ * vectorized then, but the block stays in cache between classes.
+ */
+template <bool channelFirst, class T>
+static void computeSegmentationBlocks(const T* tensorData, uchar* data, float* probabilityData, int64_t size, int nrOfClasses,
+                                      const std::vector<int>& classes, const std::vector<uchar>& labels, float threshold,
+                                      int probabilityChannel) {
+    constexpr int blockSize = 256;
+    const int64_t blocks = (size + blockSize - 1) / blockSize;
+    // Offset between pixels and between classes. The pixel stride is the literal 1 when channel first.
+    const int64_t pixelStride = channelFirst ? 1 : nrOfClasses;
+    const int64_t classStride = channelFirst ? size : 1;
+    #pragma omp parallel for if(blocks > 16)
+    for(int64_t block = 0; block < blocks; ++block) {
+        const int64_t start = block*blockSize;
+        const int count = (int)std::min<int64_t>(blockSize, size - start);
+        float bestValue[blockSize];
+        int bestClass[blockSize];
+        // The first channel is the initial best value, even if it is the background class or ignored
+        const T* firstChannel = tensorData + start*pixelStride;
+        for(int i = 0; i < count; ++i) {
+            bestValue[i] = (float)firstChannel[i*pixelStride];
+            bestClass[i] = -1;
+        }
+        for(int j : classes) {
+            const T* channel = tensorData + start*pixelStride + j*classStride;
+            for(int i = 0; i < count; ++i) {
+                const float value = (float)channel[i*pixelStride];
+                const bool better = value > threshold && value >= bestValue[i];
+                bestValue[i] = better ? value : bestValue[i];
+                bestClass[i] = better ? j : bestClass[i];
+            }
+        }
+        for(int i = 0; i < count; ++i)
+            data[start + i] = bestClass[i] < 0 ? 0 : labels[bestClass[i]];
+        if(probabilityData != nullptr) {
+            const T* channel = tensorData + start*pixelStride + probabilityChannel*classStride;
+            for(int i = 0; i < count; ++i)
+                probabilityData[start + i] = (float)channel[i*pixelStride];
+        }
+    }
+}
+
+/**
+ * Run the segmentation kernel for the data type of the tensor. The tensor is processed in its own data type,
+ * e.g. uint8 or float16 from a quantized or half precision network.
+ */
+template <bool channelFirst>
+static void computeSegmentation(DataType type, const void* tensorData, uchar* data, float* probabilityData, int64_t size, int nrOfClasses,
+                                const std::vector<int>& classes, const std::vector<uchar>& labels, float threshold,
+                                int probabilityChannel) {
+    switch(type) {
+        fastSwitchTensorTypeMacro(computeSegmentationBlocks<channelFirst>((const FAST_TYPE*)tensorData, data, probabilityData, size, nrOfClasses,
+                                                                         classes, labels, threshold, probabilityChannel));
+        default:
+            throw Exception("Unsupported tensor data type in TensorToSegmentation");
+    }
+}
+
 void TensorToSegmentation::execute() {
     auto tensor = getInputData<Tensor>();
 
     auto shape = tensor->getShape();
     const int dims = shape.getDimensions();
-    int outputHeight = shape[dims-3];
-    int outputWidth = shape[dims-2];
-    int outputDepth = 1;
-    auto access = tensor->getAccess(ACCESS_READ);
-    float* tensorData = access->getRawData();
-    if(dims == 4) {
-        outputDepth = shape[dims - 4];
-    }
-    const int size = outputWidth*outputHeight*outputDepth;
+    const bool channelFirst = m_channelOrdering == ImageOrdering::ChannelFirst;
+    // Spatial dimensions are (depth,) height, width, after the channels if channel first, and before if channel last
+    const int spatialStart = channelFirst ? 1 : 0;
+    const int spatialEnd = channelFirst ? dims : dims - 1;
+    if(spatialEnd - spatialStart < 2 || spatialEnd - spatialStart > 3)
+        throw Exception("TensorToSegmentation expects a tensor with 2 or 3 spatial dimensions, got shape " + shape.toString());
+    const int outputHeight = shape[spatialEnd - 2];
+    const int outputWidth = shape[spatialEnd - 1];
+    const int outputDepth = spatialEnd - spatialStart == 3 ? shape[spatialStart] : 1;
+    const int nrOfClasses = channelFirst ? shape[0] : shape[dims - 1];
+    const int64_t size = (int64_t)outputWidth*outputHeight*outputDepth;
+    if(m_probabilityOutputChannel >= nrOfClasses)
+        throw Exception("Probability output channel " + std::to_string(m_probabilityOutputChannel) + " is larger than the number of channels in TensorToSegmentation");
 
-    // TODO Move this to GPU
-    auto data = make_uninitialized_unique<uchar[]>(size);
-    const int nrOfClasses = tensor->getShape()[tensor->getShape().getDimensions()-1];
     int firstClass = (m_hasBackgroundClass && nrOfClasses > 1) ? 1 : 0;
-
-    if(m_channelsToIgnore.empty()) {
-        for(int x = 0; x < size; ++x) {
-            uchar maxClass = 0;
-            bool found = false;
-            for(uchar j = firstClass; j < nrOfClasses; j++) {
-                if(tensorData[getPosition(x, nrOfClasses, j)] > m_threshold &&
-                tensorData[getPosition(x, nrOfClasses, j)] >= tensorData[getPosition(x, nrOfClasses, maxClass)]) {
-                    maxClass = j;
-                    found = true;
-                }
-            }
-            // If no match found: class is background (0).
-            // If a match is found; add (1 - firstClass). Thus if there is no background class, we will add 1 when maxClass is actually 0
-            data[x] = found ? maxClass + (1 - firstClass) : 0;
+    for(int i : m_channelsToIgnore) {
+        reportInfo() << "Ignoring channels: " << i << reportEnd();
+        if(firstClass == i) {
+            firstClass++;
         }
-    } else {
-        // There are channels to ignore.. handle it.
-        std::map<int, int> remapChannels;
-        for(int i : m_channelsToIgnore) {
-            reportInfo() << "Ignoring channels: " << i << reportEnd();
-            if(firstClass == i) {
-                firstClass++;
-            }
-        }
-        int counter = 0;
-        for(int i = 0; i < nrOfClasses; ++i) {
-            if(m_channelsToIgnore.count(i) == 0) {
-                remapChannels[i] = counter;
-                ++counter;
-            }
-        }
-        for(int x = 0; x < size; ++x) {
-            uchar maxClass = 0;
-            bool found = false;
-            for(uchar j = firstClass; j < nrOfClasses; j++) {
-                if(m_channelsToIgnore.count(j) > 0)
-                    continue;
-                if(tensorData[getPosition(x, nrOfClasses, j)] > m_threshold &&
-                tensorData[getPosition(x, nrOfClasses, j)] >= tensorData[getPosition(x, nrOfClasses, maxClass)]) {
-                    maxClass = j;
-                    found = true;
-                }
-            }
-            // Remap values if channelsToIgnore
-            if(!m_channelsToIgnore.empty())
-                maxClass = remapChannels[maxClass];
-            // If no match found: class is background (0).
-            // If a match is found; add (1 - firstClass). Thus if there is no background class, we will add 1 when maxClass is actually 0
-            data[x] = found ? maxClass + (1 - firstClass) : 0;
+    }
+    // Classes to consider, and the label of each class. Labels are remapped when channels are ignored.
+    // If there is no background class, 1 is added to the label so that label 0 is only used when no class was found.
+    std::vector<int> classes;
+    std::vector<uchar> labels(nrOfClasses, 0);
+    int counter = 0;
+    for(int i = 0; i < nrOfClasses; ++i) {
+        if(m_channelsToIgnore.count(i) > 0)
+            continue;
+        labels[i] = (m_channelsToIgnore.empty() ? i : counter) + (1 - firstClass);
+        ++counter;
+        if(i >= firstClass)
+            classes.push_back(i);
+    }
+
+    auto data = make_uninitialized_unique<uchar[]>(size);
+    std::unique_ptr<float[]> probabilityData;
+    if(m_probabilityOutputChannel >= 0)
+        probabilityData = make_uninitialized_unique<float[]>(size);
+    {
+        auto access = tensor->getAccess(ACCESS_READ);
+        // The channel ordering is dispatched once here, so that the kernel is compiled for each ordering
+        if(channelFirst) {
+            computeSegmentation<true>(tensor->getDataType(), access->get(), data.get(), probabilityData.get(), size, nrOfClasses,
+                                      classes, labels, m_threshold, m_probabilityOutputChannel);
+        } else {
+            computeSegmentation<false>(tensor->getDataType(), access->get(), data.get(), probabilityData.get(), size, nrOfClasses,
+                                       classes, labels, m_threshold, m_probabilityOutputChannel);
         }
     }
     Image::pointer output;
+    Image::pointer probabilityOutput;
     if(outputDepth == 1) {
         output = Image::create(outputWidth, outputHeight, TYPE_UINT8, 1, std::move(data));
+        if(probabilityData)
+            probabilityOutput = Image::create(outputWidth, outputHeight, TYPE_FLOAT, 1, std::move(probabilityData));
     } else {
         output = Image::create(outputWidth, outputHeight, outputDepth, TYPE_UINT8, 1, std::move(data));
+        if(probabilityData)
+            probabilityOutput = Image::create(outputWidth, outputHeight, outputDepth, TYPE_FLOAT, 1, std::move(probabilityData));
     }
     output->setSpacing(tensor->getSpacing());
-
     addOutputData(0, output);
+    if(probabilityOutput) {
+        probabilityOutput->setSpacing(tensor->getSpacing());
+        addOutputData(1, probabilityOutput);
+    }
+}
+
+void TensorToSegmentation::setChannelOrdering(ImageOrdering ordering) {
+    m_channelOrdering = ordering;
+    setModified(true);
+}
+
+ImageOrdering TensorToSegmentation::getChannelOrdering() const {
+    return m_channelOrdering;
+}
+
+void TensorToSegmentation::setProbabilityOutputChannel(int channel) {
+    if(channel < -1)
+        throw Exception("Probability output channel must be >= -1");
+    m_probabilityOutputChannel = channel;
+    setModified(true);
+}
+
+int TensorToSegmentation::getProbabilityOutputChannel() const {
+    return m_probabilityOutputChannel;
 }
 
 void TensorToSegmentation::setThreshold(float threshold) {
@@ -121,6 +186,7 @@ float TensorToSegmentation::getThreshold() const {
 
 void TensorToSegmentation::loadAttributes() {
     setThreshold(getFloatAttribute("threshold"));
+    setProbabilityOutputChannel(getIntegerAttribute("probability-output-channel"));
 }
 
 void TensorToSegmentation::setBackgroundClass(bool hasBackgroundClass) {
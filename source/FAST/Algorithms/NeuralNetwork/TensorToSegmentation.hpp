@@ -1,12 +1,25 @@
 #pragma once
 
 #include <FAST/ProcessObject.hpp>
+#include <FAST/Algorithms/NeuralNetwork/InferenceEngine.hpp>
 
 namespace fast {
 
 /**
  * @brief A process object which converts a Tensor to a Segmentation object.
  *
+ * Each pixel gets the label of the channel with the highest value above the threshold.
+ * Optionally, one of the channels can be output as a probability map on output port 1, without a second pass
+ * over the tensor.
+ *
+ * Inputs:
+ * - 0: Tensor with shape (depth,) height, width, channels, or channels, (depth,) height, width if channel ordering
+ *  is ChannelFirst
+ *
+ * Outputs:
+ * - 0: Image segmentation of type uint8
+ * - 1: Image probability map of type float, only if a probability output channel is set
+ *
  * @ingroup neural-network
  */
 class FAST_EXPORT TensorToSegmentation : public ProcessObject {
@@ -43,12 +56,28 @@ class FAST_EXPORT TensorToSegmentation : public ProcessObject {
          * @param channels
          */
         void setChannelsToIgnore(std::vector<int> channels);
+        /**
+         * @brief Set ordering of the input tensor
+         * ChannelFirst lets a network output tensor be used directly, without transposing it to channel last.
+         * Default: ChannelLast
+         * @param ordering
+         */
+        void setChannelOrdering(ImageOrdering ordering);
+        ImageOrdering getChannelOrdering() const;
+        /**
+         * @brief Output the values of a channel as a probability map on output port 1
+         * @param channel Channel to output. -1 disables the probability map output, which is the default.
+         */
+        void setProbabilityOutputChannel(int channel);
+        int getProbabilityOutputChannel() const;
         void loadAttributes();
     protected:
         void execute() override;
         float m_threshold = 0.5f;
         bool m_hasBackgroundClass = true;
         std::set<int> m_channelsToIgnore;
+        ImageOrdering m_channelOrdering = ImageOrdering::ChannelLast;
+        int m_probabilityOutputChannel = -1;
 };
 
 }
\ No newline at end of file
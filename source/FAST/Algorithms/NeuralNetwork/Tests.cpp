@@ -1,6 +1,10 @@
 #include <FAST/Testing.hpp>
 #include "NeuralNetwork.hpp"
 #include "SegmentationNetwork.hpp"
+#include "TensorToSegmentation.hpp"
+#include "TensorToBoundingBoxSet.hpp"
+#include "TensorToImage.hpp"
+#include <FAST/Data/BoundingBox.hpp>
 #include "InferenceEngineManager.hpp"
 #include <FAST/Importers/ImageFileImporter.hpp>
 #include <FAST/Visualization/SegmentationRenderer/SegmentationRenderer.hpp>
@@ -15,6 +19,7 @@
 #include <FAST/Streamers/ImageFileStreamer.hpp>
 #include <FAST/Visualization/HeatmapRenderer/HeatmapRenderer.hpp>
 #include <FAST/Visualization/Widgets/PlaybackWidget/PlaybackWidget.hpp>
+#include <QDir>
 
 using namespace fast;
 
@@ -190,6 +195,199 @@ TEST_CASE("Single input multi output network", "[fast][neuralnetwork]") {
     }
 }
 
+TEST_CASE("NN with several frames in flight gives same output as one frame at a time", "[fast][neuralnetwork][async]") {
+    // Frames are pulled from the queue of the streamer, while a parent which is not a streamer is never updated by the network
+    for(auto& engine : InferenceEngineManager::getEngineList()) {
+        for(bool streamerIsParent : {true, false}) {
+            std::vector<std::vector<Tensor::pointer>> results;
+            for(int framesInFlight : {1, 3}) {
+                auto streamer = ImageFileStreamer::create(Config::getTestDataPath() + "US/JugularVein/US-2D_#.mhd", false, false);
+                streamer->setMaximumNumberOfFrames(10);
+                ProcessObject::pointer parent = streamer;
+                if(!streamerIsParent)
+                    parent = GaussianSmoothing::create(0.5f)->connect(streamer);
+
+                auto network = NeuralNetwork::New();
+                network->setInferenceEngine(engine);
+                network->setMaxFramesInFlight(framesInFlight);
+                network->load(join(Config::getTestDataPath(),
+                                   "NeuralNetworkModels/jugular_vein_segmentation." +
+                                   getModelFileExtension(network->getInferenceEngine()->getPreferredModelFormat())));
+                network->setScaleFactor(1.0f / 255.0f);
+                network->connect(parent);
+
+                std::vector<Tensor::pointer> tensors;
+                auto stream = DataStream(network);
+                while(!stream.isDone())
+                    tensors.push_back(stream.getNextFrame<Tensor>());
+                results.push_back(tensors);
+            }
+            REQUIRE(results[0].size() == 10);
+            REQUIRE(results[1].size() == results[0].size());
+            CHECK(results[1].back()->isLastFrame());
+            for(int i = 0; i < results[0].size(); ++i) {
+                auto access1 = results[0][i]->getAccess(ACCESS_READ);
+                auto access2 = results[1][i]->getAccess(ACCESS_READ);
+                const int size = results[0][i]->getShape().getTotalSize();
+                REQUIRE(results[1][i]->getShape().getTotalSize() == size);
+                const float* data1 = access1->getRawData();
+                const float* data2 = access2->getRawData();
+                for(int j = 0; j < size; j += 101)
+                    CHECK(data1[j] == Approx(data2[j]).margin(1e-4));
+            }
+        }
+    }
+}
+
+TEST_CASE("NN input preprocessing on host gives same output as on OpenCL device", "[fast][neuralnetwork][host]") {
+    for(auto& engine : InferenceEngineManager::getEngineList()) {
+        std::vector<Tensor::pointer> results;
+        for(bool host : {false, true}) {
+            auto importer = ImageFileImporter::create(Config::getTestDataPath() + "US/JugularVein/US-2D_0.mhd");
+            auto network = NeuralNetwork::New();
+            network->setInferenceEngine(engine);
+            network->load(join(Config::getTestDataPath(),
+                               "NeuralNetworkModels/jugular_vein_segmentation." +
+                               getModelFileExtension(network->getInferenceEngine()->getPreferredModelFormat())));
+            network->setScaleFactor(1.0f / 255.0f);
+            if(host)
+                network->setMainDevice(Host::getInstance());
+            network->connect(importer);
+            results.push_back(network->runAndGetOutputData<Tensor>());
+        }
+        const int size = results[0]->getShape().getTotalSize();
+        REQUIRE(results[1]->getShape().getTotalSize() == size);
+        auto access1 = results[0]->getAccess(ACCESS_READ);
+        auto access2 = results[1]->getAccess(ACCESS_READ);
+        const float* data1 = access1->getRawData();
+        const float* data2 = access2->getRawData();
+        // Resizing on the OpenCL device uses lower precision interpolation weights
+        double difference = 0.0;
+        for(int i = 0; i < size; ++i)
+            difference += std::fabs(data1[i] - data2[i]);
+        CHECK(difference / size < 0.01);
+    }
+}
+
+TEST_CASE("NN input preprocessing on host with default device type when engine runs on CPU", "[fast][neuralnetwork][host]") {
+    for(auto& engine : InferenceEngineManager::getEngineList()) {
+        std::vector<Tensor::pointer> results;
+        for(bool host : {false, true}) {
+            auto importer = ImageFileImporter::create(Config::getTestDataPath() + "US/JugularVein/US-2D_0.mhd");
+            auto network = NeuralNetwork::New();
+            network->setInferenceEngine(engine);
+            network->load(join(Config::getTestDataPath(),
+                               "NeuralNetworkModels/jugular_vein_segmentation." +
+                               getModelFileExtension(network->getInferenceEngine()->getPreferredModelFormat())));
+            REQUIRE(network->getInferenceEngine()->getDeviceType() == InferenceDeviceType::ANY);
+#if !defined(WIN32) && !defined(__APPLE__)
+            // ONNX Runtime has only the CPU execution provider on Linux
+            if(engine == "ONNXRuntime")
+                REQUIRE(network->getInferenceEngine()->runsOnCPU());
+#endif
+            if(!network->getInferenceEngine()->runsOnCPU())
+                break;
+            network->setScaleFactor(1.0f / 255.0f);
+            if(host)
+                network->setMainDevice(Host::getInstance());
+            CHECK(network->isPreprocessingOnHost());
+            network->connect(importer);
+            results.push_back(network->runAndGetOutputData<Tensor>());
+        }
+        if(results.size() < 2) // Engine runs on a GPU
+            continue;
+        // Both use the host path, with and without the host as main device
+        const int size = results[0]->getShape().getTotalSize();
+        REQUIRE(results[1]->getShape().getTotalSize() == size);
+        auto access1 = results[0]->getAccess(ACCESS_READ);
+        auto access2 = results[1]->getAccess(ACCESS_READ);
+        const float* data1 = access1->getRawData();
+        const float* data2 = access2->getRawData();
+        for(int i = 0; i < size; ++i)
+            CHECK(data1[i] == Approx(data2[i]).margin(1e-4));
+    }
+}
+
+TEST_CASE("Inference engine async requests", "[fast][neuralnetwork][async]") {
+    for(auto& engine : InferenceEngineManager::getEngineList()) {
+        auto importer = ImageFileImporter::create(Config::getTestDataPath() + "US/JugularVein/US-2D_0.mhd");
+        auto network = NeuralNetwork::New();
+        network->setInferenceEngine(engine);
+        network->setMaxFramesInFlight(0);
+        network->load(join(Config::getTestDataPath(),
+                           "NeuralNetworkModels/jugular_vein_segmentation." +
+                           getModelFileExtension(network->getInferenceEngine()->getPreferredModelFormat())));
+        network->connect(importer);
+        auto tensor = network->runAndGetOutputData<Tensor>();
+        CHECK(network->getMaxFramesInFlight() >= 1);
+
+        // Submit the same input several times, and wait for the results in reverse order
+        auto inferenceEngine = network->getInferenceEngine();
+        std::vector<int> requests;
+        for(int i = 0; i < 4; ++i)
+            requests.push_back(inferenceEngine->submit());
+        for(int i = 3; i >= 0; --i) {
+            inferenceEngine->wait(requests[i]);
+            auto output = inferenceEngine->getOutputData(inferenceEngine->getOutputNodes().begin()->first);
+            CHECK(output->getShape().getTotalSize() == tensor->getShape().getTotalSize());
+        }
+        CHECK_THROWS(inferenceEngine->wait(requests[0]));
+    }
+}
+
+TEST_CASE("NN warm up and cached engine give same output", "[fast][neuralnetwork][cache]") {
+    const std::string cachePath = InferenceEngineManager::getCachePath();
+    const std::string testCachePath = join(Config::getKernelBinaryPath(), "inference_engines_test");
+    QDir(testCachePath.c_str()).removeRecursively();
+    InferenceEngineManager::setCachePath(testCachePath);
+    for(auto& engine : InferenceEngineManager::getEngineList()) {
+        std::vector<Tensor::pointer> results;
+        // Second time the engine is loaded from the cache
+        for(int i = 0; i < 2; ++i) {
+            auto importer = ImageFileImporter::create(Config::getTestDataPath() + "US/JugularVein/US-2D_0.mhd");
+            auto network = NeuralNetwork::New();
+            network->setInferenceEngine(engine);
+            // ONNX Runtime only caches CPU sessions
+            network->getInferenceEngine()->setDeviceType(InferenceDeviceType::CPU);
+            const std::string modelFilename = join(Config::getTestDataPath(),
+                               "NeuralNetworkModels/jugular_vein_segmentation." +
+                               getModelFileExtension(network->getInferenceEngine()->getPreferredModelFormat()));
+            network->load(modelFilename);
+            network->setScaleFactor(1.0f / 255.0f);
+            network->warmUp();
+            CHECK(network->getInferenceEngine()->isLoaded());
+            if(i == 0) {
+                // Cache should exist after the first load
+                if(engine == "ONNXRuntime") {
+                    // <model>_<hash>.<ONNX Runtime version>.onnx
+                    const std::string prefix = getFileName(modelFilename) + "_";
+                    bool found = false;
+                    for(auto&& filename : getDirectoryList(testCachePath)) {
+                        if(filename.substr(0, prefix.size()) == prefix && filename.size() > 5 && filename.substr(filename.size() - 5) == ".onnx")
+                            found = true;
+                    }
+                    CHECK(found);
+                } else if(engine == "OpenVINO") {
+                    CHECK(isDir(join(testCachePath, "openvino")));
+                    CHECK_FALSE(getDirectoryList(join(testCachePath, "openvino")).empty());
+                }
+            }
+            network->connect(importer);
+            results.push_back(network->runAndGetOutputData<Tensor>());
+        }
+        const int size = results[0]->getShape().getTotalSize();
+        REQUIRE(results[1]->getShape().getTotalSize() == size);
+        auto access1 = results[0]->getAccess(ACCESS_READ);
+        auto access2 = results[1]->getAccess(ACCESS_READ);
+        const float* data1 = access1->getRawData();
+        const float* data2 = access2->getRawData();
+        for(int j = 0; j < size; j += 101)
+            CHECK(data1[j] == Approx(data2[j]).margin(1e-4));
+    }
+    InferenceEngineManager::setCachePath(cachePath);
+    QDir(testCachePath.c_str()).removeRecursively();
+}
+
 TEST_CASE("Single 3D image input network", "[fast][neuralnetwork][3d]") {
     for(auto& engine : InferenceEngineManager::getEngineList()) {
         auto importer = ImageFileImporter::New();
@@ -391,6 +589,200 @@ TEST_CASE("NN: temporal input temporal output, streaming mode", "[fast][neuralne
     }
 }
 
+TEST_CASE("TensorToSegmentation gives same result for all tensor data types", "[fast][neuralnetwork][TensorToSegmentation]") {
+    // 2x2 image with 3 classes
+    const float values[12] = {
+        0.9f, 0.05f, 0.05f,
+        0.1f, 0.8f, 0.1f,
+        0.2f, 0.2f, 0.6f,
+        0.3f, 0.35f, 0.35f,
+    };
+    auto floatTensor = Tensor::create(values, TensorShape({2, 2, 3}));
+    const uchar expected[4] = {0, 1, 2, 0};
+    for(DataType type : {TYPE_FLOAT, TYPE_FLOAT16, TYPE_UINT8}) {
+        auto input = floatTensor;
+        if(type == TYPE_UINT8) {
+            // Quantized probabilities
+            auto scaled = Tensor::create(TensorShape({2, 2, 3}));
+            {
+                auto access = scaled->getAccess(ACCESS_READ_WRITE);
+                auto inputAccess = floatTensor->getAccess(ACCESS_READ);
+                for(int i = 0; i < 12; ++i)
+                    access->getRawData()[i] = inputAccess->getRawData()[i]*255.0f;
+            }
+            input = scaled;
+        }
+        input = input->toDataType(type);
+        auto segmentation = TensorToSegmentation::create(type == TYPE_UINT8 ? 0.5f*255.0f : 0.5f);
+        segmentation->connect(input);
+        auto image = segmentation->runAndGetOutputData<Image>();
+        auto access = image->getImageAccess(ACCESS_READ);
+        for(int i = 0; i < 4; ++i)
+            CHECK(access->getScalarFast<uchar>(i) == expected[i]);
+    }
+}
+
+TEST_CASE("TensorToImage gives same result for all tensor data types", "[fast][neuralnetwork][TensorToImage]") {
+    // 2x2 image with 3 channels, values are exactly representable in all data types
+    const float values[12] = {
+        0.0f, 1.0f, 2.0f,
+        10.0f, 20.0f, 30.0f,
+        100.0f, 127.0f, 128.0f,
+        200.0f, 250.0f, 255.0f,
+    };
+    auto floatTensor = Tensor::create(values, TensorShape({2, 2, 3}));
+    for(DataType type : {TYPE_FLOAT, TYPE_FLOAT16, TYPE_UINT8}) {
+        auto input = floatTensor->toDataType(type);
+        CHECK(input->getDataType() == type);
+        {
+            auto image = TensorToImage::create()->connect(input)->runAndGetOutputData<Image>();
+            CHECK(image->getDataType() == TYPE_FLOAT);
+            CHECK(image->getNrOfChannels() == 3);
+            auto access = image->getImageAccess(ACCESS_READ);
+            for(int i = 0; i < 12; ++i)
+                CHECK(((float*)access->get())[i] == values[i]);
+        }
+        {
+            auto image = TensorToImage::create({1})->connect(input)->runAndGetOutputData<Image>();
+            CHECK(image->getNrOfChannels() == 1);
+            auto access = image->getImageAccess(ACCESS_READ);
+            for(int i = 0; i < 4; ++i)
+                CHECK(access->getScalarFast<float>(i) == values[i*3 + 1]);
+        }
+    }
+}
+
+TEST_CASE("TensorToSegmentation gives same result for channel first and channel last", "[fast][neuralnetwork][TensorToSegmentation]") {
+    const int width = 67;
+    const int height = 45;
+    const int classes = 4;
+    const int size = width*height;
+    auto channelLast = Tensor::create(TensorShape({height, width, classes}));
+    auto channelFirst = Tensor::create(TensorShape({classes, height, width}));
+    {
+        auto lastAccess = channelLast->getAccess(ACCESS_READ_WRITE);
+        auto firstAccess = channelFirst->getAccess(ACCESS_READ_WRITE);
+        for(int x = 0; x < size; ++x) {
+            for(int j = 0; j < classes; ++j) {
+                const float value = (float)((x*7 + j*13) % 17) / 16.0f;
+                lastAccess->getRawData()[x*classes + j] = value;
+                firstAccess->getRawData()[x + j*size] = value;
+            }
+        }
+    }
+    for(std::vector<int> ignore : {std::vector<int>(), std::vector<int>{2}}) {
+        auto lastSegmentation = TensorToSegmentation::create(0.5f, true, ignore);
+        lastSegmentation->connect(channelLast);
+        auto firstSegmentation = TensorToSegmentation::create(0.5f, true, ignore);
+        firstSegmentation->setChannelOrdering(ImageOrdering::ChannelFirst);
+        firstSegmentation->setProbabilityOutputChannel(1);
+        firstSegmentation->connect(channelFirst);
+        auto lastImage = lastSegmentation->runAndGetOutputData<Image>();
+        auto firstImage = firstSegmentation->runAndGetOutputData<Image>(0);
+        auto probability = firstSegmentation->getOutputData<Image>(1);
+        CHECK(firstImage->getWidth() == width);
+        CHECK(firstImage->getHeight() == height);
+        CHECK(probability->getDataType() == TYPE_FLOAT);
+        auto lastAccess = lastImage->getImageAccess(ACCESS_READ);
+        auto firstAccess = firstImage->getImageAccess(ACCESS_READ);
+        auto probabilityAccess = probability->getImageAccess(ACCESS_READ);
+        auto tensorAccess = channelLast->getAccess(ACCESS_READ);
+        for(int x = 0; x < size; ++x) {
+            REQUIRE(firstAccess->getScalarFast<uchar>(x) == lastAccess->getScalarFast<uchar>(x));
+            REQUIRE(probabilityAccess->getScalarFast<float>(x) == tensorAccess->getRawData()[x*classes + 1]);
+        }
+    }
+}
+
+TEST_CASE("TensorToBoundingBoxSet decodes YOLO output of tensors and batches", "[fast][neuralnetwork][TensorToBoundingBoxSet]") {
+    // 8x8 grid, 2 anchors, 3 classes
+    const int size = 8;
+    const int classes = 3;
+    const std::vector<Vector2f> anchors = {Vector2f(10, 12), Vector2f(20, 18)};
+    const int channels = anchors.size()*(classes + 5);
+    const float threshold = 0.4f;
+    auto tensor = Tensor::create(TensorShape({size, size, channels}));
+    {
+        auto access = tensor->getAccess(ACCESS_READ_WRITE);
+        for(int i = 0; i < size*size*channels; ++i)
+            access->getRawData()[i] = (float)((i*37) % 23) / 11.0f - 1.0f;
+    }
+    tensor->setFrameData("network-input-size-x", 256);
+    tensor->setFrameData("network-input-size-y", 256);
+
+    // Reference: score of every class
+    auto sigmoid = [](float x) { return 1.0f / (1.0f + std::exp(-x)); };
+    std::vector<std::pair<Vector2f, float>> expected;
+    {
+        auto access = tensor->getAccess(ACCESS_READ);
+        const float* data = access->getRawData();
+        for(int y = 0; y < size; ++y) {
+            for(int x = 0; x < size; ++x) {
+                for(int a = 0; a < anchors.size(); ++a) {
+                    const float* prediction = data + (y*size + x)*channels + a*(classes + 5);
+                    float bestScore = 0.0f;
+                    for(int c = 0; c < classes; ++c)
+                        bestScore = std::max(bestScore, sigmoid(prediction[4])*sigmoid(prediction[5 + c]));
+                    if(bestScore < threshold)
+                        continue;
+                    const float width = anchors[a].x()*std::exp(prediction[2]);
+                    const float height = anchors[a].y()*std::exp(prediction[3]);
+                    expected.push_back({Vector2f(
+                            (sigmoid(prediction[0]) + x) / size * 256 - 0.5f*width,
+                            (sigmoid(prediction[1]) + y) / size * 256 - 0.5f*height), bestScore});
+                }
+            }
+        }
+    }
+    REQUIRE(!expected.empty());
+
+    auto decoder = TensorToBoundingBoxSet::create(BoundingBoxNetworkType::YOLOv3, threshold, {anchors});
+    decoder->setNrOfInputNodes(1);
+    decoder->setInputData(0, tensor);
+    auto bbset = decoder->updateAndGetOutputData<BoundingBoxSet>();
+    {
+        auto access = bbset->getAccess(ACCESS_READ);
+        auto coordinates = access->getCoordinates();
+        auto scores = access->getScores();
+        REQUIRE(scores.size() == expected.size());
+        for(int i = 0; i < expected.size(); ++i) {
+            CHECK(coordinates[i*12] == Approx(expected[i].first.x()));
+            CHECK(coordinates[i*12 + 1] == Approx(expected[i].first.y()));
+            CHECK(scores[i] == Approx(expected[i].second));
+        }
+    }
+
+    // Batch of two patches, the second is moved to its position in the full image
+    auto patch2 = Tensor::create(TensorShape({1, size, size, channels}));
+    {
+        auto access = tensor->getAccess(ACCESS_READ);
+        auto access2 = patch2->getAccess(ACCESS_READ_WRITE);
+        std::memcpy(access2->getRawData(), access->getRawData(), size*size*channels*sizeof(float));
+    }
+    patch2 = patch2->getView(0);
+    patch2->setFrameData("network-input-size-x", 256);
+    patch2->setFrameData("network-input-size-y", 256);
+    patch2->setFrameData("patchid-x", 1);
+    patch2->setFrameData("patchid-y", 0);
+    patch2->setFrameData("patch-width", 256);
+    patch2->setFrameData("patch-height", 256);
+    patch2->setFrameData("patch-spacing-x", 1.0f);
+    patch2->setFrameData("patch-spacing-y", 1.0f);
+    auto batchDecoder = TensorToBoundingBoxSet::create(BoundingBoxNetworkType::YOLOv3, threshold, {anchors});
+    batchDecoder->setNrOfInputNodes(1);
+    batchDecoder->setInputData(0, Batch::create(std::vector<Tensor::pointer>{tensor, patch2}));
+    auto batchBBset = batchDecoder->updateAndGetOutputData<BoundingBoxSet>();
+    {
+        auto access = batchBBset->getAccess(ACCESS_READ);
+        auto coordinates = access->getCoordinates();
+        REQUIRE(access->getScores().size() == 2*expected.size());
+        for(int i = 0; i < expected.size(); ++i) {
+            CHECK(coordinates[i*12] == Approx(expected[i].first.x()));
+            CHECK(coordinates[(i + expected.size())*12] == Approx(expected[i].first.x() + 256));
+        }
+    }
+}
+
 /*
 TEST_CASE("Dynamic input shapes", "[fast][dynamicshapes]") {
     auto network = NeuralNetwork::create("/home/smistad/workspace/adapt-ai-tuning/models/unet-adapt-rspace-full-res-ssim-1.5-dynamic.onnx",
@@ -1,74 +1,184 @@
 #include "NonMaximumSuppression.hpp"
 #include <FAST/Data/BoundingBox.hpp>
+#include <FAST/Data/BoundingBoxGrid.hpp>
+#include <cmath>
+#include <numeric>
 #include <queue>
 
 namespace fast {
 
-NonMaximumSuppression::NonMaximumSuppression(float threshold) {
+namespace {
+struct Box {
+    Vector2f min;
+    Vector2f max;
+    uchar label;
+};
+
+/**
+ * Cells about the size of a bounding box, so that each bounding box covers a few cells,
+ * but limit the number of cells for sparse sets.
+ */
+float getGridCellSize(const std::vector<Box>& boxes) {
+    if(boxes.empty())
+        return 1.0f;
+    Vector2f min = boxes[0].min;
+    Vector2f max = boxes[0].max;
+    double meanSize = 0;
+    for(const auto& box : boxes) {
+        min = min.cwiseMin(box.min);
+        max = max.cwiseMax(box.max);
+        meanSize += (box.max - box.min).maxCoeff();
+    }
+    meanSize /= boxes.size();
+    return std::max((float)meanSize, (max - min).maxCoeff() / 1024.0f);
+}
+}
+
+NonMaximumSuppression::NonMaximumSuppression(float threshold, bool perClass, bool soft, float sigma, float minimumScore) {
 	createInputPort<BoundingBoxSet>(0);
 	createOutputPort<BoundingBoxSet>(0);
     setThreshold(threshold);
+    setPerClass(perClass);
+    setSoft(soft, sigma);
+    setMinimumScore(minimumScore);
 	createFloatAttribute("threshold", "Threshold", "Threshold", m_threshold);
+	createBooleanAttribute("per-class", "Per class", "Only suppress overlapping bounding boxes with the same label", m_perClass);
+	createBooleanAttribute("soft", "Soft", "Use soft non-maximum suppression", m_soft);
+	createFloatAttribute("sigma", "Sigma", "Gaussian decay parameter for soft non-maximum suppression", m_sigma);
+	createFloatAttribute("minimum-score", "Minimum score", "Bounding boxes with a score below this value are removed", m_minimumScore);
 }
 
 void NonMaximumSuppression::loadAttributes() {
 	setThreshold(getFloatAttribute("threshold"));
+	setPerClass(getBooleanAttribute("per-class"));
+	setSoft(getBooleanAttribute("soft"), getFloatAttribute("sigma"));
+	setMinimumScore(getFloatAttribute("minimum-score"));
 }
 
 void NonMaximumSuppression::setThreshold(float threshold) {
 	m_threshold = threshold;
+	setModified(true);
+}
+
+void NonMaximumSuppression::setPerClass(bool perClass) {
+	m_perClass = perClass;
+	setModified(true);
+}
+
+void NonMaximumSuppression::setSoft(bool soft, float sigma) {
+	if(sigma <= 0.0f)
+		throw Exception("Sigma of soft non-maximum suppression must be > 0");
+	m_soft = soft;
+	m_sigma = sigma;
+	setModified(true);
+}
+
+void NonMaximumSuppression::setMinimumScore(float minimumScore) {
+	m_minimumScore = minimumScore;
+	setModified(true);
 }
 
 void NonMaximumSuppression::execute() {
 	auto input = getInputData<BoundingBoxSet>();
 	auto output = BoundingBoxSet::create();
 
-	auto compare = [](BoundingBox::pointer a, BoundingBox::pointer b) {
-		return a->getScore() < b->getScore(); // if true, they swap place
-	};
-	std::priority_queue<BoundingBox::pointer, std::vector<BoundingBox::pointer>, decltype(compare)> queue(compare);
-	// Add bounding boxes to the queue
-	auto inputAccess = input->getAccess(ACCESS_READ);
-	auto outputAccess = output->getAccess(ACCESS_READ_WRITE);
-	auto coordinates = inputAccess->getCoordinates();
-	auto labels = inputAccess->getLabels();
-	auto scores = inputAccess->getScores();
-	for(int i = 0; i < coordinates.size(); i += 12) {
-		Vector2f position = Vector2f(coordinates[i], coordinates[i + 1]);
-		Vector2f size = Vector2f(coordinates[i + 6], coordinates[i + 7]) - position;
-		try {
-            auto bbox = BoundingBox::create(position, size, labels[i / 4], scores[i / 12]);
-            queue.push(bbox);
-        } catch(Exception &e) {
-
+	// Extract bounding boxes from the coordinate arrays. Each bounding box has 4 vertices with 3 coordinates,
+	// 4 labels and 1 score.
+	std::vector<Box> boxes;
+	std::vector<float> scores;
+	{
+		auto inputAccess = input->getAccess(ACCESS_READ);
+		const auto coordinates = inputAccess->getCoordinates();
+		const auto labels = inputAccess->getLabels();
+		const auto inputScores = inputAccess->getScores();
+		const int nrOfBoxes = inputScores.size();
+		boxes.reserve(nrOfBoxes);
+		scores.reserve(nrOfBoxes);
+		for(int i = 0; i < nrOfBoxes; ++i) {
+			Box box;
+			box.min = Vector2f(coordinates[i*12], coordinates[i*12 + 1]);
+			box.max = Vector2f(coordinates[i*12 + 6], coordinates[i*12 + 7]);
+			// Skip invalid bounding boxes and bounding boxes with a too low score
+			if(box.max.x() <= box.min.x() || box.max.y() <= box.min.y() || inputScores[i] < m_minimumScore)
+				continue;
+			box.label = labels[i*4];
+			boxes.push_back(box);
+			scores.push_back(inputScores[i]);
 		}
 	}
+	const int nrOfBoxes = boxes.size();
+	std::vector<int> keep;
+	BoundingBoxGrid grid(getGridCellSize(boxes));
 
-	std::unordered_set<BoundingBox::pointer> erased;
-	while(!queue.empty()) {
-		BoundingBox::pointer b_m;
-		do {
-			b_m = queue.top();
+	if(!m_soft) {
+		// Visit bounding boxes from highest to lowest score. A bounding box is kept if it doesn't overlap
+		// any of the kept bounding boxes, which are stored in the grid.
+		std::vector<int> order(nrOfBoxes);
+		std::iota(order.begin(), order.end(), 0);
+		std::stable_sort(order.begin(), order.end(), [&scores](int a, int b) {
+			return scores[a] > scores[b];
+		});
+		for(int i : order) {
+			const Box& box = boxes[i];
+			bool suppressed = false;
+			grid.forEachNeighbour(box.min, box.max, [&](int j) {
+				if(m_perClass && boxes[j].label != box.label)
+					return true;
+				suppressed = intersectionOverUnion(boxes[j].min, boxes[j].max, box.min, box.max) > m_threshold;
+				return !suppressed;
+			});
+			if(!suppressed) {
+				keep.push_back(i);
+				grid.insert(i, box.min, box.max);
+			}
+		}
+	} else {
+		// Soft non-maximum suppression: Select the bounding box with the highest score, and decay the score
+		// of its neighbours. Scores only decrease, thus outdated entries in the queue are skipped.
+		for(int i = 0; i < nrOfBoxes; ++i)
+			grid.insert(i, boxes[i].min, boxes[i].max);
+		auto compare = [](const std::pair<float, int>& a, const std::pair<float, int>& b) {
+			return a.first < b.first || (a.first == b.first && a.second > b.second);
+		};
+		std::priority_queue<std::pair<float, int>, std::vector<std::pair<float, int>>, decltype(compare)> queue(compare);
+		for(int i = 0; i < nrOfBoxes; ++i)
+			queue.push({scores[i], i});
+		std::vector<bool> selected(nrOfBoxes, false);
+		std::vector<int> lastVisit(nrOfBoxes, -1);
+		while(!queue.empty()) {
+			const auto top = queue.top();
 			queue.pop();
-		} while(erased.count(b_m) > 0 && !queue.empty());
-		if(!b_m)
-			break;
-		
-		outputAccess->addBoundingBox(b_m);
-		auto iterateQueue = queue; // Create new queue for iterating
-
-		// Remove overlapping bounding boxes
-		while(!iterateQueue.empty()) {
-			auto b = iterateQueue.top();
-			iterateQueue.pop();
+			const int i = top.second;
+			if(selected[i] || top.first != scores[i])
+				continue;
+			if(scores[i] < m_minimumScore)
+				break;
+			selected[i] = true;
+			keep.push_back(i);
+			const Box& box = boxes[i];
+			grid.forEachNeighbour(box.min, box.max, [&](int j) {
+				if(selected[j] || lastVisit[j] == i || (m_perClass && boxes[j].label != box.label))
+					return true;
+				lastVisit[j] = i;
+				const float iou = intersectionOverUnion(box.min, box.max, boxes[j].min, boxes[j].max);
+				if(iou > 0.0f) {
+					scores[j] *= std::exp(-iou*iou / m_sigma);
+					queue.push({scores[j], j});
+				}
+				return true;
+			});
+		}
+	}
 
-			if(b_m->intersectionOverUnion(b) > m_threshold) { // If large overlap
-				erased.insert(b);
-			}
+	{
+		auto outputAccess = output->getAccess(ACCESS_READ_WRITE);
+		for(int i : keep) {
+			const Box& box = boxes[i];
+			outputAccess->addBoundingBox(box.min, box.max - box.min, box.label, scores[i]);
 		}
 	}
 
 	addOutputData(0, output);
 }
 
-}
\ No newline at end of file
+}
@@ -8,12 +8,18 @@ namespace fast {
  * @brief Non-maximum suppression of bounding box sets
  *
  * Removes overlapping bounding boxes in a BoundingBoxSet if intersection over union is above a provided threshold.
+ * Bounding boxes are sorted by score once, and a uniform grid is used to only compare bounding boxes which are
+ * close to each other. Thus large sets of bounding boxes, such as detections in a whole slide image, are handled quickly.
+ *
+ * With soft non-maximum suppression, the scores of overlapping bounding boxes are decayed instead,
+ * by exp(-IoU^2/sigma), and bounding boxes are only removed if their score drops below a minimum score.
+ * The intersection over union threshold is not used in this mode.
  *
  * Inputs:
  * - 0: BoundingBoxSet
  *
  * Outputs:
- * - 0: BoundingBoxSet
+ * - 0: BoundingBoxSet, sorted by score
  *
  * @ingroup bounding-box
  */
@@ -23,15 +29,45 @@ class FAST_EXPORT NonMaximumSuppression : public ProcessObject {
         /**
          * @brief Create instance
          * @param threshold Minimum intersection over union to remove overlapping bounding box.
+         * @param perClass Only suppress overlapping bounding boxes with the same label.
+         * @param soft Use soft non-maximum suppression, which decays scores of overlapping bounding boxes instead of removing them.
+         * @param sigma Gaussian decay parameter for soft non-maximum suppression.
+         * @param minimumScore Bounding boxes with a score below this value are removed.
          * @return instance
          */
-        FAST_CONSTRUCTOR(NonMaximumSuppression, float, threshold, = 0.5f);
+        FAST_CONSTRUCTOR(NonMaximumSuppression,
+                         float, threshold, = 0.5f,
+                         bool, perClass, = false,
+                         bool, soft, = false,
+                         float, sigma, = 0.5f,
+                         float, minimumScore, = 0.0f
+        );
 		void setThreshold(float threshold);
+		/**
+		 * @brief Only suppress overlapping bounding boxes with the same label
+		 * @param perClass
+		 */
+		void setPerClass(bool perClass);
+		/**
+		 * @brief Enable soft non-maximum suppression
+		 * @param soft
+		 * @param sigma Gaussian decay parameter. Smaller values decay scores more.
+		 */
+		void setSoft(bool soft, float sigma = 0.5f);
+		/**
+		 * @brief Remove bounding boxes with a score below this value
+		 * @param minimumScore
+		 */
+		void setMinimumScore(float minimumScore);
 		void loadAttributes();
 	protected:
 		void execute() override;
 
 		float m_threshold = 0.5f;
+		bool m_perClass = false;
+		bool m_soft = false;
+		float m_sigma = 0.5f;
+		float m_minimumScore = 0.0f;
 };
 
-}
\ No newline at end of file
+}
@@ -0,0 +1,99 @@
+#include <FAST/Testing.hpp>
+#include <FAST/Algorithms/NonMaximumSuppression/NonMaximumSuppression.hpp>
+#include <FAST/Data/BoundingBox.hpp>
+#include <random>
+
+using namespace fast;
+
+namespace {
+struct TestBox {
+    Vector2f position;
+    Vector2f size;
+    uchar label;
+    float score;
+};
+
+float testIntersectionOverUnion(const TestBox& a, const TestBox& b) {
+    const float x_left = std::max(a.position.x(), b.position.x());
+    const float y_top = std::max(a.position.y(), b.position.y());
+    const float x_right = std::min(a.position.x() + a.size.x(), b.position.x() + b.size.x());
+    const float y_bottom = std::min(a.position.y() + a.size.y(), b.position.y() + b.size.y());
+    if(x_right < x_left || y_bottom < y_top)
+        return 0.0f;
+    const float intersection = (x_right - x_left) * (y_bottom - y_top);
+    return intersection / (a.size.x()*a.size.y() + b.size.x()*b.size.y() - intersection);
+}
+
+// Brute force greedy non-maximum suppression
+std::vector<TestBox> referenceNonMaximumSuppression(std::vector<TestBox> boxes, float threshold, bool perClass) {
+    std::stable_sort(boxes.begin(), boxes.end(), [](const TestBox& a, const TestBox& b) { return a.score > b.score; });
+    std::vector<TestBox> keep;
+    for(const auto& box : boxes) {
+        bool suppressed = false;
+        for(const auto& kept : keep) {
+            if(perClass && kept.label != box.label)
+                continue;
+            if(testIntersectionOverUnion(kept, box) > threshold)
+                suppressed = true;
+        }
+        if(!suppressed)
+            keep.push_back(box);
+    }
+    return keep;
+}
+}
+
+TEST_CASE("Non-maximum suppression gives same result as brute force", "[fast][NonMaximumSuppression]") {
+    std::mt19937 generator(42);
+    std::uniform_real_distribution<float> position(0.0f, 2000.0f);
+    std::uniform_real_distribution<float> size(10.0f, 60.0f);
+    std::uniform_real_distribution<float> score(0.0f, 1.0f);
+    std::vector<TestBox> boxes;
+    auto bbset = BoundingBoxSet::create();
+    {
+        auto access = bbset->getAccess(ACCESS_READ_WRITE);
+        for(int i = 0; i < 5000; ++i) {
+            TestBox box = {Vector2f(position(generator), position(generator)), Vector2f(size(generator), size(generator)), (uchar)(i % 2 + 1), score(generator)};
+            boxes.push_back(box);
+            access->addBoundingBox(box.position, box.size, box.label, box.score);
+        }
+    }
+    for(bool perClass : {false, true}) {
+        auto expected = referenceNonMaximumSuppression(boxes, 0.3f, perClass);
+        auto nms = NonMaximumSuppression::create(0.3f, perClass)->connect(bbset);
+        auto result = nms->runAndGetOutputData<BoundingBoxSet>();
+        auto access = result->getAccess(ACCESS_READ);
+        auto coordinates = access->getCoordinates();
+        auto labels = access->getLabels();
+        auto scores = access->getScores();
+        REQUIRE(scores.size() == expected.size());
+        for(int i = 0; i < expected.size(); ++i) {
+            CHECK(scores[i] == expected[i].score);
+            CHECK(labels[i*4] == expected[i].label);
+            CHECK(coordinates[i*12] == Approx(expected[i].position.x()));
+            CHECK(coordinates[i*12 + 1] == Approx(expected[i].position.y()));
+        }
+    }
+}
+
+TEST_CASE("Soft non-maximum suppression decays scores of overlapping boxes", "[fast][NonMaximumSuppression]") {
+    auto bbset = BoundingBoxSet::create();
+    {
+        auto access = bbset->getAccess(ACCESS_READ_WRITE);
+        access->addBoundingBox(Vector2f(0, 0), Vector2f(10, 10), 1, 0.9f);
+        access->addBoundingBox(Vector2f(5, 0), Vector2f(10, 10), 1, 0.8f); // IoU 1/3 with first
+        access->addBoundingBox(Vector2f(100, 100), Vector2f(10, 10), 1, 0.7f);
+        access->addBoundingBox(Vector2f(0, 0), Vector2f(10, 10), 1, 0.05f);
+    }
+    auto nms = NonMaximumSuppression::create(0.5f, false, true, 0.5f, 0.1f)->connect(bbset);
+    auto result = nms->runAndGetOutputData<BoundingBoxSet>();
+    auto access = result->getAccess(ACCESS_READ);
+    auto scores = access->getScores();
+    auto coordinates = access->getCoordinates();
+    // Last box is removed, since it is below minimum score
+    REQUIRE(scores.size() == 3);
+    CHECK(scores[0] == Approx(0.9f));
+    CHECK(scores[1] == Approx(0.8f*std::exp(-(1.0f/9.0f)/0.5f)));
+    CHECK(coordinates[12] == Approx(5.0f));
+    CHECK(scores[2] == Approx(0.7f));
+}
@@ -33,8 +33,8 @@ void ScanConverter::execute() {
     float startRadius = m_startDepth;
     float stopRadius = m_endDepth;
     if(m_endDepth - m_startDepth <= 0) {
-        startRadius = std::stof(input->getFrameData("startRadius"));
-        stopRadius = std::stof(input->getFrameData("stopRadius"));
+        startRadius = input->getFrameData<float>("startRadius");
+        stopRadius = input->getFrameData<float>("stopRadius");
     }
     float startTheta;
     float stopTheta;
@@ -48,8 +48,8 @@ void ScanConverter::execute() {
         startTheta = m_leftPos;
         stopTheta = m_rightPos;
     } else {
-        startTheta = std::stof(input->getFrameData("startTheta"));
-        stopTheta = std::stof(input->getFrameData("stopTheta"));
+        startTheta = input->getFrameData<float>("startTheta");
+        stopTheta = input->getFrameData<float>("stopTheta");
         isPolar = input->getFrameData("isPolar") == "true";
     }
 
@@ -112,8 +112,8 @@ void UltrasoundImageCropper::execute() {
     auto outputImage = Image::create(m_width, m_height, image->getDataType(), image->getNrOfChannels());
     outputImage->setSpacing(m_spacing);
     outputImage->setCreationTimestamp(image->getCreationTimestamp());
-	outputImage->setFrameData("original-width", std::to_string(outputImage->getWidth()));
-	outputImage->setFrameData("original-height", std::to_string(outputImage->getHeight()));
+	outputImage->setFrameData("original-width", outputImage->getWidth());
+	outputImage->setFrameData("original-height", outputImage->getHeight());
 
     OpenCLImageAccess::pointer outputAccess = outputImage->getOpenCLImageAccess(ACCESS_READ_WRITE, device);
 
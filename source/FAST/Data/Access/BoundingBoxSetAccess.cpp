@@ -83,15 +83,16 @@ std::vector<float> BoundingBoxSetAccess::getScores() const {
 	return *m_scores;
 }
 
-void BoundingBoxSetAccess::addBoundingBoxes(std::vector<float> coordinates, std::vector<uint> lines, std::vector<uchar> labels, std::vector<float> scores, float minimumSize) {
+void BoundingBoxSetAccess::addBoundingBoxes(const std::vector<float>& coordinates, const std::vector<uint>& lines, const std::vector<uchar>& labels, const std::vector<float>& scores, float minimumSize) {
 	const int size = m_coordinates->size() / 3;
 	m_coordinates->insert(m_coordinates->end(), coordinates.begin(), coordinates.end());
 	// Have to update indexes of new lines:
-	std::transform(lines.begin(), lines.end(), lines.begin(), [size](uint index) -> uint {
+	const std::size_t linesStart = m_lines->size();
+	m_lines->resize(linesStart + lines.size());
+	std::transform(lines.begin(), lines.end(), m_lines->begin() + linesStart, [size](uint index) -> uint {
 		return index + size;
 	});
 	*m_minimumSize = std::min(*m_minimumSize, minimumSize);
-	m_lines->insert(m_lines->end(), lines.begin(), lines.end());
 	m_labels->insert(m_labels->end(), labels.begin(), labels.end());
 	m_scores->insert(m_scores->end(), scores.begin(), scores.end());
 }
@@ -10,6 +10,9 @@
 #include <tiffio.h>
 #include <FAST/Data/Image.hpp>
 #include <jpeglib.h>
+#ifndef WIN32
+#include <unistd.h>
+#endif
 
 namespace fast {
 
@@ -18,13 +21,14 @@ ImagePyramidAccess::ImagePyramidAccess(
         openslide_t* fileHandle,
         TIFF* tiffHandle,
         std::ifstream* vsiHandle,
-        std::vector<vsi_tile_header>& vsiTiles,
+        const std::vector<vsi_tile_header>& vsiTiles,
         std::shared_ptr<ImagePyramid> imagePyramid,
         bool write,
         std::unordered_set<std::string>& initializedPatchList,
         std::mutex& readMutex,
-        ImageCompression compressionFormat
-        ) : m_initializedPatchList(initializedPatchList), m_readMutex(readMutex) {
+        ImageCompression compressionFormat,
+        int vsiFileDescriptor
+        ) : m_initializedPatchList(initializedPatchList), m_readMutex(readMutex), m_vsiTiles(vsiTiles) {
 	if(levels.size() == 0)
 		throw Exception("Image pyramid has no levels");
 	m_image = imagePyramid;
@@ -33,7 +37,7 @@ ImagePyramidAccess::ImagePyramidAccess(
     m_fileHandle = fileHandle;
     m_tiffHandle = tiffHandle;
     m_vsiHandle = vsiHandle;
-    m_vsiTiles = vsiTiles;
+    m_vsiFileDescriptor = vsiFileDescriptor;
     m_compressionFormat = compressionFormat;
 }
 
@@ -64,16 +68,30 @@ void jpegErrorExit(j_common_ptr cinfo) {
     throw std::runtime_error( jpegLastErrorMsg );
 }
 
+void ImagePyramidAccess::readVSITileBytes(vsi_tile_header tile, char* buffer) {
+#ifndef WIN32
+    if(m_vsiFileDescriptor >= 0) {
+        // Positional reads does not change any shared file offset, thus no locking is needed
+        std::size_t totalRead = 0;
+        while(totalRead < tile.numbytes) {
+            auto bytesRead = pread(m_vsiFileDescriptor, buffer + totalRead, tile.numbytes - totalRead, tile.offset + totalRead);
+            if(bytesRead <= 0)
+                throw Exception("Failed to read tile from VSI file");
+            totalRead += bytesRead;
+        }
+        return;
+    }
+#endif
+    // Reading VSI tiles from the stream is not thread safe
+    std::lock_guard<std::mutex> lock(m_readMutex);
+    m_vsiHandle->seekg(tile.offset);
+    m_vsiHandle->read(buffer, tile.numbytes);
+}
+
 void ImagePyramidAccess::readVSITileToBuffer(vsi_tile_header tile, uchar* data) {
     if(m_compressionFormat == ImageCompression::JPEG) {
         auto buffer = make_uninitialized_unique<char[]>(tile.numbytes);
-
-        // Reading VSI tiles is not thread safe
-        {
-            std::lock_guard<std::mutex> lock(m_readMutex);
-            m_vsiHandle->seekg(tile.offset);
-            m_vsiHandle->read(buffer.get(), tile.numbytes);
-        }
+        readVSITileBytes(tile, buffer.get());
         jpeg_decompress_struct cinfo;
         jpeg_error_mgr jerr; //error handling
         jpeg_source_mgr src_mem;
@@ -101,25 +119,62 @@ void ImagePyramidAccess::readVSITileToBuffer(vsi_tile_header tile, uchar* data)
             throw Exception("JPEG error: " + std::string(e.what())); // or return an error code
         }
     } else if(m_compressionFormat == ImageCompression::RAW) { // Uncompressed
-        // Reading VSI tiles is not thread safe
-        {
-            auto buffer = make_uninitialized_unique<char[]>(tile.numbytes);
-            std::lock_guard<std::mutex> lock(m_readMutex);
-            m_vsiHandle->seekg(tile.offset);
-            m_vsiHandle->read(buffer.get(), tile.numbytes);
-            // Data is stored as BGR, convert it to RGB
-            // TODO could optimize this by doing it on the GPU instead..
-            for(int i = 0; i < tile.numbytes/3; ++i) {
-                data[i*3 + 0] = buffer[i*3+2];
-                data[i*3 + 1] = buffer[i*3+1];
-                data[i*3 + 2] = buffer[i*3+0];
-            }
+        auto buffer = make_uninitialized_unique<char[]>(tile.numbytes);
+        readVSITileBytes(tile, buffer.get());
+        // Data is stored as BGR, convert it to RGB
+        // TODO could optimize this by doing it on the GPU instead..
+        for(int i = 0; i < tile.numbytes/3; ++i) {
+            data[i*3 + 0] = buffer[i*3+2];
+            data[i*3 + 1] = buffer[i*3+1];
+            data[i*3 + 2] = buffer[i*3+0];
         }
     } else {
         throw Exception("Unknown image compression format in ImagePyramidAccess::readVSITileToBuffer: " + std::to_string((int)m_compressionFormat));
     }
 }
 
+std::shared_ptr<uchar[]> ImagePyramidAccess::getVSITile(int level, vsi_tile_header tile) {
+    auto& cache = m_image->getTileCache();
+    auto data = cache.get(level, tile.coord[0], tile.coord[1]);
+    if(!data) {
+        const std::size_t tileBytes = (std::size_t)m_image->getLevelTileWidth(level)*m_image->getLevelTileHeight(level)*m_image->getNrOfChannels();
+        data = std::shared_ptr<uchar[]>(new uchar[tileBytes]);
+        readVSITileToBuffer(tile, data.get());
+        cache.put(level, tile.coord[0], tile.coord[1], data, tileBytes);
+    }
+    return data;
+}
+
+void ImagePyramidAccess::copyTilesToBuffer(const std::map<std::pair<int, int>, std::shared_ptr<uchar[]>>& tiles, int level, int x, int y, int width, int height, uchar* data) {
+    const int channels = m_image->getNrOfChannels();
+    const int tileWidth = m_image->getLevelTileWidth(level);
+    const int tileHeight = m_image->getLevelTileHeight(level);
+    const int firstTileX = x / tileWidth;
+    const int firstTileY = y / tileHeight;
+    const int lastTileX = (x + width - 1) / tileWidth;
+    const int lastTileY = (y + height - 1) / tileHeight;
+    if(tiles.size() < (lastTileX - firstTileX + 1)*(lastTileY - firstTileY + 1)) {
+        // Some tiles are outside or missing, fill with blank value
+        std::memset(data, channels > 1 ? 255 : 0, (std::size_t)width*height*channels);
+    }
+    for(auto&& tile : tiles) {
+        const int tileOffsetX = tile.first.first*tileWidth;
+        const int tileOffsetY = tile.first.second*tileHeight;
+        // Intersection of tile and requested region
+        const int startX = std::max(x, tileOffsetX);
+        const int endX = std::min(x + width, tileOffsetX + tileWidth);
+        const int startY = std::max(y, tileOffsetY);
+        const int endY = std::min(y + height, tileOffsetY + tileHeight);
+        for(int cy = startY; cy < endY; ++cy) {
+            std::memcpy(
+                    &data[((cy - y)*width + startX - x)*channels],
+                    &tile.second[((cy - tileOffsetY)*tileWidth + startX - tileOffsetX)*channels],
+                    (endX - startX)*channels
+            );
+        }
+    }
+}
+
 std::unique_ptr<uchar[]> ImagePyramidAccess::getPatchData(int level, int x, int y, int width, int height) {
     const int levelWidth = m_image->getLevelWidth(level);
     const int levelHeight = m_image->getLevelHeight(level);
@@ -135,81 +190,73 @@ std::unique_ptr<uchar[]> ImagePyramidAccess::getPatchData(int level, int x, int
             std::memset(data.get(), 0, width*height*channels);
             return data;
         }
-        std::lock_guard<std::mutex> lock(m_readMutex);
-        if(m_image->isOMETIFF()) {
-            if(level == 0) {
-                TIFFSetDirectory(m_tiffHandle, level);
-            } else {
-                TIFFSetSubDirectory(m_tiffHandle, m_levels[level].offset);
+        // Get all tiles covering the region, either from the tile cache or by decoding them
+        auto& cache = m_image->getTileCache();
+        const std::size_t tileBytes = (std::size_t)tileWidth*tileHeight*channels;
+        const int firstTileX = x / tileWidth;
+        const int firstTileY = y / tileHeight;
+        const int lastTileX = std::min((x + width - 1) / tileWidth, m_levels[level].tilesX - 1);
+        const int lastTileY = std::min((y + height - 1) / tileHeight, m_levels[level].tilesY - 1);
+        std::map<std::pair<int, int>, std::shared_ptr<uchar[]>> tiles;
+        std::vector<std::pair<int, int>> missingTiles;
+        for(int tileY = firstTileY; tileY <= lastTileY; ++tileY) {
+            for(int tileX = firstTileX; tileX <= lastTileX; ++tileX) {
+                auto tile = cache.get(level, tileX, tileY);
+                if(tile) {
+                    tiles[std::make_pair(tileX, tileY)] = tile;
+                } else {
+                    missingTiles.push_back(std::make_pair(tileX, tileY));
+                }
             }
-        } else {
-            TIFFSetDirectory(m_tiffHandle, level);
         }
-        if(width == tileWidth && height == tileHeight && x % tileWidth == 0 && y % tileHeight == 0) {
-            // From TIFFReadTile documentation: Return the data for the tile containing the specified coordinates.
-            int bytesRead = TIFFReadTile(m_tiffHandle, (void *) data.get(), x, y, 0, 0);
-        } else if((width < tileWidth || height < tileHeight) && x % tileWidth == 0 && y % tileHeight == 0) {
-            auto tileData = std::make_unique<uchar[]>(tileWidth*tileHeight*channels);
-            {
-                // From TIFFReadTile documentation: Return the data for the tile containing the specified coordinates.
+        auto readMissingTiles = [&](TIFF* tiff) {
+            for(auto&& tileID : missingTiles) {
                 // In TIFF all tiles have the same size, thus they are padded..
-                int bytesRead = TIFFReadTile(m_tiffHandle, (void *) tileData.get(), x, y, 0, 0);
-            }
-            // Remove extra
-            for(int dy = 0; dy < height; ++dy) {
-                for(int dx = 0; dx < width; ++dx) {
-		    for(int channel = 0; channel < channels; ++channel) {
-                        data[(dx + dy*width)*channels + channel] = tileData[(dx + dy*tileWidth)*channels + channel];
-		    }
-                }
-            }
-        } else {
-            // Create buffer to contain all tiles
-            int totalTilesX = std::ceil((float)width / tileWidth);
-            int totalTilesY = std::ceil((float)height / tileHeight);
-            if(x % tileWidth != 0) totalTilesX += 1;
-            if(y % tileHeight != 0) totalTilesY += 1;
-            const int targetNumberOfTiles = totalTilesX*totalTilesY;
-            auto fullTileBuffer = make_uninitialized_unique<uchar[]>(tileWidth*tileHeight*targetNumberOfTiles*channels);
-            // Does the buffer need to be initialized/padded?
-            if(x+width >= levelWidth || x+height >= levelHeight) { // Some tiles are outside, fill it
-                if(channels > 1) {
-                    std::memset(fullTileBuffer.get(), 255, tileWidth*tileHeight*targetNumberOfTiles*channels);
+                std::shared_ptr<uchar[]> tile(new uchar[tileBytes]);
+                if(TIFFReadTile(tiff, (void *) tile.get(), tileID.first*tileWidth, tileID.second*tileHeight, 0, 0) < 0) {
+                    // Corrupt or truncated tile: Use the blank value, and don't put it in the cache
+                    reportWarning() << "Failed to read tile " << tileID.first << ", " << tileID.second << " at level " << level << " of image pyramid" << reportEnd();
+                    std::memset(tile.get(), channels > 1 ? 255 : 0, tileBytes);
                 } else {
-                    std::memset(fullTileBuffer.get(), 0, tileWidth*tileHeight*targetNumberOfTiles*channels);
+                    cache.put(level, tileID.first, tileID.second, tile, tileBytes);
                 }
+                tiles[tileID] = tile;
             }
-            // Fill the full tile buffer
-            const int firstTileX = x / tileWidth;
-            const int firstTileY = y / tileHeight;
-            const int fullTileBufferWidth = totalTilesX*tileWidth;
-            for(int i = 0; i < totalTilesX; ++i) {
-                for(int j = 0; j < totalTilesY; ++j) {
-                    auto tileData = std::make_unique<uchar[]>(tileWidth*tileHeight*channels);
-                    int tileX = i*tileWidth;
-                    int tileY = j*tileHeight;
-                    int bytesRead = TIFFReadTile(m_tiffHandle, (void *) tileData.get(), firstTileX*tileWidth+tileX, firstTileY*tileHeight+tileY, 0, 0);
-                    // Stitch tile into full buffer
-                    for(int cy = 0; cy < tileHeight; ++cy) {
-                        for(int cx = 0; cx < tileWidth; ++cx) {
-                            for(int channel = 0; channel < channels; ++channel) {
-                                fullTileBuffer[(tileX + cx + (tileY + cy)*fullTileBufferWidth)*channels + channel] = tileData[(cx + cy*tileWidth)*channels + channel];
-                            }
-                        }
+        };
+        if(missingTiles.empty()) {
+            // All tiles were in the cache
+        } else if(m_image->usesTIFFReadHandles()) {
+            // Read-only pyramid: Use a handle from the pool, so that this thread doesn't block other readers.
+            auto readHandle = m_image->acquireTIFFReadHandle();
+            try {
+                if(readHandle.level != level) {
+                    if(m_image->isOMETIFF() && level > 0) {
+                        TIFFSetSubDirectory(readHandle.handle, m_levels[level].offset);
+                    } else {
+                        TIFFSetDirectory(readHandle.handle, level);
                     }
+                    readHandle.level = level;
                 }
+                readMissingTiles(readHandle.handle);
+            } catch(...) {
+                m_image->releaseTIFFReadHandle(readHandle);
+                throw;
             }
-            // Crop the full buffer to data[]
-            const int offsetX = x - firstTileX*tileWidth;
-            const int offsetY = y - firstTileY*tileHeight;
-            for(int cy = offsetY; cy < offsetY + height; ++cy) {
-                for(int cx = offsetX; cx < offsetX + width; ++cx) {
-                    for(int channel = 0; channel < channels; ++channel) {
-                        data[(cx - offsetX + (cy - offsetY) * width)*channels + channel] = fullTileBuffer[(cx + cy * fullTileBufferWidth)*channels + channel];
-                    }
+            m_image->releaseTIFFReadHandle(readHandle);
+        } else {
+            std::lock_guard<std::mutex> lock(m_readMutex);
+            if(m_image->isOMETIFF()) {
+                if(level == 0) {
+                    TIFFSetDirectory(m_tiffHandle, level);
+                } else {
+                    TIFFSetSubDirectory(m_tiffHandle, m_levels[level].offset);
                 }
+            } else {
+                TIFFSetDirectory(m_tiffHandle, level);
             }
+            readMissingTiles(m_tiffHandle);
         }
+        copyTilesToBuffer(tiles, level, x, y, width, height, data.get());
     } else if(m_fileHandle != nullptr) {
         int scale = (float)m_image->getFullWidth()/levelWidth;
 #ifndef WIN32
@@ -222,89 +269,39 @@ std::unique_ptr<uchar[]> ImagePyramidAccess::getPatchData(int level, int x, int
 #endif
         openslide_read_region(m_fileHandle, (uint32_t*)data.get(), x * scale, y * scale, level, width, height);
     } else if(!m_vsiTiles.empty()) {
-        if(width == tileWidth && height == tileHeight && x % tileWidth == 0 && y % tileHeight == 0) {
-            vsi_tile_header tile;
-            bool found = false;
-            for(int i = 0; i < m_vsiTiles.size(); ++i) {
-                vsi_tile_header currentTile = m_vsiTiles[i];
-                if(currentTile.level != level)
-                    continue;
-                if(currentTile.coord[0] != x / m_image->getLevelTileWidth(level) || currentTile.coord[1] != y / m_image->getLevelTileHeight(level))
-                    continue;
-                tile = currentTile;
-                found = true;
-                break;
-            }
-            if(!found)
-                throw Exception("Could not find tile for getPathcData in VSI");
-
-            readVSITileToBuffer(tile, data.get());
-        } else {
-            std::vector<vsi_tile_header> tilesToRead;
-            int firstTileX = x / m_image->getLevelTileWidth(level);
-            int firstTileY = y / m_image->getLevelTileHeight(level);
-            int lastTileX = std::ceil((float)(x + width) / m_image->getLevelTileWidth(level));
-            int lastTileY = std::ceil((float)(y + height) / m_image->getLevelTileHeight(level));
-            // How many tiles we are supposed to have
-            const int targetNumberOfTiles = (lastTileX-firstTileX)*(lastTileY-firstTileY);
-            for(int i = 0; i < m_vsiTiles.size(); ++i) {
-                vsi_tile_header currentTile = m_vsiTiles[i];
-                if(currentTile.level != level)
-                    continue;
-                if(
-                        !((currentTile.coord[0] >= firstTileX && currentTile.coord[0] < lastTileX) &&
-                        (currentTile.coord[1] >= firstTileY && currentTile.coord[1] < lastTileY)))
-                    continue;
-                tilesToRead.push_back(currentTile);
-            }
-            if(tilesToRead.empty())
-                throw Exception("Tiles to ready empty");
-
-            auto fullTileBuffer = make_uninitialized_unique<uchar[]>(tileWidth*tileHeight*targetNumberOfTiles*channels);
-            if(tilesToRead.size() != targetNumberOfTiles) { // Some tiles are missing.. (edge case) fill with some blank value
-                if(channels > 1) {
-                    std::memset(fullTileBuffer.get(), 255, tileWidth*tileHeight*targetNumberOfTiles*channels);
-                } else {
-                    std::memset(fullTileBuffer.get(), 0, tileWidth*tileHeight*targetNumberOfTiles*channels);
-                }
-            }
-            const auto fullTileBufferWidth = (lastTileX-firstTileX)*tileWidth;
-            // Read tile to buffer
-            auto tileBuffer = make_uninitialized_unique<uchar[]>(tileWidth*tileHeight*channels); // assume full tiles of same size for all
-            for(auto tile : tilesToRead) {
-                const int tileX = (tile.coord[0]-firstTileX)*tileWidth;
-                const int tileY = (tile.coord[1]-firstTileY)*tileHeight;
-                readVSITileToBuffer(tile, tileBuffer.get());
-                // Stitch tile into full buffer
-                for(int cy = 0; cy < tileHeight; ++cy) {
-                    for(int cx = 0; cx < tileWidth; ++cx) {
-                        for(int channel = 0; channel < channels; ++channel) {
-                            fullTileBuffer[(tileX + cx + (tileY + cy)*fullTileBufferWidth)*channels + channel] = tileBuffer[(cx + cy*tileWidth)*channels + channel];
-                        }
-                    }
-                }
-            }
-
-            // Crop the full buffer to data[]
-            const int offsetX = x - firstTileX*tileWidth;
-            const int offsetY = y - firstTileY*tileHeight;
-            for(int cy = offsetY; cy < offsetY + height; ++cy) {
-                for(int cx = offsetX; cx < offsetX + width; ++cx) {
-                    for(int channel = 0; channel < channels; ++channel) {
-                        data[(cx - offsetX + (cy - offsetY) * width)*channels + channel] = fullTileBuffer[(cx + cy * fullTileBufferWidth)*channels + channel];
-                    }
-                }
-            }
+        const int firstTileX = x / tileWidth;
+        const int firstTileY = y / tileHeight;
+        const int lastTileX = (x + width - 1) / tileWidth;
+        const int lastTileY = (y + height - 1) / tileHeight;
+        std::map<std::pair<int, int>, std::shared_ptr<uchar[]>> tiles;
+        for(int i = 0; i < m_vsiTiles.size(); ++i) {
+            const vsi_tile_header& currentTile = m_vsiTiles[i];
+            if(currentTile.level != level)
+                continue;
+            if(
+                    !((currentTile.coord[0] >= firstTileX && currentTile.coord[0] <= lastTileX) &&
+                    (currentTile.coord[1] >= firstTileY && currentTile.coord[1] <= lastTileY)))
+                continue;
+            tiles[std::make_pair((int)currentTile.coord[0], (int)currentTile.coord[1])] = getVSITile(level, currentTile);
         }
+        if(tiles.empty())
+            throw Exception("Could not find any tiles for getPatchData in VSI");
+        // Missing tiles (edge case) are filled with a blank value
+        copyTilesToBuffer(tiles, level, x, y, width, height, data.get());
     } else {
-        auto levelData = m_levels[level];
-        for(int cy = y; cy < std::min(y + height, levelHeight); ++cy) {
-            for(int cx = x; cx < std::min(x + width, levelWidth); ++cx) {
-                for(int channel = 0; channel < channels; ++channel) {
-                    data[(cx - x + (cy - y) * width)*channels + channel] = levelData.data[(cx + cy * levelWidth)*channels + channel];
-                }
+        // Memory mapped tiles, which are read directly without any decoding or caching
+        const int firstTileX = x / tileWidth;
+        const int firstTileY = y / tileHeight;
+        const int lastTileX = std::min((x + width - 1) / tileWidth, m_levels[level].tilesX - 1);
+        const int lastTileY = std::min((y + height - 1) / tileHeight, m_levels[level].tilesY - 1);
+        std::map<std::pair<int, int>, std::shared_ptr<uchar[]>> tiles;
+        for(int tileY = firstTileY; tileY <= lastTileY; ++tileY) {
+            for(int tileX = firstTileX; tileX <= lastTileX; ++tileX) {
+                // The memory is owned by the pyramid, thus nothing is deleted
+                tiles[std::make_pair(tileX, tileY)] = std::shared_ptr<uchar[]>(getMemoryTile(level, tileX, tileY), [](uchar*) {});
             }
         }
+        copyTilesToBuffer(tiles, level, x, y, width, height, data.get());
     }
 
     return data;
@@ -427,9 +424,83 @@ std::shared_ptr<Image> ImagePyramidAccess::getPatchAsImage(int level, int tileX,
     }
 }
 
-void ImagePyramidAccess::setPatch(int level, int x, int y, Image::pointer patch) {
-    if(m_tiffHandle == nullptr)
-        throw Exception("setPatch only available for TIFF backend ImagePyramids");
+/**
+ * Downsample a tile by 2x2 into a quadrant of a tile of the next level. Color images are averaged, while
+ * single channel images, such as segmentations, use the max to keep small objects.
+ * The number of channels is a template parameter and the inner loops are branch free,
+ * so that the compiler can vectorize them.
+ */
+template <int channels>
+static void downsampleTile(const uchar* input, int inputTileWidth, uchar* output, int tileWidth, int tileHeight, int quadrantX, int quadrantY) {
+    const int offsetX = quadrantX*tileWidth/2;
+    const int offsetY = quadrantY*tileHeight/2;
+    for(int dy = 0; dy < tileHeight/2; ++dy) {
+        const uchar* row0 = &input[(std::size_t)dy*2*inputTileWidth*channels];
+        const uchar* row1 = row0 + (std::size_t)inputTileWidth*channels;
+        uchar* outputRow = &output[((std::size_t)(dy + offsetY)*tileWidth + offsetX)*channels];
+        for(int dx = 0; dx < tileWidth/2; ++dx) {
+            for(int c = 0; c < channels; ++c) {
+                const int a = dx*2*channels + c;
+                const int b = a + channels;
+                if(channels >= 3) {
+                    // Same as rounding the average
+                    outputRow[dx*channels + c] = (uchar)((row0[a] + row0[b] + row1[a] + row1[b] + 2) >> 2);
+                } else {
+                    outputRow[dx*channels + c] = std::max(std::max(row0[a], row0[b]), std::max(row1[a], row1[b]));
+                }
+            }
+        }
+    }
+}
+
+static void downsampleTile(const uchar* input, int inputTileWidth, uchar* output, int tileWidth, int tileHeight, int quadrantX, int quadrantY, int channels) {
+    switch(channels) {
+        case 1:
+            downsampleTile<1>(input, inputTileWidth, output, tileWidth, tileHeight, quadrantX, quadrantY);
+            break;
+        case 2:
+            downsampleTile<2>(input, inputTileWidth, output, tileWidth, tileHeight, quadrantX, quadrantY);
+            break;
+        case 3:
+            downsampleTile<3>(input, inputTileWidth, output, tileWidth, tileHeight, quadrantX, quadrantY);
+            break;
+        case 4:
+            downsampleTile<4>(input, inputTileWidth, output, tileWidth, tileHeight, quadrantX, quadrantY);
+            break;
+        default:
+            throw Exception("Unsupported number of channels in image pyramid: " + std::to_string(channels));
+    }
+}
+
+uint32_t ImagePyramidAccess::getTileID(int level, int x, int y) {
+    if(m_tiffHandle != nullptr) {
+        TIFFSetDirectory(m_tiffHandle, level);
+        return TIFFComputeTile(m_tiffHandle, x, y, 0, 0);
+    }
+    return x / m_levels[level].tileWidth + (y / m_levels[level].tileHeight)*m_levels[level].tilesX;
+}
+
+uchar* ImagePyramidAccess::getMemoryTile(int level, int tileX, int tileY) {
+    const std::size_t tileBytes = (std::size_t)m_levels[level].tileWidth*m_levels[level].tileHeight*m_image->getNrOfChannels();
+    return m_levels[level].data + ((std::size_t)tileY*m_levels[level].tilesX + tileX)*tileBytes;
+}
+
+void ImagePyramidAccess::writeTile(int level, int x, int y, const uchar* data) {
+    std::lock_guard<std::mutex> lock(m_readMutex);
+    if(m_tiffHandle != nullptr) {
+        TIFFSetDirectory(m_tiffHandle, level);
+        TIFFWriteTile(m_tiffHandle, (void *) data, x, y, 0, 0);
+        TIFFCheckpointDirectory(m_tiffHandle);
+    } else {
+        const std::size_t tileBytes = (std::size_t)m_levels[level].tileWidth*m_levels[level].tileHeight*m_image->getNrOfChannels();
+        std::memcpy(getMemoryTile(level, x / m_levels[level].tileWidth, y / m_levels[level].tileHeight), data, tileBytes);
+    }
+    m_initializedPatchList.insert(std::to_string(level) + "-" + std::to_string(getTileID(level, x, y)));
+}
+
+void ImagePyramidAccess::setPatch(int level, int x, int y, Image::pointer patch, bool propagate) {
+    if(m_tiffHandle == nullptr && m_levels[level].data == nullptr)
+        throw Exception("setPatch only available for TIFF and memory mapped ImagePyramids");
 
     if(m_image->getLevelTileWidth(level) > patch->getWidth() || m_image->getLevelTileHeight(level) > patch->getHeight()) {
         // Padding needed
@@ -454,15 +525,7 @@ void ImagePyramidAccess::setPatch(int level, int x, int y, Image::pointer patch)
     // Write tile to this level
     auto patchAccess = patch->getImageAccess(ACCESS_READ);
     auto data = (uchar*)patchAccess->get();
-    uint32_t tile_id;
-    {
-        std::lock_guard<std::mutex> lock(m_readMutex);
-        TIFFSetDirectory(m_tiffHandle, level);
-        TIFFWriteTile(m_tiffHandle, (void *) data, x, y, 0, 0);
-        TIFFCheckpointDirectory(m_tiffHandle);
-        tile_id = TIFFComputeTile(m_tiffHandle, x, y, 0, 0);
-    }
-    m_initializedPatchList.insert(std::to_string(level) + "-" + std::to_string(tile_id));
+    writeTile(level, x, y, data);
 
     // Add patch to list of dirty patches, so the renderer can update it if needed
     int levelWidth = m_image->getLevelWidth(level);
@@ -474,12 +537,23 @@ void ImagePyramidAccess::setPatch(int level, int x, int y, Image::pointer patch)
     m_image->setDirtyPatch(level, patchIdX, patchIdY);
 
     // Propagate upwards
-    auto previousData = std::make_unique<uchar[]>(patch->getNrOfVoxels()*patch->getNrOfChannels());
-    std::memcpy(previousData.get(), data, patch->getNrOfVoxels()*patch->getNrOfChannels());
+    const std::size_t patchBytes = patch->getNrOfVoxels()*patch->getNrOfChannels();
+    std::shared_ptr<uchar[]> previousData(new uchar[patchBytes]);
+    std::memcpy(previousData.get(), data, patchBytes);
+    // Write-through to tile cache, previous data is never modified after this. Memory mapped tiles are not cached.
+    auto& cache = m_image->getTileCache();
+    if(m_tiffHandle != nullptr)
+        cache.put(level, x / m_image->getLevelTileWidth(level), y / m_image->getLevelTileHeight(level), previousData, patchBytes);
+    if(!propagate) {
+        if(level < m_image->getNrOfLevels()-1) {
+            std::lock_guard<std::mutex> lock(m_image->m_pendingPyramidTilesMutex);
+            m_image->m_pendingPyramidTiles[level].insert(std::make_pair(x / m_image->getLevelTileWidth(level), y / m_image->getLevelTileHeight(level)));
+        }
+        return;
+    }
     const auto channels = m_image->getNrOfChannels();
     while(level < m_image->getNrOfLevels()-1) {
         const auto previousTileWidth = m_image->getLevelTileWidth(level);
-        const auto previousTileHeight = m_image->getLevelTileHeight(level);
         ++level;
         x /= 2;
         y /= 2;
@@ -494,60 +568,11 @@ void ImagePyramidAccess::setPatch(int level, int x, int y, Image::pointer patch)
         auto newData = getPatchData(level, x, y, tileWidth, tileHeight);
 
         // Downsample tile from previous level and add it to existing tile
-        if(m_image->getNrOfChannels() >= 3) {
-            const int channels = m_image->getNrOfChannels();
-            // Use average if RGB(A) image
-            for(int dy = 0; dy < tileHeight/2; ++dy) {
-                for(int dx = 0; dx < tileWidth/2; ++dx) {
-                    for(int c = 0; c < channels; ++c) {
-                        newData[c + channels*(dx + offsetX * tileWidth / 2 + (dy + offsetY * tileHeight / 2) * tileWidth)] =
-                            (uchar)round((float)(
-                                previousData[c + channels*(dx * 2 + dy * 2 * previousTileWidth)] +
-                                previousData[c + channels*(dx * 2 + 1 + dy * 2 * previousTileWidth)] +
-                                previousData[c + channels*(dx * 2 + 1 + (dy * 2 + 1) * previousTileWidth)] +
-                                previousData[c + channels*(dx * 2 + (dy * 2 + 1) * previousTileWidth)]
-                                ) / 4);
-                    }
-                }
-            }
-        } else {
-            // Use majority vote if single channel image.
-            for(int dy = 0; dy < tileHeight/2; ++dy) {
-                for(int dx = 0; dx < tileWidth/2; ++dx) {
-                    /*
-                    // This is more correct, but 100 times slower than just doing max.
-                    std::vector<uchar> list = {
-                            previousData[dx*2 + dy*2*previousTileWidth],
-                            previousData[dx*2 + 1 + dy*2*previousTileWidth],
-                            previousData[dx*2 + 1 + (dy*2+1)*previousTileWidth],
-                            previousData[dx*2 + (dy*2+1)*previousTileWidth]
-                    };
-                    std::sort(list.begin(), list.end());
-                    if(list[0] == list[1]) { // If there is more than of element 0, it should be placed as element 1
-                        newData[dx + offsetX*tileWidth/2 + (dy+offsetY*tileHeight/2)*tileWidth] = list[0];
-                    } else { // If not, it means that there is more than 1 of element 1, OR all 4 values are different and its no matter which is picked.
-                        newData[dx + offsetX*tileWidth/2 + (dy+offsetY*tileHeight/2)*tileWidth] = list[2];
-                    }*/
-
-                    // Just do max? 0.006 milliseconds
-                    uchar list[4] = {
-                            previousData[dx*2 + dy*2*previousTileWidth],
-                            previousData[dx*2 + 1 + dy*2*previousTileWidth],
-                            previousData[dx*2 + 1 + (dy*2+1)*previousTileWidth],
-                            previousData[dx*2 + (dy*2+1)*previousTileWidth]
-                    };
-                    newData[dx + offsetX*tileWidth/2 + (dy+offsetY*tileHeight/2)*tileWidth] = std::max(std::max(std::max(list[0], list[1]), list[2]), list[3]);
-                }
-            }
-        }
-        {
-            std::lock_guard<std::mutex> lock(m_readMutex);
-            TIFFSetDirectory(m_tiffHandle, level);
-            TIFFWriteTile(m_tiffHandle, (void *) newData.get(), x, y, 0, 0);
-            TIFFCheckpointDirectory(m_tiffHandle);
-            tile_id = TIFFComputeTile(m_tiffHandle, x, y, 0, 0);
-        }
+        downsampleTile(previousData.get(), previousTileWidth, newData.get(), tileWidth, tileHeight, offsetX, offsetY, channels);
+        writeTile(level, x, y, newData.get());
         previousData = std::move(newData);
+        if(m_tiffHandle != nullptr)
+            cache.put(level, x / tileWidth, y / tileHeight, previousData, (std::size_t)tileWidth*tileHeight*channels);
 
         int levelWidth = m_image->getLevelWidth(level);
         int levelHeight = m_image->getLevelHeight(level);
@@ -556,7 +581,93 @@ void ImagePyramidAccess::setPatch(int level, int x, int y, Image::pointer patch)
         int patchIdX = std::floor(((float)x / levelWidth) * tilesX);
         int patchIdY = std::floor(((float)y / levelHeight) * tilesY);
         m_image->setDirtyPatch(level, patchIdX, patchIdY);
-        m_initializedPatchList.insert(std::to_string(level) + "-" + std::to_string(tile_id));
+    }
+}
+
+void ImagePyramidAccess::updatePyramidLevels() {
+    if(m_tiffHandle == nullptr && m_levels[0].data == nullptr)
+        throw Exception("updatePyramidLevels only available for TIFF and memory mapped ImagePyramids");
+
+    std::map<int, std::set<std::pair<int, int>>> pendingTiles;
+    {
+        std::lock_guard<std::mutex> lock(m_image->m_pendingPyramidTilesMutex);
+        pendingTiles.swap(m_image->m_pendingPyramidTiles);
+    }
+    const int channels = m_image->getNrOfChannels();
+    auto& cache = m_image->getTileCache();
+    // Go from the finest to the coarsest level, since the updated tiles of a level are the input to the next
+    for(int level = 0; level < m_image->getNrOfLevels()-1; ++level) {
+        if(pendingTiles.count(level) == 0)
+            continue;
+        std::set<std::pair<int, int>> parentSet;
+        for(auto&& tile : pendingTiles[level])
+            parentSet.insert(std::make_pair(tile.first / 2, tile.second / 2));
+        const std::vector<std::pair<int, int>> parents(parentSet.begin(), parentSet.end());
+        const int previousTileWidth = m_image->getLevelTileWidth(level);
+        const int previousTileHeight = m_image->getLevelTileHeight(level);
+        const int previousTilesX = m_image->getLevelTilesX(level);
+        const int previousTilesY = m_image->getLevelTilesY(level);
+        const int tileWidth = m_image->getLevelTileWidth(level+1);
+        const int tileHeight = m_image->getLevelTileHeight(level+1);
+        const std::size_t tileBytes = (std::size_t)tileWidth*tileHeight*channels;
+
+        // Build tiles in batches, to limit memory usage
+        const int batchSize = 256;
+        for(int start = 0; start < parents.size(); start += batchSize) {
+            const int end = std::min<int>(start + batchSize, parents.size());
+            std::vector<std::shared_ptr<uchar[]>> tiles(end - start);
+            #pragma omp parallel for
+            for(int i = start; i < end; ++i) {
+                const int tileX = parents[i].first;
+                const int tileY = parents[i].second;
+                bool initialized[2][2];
+                bool allInitialized = true;
+                for(int quadrantY = 0; quadrantY < 2; ++quadrantY) {
+                    for(int quadrantX = 0; quadrantX < 2; ++quadrantX) {
+                        const int previousX = tileX*2 + quadrantX;
+                        const int previousY = tileY*2 + quadrantY;
+                        initialized[quadrantY][quadrantX] = previousX < previousTilesX && previousY < previousTilesY &&
+                                isPatchInitialized(level, previousX*previousTileWidth, previousY*previousTileHeight);
+                        allInitialized = allInitialized && initialized[quadrantY][quadrantX];
+                    }
+                }
+                // Keep existing data of quadrants without any tile
+                std::shared_ptr<uchar[]> tile = allInitialized ?
+                        std::shared_ptr<uchar[]>(new uchar[tileBytes]) :
+                        std::shared_ptr<uchar[]>(getPatchData(level+1, tileX*tileWidth, tileY*tileHeight, tileWidth, tileHeight));
+                for(int quadrantY = 0; quadrantY < 2; ++quadrantY) {
+                    for(int quadrantX = 0; quadrantX < 2; ++quadrantX) {
+                        if(!initialized[quadrantY][quadrantX])
+                            continue;
+                        auto previousData = getPatchData(level, (tileX*2 + quadrantX)*previousTileWidth, (tileY*2 + quadrantY)*previousTileHeight, previousTileWidth, previousTileHeight);
+                        downsampleTile(previousData.get(), previousTileWidth, tile.get(), tileWidth, tileHeight, quadrantX, quadrantY, channels);
+                    }
+                }
+                tiles[i - start] = tile;
+            }
+
+            if(m_tiffHandle != nullptr) {
+                // Writing to the TIFF is sequential
+                std::lock_guard<std::mutex> lock(m_readMutex);
+                TIFFSetDirectory(m_tiffHandle, level+1);
+                for(int i = start; i < end; ++i) {
+                    const int x = parents[i].first*tileWidth;
+                    const int y = parents[i].second*tileHeight;
+                    TIFFWriteTile(m_tiffHandle, (void *) tiles[i - start].get(), x, y, 0, 0);
+                    m_initializedPatchList.insert(std::to_string(level+1) + "-" + std::to_string(TIFFComputeTile(m_tiffHandle, x, y, 0, 0)));
+                }
+                TIFFCheckpointDirectory(m_tiffHandle);
+            } else {
+                for(int i = start; i < end; ++i)
+                    writeTile(level+1, parents[i].first*tileWidth, parents[i].second*tileHeight, tiles[i - start].get());
+            }
+            for(int i = start; i < end; ++i) {
+                if(m_tiffHandle != nullptr)
+                    cache.put(level+1, parents[i].first, parents[i].second, tiles[i - start], tileBytes);
+                m_image->setDirtyPatch(level+1, parents[i].first, parents[i].second);
+                pendingTiles[level+1].insert(parents[i]);
+            }
+        }
     }
 }
 
@@ -564,9 +675,7 @@ bool ImagePyramidAccess::isPatchInitialized(uint level, uint x, uint y) {
     if(m_image->isPyramidFullyInitialized())
         return true;
     std::lock_guard<std::mutex> lock(m_readMutex);
-    TIFFSetDirectory(m_tiffHandle, level);
-    auto tile = TIFFComputeTile(m_tiffHandle, x, y, 0, 0);
-    return m_initializedPatchList.count(std::to_string(level) + "-" + std::to_string(tile)) > 0;
+    return m_initializedPatchList.count(std::to_string(level) + "-" + std::to_string(getTileID(level, x, y))) > 0;
 }
 
 }
@@ -4,6 +4,7 @@
 #include <FAST/Data/DataTypes.hpp>
 #include <unordered_set>
 #include <fstream>
+#include <map>
 
 // Forward declare
 typedef struct _openslide openslide_t;
@@ -54,8 +55,8 @@ public:
 	int tileHeight = 256;
 	int tilesX;
     int tilesY;
-	bool memoryMapped;
-	uint8_t* data;
+	bool memoryMapped = false;
+	uint8_t* data = nullptr; // Uncompressed tiles, stored after each other in row order
 	uint64_t offset = 0; // subifd offset used by OME-TIFF
 #ifdef WIN32
 	void* fileHandle;
@@ -67,8 +68,24 @@ public:
 class FAST_EXPORT ImagePyramidAccess : Object {
 public:
 	typedef std::unique_ptr<ImagePyramidAccess> pointer;
-	ImagePyramidAccess(std::vector<ImagePyramidLevel> levels, openslide_t* fileHandle, TIFF* tiffHandle, std::ifstream* stream, std::vector<vsi_tile_header>& vsiTiles, std::shared_ptr<ImagePyramid> imagePyramid, bool writeAccess, std::unordered_set<std::string>& initializedPatchList, std::mutex& readMutex, ImageCompression compressionFormat);
-	void setPatch(int level, int x, int y, std::shared_ptr<Image> patch);
+	ImagePyramidAccess(std::vector<ImagePyramidLevel> levels, openslide_t* fileHandle, TIFF* tiffHandle, std::ifstream* stream, const std::vector<vsi_tile_header>& vsiTiles, std::shared_ptr<ImagePyramid> imagePyramid, bool writeAccess, std::unordered_set<std::string>& initializedPatchList, std::mutex& readMutex, ImageCompression compressionFormat, int vsiFileDescriptor = -1);
+	/**
+	 * @brief Write a tile to the image pyramid
+	 *
+	 * @param level Level to write to
+	 * @param x Position of tile in pixels
+	 * @param y Position of tile in pixels
+	 * @param patch Tile data
+	 * @param propagate Update the tiles of all coarser levels right away. If false, the coarser levels are
+	 * 		only updated when updatePyramidLevels() is called. This is much faster when writing many tiles.
+	 */
+	void setPatch(int level, int x, int y, std::shared_ptr<Image> patch, bool propagate = true);
+	/**
+	 * @brief Build the tiles of the coarser levels from all tiles written with setPatch without propagation
+	 *
+	 * Each coarser tile is downsampled once from its four finer tiles, using multiple threads.
+	 */
+	void updatePyramidLevels();
 	bool isPatchInitialized(uint level, uint x, uint y);
 	std::unique_ptr<uchar[]> getPatchData(int level, int x, int y, int width, int height);
 	ImagePyramidPatch getPatch(std::string tile);
@@ -87,9 +104,18 @@ private:
     std::unordered_set<std::string>& m_initializedPatchList; // Keep a list of initialized patches, for tiff backend
     std::mutex& m_readMutex;
     std::ifstream* m_vsiHandle;
+    int m_vsiFileDescriptor;
     ImageCompression m_compressionFormat;
-    std::vector<vsi_tile_header> m_vsiTiles;
+    const std::vector<vsi_tile_header>& m_vsiTiles;
     void readVSITileToBuffer(vsi_tile_header tile, uchar* data);
+    void readVSITileBytes(vsi_tile_header tile, char* buffer);
+    std::shared_ptr<uchar[]> getVSITile(int level, vsi_tile_header tile);
+    void copyTilesToBuffer(const std::map<std::pair<int, int>, std::shared_ptr<uchar[]>>& tiles, int level, int x, int y, int width, int height, uchar* data);
+    // Number of the tile containing x, y. For TIFF, m_readMutex must be locked.
+    uint32_t getTileID(int level, int x, int y);
+    uchar* getMemoryTile(int level, int tileX, int tileY);
+    // Write a full tile to the TIFF file or memory, and mark it as initialized
+    void writeTile(int level, int x, int y, const uchar* data);
 };
 
 }
\ No newline at end of file
@@ -3,9 +3,10 @@
 
 namespace fast {
 
-TensorAccess::TensorAccess(float *data, TensorShape shape, std::shared_ptr<Tensor> tensor) {
+TensorAccess::TensorAccess(void* data, TensorShape shape, DataType type, std::shared_ptr<Tensor> tensor) {
     m_data = data;
     m_shape = shape;
+    m_dataType = type;
     m_tensor = tensor;
 }
 
@@ -22,7 +23,18 @@ void TensorAccess::release() {
 }
 
 float* TensorAccess::getRawData() {
+    if(m_dataType != TYPE_FLOAT)
+        throw Exception("TensorAccess::getRawData() requires a float tensor, but tensor has data type " +
+                getCTypeAsString(m_dataType) + ". Use get() or convert it with Tensor::toDataType(TYPE_FLOAT).");
+    return (float*)m_data;
+}
+
+void* TensorAccess::get() {
     return m_data;
 }
 
+DataType TensorAccess::getDataType() const {
+    return m_dataType;
+}
+
 }
\ No newline at end of file
@@ -15,8 +15,18 @@ class Tensor;
 class FAST_EXPORT TensorAccess {
     public:
         typedef std::unique_ptr<TensorAccess> pointer;
-        TensorAccess(float* data, TensorShape shape, std::shared_ptr<Tensor> tensor);
+        TensorAccess(void* data, TensorShape shape, DataType type, std::shared_ptr<Tensor> tensor);
+        /**
+         * @brief Get pointer to float data. Throws if the tensor is not of type TYPE_FLOAT.
+         * @return pointer to data
+         */
         float * getRawData();
+        /**
+         * @brief Get pointer to data of any type. Use getDataType() to know the type.
+         * @return pointer to data
+         */
+        void* get();
+        DataType getDataType() const;
         TensorShape getShape() const;
         ~TensorAccess();
         void release();
@@ -25,7 +35,8 @@ class FAST_EXPORT TensorAccess {
     private:
         std::shared_ptr<Tensor> m_tensor;
         TensorShape m_shape;
-        float* m_data;
+        DataType m_dataType;
+        void* m_data;
 };
 
 
@@ -33,6 +44,8 @@ template <int NumDimensions>
 TensorData<NumDimensions> TensorAccess::getData() const {
     if(NumDimensions != m_shape.getDimensions())
         throw Exception("Dimension mismatch for Eigen tensor in TensorAccess::getData<#Dimension>().");
+    if(m_dataType != TYPE_FLOAT)
+        throw Exception("TensorAccess::getData<#Dimension>() is only supported for float tensors");
 
     // Construct eigen shape
     Eigen::array<int, NumDimensions> sizes;
@@ -40,7 +53,7 @@ TensorData<NumDimensions> TensorAccess::getData() const {
         sizes[i] = m_shape[i];
 
     // Create and return mapped eigen tensor
-    return TensorData<NumDimensions>(m_data, sizes);
+    return TensorData<NumDimensions>((float*)m_data, sizes);
 }
 
 
@@ -366,9 +366,115 @@ float BoundingBoxSet::getMinimumSize() const {
 }
 
 
-BoundingBoxSetAccumulator::BoundingBoxSetAccumulator() {
+BoundingBoxSetAccumulator::BoundingBoxSetAccumulator(float mergeThreshold, std::string filename) {
     createInputPort<BoundingBoxSet>(0);
     createOutputPort<BoundingBoxSet>(0);
+    setMergeThreshold(mergeThreshold);
+    setFilename(filename);
+    createFloatAttribute("merge-threshold", "Merge threshold", "Minimum intersection over smallest area to merge bounding boxes from different patches. Negative value disables merging.", m_mergeThreshold);
+    createStringAttribute("filename", "Filename", "CSV file to write finalized bounding boxes to", m_filename);
+}
+
+void BoundingBoxSetAccumulator::loadAttributes() {
+    setMergeThreshold(getFloatAttribute("merge-threshold"));
+    setFilename(getStringAttribute("filename"));
+}
+
+void BoundingBoxSetAccumulator::setMergeThreshold(float threshold) {
+    m_mergeThreshold = threshold;
+    setModified(true);
+}
+
+float BoundingBoxSetAccumulator::getMergeThreshold() const {
+    return m_mergeThreshold;
+}
+
+void BoundingBoxSetAccumulator::setFilename(std::string filename) {
+    m_filename = filename;
+    setModified(true);
+}
+
+std::string BoundingBoxSetAccumulator::getFilename() const {
+    return m_filename;
+}
+
+Vector2f BoundingBoxSetAccumulator::getPatchOffset(std::shared_ptr<DataObject> patch) {
+    if(!patch->hasFrameData("patchid-x"))
+        return Vector2f::Zero();
+    const int overlapX = patch->hasFrameData("patch-overlap-x") ? patch->getFrameData<int>("patch-overlap-x") : 0;
+    const int overlapY = patch->hasFrameData("patch-overlap-y") ? patch->getFrameData<int>("patch-overlap-y") : 0;
+    // Patches overlap, and the first patch is padded by the overlap
+    return Vector2f(
+        (patch->getFrameData<int>("patchid-x")*(patch->getFrameData<int>("patch-width") - 2*overlapX) - overlapX) * patch->getFrameData<float>("patch-spacing-x"),
+        (patch->getFrameData<int>("patchid-y")*(patch->getFrameData<int>("patch-height") - 2*overlapY) - overlapY) * patch->getFrameData<float>("patch-spacing-y")
+    );
+}
+
+int BoundingBoxSetAccumulator::getNrOfActiveBoundingBoxes() const {
+    int count = 0;
+    for(const auto& box : m_activeBoxes) {
+        if(!box.removed)
+            ++count;
+    }
+    return count;
+}
+
+void BoundingBoxSetAccumulator::addActiveBoundingBox(ActiveBoundingBox box) {
+    if(m_mergeThreshold >= 0.0f) {
+        // Merge with duplicates from other patches. The merged bounding box may overlap other duplicates,
+        // thus search again until no more duplicates are found.
+        bool merged;
+        do {
+            merged = false;
+            m_grid.forEachNeighbour(box.min, box.max, [&](int index) {
+                auto& other = m_activeBoxes[index];
+                if(other.removed || other.patch == box.patch || other.label != box.label)
+                    return true;
+                if(intersectionOverMinimumArea(box.min, box.max, other.min, other.max) > m_mergeThreshold) {
+                    box.min = box.min.cwiseMin(other.min);
+                    box.max = box.max.cwiseMax(other.max);
+                    box.score = std::max(box.score, other.score);
+                    other.removed = true;
+                    merged = true;
+                }
+                return !merged;
+            });
+        } while(merged);
+    }
+    indexActiveBoundingBox(box);
+}
+
+void BoundingBoxSetAccumulator::indexActiveBoundingBox(const ActiveBoundingBox& box) {
+    const int index = m_activeBoxes.size();
+    m_activeBoxes.push_back(box);
+    m_grid.insert(index, box.min, box.max);
+}
+
+void BoundingBoxSetAccumulator::finalizeBoundingBoxes(float maxY, bool all) {
+    // Bounding boxes are finalized if all is true, or if they are above maxY
+    std::vector<ActiveBoundingBox> remaining;
+    {
+        auto outputAccess = m_accumulatedBBset->getAccess(ACCESS_READ_WRITE);
+        for(const auto& box : m_activeBoxes) {
+            if(box.removed)
+                continue;
+            if(!all && box.max.y() >= maxY) {
+                remaining.push_back(box);
+                continue;
+            }
+            const Vector2f size = box.max - box.min;
+            if(m_file.is_open()) {
+                m_file << box.min.x() << "," << box.min.y() << "," << size.x() << "," << size.y() << "," << (int)box.label << "," << box.score << "\n";
+            } else {
+                outputAccess->addBoundingBox(box.min, size, box.label, box.score);
+            }
+        }
+    }
+    // Rebuild the spatial index with the remaining bounding boxes
+    m_activeBoxes.clear();
+    m_grid.clear();
+    for(const auto& box : remaining)
+        indexActiveBoundingBox(box);
 }
 
 void BoundingBoxSetAccumulator::execute() {
@@ -377,21 +483,92 @@ void BoundingBoxSetAccumulator::execute() {
         m_accumulatedBBset = BoundingBoxSet::create();
     }
 
-    auto outputAccess = m_accumulatedBBset->getAccess(ACCESS_READ_WRITE);
-    auto inputAccess = input->getAccess(ACCESS_READ);
-
-
-	const float offsetX = std::stoi(input->getFrameData("patchid-x")) * std::stoi(input->getFrameData("patch-width")) * std::stof(input->getFrameData("patch-spacing-x"));
-	const float offsetY = std::stoi(input->getFrameData("patchid-y")) * std::stoi(input->getFrameData("patch-height")) * std::stof(input->getFrameData("patch-spacing-y"));
+    // Position of patch in the full image
+    const Vector2f offset = getPatchOffset(input);
+    const float offsetX = offset.x();
+    const float offsetY = offset.y();
+    int patchX = 0;
+    int patchY = -1;
+    if(input->hasFrameData("patchid-x")) {
+        patchX = input->getFrameData<int>("patchid-x");
+        patchY = input->getFrameData<int>("patchid-y");
+    }
 
+    auto inputAccess = input->getAccess(ACCESS_READ);
 	auto coords = inputAccess->getCoordinates();
     for(int i = 0; i < coords.size(); i += 3) {
         coords[i + 0] += offsetX;
         coords[i + 1] += offsetY;
     }
 
-    outputAccess->addBoundingBoxes(coords, inputAccess->getLines(), inputAccess->getLabels(), inputAccess->getScores(), input->getMinimumSize());
-    addOutputData(0, m_accumulatedBBset);
+    if(m_mergeThreshold < 0.0f && m_filename.empty()) {
+        // Only concatenate the bounding box sets
+        auto outputAccess = m_accumulatedBBset->getAccess(ACCESS_READ_WRITE);
+        outputAccess->addBoundingBoxes(coords, inputAccess->getLines(), inputAccess->getLabels(), inputAccess->getScores(), input->getMinimumSize());
+        addOutputData(0, m_accumulatedBBset);
+        return;
+    }
+
+    if(!m_filename.empty() && !m_file.is_open()) {
+        m_file.open(m_filename, std::ios::out | std::ios::trunc);
+        if(!m_file.is_open())
+            throw Exception("Unable to open file " + m_filename + " in BoundingBoxSetAccumulator");
+        m_file << "x,y,width,height,label,score\n";
+    }
+
+    // Patches arrive row by row. When a new row starts, bounding boxes above it can't overlap any later patch.
+    if(patchY >= 0 && patchY != m_currentPatchRow) {
+        if(m_currentPatchRow >= 0)
+            finalizeBoundingBoxes(offsetY, false);
+        m_currentPatchRow = patchY;
+    }
+
+    const auto labels = inputAccess->getLabels();
+    const auto scores = inputAccess->getScores();
+    if(m_cellSize <= 0.0f && !scores.empty()) {
+        // Cells about twice the size of the bounding boxes
+        double meanSize = 0.0;
+        for(int i = 0; i < scores.size(); ++i)
+            meanSize += std::max(coords[i*12 + 6] - coords[i*12], coords[i*12 + 7] - coords[i*12 + 1]);
+        m_cellSize = std::max(2.0*meanSize / scores.size(), 1e-6);
+        m_grid.setCellSize(m_cellSize);
+    }
+    const int64_t patch = patchY >= 0 ? ((int64_t)patchY << 32) + patchX : m_frameCounter;
+    ++m_frameCounter;
+    for(int i = 0; i < scores.size(); ++i) {
+        ActiveBoundingBox box;
+        box.min = Vector2f(coords[i*12], coords[i*12 + 1]);
+        box.max = Vector2f(coords[i*12 + 6], coords[i*12 + 7]);
+        if(box.max.x() <= box.min.x() || box.max.y() <= box.min.y())
+            continue;
+        box.label = labels[i*4];
+        box.score = scores[i];
+        box.patch = patch;
+        box.removed = false;
+        addActiveBoundingBox(box);
+    }
+
+    if(input->isLastFrame()) {
+        finalizeBoundingBoxes(0.0f, true);
+        if(m_file.is_open())
+            m_file.close();
+        m_currentPatchRow = -1;
+    }
+
+    if(!m_filename.empty()) {
+        // Finalized bounding boxes are on disk, output the ones still in memory
+        auto output = BoundingBoxSet::create();
+        {
+            auto outputAccess = output->getAccess(ACCESS_READ_WRITE);
+            for(const auto& box : m_activeBoxes) {
+                if(!box.removed)
+                    outputAccess->addBoundingBox(box.min, box.max - box.min, box.label, box.score);
+            }
+        }
+        addOutputData(0, output);
+    } else {
+        addOutputData(0, m_accumulatedBBset);
+    }
 }
 
-}
\ No newline at end of file
+}
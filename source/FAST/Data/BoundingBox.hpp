@@ -3,7 +3,9 @@
 #include <FAST/Data/SpatialDataObject.hpp>
 #include <FAST/Data/SimpleDataObject.hpp>
 #include <FAST/Data/Access/BoundingBoxSetAccess.hpp>
+#include <FAST/Data/BoundingBoxGrid.hpp>
 #include <thread>
+#include <fstream>
 #include <FAST/ProcessObject.hpp>
 
 namespace fast {
@@ -100,17 +102,83 @@ class FAST_EXPORT BoundingBoxSet : public SpatialDataObject {
 /**
  * @brief Accumulate a stream of bounding box sets to a single large bounding box set.
  *
+ * Bounding boxes of patches from PatchGenerator are moved to the coordinate system of the whole image,
+ * using the patch frame data.
+ *
+ * If a merge threshold is set, duplicate detections of objects on the border of overlapping patches are merged as
+ * patches arrive. Two bounding boxes from different patches with the same label are merged into the union of them,
+ * with the highest score, if their intersection divided by the area of the smallest bounding box is above the threshold.
+ * Bounding boxes are kept in a spatial index until no later patch can overlap them, which is when the stream has moved
+ * on to the next row of patches. They are then finalized, and added to the output bounding box set.
+ * Thus the output lags one row of patches behind, and is complete when the last frame has been processed.
+ *
+ * If a filename is set, finalized bounding boxes are written to this CSV file with the columns x, y, width, height,
+ * label, score instead of being kept in memory. The output then only contains the bounding boxes which are not
+ * finalized yet. Memory usage is then proportional to a row of patches instead of the whole image.
+ *
+ * Inputs:
+ * - 0: BoundingBoxSet stream
+ *
+ * Outputs:
+ * - 0: BoundingBoxSet
+ *
  * @todo move to algorithms folder
  * @ingroup bounding-box
  */
 class FAST_EXPORT BoundingBoxSetAccumulator : public ProcessObject {
     FAST_PROCESS_OBJECT(BoundingBoxSetAccumulator)
 	public:
-        FAST_CONSTRUCTOR(BoundingBoxSetAccumulator)
+        /**
+         * @brief Create instance
+         * @param mergeThreshold Minimum intersection over smallest area to merge bounding boxes from different patches.
+         *      Negative value disables merging, which is the default.
+         * @param filename CSV file to write finalized bounding boxes to. If empty, finalized bounding boxes are
+         *      kept in the output bounding box set.
+         * @return instance
+         */
+        FAST_CONSTRUCTOR(BoundingBoxSetAccumulator,
+                         float, mergeThreshold, = -1.0f,
+                         std::string, filename, = ""
+        )
+        void setMergeThreshold(float threshold);
+        float getMergeThreshold() const;
+        void setFilename(std::string filename);
+        std::string getFilename() const;
+        void loadAttributes() override;
+        /**
+         * @brief Get position of a patch from PatchGenerator in the full image, using its frame data
+         * @param patch Patch, or data object created from a patch, such as a tensor
+         * @return physical position of the patch. Zero if the data object has no patch frame data.
+         */
+        static Vector2f getPatchOffset(std::shared_ptr<DataObject> patch);
+        /**
+         * @return number of bounding boxes not finalized yet
+         */
+        int getNrOfActiveBoundingBoxes() const;
 	protected:
         void execute() override;
+        struct ActiveBoundingBox {
+            Vector2f min;
+            Vector2f max;
+            uchar label;
+            float score;
+            int64_t patch;
+            bool removed;
+        };
+        void addActiveBoundingBox(ActiveBoundingBox box);
+        void indexActiveBoundingBox(const ActiveBoundingBox& box);
+        void finalizeBoundingBoxes(float maxY, bool all);
 
         BoundingBoxSet::pointer m_accumulatedBBset;
+        float m_mergeThreshold = -1.0f;
+        std::string m_filename;
+        std::ofstream m_file;
+        // Spatial hash of bounding boxes which are not finalized yet
+        std::vector<ActiveBoundingBox> m_activeBoxes;
+        BoundingBoxGrid m_grid;
+        float m_cellSize = -1.0f; // Chosen from the first bounding boxes
+        int m_currentPatchRow = -1;
+        int64_t m_frameCounter = 0;
 };
 
 }
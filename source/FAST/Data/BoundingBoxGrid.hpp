@@ -0,0 +1,111 @@
+#pragma once
+
+#include <FAST/Data/DataTypes.hpp>
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+namespace fast {
+
+/**
+ * @brief Spatial hash grid of bounding box indices
+ *
+ * Internal helper of NonMaximumSuppression and BoundingBoxSetAccumulator, not part of the public API.
+ * A bounding box is stored in every cell it overlaps, thus two overlapping bounding boxes always share at least one cell.
+ * Only cells containing bounding boxes are stored, thus the grid is unbounded, and coordinates can be negative.
+ */
+class BoundingBoxGrid {
+    public:
+        explicit BoundingBoxGrid(float cellSize = 1.0f) {
+            setCellSize(cellSize);
+        }
+        /**
+         * Set size of the square cells. Clears the grid.
+         */
+        void setCellSize(float cellSize) {
+            m_cellSize = std::max(cellSize, 1e-6f);
+            m_cells.clear();
+        }
+        float getCellSize() const {
+            return m_cellSize;
+        }
+        void insert(int index, const Vector2f& min, const Vector2f& max) {
+            int x1, y1, x2, y2;
+            getCellRange(min, max, x1, y1, x2, y2);
+            for(int y = y1; y <= y2; ++y) {
+                for(int x = x1; x <= x2; ++x)
+                    m_cells[getCellKey(x, y)].push_back(index);
+            }
+        }
+        /**
+         * Call function for every bounding box index in the cells the given bounding box overlaps.
+         * The same index may be visited more than once. Stops if the function returns false.
+         */
+        template <class Function>
+        void forEachNeighbour(const Vector2f& min, const Vector2f& max, Function function) const {
+            int x1, y1, x2, y2;
+            getCellRange(min, max, x1, y1, x2, y2);
+            for(int y = y1; y <= y2; ++y) {
+                for(int x = x1; x <= x2; ++x) {
+                    auto cell = m_cells.find(getCellKey(x, y));
+                    if(cell == m_cells.end())
+                        continue;
+                    for(int index : cell->second) {
+                        if(!function(index))
+                            return;
+                    }
+                }
+            }
+        }
+        void clear() {
+            m_cells.clear();
+        }
+    private:
+        int getCell(float coordinate) const {
+            // Clamp before converting, since converting a float outside the range of int is undefined
+            const float cell = std::floor(coordinate / m_cellSize);
+            return (int)std::min(std::max(cell, -1073741824.0f), 1073741824.0f);
+        }
+        void getCellRange(const Vector2f& min, const Vector2f& max, int& x1, int& y1, int& x2, int& y2) const {
+            x1 = getCell(min.x());
+            y1 = getCell(min.y());
+            x2 = getCell(max.x());
+            y2 = getCell(max.y());
+        }
+        static int64_t getCellKey(int x, int y) {
+            // Shift as unsigned, since left shift of a negative signed value is undefined
+            return (int64_t)(((uint64_t)(uint32_t)x << 32) | (uint64_t)(uint32_t)y);
+        }
+        float m_cellSize;
+        std::unordered_map<int64_t, std::vector<int>> m_cells;
+};
+
+/**
+ * Intersection over union of two bounding boxes given by their min and max corners.
+ */
+inline float intersectionOverUnion(const Vector2f& min1, const Vector2f& max1, const Vector2f& min2, const Vector2f& max2) {
+    const Vector2f intersectionMin = min1.cwiseMax(min2);
+    const Vector2f intersectionMax = max1.cwiseMin(max2);
+    if(intersectionMax.x() < intersectionMin.x() || intersectionMax.y() < intersectionMin.y()) // There is no overlap
+        return 0.0f;
+    const float intersection = (intersectionMax - intersectionMin).prod();
+    return intersection / ((max1 - min1).prod() + (max2 - min2).prod() - intersection);
+}
+
+/**
+ * Intersection divided by the area of the smallest bounding box. Unlike intersection over union, this is large when
+ * a bounding box cut by a patch border is inside the bounding box of the same object from the neighbour patch.
+ */
+inline float intersectionOverMinimumArea(const Vector2f& min1, const Vector2f& max1, const Vector2f& min2, const Vector2f& max2) {
+    const Vector2f intersectionMin = min1.cwiseMax(min2);
+    const Vector2f intersectionMax = max1.cwiseMin(max2);
+    if(intersectionMax.x() <= intersectionMin.x() || intersectionMax.y() <= intersectionMin.y())
+        return 0.0f;
+    const float intersection = (intersectionMax - intersectionMin).prod();
+    const float minimumArea = std::min((max1 - min1).prod(), (max2 - min2).prod());
+    return intersection / minimumArea;
+}
+
+}
@@ -94,20 +94,45 @@ std::set<std::string> DataObject::getLastFrame() {
 }
 
 void DataObject::setFrameData(std::string name, std::string value) {
-    m_frameData[name] = value;
+    m_frameData.set(name, std::move(value));
 }
 
-std::string DataObject::getFrameData(std::string name) {
-    if(m_frameData.count(name) == 0)
-        throw Exception("Frame data " + name + " does not exist.");
+void DataObject::setFrameData(std::string name, int value) {
+    m_frameData.set(name, (int64_t)value);
+}
+
+void DataObject::setFrameData(std::string name, int64_t value) {
+    m_frameData.set(name, value);
+}
+
+void DataObject::setFrameData(std::string name, float value) {
+    m_frameData.set(name, (double)value);
+}
 
-    return m_frameData[name];
+void DataObject::setFrameData(std::string name, double value) {
+    m_frameData.set(name, value);
+}
+
+void DataObject::setFrameData(std::string name, std::vector<float> value) {
+    m_frameData.set(name, std::move(value));
+}
+
+std::string DataObject::getFrameData(std::string name) {
+    return m_frameData.getString(name);
 }
 
 std::map<std::string, std::string> DataObject::getFrameData() {
+    return m_frameData.toStringMap();
+}
+
+const FrameData& DataObject::getFrameDataStore() const {
     return m_frameData;
 }
 
+void DataObject::mergeFrameData(const FrameData& frameData) {
+    m_frameData.merge(frameData);
+}
+
 void DataObject::removeLastFrame(std::string streamer) {
     m_lastFrame.erase(streamer);
 }
@@ -117,21 +142,39 @@ void DataObject::clearLastFrame() {
 }
 
 bool DataObject::hasFrameData(std::string name) const {
-    return m_frameData.count(name) > 0;
+    return m_frameData.has(name);
 }
 
 void DataObject::setFrameData(std::map<std::string, std::string> frameData) {
-    m_frameData = frameData;
+    m_frameData.clear();
+    for(auto&& item : frameData)
+        m_frameData.set(item.first, item.second);
 }
 
 
 template <>
 int DataObject::getFrameData(std::string name) {
-    return std::stoi(getFrameData(name));
+    return (int)m_frameData.getInteger(name);
+}
+template <>
+int64_t DataObject::getFrameData(std::string name) {
+    return m_frameData.getInteger(name);
 }
 template <>
 float DataObject::getFrameData(std::string name) {
-    return std::stof(getFrameData(name));
+    return (float)m_frameData.getFloat(name);
+}
+template <>
+double DataObject::getFrameData(std::string name) {
+    return m_frameData.getFloat(name);
+}
+template <>
+std::string DataObject::getFrameData(std::string name) {
+    return m_frameData.getString(name);
+}
+template <>
+std::vector<float> DataObject::getFrameData(std::string name) {
+    return m_frameData.getFloatList(name);
 }
 
 } // end namespace fast
@@ -2,6 +2,7 @@
 
 #include "FAST/Object.hpp"
 #include "FAST/ExecutionDevice.hpp"
+#include "FAST/Data/FrameData.hpp"
 #include <map>
 #include <set>
 #include <condition_variable>
@@ -46,12 +47,33 @@ class FAST_EXPORT  DataObject : public Object {
         void clearLastFrame();
         std::set<std::string> getLastFrame();
         void setFrameData(std::string name, std::string value);
+        void setFrameData(std::string name, int value);
+        void setFrameData(std::string name, float value);
+        void setFrameData(std::string name, double value);
+#ifndef SWIG
+        void setFrameData(std::string name, int64_t value);
+        void setFrameData(std::string name, std::vector<float> value);
+#endif
         void setFrameData(std::map<std::string, std::string> frameData);
         std::string getFrameData(std::string name);
+        /**
+         * @brief Get frame data as type T without parsing, if it was stored as this type.
+         * Supported types are int, int64_t, float, double, std::string and std::vector<float>.
+         */
         template <class T>
         T getFrameData(std::string name);
         bool hasFrameData(std::string name) const;
         std::map<std::string, std::string> getFrameData();
+#ifndef SWIG
+        /**
+         * @brief Get typed frame data store of this data object
+         */
+        const FrameData& getFrameDataStore() const;
+        /**
+         * @brief Add all frame data in frameData to this data object, overwriting existing values with same name.
+         */
+        void mergeFrameData(const FrameData& frameData);
+#endif
         void accessFinished();
     protected:
         virtual void free(ExecutionDevice::pointer device) = 0;
@@ -79,7 +101,7 @@ class FAST_EXPORT  DataObject : public Object {
 
         // Frame data
         // Similar to metadata, only this is transferred from input to output
-        std::map<std::string, std::string> m_frameData;
+        FrameData m_frameData;
         // Indicates whether this data object is the last frame in a stream, and if so, the name of the stream
         std::set<std::string> m_lastFrame;
 
@@ -90,5 +112,13 @@ template <>
 int DataObject::getFrameData(std::string name);
 template <>
 float DataObject::getFrameData(std::string name);
+template <>
+int64_t DataObject::getFrameData(std::string name);
+template <>
+double DataObject::getFrameData(std::string name);
+template <>
+std::string DataObject::getFrameData(std::string name);
+template <>
+std::vector<float> DataObject::getFrameData(std::string name);
 
 }
@@ -1,4 +1,5 @@
 #include "DataTypes.hpp"
+#include <cstring>
 
 namespace fast {
 
@@ -10,7 +11,9 @@ std::string getCTypeAsString(DataType type) {
             {TYPE_INT16, "short"},
             {TYPE_SNORM_INT16, "short"},
             {TYPE_UINT16, "ushort"},
-            {TYPE_UNORM_INT16, "ushort"}
+            {TYPE_UNORM_INT16, "ushort"},
+            {TYPE_INT32, "int"},
+            {TYPE_FLOAT16, "half"}
     };
 
     return defines.at(type);
@@ -42,6 +45,12 @@ cl::ImageFormat getOpenCLImageFormat(OpenCLDevice::pointer device, cl_mem_object
     case TYPE_SNORM_INT16:
         channelType = CL_SNORM_INT16;
         break;
+    case TYPE_INT32:
+        channelType = CL_SIGNED_INT32;
+        break;
+    case TYPE_FLOAT16:
+        channelType = CL_HALF_FLOAT;
+        break;
     }
 
     switch(channels) {
@@ -94,6 +103,12 @@ size_t getSizeOfDataType(DataType type, unsigned int nrOfComponents) {
     case TYPE_UNORM_INT16:
         bytes = sizeof(short);
         break;
+    case TYPE_INT32:
+        bytes = sizeof(int);
+        break;
+    case TYPE_FLOAT16:
+        bytes = sizeof(float16);
+        break;
     }
 
     return nrOfComponents*bytes;
@@ -123,6 +138,12 @@ float getDefaultIntensityLevel(DataType type) {
     case TYPE_SNORM_INT16:
         level = 0;
         break;
+    case TYPE_INT32:
+        level = 0;
+        break;
+    case TYPE_FLOAT16:
+        level = 0.5;
+        break;
     }
     return level;
 }
@@ -151,6 +172,12 @@ float getDefaultIntensityWindow(DataType type) {
     case TYPE_SNORM_INT16:
         window = 2;
         break;
+    case TYPE_INT32:
+        window = 255;
+        break;
+    case TYPE_FLOAT16:
+        window = 1.0;
+        break;
     }
     return window;
 }
@@ -174,7 +201,76 @@ void deleteArray(void * data, DataType type) {
         case TYPE_SNORM_INT16:
             delete[] (short*)data;
             break;
+        case TYPE_INT32:
+            delete[] (int*)data;
+            break;
+        case TYPE_FLOAT16:
+            delete[] (float16*)data;
+            break;
+    }
+}
+
+float16::float16(float value) {
+    // Round to nearest even, with overflow to infinity and underflow to subnormals/zero
+    uint32_t x;
+    std::memcpy(&x, &value, sizeof(x));
+    const uint32_t sign = (x >> 16) & 0x8000;
+    x &= 0x7FFFFFFF;
+    if(x >= 0x7F800000) {
+        // Inf or NaN
+        bits = sign | 0x7C00 | (x > 0x7F800000 ? 0x200 : 0);
+    } else if(x >= 0x477FF000) {
+        // Too large, rounds to infinity
+        bits = sign | 0x7C00;
+    } else if(x < 0x38800000) {
+        // Subnormal or zero
+        if(x < 0x33000000) {
+            bits = sign;
+        } else {
+            const int shift = 126 - (x >> 23);
+            const uint32_t mantissa = (x & 0x7FFFFF) | 0x800000;
+            uint32_t result = mantissa >> shift;
+            const uint32_t remainder = mantissa & ((1u << shift) - 1);
+            const uint32_t half = 1u << (shift - 1);
+            if(remainder > half || (remainder == half && (result & 1)))
+                ++result;
+            bits = sign | result;
+        }
+    } else {
+        uint32_t result = ((x - 0x38000000) >> 13);
+        const uint32_t remainder = x & 0x1FFF;
+        if(remainder > 0x1000 || (remainder == 0x1000 && (result & 1)))
+            ++result;
+        bits = sign | result;
+    }
+}
+
+float16::operator float() const {
+    const uint32_t sign = (uint32_t)(bits & 0x8000) << 16;
+    const uint32_t exponent = (bits >> 10) & 0x1F;
+    uint32_t mantissa = bits & 0x3FF;
+    uint32_t x;
+    if(exponent == 0x1F) {
+        // Inf or NaN
+        x = sign | 0x7F800000 | (mantissa << 13);
+    } else if(exponent == 0) {
+        if(mantissa == 0) {
+            x = sign;
+        } else {
+            // Subnormal, normalize it
+            int e = -1;
+            do {
+                ++e;
+                mantissa <<= 1;
+            } while((mantissa & 0x400) == 0);
+            x = sign | ((uint32_t)(112 - e) << 23) | ((mantissa & 0x3FF) << 13);
+        }
+    } else {
+        x = sign | ((exponent + 112) << 23) | (mantissa << 13);
     }
+    float value;
+    std::memcpy(&value, &x, sizeof(value));
+    return value;
 }
 
 } // end namespace fast
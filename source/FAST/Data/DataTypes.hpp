@@ -43,9 +43,26 @@ enum DataType {
     TYPE_UINT16,
     TYPE_INT16,
     TYPE_UNORM_INT16, // Unsigned normalized 16 bit integer. A 16 bit int interpreted as a float between 0 and 1.
-    TYPE_SNORM_INT16 // Signed normalized 16 bit integer. A 16 bit int interpreted as a float between -1 and 1.
+    TYPE_SNORM_INT16, // Signed normalized 16 bit integer. A 16 bit int interpreted as a float between -1 and 1.
+    TYPE_INT32,
+    TYPE_FLOAT16 // Half precision floating point, stored as float16
 };
 
+/**
+ * @brief Half precision (16 bit) floating point value
+ *
+ * Only used for storage, such as tensor data of half precision neural networks.
+ * Convert to float to do arithmetic.
+ */
+#ifndef SWIG
+struct FAST_EXPORT float16 {
+    ushort bits;
+    float16() = default;
+    explicit float16(float value);
+    explicit operator float() const;
+};
+#endif
+
 enum PlaneType {PLANE_X, PLANE_Y, PLANE_Z};
 
 // Returns the C type for a DataType as a string
@@ -62,6 +79,16 @@ FAST_EXPORT std::string getCTypeAsString(DataType type);
         fastCaseTypeMacro(TYPE_SNORM_INT16, short, call) \
         fastCaseTypeMacro(TYPE_UNORM_INT16, ushort, call) \
 
+// Switch over the data types supported by Tensor
+#define fastSwitchTensorTypeMacro(call) \
+        fastCaseTypeMacro(TYPE_FLOAT, float, call) \
+        fastCaseTypeMacro(TYPE_FLOAT16, float16, call) \
+        fastCaseTypeMacro(TYPE_INT8, char, call) \
+        fastCaseTypeMacro(TYPE_UINT8, uchar, call) \
+        fastCaseTypeMacro(TYPE_INT16, short, call) \
+        fastCaseTypeMacro(TYPE_UINT16, ushort, call) \
+        fastCaseTypeMacro(TYPE_INT32, int, call) \
+
 FAST_EXPORT cl::ImageFormat getOpenCLImageFormat(OpenCLDevice::pointer, cl_mem_object_type imageType, DataType type, unsigned int channels);
 
 FAST_EXPORT size_t getSizeOfDataType(DataType type, unsigned int nrOfChannels);
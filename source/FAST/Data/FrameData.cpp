@@ -0,0 +1,233 @@
+#include "FrameData.hpp"
+#include <FAST/Exception.hpp>
+#include <algorithm>
+#include <atomic>
+#include <limits>
+#include <mutex>
+#include <shared_mutex>
+#include <sstream>
+#include <unordered_map>
+
+namespace fast {
+
+// Registry of interned frame data names
+static std::shared_mutex keyMutex;
+static std::unordered_map<std::string, uint32_t> keys;
+static std::vector<std::string> names;
+
+uint32_t FrameData::getKey(const std::string& name) {
+    {
+        std::shared_lock<std::shared_mutex> lock(keyMutex);
+        auto it = keys.find(name);
+        if(it != keys.end())
+            return it->second;
+    }
+    std::unique_lock<std::shared_mutex> lock(keyMutex);
+    auto it = keys.find(name);
+    if(it != keys.end()) // Another thread may have added it in the meantime
+        return it->second;
+    const uint32_t key = names.size();
+    names.push_back(name);
+    keys[name] = key;
+    return key;
+}
+
+bool FrameData::findKey(const std::string& name, uint32_t& key) {
+    std::shared_lock<std::shared_mutex> lock(keyMutex);
+    auto it = keys.find(name);
+    if(it == keys.end())
+        return false;
+    key = it->second;
+    return true;
+}
+
+std::string FrameData::getName(uint32_t key) {
+    std::shared_lock<std::shared_mutex> lock(keyMutex);
+    if(key >= names.size())
+        throw Exception("Unknown frame data key " + std::to_string(key));
+    return names[key];
+}
+
+std::string FrameData::toString(const Value& value) {
+    if(auto string = std::get_if<std::string>(&value)) {
+        return *string;
+    } else if(auto integer = std::get_if<int64_t>(&value)) {
+        return std::to_string(*integer);
+    } else if(auto floatingPoint = std::get_if<double>(&value)) {
+        // Values such as WSI pixel spacing are very small, so std::to_string can't be used as it rounds the numbers
+        std::ostringstream out;
+        out.precision(std::numeric_limits<double>::max_digits10);
+        out << *floatingPoint;
+        return out.str();
+    } else {
+        std::ostringstream out;
+        out.precision(std::numeric_limits<float>::max_digits10);
+        for(auto item : std::get<std::vector<float>>(value))
+            out << item << " ";
+        return out.str();
+    }
+}
+
+FrameData::Storage& FrameData::getWritableStorage() {
+    if(!m_storage) {
+        m_storage = std::make_shared<Storage>();
+    } else if(m_storage.use_count() > 1) {
+        // Storage is shared with other frame data objects, make a copy before writing
+        m_storage = std::make_shared<Storage>(*m_storage);
+    } else {
+        // Only this object refers to the storage. use_count() is a relaxed load, thus make sure any reads done by
+        // other objects before releasing the storage happen before it is modified here.
+        std::atomic_thread_fence(std::memory_order_acquire);
+    }
+    return *m_storage;
+}
+
+const FrameData::Value* FrameData::find(uint32_t key) const {
+    if(!m_storage)
+        return nullptr;
+    auto it = std::lower_bound(m_storage->begin(), m_storage->end(), key, [](const std::pair<uint32_t, Value>& item, uint32_t key) {
+        return item.first < key;
+    });
+    if(it == m_storage->end() || it->first != key)
+        return nullptr;
+    return &it->second;
+}
+
+void FrameData::set(uint32_t key, Value value) {
+    auto& storage = getWritableStorage();
+    auto it = std::lower_bound(storage.begin(), storage.end(), key, [](const std::pair<uint32_t, Value>& item, uint32_t key) {
+        return item.first < key;
+    });
+    if(it != storage.end() && it->first == key) {
+        it->second = std::move(value);
+    } else {
+        storage.insert(it, std::make_pair(key, std::move(value)));
+    }
+}
+
+void FrameData::set(const std::string& name, Value value) {
+    set(getKey(name), std::move(value));
+}
+
+bool FrameData::has(uint32_t key) const {
+    return find(key) != nullptr;
+}
+
+bool FrameData::has(const std::string& name) const {
+    // Names which have never been set are not interned
+    uint32_t key;
+    return findKey(name, key) && has(key);
+}
+
+const FrameData::Value& FrameData::get(uint32_t key) const {
+    auto value = find(key);
+    if(value == nullptr)
+        throw Exception("Frame data " + getName(key) + " does not exist.");
+    return *value;
+}
+
+const FrameData::Value& FrameData::get(const std::string& name) const {
+    uint32_t key;
+    if(!findKey(name, key))
+        throw Exception("Frame data " + name + " does not exist.");
+    return get(key);
+}
+
+std::string FrameData::getString(const std::string& name) const {
+    return toString(get(name));
+}
+
+int64_t FrameData::getInteger(uint32_t key) const {
+    const auto& value = get(key);
+    if(auto integer = std::get_if<int64_t>(&value)) {
+        return *integer;
+    } else if(auto floatingPoint = std::get_if<double>(&value)) {
+        return (int64_t)*floatingPoint;
+    } else if(auto string = std::get_if<std::string>(&value)) {
+        return std::stoll(*string);
+    }
+    throw Exception("Frame data " + getName(key) + " is not a number");
+}
+
+int64_t FrameData::getInteger(const std::string& name) const {
+    uint32_t key;
+    if(!findKey(name, key))
+        throw Exception("Frame data " + name + " does not exist.");
+    return getInteger(key);
+}
+
+double FrameData::getFloat(uint32_t key) const {
+    const auto& value = get(key);
+    if(auto floatingPoint = std::get_if<double>(&value)) {
+        return *floatingPoint;
+    } else if(auto integer = std::get_if<int64_t>(&value)) {
+        return (double)*integer;
+    } else if(auto string = std::get_if<std::string>(&value)) {
+        return std::stod(*string);
+    }
+    throw Exception("Frame data " + getName(key) + " is not a number");
+}
+
+double FrameData::getFloat(const std::string& name) const {
+    uint32_t key;
+    if(!findKey(name, key))
+        throw Exception("Frame data " + name + " does not exist.");
+    return getFloat(key);
+}
+
+std::vector<float> FrameData::getFloatList(const std::string& name) const {
+    const auto& value = get(name);
+    if(auto list = std::get_if<std::vector<float>>(&value))
+        return *list;
+    // Parse space separated list
+    std::vector<float> result;
+    std::istringstream in(toString(value));
+    float item;
+    while(in >> item)
+        result.push_back(item);
+    return result;
+}
+
+void FrameData::remove(const std::string& name) {
+    uint32_t key;
+    if(!findKey(name, key) || !has(key))
+        return;
+    auto& storage = getWritableStorage();
+    storage.erase(std::remove_if(storage.begin(), storage.end(), [key](const std::pair<uint32_t, Value>& item) {
+        return item.first == key;
+    }), storage.end());
+}
+
+void FrameData::merge(const FrameData& other) {
+    if(other.empty() || m_storage == other.m_storage)
+        return;
+    if(empty()) {
+        m_storage = other.m_storage;
+        return;
+    }
+    for(auto&& item : *other.m_storage)
+        set(item.first, item.second);
+}
+
+std::map<std::string, std::string> FrameData::toStringMap() const {
+    std::map<std::string, std::string> result;
+    if(m_storage) {
+        for(auto&& item : *m_storage)
+            result[getName(item.first)] = toString(item.second);
+    }
+    return result;
+}
+
+std::size_t FrameData::size() const {
+    return m_storage ? m_storage->size() : 0;
+}
+
+bool FrameData::empty() const {
+    return size() == 0;
+}
+
+void FrameData::clear() {
+    m_storage.reset();
+}
+
+}
@@ -0,0 +1,83 @@
+#pragma once
+
+#include <FAST/Object.hpp>
+#include <variant>
+#include <vector>
+#include <map>
+
+namespace fast {
+
+/**
+ * @brief Typed storage of frame data
+ *
+ * Frame data are name-value pairs which are transferred from input to output data objects in a pipeline.
+ * Values are stored with their type (string, integer, floating point or list of floats), so that
+ * they can be read without any parsing. Names are interned to integer keys, and the storage is shared
+ * between copies until one of them is modified (copy-on-write), which makes copying frame data cheap.
+ *
+ * A FrameData object has a single writer: it must not be read or copied by other threads while it is modified.
+ * Different objects sharing the same storage may be modified concurrently, as the storage is copied
+ * before it is modified if it is shared.
+ *
+ * @sa DataObject
+ */
+class FAST_EXPORT FrameData {
+    public:
+        typedef std::variant<std::string, int64_t, double, std::vector<float>> Value;
+        /**
+         * @brief Get interned key of a frame data name
+         *
+         * The key is the same for the lifetime of the process, so it can be stored and reused to avoid
+         * looking up the name for every access.
+         * @param name
+         * @return key
+         */
+        static uint32_t getKey(const std::string& name);
+        /**
+         * @brief Get frame data name of an interned key
+         */
+        static std::string getName(uint32_t key);
+        /**
+         * @brief Convert a frame data value to string
+         */
+        static std::string toString(const Value& value);
+
+        void set(const std::string& name, Value value);
+        void set(uint32_t key, Value value);
+        bool has(const std::string& name) const;
+        bool has(uint32_t key) const;
+        /**
+         * @brief Get value, throws exception if it doesn't exist
+         */
+        const Value& get(const std::string& name) const;
+        const Value& get(uint32_t key) const;
+        std::string getString(const std::string& name) const;
+        int64_t getInteger(const std::string& name) const;
+        int64_t getInteger(uint32_t key) const;
+        double getFloat(const std::string& name) const;
+        double getFloat(uint32_t key) const;
+        std::vector<float> getFloatList(const std::string& name) const;
+        void remove(const std::string& name);
+        /**
+         * @brief Copy all values from other into this, overwriting values with the same name.
+         * If this is empty, the storage of other is shared instead of copied.
+         */
+        void merge(const FrameData& other);
+        std::map<std::string, std::string> toStringMap() const;
+        std::size_t size() const;
+        bool empty() const;
+        void clear();
+    private:
+        // Sorted by key
+        typedef std::vector<std::pair<uint32_t, Value>> Storage;
+        std::shared_ptr<Storage> m_storage;
+
+        Storage& getWritableStorage();
+        /**
+         * Get key of a name without interning it, returns false if the name is unknown.
+         */
+        static bool findKey(const std::string& name, uint32_t& key);
+        const Value* find(uint32_t key) const;
+};
+
+}
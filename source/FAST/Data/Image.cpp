@@ -1,5 +1,6 @@
 #include "Image.hpp"
 #include "FAST/Data/Access/ImageAccess.hpp"
+#include "FAST/Data/MemoryPool.hpp"
 #include "FAST/Utility.hpp"
 #include "FAST/Exception.hpp"
 #include "FAST/Utility.hpp"
@@ -24,12 +25,10 @@
 namespace fast {
 
 unique_pixel_ptr allocatePixelArray(std::size_t size, DataType type) {
-    unique_pixel_ptr ptr;
-    switch(type) {
-        fastSwitchTypeMacro(ptr = make_unique_pixel<FAST_TYPE>(new FAST_TYPE[size]))
-    }
-
-    return ptr;
+    const std::size_t bytes = size*getSizeOfDataType(type, 1);
+    return unique_pixel_ptr(MemoryPool::getInstance()->allocate(bytes), [bytes](void* data) {
+        MemoryPool::getInstance()->deallocate(data, bytes);
+    });
 }
 
 // Pad data with 1, 2 or 3 channels to 4 channels with 0
@@ -66,8 +65,9 @@ const void * const adaptDataToImage(const void* const data, cl_channel_order ord
 
 // Remove padding from a data array created by padData
 template <class T>
-void * removePadding(T * data, unsigned int size, unsigned int nrOfChannels) {
-     T * newData = new T[size*nrOfChannels];
+unique_pixel_ptr removePadding(T * data, unsigned int size, unsigned int nrOfChannels, DataType type) {
+    auto newDataPtr = allocatePixelArray(size*nrOfChannels, type);
+    T * newData = (T*)newDataPtr.get();
     for(unsigned int i = 0; i < size; i++) {
     	if(nrOfChannels == 1) {
             newData[i] = data[i*4];
@@ -80,7 +80,7 @@ void * removePadding(T * data, unsigned int size, unsigned int nrOfChannels) {
             newData[i*3+2] = data[i*4+2];
     	}
     }
-    return (void *)newData;
+    return newDataPtr;
 }
 
 unique_pixel_ptr adaptImageDataToHostData(unique_pixel_ptr data, cl_channel_order order, unsigned int size, DataType type, unsigned int nrOfChannels) {
@@ -90,7 +90,7 @@ unique_pixel_ptr adaptImageDataToHostData(unique_pixel_ptr data, cl_channel_orde
     // This function removes that padding
     if(order == CL_RGBA && nrOfChannels != 4) {
         switch(type) {
-            fastSwitchTypeMacro(return unique_pixel_ptr(removePadding<FAST_TYPE>((FAST_TYPE*)data.get(), size, nrOfChannels), &pixel_deleter<FAST_TYPE>))
+            fastSwitchTypeMacro(return removePadding<FAST_TYPE>((FAST_TYPE*)data.get(), size, nrOfChannels, type))
         }
     }
 
@@ -153,14 +153,9 @@ void Image::updateOpenCLImageData(OpenCLDevice::pointer device) {
     bool updated = false;
     if (mCLImagesIsUpToDate.count(device) == 0) {
         // Data is not on device, create it
-        cl::Image * newImage;
-        if(mDimensions == 2) {
-            newImage = new cl::Image2D(device->getContext(),
-            CL_MEM_READ_WRITE, getOpenCLImageFormat(device, CL_MEM_OBJECT_IMAGE2D, mType,mChannels), mWidth, mHeight);
-        } else {
-            newImage = new cl::Image3D(device->getContext(),
-            CL_MEM_READ_WRITE, getOpenCLImageFormat(device, CL_MEM_OBJECT_IMAGE3D, mType,mChannels), mWidth, mHeight, mDepth);
-        }
+        cl::Image * newImage = MemoryPool::getInstance()->allocateImage(device, mDimensions,
+            getOpenCLImageFormat(device, mDimensions == 2 ? CL_MEM_OBJECT_IMAGE2D : CL_MEM_OBJECT_IMAGE3D, mType, mChannels),
+            mWidth, mHeight, mDepth);
 
         if(hasAnyData()) {
             mCLImagesIsUpToDate[device] = false;
@@ -262,8 +257,7 @@ void Image::updateOpenCLBufferData(OpenCLDevice::pointer device) {
     if (mCLBuffers.count(device) == 0) {
         // Data is not on device, create it
         unsigned int bufferSize = getBufferSize();
-        cl::Buffer * newBuffer = new cl::Buffer(device->getContext(),
-        CL_MEM_READ_WRITE, bufferSize);
+        cl::Buffer * newBuffer = MemoryPool::getInstance()->allocateBuffer(device, bufferSize);
 
         if(hasAnyData()) {
             mCLBuffersIsUpToDate[device] = false;
@@ -641,31 +635,11 @@ void Image::copyData(ExecutionDevice::pointer device, const void* const data) {
         mIsInitialized = true;
     } else {
         OpenCLDevice::pointer clDevice = std::static_pointer_cast<OpenCLDevice>(device);
-        cl::Image* clImage;
-        void* tempData;
-        if(mDimensions == 2) {
-            tempData = (void*)adaptDataToImage(data, getOpenCLImageFormat(clDevice, CL_MEM_OBJECT_IMAGE2D, mType,
-                                                                         mChannels).image_channel_order,
-                                              mWidth * mHeight, mType, mChannels);
-            clImage = new cl::Image2D(
-                    clDevice->getContext(),
-                    CL_MEM_READ_WRITE | CL_MEM_COPY_HOST_PTR,
-                    getOpenCLImageFormat(clDevice, CL_MEM_OBJECT_IMAGE2D, mType, mChannels),
-                    mWidth, mHeight,
-                    0,
-                    tempData
-            );
-        } else {
-            tempData = (void*)adaptDataToImage(data, getOpenCLImageFormat(clDevice, CL_MEM_OBJECT_IMAGE3D, mType, mChannels).image_channel_order, mWidth*mHeight*mDepth, mType, mChannels);
-            clImage = new cl::Image3D(
-                clDevice->getContext(),
-                CL_MEM_READ_WRITE | CL_MEM_COPY_HOST_PTR,
-                getOpenCLImageFormat(clDevice, CL_MEM_OBJECT_IMAGE3D, mType, mChannels),
-                mWidth, mHeight, mDepth,
-                0, 0,
-                tempData
-            );
-        }
+        const cl::ImageFormat format = getOpenCLImageFormat(clDevice, mDimensions == 2 ? CL_MEM_OBJECT_IMAGE2D : CL_MEM_OBJECT_IMAGE3D, mType, mChannels);
+        void* tempData = (void*)adaptDataToImage(data, format.image_channel_order, mWidth*mHeight*mDepth, mType, mChannels);
+        cl::Image* clImage = MemoryPool::getInstance()->allocateImage(clDevice, mDimensions, format, mWidth, mHeight, mDepth);
+        clDevice->getCommandQueue().enqueueWriteImage(*clImage, CL_TRUE, createOrigoRegion(),
+                createRegion(mWidth, mHeight, mDepth), 0, 0, tempData);
         mCLImages[clDevice] = clImage;
         mCLImagesIsUpToDate[clDevice] = true;
         if(tempData != data) // If a new copy was made, delete it
@@ -705,12 +679,15 @@ void Image::free(ExecutionDevice::pointer device) {
         mHostHasData = false;
     } else {
         OpenCLDevice::pointer clDevice = std::static_pointer_cast<OpenCLDevice>(device);
-        // Delete any OpenCL images
-        delete mCLImages[clDevice];
+        // Give any OpenCL images and buffers back to the memory pool
+        auto image = mCLImages.find(clDevice);
+        if(image != mCLImages.end())
+            MemoryPool::getInstance()->deallocateImage(clDevice, image->second);
         mCLImages.erase(clDevice);
         mCLImagesIsUpToDate.erase(clDevice);
-        // Delete any OpenCL buffers
-        delete mCLBuffers[clDevice];
+        auto buffer = mCLBuffers.find(clDevice);
+        if(buffer != mCLBuffers.end())
+            MemoryPool::getInstance()->deallocateBuffer(clDevice, buffer->second);
         mCLBuffers.erase(clDevice);
         mCLBuffersIsUpToDate.erase(clDevice);
     }
@@ -720,7 +697,7 @@ void Image::freeAll() {
     // Delete OpenCL Images
     std::unordered_map<OpenCLDevice::pointer, cl::Image*>::iterator it;
     for (it = mCLImages.begin(); it != mCLImages.end(); it++) {
-        delete it->second;
+        MemoryPool::getInstance()->deallocateImage(it->first, it->second);
     }
     mCLImages.clear();
     mCLImagesIsUpToDate.clear();
@@ -728,7 +705,7 @@ void Image::freeAll() {
     // Delete OpenCL buffers
     std::unordered_map<OpenCLDevice::pointer, cl::Buffer*>::iterator it2;
     for (it2 = mCLBuffers.begin(); it2 != mCLBuffers.end(); it2++) {
-        delete it2->second;
+        MemoryPool::getInstance()->deallocateBuffer(it2->first, it2->second);
     }
     mCLBuffers.clear();
     mCLBuffersIsUpToDate.clear();
@@ -803,34 +780,94 @@ void fast::Image::setSpacing(float x, float y, float z) {
 	setSpacing(Vector3f(x, y, z));
 }
 
+// Intensity statistics which are calculated together in one pass over the pixel data
+struct IntensityStatistics {
+    float min = std::numeric_limits<float>::max();
+    float max = std::numeric_limits<float>::lowest();
+    double sum = 0.0;
+    double sumOfSquares = 0.0;
+};
+
+// Integer sums are accumulated exactly in 64 bit integers, which also lets the compiler vectorize the loops
+template <class T>
+using IntensitySumType = typename std::conditional<std::is_integral<T>::value, int64_t, double>::type;
+
+/**
+ * Calculate min and max of all channels, and sum and sum of squares of the first channel.
+ * The data is split into blocks which are reduced in parallel. Each block is small enough to stay in cache,
+ * so the pixel data is only read once from memory.
+ */
+template <class T>
+static IntensityStatistics calculateIntensityStatistics(const T* data, int64_t nrOfVoxels, int nrOfChannels) {
+    IntensityStatistics result;
+    const int64_t blockSize = 16384;
+    const int64_t nrOfBlocks = (nrOfVoxels + blockSize - 1) / blockSize;
+    #pragma omp parallel
+    {
+        T min = std::numeric_limits<T>::max();
+        T max = std::numeric_limits<T>::lowest();
+        IntensitySumType<T> sum = 0;
+        IntensitySumType<T> sumOfSquares = 0;
+        #pragma omp for
+        for(int64_t block = 0; block < nrOfBlocks; ++block) {
+            const int64_t start = block*blockSize;
+            const int64_t end = std::min(start + blockSize, nrOfVoxels);
+            const T* blockData = data + start*nrOfChannels;
+            const int64_t nrOfElements = (end - start)*nrOfChannels;
+            for(int64_t i = 0; i < nrOfElements; ++i) {
+                min = std::min(min, blockData[i]);
+                max = std::max(max, blockData[i]);
+            }
+            for(int64_t i = 0; i < nrOfElements; i += nrOfChannels) {
+                const IntensitySumType<T> value = blockData[i];
+                sum += value;
+                sumOfSquares += value*value;
+            }
+        }
+        #pragma omp critical
+        {
+            result.min = std::min(result.min, (float)min);
+            result.max = std::max(result.max, (float)max);
+            result.sum += (double)sum;
+            result.sumOfSquares += (double)sumOfSquares;
+        }
+    }
+    return result;
+}
+
+void Image::calculateIntensityStatisticsOnHost() {
+    IntensityStatistics statistics;
+    {
+        auto access = getImageAccess(ACCESS_READ);
+        switch(mType) {
+            fastSwitchTypeMacro(statistics = calculateIntensityStatistics<FAST_TYPE>((const FAST_TYPE*)access->get(), getNrOfVoxels(), mChannels))
+        }
+    }
+    const double nrOfVoxels = getNrOfVoxels();
+    const double average = statistics.sum / nrOfVoxels;
+    mMinimumIntensity = statistics.min;
+    mMaximumIntensity = statistics.max;
+    mSumIntensity = (float)statistics.sum;
+    mStdDevIntensity = (float)std::sqrt(std::max(statistics.sumOfSquares / nrOfVoxels - average*average, 0.0));
+
+    // All statistics are now up to date
+    mMaxMinTimestamp = getTimestamp();
+    mSumIntensityTimestamp = getTimestamp();
+    mStdDevIntensityTimestamp = getTimestamp();
+    mMaxMinInitialized = true;
+    mSumInitialized = true;
+    mStdDevInitialized = true;
+}
+
 void Image::calculateMaxAndMinIntensity() {
     // Calculate max and min if image has changed or it is the first time
     if(!mMaxMinInitialized || mMaxMinTimestamp != getTimestamp()) {
 
         unsigned int nrOfElements = mWidth*mHeight*mDepth*mChannels;
         if(mHostHasData && mHostDataIsUpToDate) {
-            // Host data is up to date, calculate min and max on host
-            ImageAccess::pointer access = getImageAccess(ACCESS_READ);
-            void* data = access->get();
-            switch(mType) {
-            case TYPE_FLOAT:
-            case TYPE_SNORM_INT16:
-            case TYPE_UNORM_INT16:
-                getMaxAndMinFromData<float>(data,nrOfElements,&mMinimumIntensity,&mMaximumIntensity);
-                break;
-            case TYPE_INT8:
-                getMaxAndMinFromData<char>(data,nrOfElements,&mMinimumIntensity,&mMaximumIntensity);
-                break;
-            case TYPE_UINT8:
-                getMaxAndMinFromData<uchar>(data,nrOfElements,&mMinimumIntensity,&mMaximumIntensity);
-                break;
-            case TYPE_INT16:
-                getMaxAndMinFromData<short>(data,nrOfElements,&mMinimumIntensity,&mMaximumIntensity);
-                break;
-            case TYPE_UINT16:
-                getMaxAndMinFromData<ushort>(data,nrOfElements,&mMinimumIntensity,&mMaximumIntensity);
-                break;
-            }
+            // Host data is up to date, calculate all statistics on host in one pass
+            calculateIntensityStatisticsOnHost();
+            return;
         } else {
             // TODO the logic here can be improved. For instance choose the best device
             // Find some OpenCL image data or buffer data that is up to date
@@ -887,28 +924,10 @@ float Image::calculateSumIntensity() {
 
     // Calculate sum if image has changed or it is the first time
     if(!mSumInitialized || mSumIntensityTimestamp != getTimestamp()) {
-        unsigned int nrOfElements = mWidth*mHeight*mDepth;
         if((mHostHasData && mHostDataIsUpToDate) || getNrOfVoxels() < 256) {
-            // Host data is up to date, or image is very small, calculate min and max on host
-            ImageAccess::pointer access = getImageAccess(ACCESS_READ);
-            void* data = access->get();
-            switch(mType) {
-                case TYPE_FLOAT:
-                    mSumIntensity = getSumFromData<float>(data,nrOfElements);
-                    break;
-                case TYPE_INT8:
-                    mSumIntensity = getSumFromData<char>(data,nrOfElements);
-                    break;
-                case TYPE_UINT8:
-                    mSumIntensity = getSumFromData<uchar>(data,nrOfElements);
-                    break;
-                case TYPE_INT16:
-                    mSumIntensity = getSumFromData<short>(data,nrOfElements);
-                    break;
-                case TYPE_UINT16:
-                    mSumIntensity = getSumFromData<ushort>(data,nrOfElements);
-                    break;
-            }
+            // Host data is up to date, or image is very small, calculate all statistics on host in one pass
+            calculateIntensityStatisticsOnHost();
+            return mSumIntensity;
         } else {
             // TODO the logic here can be improved. For instance choose the best device
             // Find some OpenCL image data or buffer data that is up to date
@@ -963,33 +982,14 @@ float Image::calculateStandardDeviationIntensity() {
     if(!isInitialized())
         throw Exception("Image has not been initialized.");
 
-    float average = calculateAverageIntensity();
-
-    // Calculate sum if image has changed or it is the first time
+    // Calculate standard deviation if image has changed or it is the first time
     if(!mStdDevInitialized || mStdDevIntensityTimestamp != getTimestamp()) {
-        unsigned int nrOfElements = mWidth*mHeight*mDepth;
         if((mHostHasData && mHostDataIsUpToDate) || getNrOfVoxels() < 256) {
-            // Host data is up to date, or image is very small, calculate min and max on host
-            auto access = getImageAccess(ACCESS_READ);
-            void* data = access->get();
-            switch(mType) {
-                case TYPE_FLOAT:
-                    mStdDevIntensity = getStandardDeviationFromData<float>(data,nrOfElements);
-                    break;
-                case TYPE_INT8:
-                    mStdDevIntensity = getStandardDeviationFromData<char>(data,nrOfElements);
-                    break;
-                case TYPE_UINT8:
-                    mStdDevIntensity = getStandardDeviationFromData<uchar>(data,nrOfElements);
-                    break;
-                case TYPE_INT16:
-                    mStdDevIntensity = getStandardDeviationFromData<short>(data,nrOfElements);
-                    break;
-                case TYPE_UINT16:
-                    mStdDevIntensity = getStandardDeviationFromData<ushort>(data,nrOfElements);
-                    break;
-            }
+            // Host data is up to date, or image is very small, calculate all statistics on host in one pass
+            calculateIntensityStatisticsOnHost();
+            return mStdDevIntensity;
         } else {
+            const float average = calculateAverageIntensity();
             // TODO the logic here can be improved. For instance choose the best device
             // Find some OpenCL image data or buffer data that is up to date
             bool found = false;
@@ -1162,24 +1162,11 @@ void Image::fill(float value) {
     } catch(...) {
     	// Has no data
     	// Create an OpenCL image
-    	cl::Image* clImage;
         OpenCLDevice::pointer clDevice = std::dynamic_pointer_cast<OpenCLDevice>(
                 DeviceManager::getInstance()->getDefaultDevice());
-    	if(getDimensions() == 2) {
-			clImage = new cl::Image2D(
-				clDevice->getContext(),
-				CL_MEM_READ_WRITE,
-				getOpenCLImageFormat(clDevice, CL_MEM_OBJECT_IMAGE2D, mType, mChannels),
-				mWidth, mHeight
-			);
-    	} else {
-			clImage = new cl::Image3D(
-				clDevice->getContext(),
-				CL_MEM_READ_WRITE,
-				getOpenCLImageFormat(clDevice, CL_MEM_OBJECT_IMAGE3D, mType, mChannels),
-				mWidth, mHeight, mDepth
-			);
-    	}
+        cl::Image* clImage = MemoryPool::getInstance()->allocateImage(clDevice, getDimensions(),
+                getOpenCLImageFormat(clDevice, getDimensions() == 2 ? CL_MEM_OBJECT_IMAGE2D : CL_MEM_OBJECT_IMAGE3D, mType, mChannels),
+                mWidth, mHeight, mDepth);
 		mCLImages[clDevice] = clImage;
 		mCLImagesIsUpToDate[clDevice] = true;
 		device = clDevice;
@@ -27,6 +27,12 @@ template<typename T>
 auto make_unique_pixel(T * ptr) -> unique_pixel_ptr {
     return unique_pixel_ptr(ptr, &pixel_deleter<T>);
 }
+/**
+ * Allocate an uninitialized pixel array from the MemoryPool.
+ * The deleter of the returned pointer gives the memory back to the pool.
+ * @param size Number of elements
+ * @param type
+ */
 unique_pixel_ptr allocatePixelArray(std::size_t size, DataType type);
 #endif
 
@@ -361,6 +367,7 @@ class FAST_EXPORT Image : public SpatialDataObject {
         unsigned long mMaxMinTimestamp, mSumIntensityTimestamp, mStdDevIntensityTimestamp;
         bool mMaxMinInitialized = false, mSumInitialized = false, mStdDevInitialized = false;
         void calculateMaxAndMinIntensity();
+        void calculateIntensityStatisticsOnHost();
 
         // Declare as friends so they can get access to the accessFinished methods
         friend class ImageAccess;
@@ -9,8 +9,10 @@
 #include <FAST/Data/Image.hpp>
 #include <FAST/Data/Access/ImagePyramidAccess.hpp>
 #include <utility>
+#include <thread>
 #ifdef WIN32
 #include <winbase.h>
+#include <winioctl.h>
 #else
 #include <sys/mman.h>
 #include <fcntl.h>
@@ -19,13 +21,19 @@
 #include <sys/types.h>
 #include <sys/stat.h>
 #include <unistd.h>
+#include <cerrno>
 #endif
 
 namespace fast {
 
 int ImagePyramid::m_counter = 0;
 
-ImagePyramid::ImagePyramid(int width, int height, int channels, int patchWidth, int patchHeight) {
+// Size in bytes of a level stored as uncompressed tiles
+static std::size_t getTiledLevelSize(const ImagePyramidLevel& level, int channels) {
+    return (std::size_t)level.tilesX*level.tilesY*level.tileWidth*level.tileHeight*channels;
+}
+
+ImagePyramid::ImagePyramid(int width, int height, int channels, int patchWidth, int patchHeight, std::string filename, ImageCompression compression, std::string directory) : ImagePyramid() {
     if(channels <= 0 || channels > 4)
         throw Exception("Nr of channels must be between 1 and 4");
 
@@ -34,36 +42,49 @@ ImagePyramid::ImagePyramid(int width, int height, int channels, int patchWidth,
     int currentWidth = width;
     int currentHeight = height;
     m_channels = channels;
-    m_tempFile = true;
-
-    std::cout << "Creating tiff path.." << std::endl;
-    do {
-        std::string randomString = generateRandomString(32);
-        std::cout << "random string: " << randomString << std::endl;
+    m_writable = true;
+    if(directory.empty()) {
 #ifdef WIN32
-        m_tiffPath = "C:/windows/temp/fast_image_pyramid_" + randomString + ".tiff";
+        directory = "C:/windows/temp";
 #else
-        m_tiffPath = "/tmp/fast_image_pyramid_" + randomString + ".tiff";
+        directory = "/tmp";
 #endif
-        std::cout << "TIFF path: " << m_tiffPath << std::endl;
-    } while(fileExists(m_tiffPath));
-
-    TIFFSetErrorHandler([](const char* module, const char* fmt, va_list ap) {
-        auto str = make_uninitialized_unique<char[]>(512);
-        sprintf(str.get(), fmt, ap);
-        Reporter::warning() << "TIFF: " << module << ": " << str.get() << Reporter::end();
-    });
-    TIFFSetWarningHandler([](const char* module, const char* fmt, va_list ap) {
-        auto str = make_uninitialized_unique<char[]>(512);
-        sprintf(str.get(), fmt, ap);
-        Reporter::warning() << "TIFF: " << module << ": " << str.get() << Reporter::end();
-    });
-    m_tiffHandle = TIFFOpen(m_tiffPath.c_str(), "w8");
-    auto tiff = m_tiffHandle;
+    }
+    // Intermediate pyramids are stored uncompressed in memory mapped files, unless a file or compression is requested
+    const bool memoryMapped = filename.empty() && (compression == ImageCompression::UNSPECIFIED || compression == ImageCompression::RAW);
+    if(compression == ImageCompression::UNSPECIFIED)
+        compression = ImageCompression::LZW;
+
+    TIFF* tiff = nullptr;
+    if(!memoryMapped) {
+        if(!filename.empty()) {
+            // Stored permanently at the given path
+            m_tiffPath = filename;
+        } else {
+            m_tempFile = true;
+            do {
+                m_tiffPath = join(directory, "fast_image_pyramid_" + generateRandomString(32) + ".tiff");
+            } while(fileExists(m_tiffPath));
+        }
+        reportInfo() << "TIFF path: " << m_tiffPath << reportEnd();
+
+        TIFFSetErrorHandler([](const char* module, const char* fmt, va_list ap) {
+            auto str = make_uninitialized_unique<char[]>(512);
+            sprintf(str.get(), fmt, ap);
+            Reporter::warning() << "TIFF: " << module << ": " << str.get() << Reporter::end();
+        });
+        TIFFSetWarningHandler([](const char* module, const char* fmt, va_list ap) {
+            auto str = make_uninitialized_unique<char[]>(512);
+            sprintf(str.get(), fmt, ap);
+            Reporter::warning() << "TIFF: " << module << ": " << str.get() << Reporter::end();
+        });
+        m_tiffHandle = TIFFOpen(m_tiffPath.c_str(), "w8");
+        if(m_tiffHandle == nullptr)
+            throw Exception("Unable to create TIFF image pyramid file " + m_tiffPath);
+        tiff = m_tiffHandle;
+    }
     m_counter += 1;
 
-    ImageCompression compression = ImageCompression::LZW;
-
     uint photometric = PHOTOMETRIC_RGB;
     uint bitsPerSample = 8;
     uint samplesPerPixel = 3; // RGBA image pyramid is converted to RGB with getPatchAsImage
@@ -95,6 +116,13 @@ ImagePyramid::ImagePyramid(int width, int height, int channels, int patchWidth,
         levelData.tilesX = std::ceil((float)levelData.width / levelData.tileWidth);
         levelData.tilesY = std::ceil((float)levelData.height / levelData.tileHeight);
 
+        if(memoryMapped) {
+            createMemoryMappedLevel(levelData, directory);
+            m_levels.push_back(levelData);
+            ++currentLevel;
+            continue;
+        }
+
         // Write base tags
         TIFFSetField(tiff, TIFFTAG_PHOTOMETRIC, photometric);
         TIFFSetField(tiff, TIFFTAG_BITSPERSAMPLE, bitsPerSample);
@@ -156,7 +184,58 @@ ImagePyramid::ImagePyramid(int width, int height, int channels, int patchWidth,
 	m_counter += 1;
 }
 
-ImagePyramid::ImagePyramid(openslide_t *fileHandle, std::vector<ImagePyramidLevel> levels) {
+void ImagePyramid::createMemoryMappedLevel(ImagePyramidLevel& level, std::string directory) {
+    // The file is sparse, thus tiles which are never written don't use any disk space or memory
+    const std::size_t bytes = getTiledLevelSize(level, m_channels);
+    std::string path;
+#ifdef WIN32
+    HANDLE file;
+    do {
+        path = join(directory, "fast_image_pyramid_" + generateRandomString(32) + ".raw");
+        file = CreateFileA(path.c_str(), GENERIC_READ | GENERIC_WRITE, 0, NULL, CREATE_NEW, FILE_ATTRIBUTE_TEMPORARY | FILE_FLAG_DELETE_ON_CLOSE, NULL);
+    } while(file == INVALID_HANDLE_VALUE && GetLastError() == ERROR_FILE_EXISTS);
+    if(file == INVALID_HANDLE_VALUE)
+        throw Exception("Unable to create memory mapped image pyramid file in " + directory);
+    DWORD bytesReturned;
+    DeviceIoControl(file, FSCTL_SET_SPARSE, NULL, 0, NULL, 0, &bytesReturned, NULL);
+    HANDLE mapping = CreateFileMappingA(file, NULL, PAGE_READWRITE, (DWORD)(bytes >> 32), (DWORD)(bytes & 0xFFFFFFFF), NULL);
+    // The mapping keeps the file open, and it is deleted when the mapping is closed
+    CloseHandle(file);
+    if(mapping == NULL)
+        throw Exception("Unable to memory map image pyramid file " + path);
+    void* data = MapViewOfFile(mapping, FILE_MAP_ALL_ACCESS, 0, 0, bytes);
+    if(data == NULL) {
+        CloseHandle(mapping);
+        throw Exception("Unable to memory map image pyramid file " + path);
+    }
+    level.fileHandle = mapping;
+#else
+    int file;
+    do {
+        path = join(directory, "fast_image_pyramid_" + generateRandomString(32) + ".raw");
+        file = open(path.c_str(), O_RDWR | O_CREAT | O_EXCL, S_IRUSR | S_IWUSR);
+    } while(file < 0 && errno == EEXIST);
+    if(file < 0)
+        throw Exception("Unable to create memory mapped image pyramid file in " + directory);
+    // Remove the file name right away, the file is deleted when it is closed
+    unlink(path.c_str());
+    if(ftruncate(file, bytes) != 0) {
+        close(file);
+        throw Exception("Unable to allocate memory mapped image pyramid file " + path);
+    }
+    void* data = mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_SHARED, file, 0);
+    if(data == MAP_FAILED) {
+        close(file);
+        throw Exception("Unable to memory map image pyramid file " + path);
+    }
+    level.fileHandle = file;
+#endif
+    level.data = (uint8_t*)data;
+    level.memoryMapped = true;
+    reportInfo() << "Memory mapped image pyramid level of " << bytes / (1024*1024) << " MB at " << path << reportEnd();
+}
+
+ImagePyramid::ImagePyramid(openslide_t *fileHandle, std::vector<ImagePyramidLevel> levels) : ImagePyramid() {
     m_fileHandle = fileHandle;
     m_levels = std::move(levels);
     m_channels = 4;
@@ -169,8 +248,16 @@ ImagePyramid::ImagePyramid(openslide_t *fileHandle, std::vector<ImagePyramidLeve
     m_pyramidFullyInitialized = true;
 	m_counter += 1;
 }
-ImagePyramid::ImagePyramid(std::ifstream* stream, std::vector<vsi_tile_header> tileHeaders, std::vector<ImagePyramidLevel> levels, ImageCompression compressionFormat) {
+ImagePyramid::ImagePyramid(std::ifstream* stream, std::vector<vsi_tile_header> tileHeaders, std::vector<ImagePyramidLevel> levels, ImageCompression compressionFormat, std::string filename) : ImagePyramid() {
     m_vsiFileHandle = stream;
+#ifndef WIN32
+    if(!filename.empty()) {
+        // Open a raw file descriptor as well, which allows reading tiles with pread without any locking
+        m_vsiFileDescriptor = open(filename.c_str(), O_RDONLY);
+        if(m_vsiFileDescriptor < 0)
+            reportWarning() << "Unable to open " << filename << " for positional reads, falling back to locked stream reads" << reportEnd();
+    }
+#endif
     m_levels = std::move(levels);
     m_vsiTiles = std::move(tileHeaders);
     m_channels = 3;
@@ -183,6 +270,7 @@ ImagePyramid::ImagePyramid(std::ifstream* stream, std::vector<vsi_tile_header> t
 ImagePyramid::ImagePyramid() {
     m_initialized = false;
     m_pyramidFullyInitialized = false;
+    m_maxTIFFReadHandles = std::max(1, (int)std::thread::hardware_concurrency());
 }
 
 ImagePyramidLevel ImagePyramid::getLevelInfo(int level) {
@@ -241,6 +329,14 @@ void ImagePyramid::freeAll() {
         openslide_close(m_fileHandle);
     } else if(m_tiffHandle != nullptr) {
         m_levels.clear();
+        m_tileCache.clear();
+        {
+            std::lock_guard<std::mutex> lock(m_tiffReadHandleMutex);
+            for(auto&& readHandle : m_freeTIFFReadHandles)
+                TIFFClose(readHandle.handle);
+            m_freeTIFFReadHandles.clear();
+            m_openTIFFReadHandles = 0;
+        }
         TIFFClose(m_tiffHandle);
         if(m_tempFile) {
             // If this is a temp file created by FAST. Delete it.
@@ -249,6 +345,13 @@ void ImagePyramid::freeAll() {
     } else if(!m_vsiTiles.empty()) {
         m_vsiFileHandle->close();
         delete m_vsiFileHandle;
+#ifndef WIN32
+        if(m_vsiFileDescriptor >= 0)
+            close(m_vsiFileDescriptor);
+#endif
+        m_vsiFileDescriptor = -1;
+        m_vsiTiles.clear();
+        m_tileCache.clear();
     } else {
 		for(auto& item : m_levels) {
 			if(item.memoryMapped) {
@@ -256,7 +359,7 @@ void ImagePyramid::freeAll() {
 				UnmapViewOfFile(item.data);
 				CloseHandle(item.fileHandle);
 #else
-				munmap(item.data, item.width*item.height*m_channels);
+				munmap(item.data, getTiledLevelSize(item, m_channels));
 				close(item.fileHandle);
 #endif
 			} else {
@@ -268,6 +371,7 @@ void ImagePyramid::freeAll() {
 
 	m_initialized = false;
 	m_fileHandle = nullptr;
+	m_tiffHandle = nullptr;
 }
 
 ImagePyramid::~ImagePyramid() {
@@ -298,7 +402,7 @@ ImagePyramidAccess::pointer ImagePyramid::getAccess(accessType type) {
         std::unique_lock<std::mutex> lock(mDataIsBeingAccessedMutex);
         mDataIsBeingAccessed = true;
     }
-    return std::make_unique<ImagePyramidAccess>(m_levels, m_fileHandle, m_tiffHandle, m_vsiFileHandle, m_vsiTiles, std::static_pointer_cast<ImagePyramid>(mPtr.lock()), type == ACCESS_READ_WRITE, m_initializedPatchList, m_readMutex, m_compressionFormat);
+    return std::make_unique<ImagePyramidAccess>(m_levels, m_fileHandle, m_tiffHandle, m_vsiFileHandle, m_vsiTiles, std::static_pointer_cast<ImagePyramid>(mPtr.lock()), type == ACCESS_READ_WRITE, m_initializedPatchList, m_readMutex, m_compressionFormat, m_vsiFileDescriptor);
 }
 
 void ImagePyramid::setDirtyPatch(int level, int patchIdX, int patchIdY) {
@@ -349,11 +453,12 @@ Vector3f ImagePyramid::getSpacing() const {
 	return m_spacing;
 }
 
-ImagePyramid::ImagePyramid(TIFF *fileHandle, std::vector<ImagePyramidLevel> levels, int channels, bool isOMETIFF) {
+ImagePyramid::ImagePyramid(TIFF *fileHandle, std::vector<ImagePyramidLevel> levels, int channels, bool isOMETIFF) : ImagePyramid() {
     m_isOMETIFF = isOMETIFF;
     if(channels <= 0 || channels > 4)
         throw Exception("Nr of channels must be between 1 and 4 in ImagePyramid when importing from TIFF");
     m_tiffHandle = fileHandle;
+    m_tiffPath = TIFFFileName(fileHandle);
     m_levels = levels;
     m_channels = channels;
     for(int i = 0; i < m_levels.size(); ++i) {
@@ -391,6 +496,10 @@ std::string ImagePyramid::getTIFFPath() const {
     return m_tiffPath;
 }
 
+bool ImagePyramid::usesMemoryMapping() const {
+    return !m_levels.empty() && m_levels[0].memoryMapped;
+}
+
 bool ImagePyramid::usesOpenSlide() const {
     return m_fileHandle != nullptr;
 }
@@ -465,4 +574,59 @@ bool ImagePyramid::isOMETIFF() const {
     return m_isOMETIFF;
 }
 
+void ImagePyramid::setMaximumNumberOfReadHandles(int handles) {
+    if(handles < 0)
+        throw Exception("Maximum number of read handles must be >= 0");
+    std::lock_guard<std::mutex> lock(m_tiffReadHandleMutex);
+    m_maxTIFFReadHandles = handles;
+}
+
+int ImagePyramid::getMaximumNumberOfReadHandles() const {
+    return m_maxTIFFReadHandles;
+}
+
+ImagePyramidTileCache& ImagePyramid::getTileCache() {
+    return m_tileCache;
+}
+
+bool ImagePyramid::usesTIFFReadHandles() const {
+    // Pyramids created by FAST are written to through the main handle, thus other handles would see stale data.
+    return m_tiffHandle != nullptr && !m_writable && !m_tiffPath.empty() && m_maxTIFFReadHandles > 0;
+}
+
+ImagePyramid::TIFFReadHandle ImagePyramid::acquireTIFFReadHandle() {
+    std::unique_lock<std::mutex> lock(m_tiffReadHandleMutex);
+    while(m_freeTIFFReadHandles.empty() && m_openTIFFReadHandles >= m_maxTIFFReadHandles)
+        m_tiffReadHandleCondition.wait(lock);
+
+    if(!m_freeTIFFReadHandles.empty()) {
+        auto readHandle = m_freeTIFFReadHandles.back();
+        m_freeTIFFReadHandles.pop_back();
+        return readHandle;
+    }
+
+    // No free handles, open a new one
+    TIFFReadHandle readHandle;
+    readHandle.handle = TIFFOpen(m_tiffPath.c_str(), "rm");
+    if(readHandle.handle == nullptr)
+        throw Exception("Failed to open TIFF read handle for " + m_tiffPath);
+    ++m_openTIFFReadHandles;
+    reportInfo() << "Opened TIFF read handle " << m_openTIFFReadHandles << " for " << m_tiffPath << reportEnd();
+    return readHandle;
+}
+
+void ImagePyramid::releaseTIFFReadHandle(TIFFReadHandle readHandle) {
+    {
+        std::lock_guard<std::mutex> lock(m_tiffReadHandleMutex);
+        if(m_openTIFFReadHandles > m_maxTIFFReadHandles) {
+            // Limit was lowered while this handle was in use
+            TIFFClose(readHandle.handle);
+            --m_openTIFFReadHandles;
+        } else {
+            m_freeTIFFReadHandles.push_back(readHandle);
+        }
+    }
+    m_tiffReadHandleCondition.notify_one();
+}
+
 }
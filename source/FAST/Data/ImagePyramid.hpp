@@ -3,7 +3,9 @@
 #include <FAST/Data/SpatialDataObject.hpp>
 #include <FAST/Data/Access/Access.hpp>
 #include <FAST/Data/Access/ImagePyramidAccess.hpp>
+#include <FAST/Data/ImagePyramidTileCache.hpp>
 #include <set>
+#include <condition_variable>
 
 
 namespace fast {
@@ -22,9 +24,33 @@ class Image;
 class FAST_EXPORT ImagePyramid : public SpatialDataObject {
     FAST_DATA_OBJECT(ImagePyramid)
     public:
-        FAST_CONSTRUCTOR(ImagePyramid, int, width,, int, height,, int, channels,, int, patchWidth, = 256, int, patchHeight, = 256);
+        /**
+         * @brief Create a new TIFF backed image pyramid which can be written to
+         * @param width Width of full resolution level
+         * @param height Height of full resolution level
+         * @param channels Nr of channels, 1-4
+         * @param patchWidth Tile width
+         * @param patchHeight Tile height
+         * @param filename Path of the TIFF file to write the pyramid to. Tiles are written to this file as they are set, and the
+         *      file is kept after the pyramid is freed. If empty, a temporary file is used, which is deleted when the pyramid is freed.
+         * @param compression Compression of tiles. If no filename is given and compression is unspecified or RAW, tiles are
+         *      stored uncompressed in sparse memory mapped files, which is much faster for intermediate pyramids. Otherwise a
+         *      TIFF file with this compression is used, which is LZW if unspecified.
+         * @param directory Directory of temporary files. Default is the temp directory of the system.
+         * @return instance
+         */
+        FAST_CONSTRUCTOR(ImagePyramid,
+                         int, width,,
+                         int, height,,
+                         int, channels,,
+                         int, patchWidth, = 256,
+                         int, patchHeight, = 256,
+                         std::string, filename, = "",
+                         ImageCompression, compression, = ImageCompression::UNSPECIFIED,
+                         std::string, directory, = ""
+        );
         FAST_CONSTRUCTOR(ImagePyramid, openslide_t*, fileHandle,, std::vector<ImagePyramidLevel>, levels,);
-        FAST_CONSTRUCTOR(ImagePyramid, std::ifstream*, stream,, std::vector<vsi_tile_header>, tileHeaders,, std::vector<ImagePyramidLevel>, levels,, ImageCompression, compressionFormat,);
+        FAST_CONSTRUCTOR(ImagePyramid, std::ifstream*, stream,, std::vector<vsi_tile_header>, tileHeaders,, std::vector<ImagePyramidLevel>, levels,, ImageCompression, compressionFormat,, std::string, filename, = "");
         FAST_CONSTRUCTOR(ImagePyramid, TIFF*, fileHandle,, std::vector<ImagePyramidLevel>, levels,, int, channels,,bool, isOMETIFF, = false);
         int getNrOfLevels();
         int getLevelWidth(int level);
@@ -52,6 +78,10 @@ class FAST_EXPORT ImagePyramid : public SpatialDataObject {
          */
         bool isPyramidFullyInitialized() const;
         bool usesOpenSlide() const;
+        /**
+         * Whether tiles are stored uncompressed in memory mapped files
+         */
+        bool usesMemoryMapping() const;
         std::string getTIFFPath() const;
         void setSpacing(Vector3f spacing);
         Vector3f getSpacing() const;
@@ -59,6 +89,25 @@ class FAST_EXPORT ImagePyramid : public SpatialDataObject {
         std::unordered_set<std::string> getDirtyPatches();
         bool isDirtyPatch(const std::string& tileID);
         bool isOMETIFF() const;
+        /**
+         * @brief Set maximum number of file handles used for concurrent reading of TIFF backed pyramids.
+         *
+         * Read-only TIFF pyramids open one extra file handle per concurrent reader, up to this limit,
+         * so that readers don't have to share a single handle and lock. Default is the number of hardware threads.
+         * Set to 0 to always read through the single shared handle.
+         * @param handles
+         */
+        void setMaximumNumberOfReadHandles(int handles);
+        int getMaximumNumberOfReadHandles() const;
+        /**
+         * @brief Get cache of decoded tiles
+         *
+         * Decoded TIFF and VSI tiles are stored in a LRU cache shared by all consumers of this pyramid,
+         * so that overlapping patches and repeated views don't decode the same tile multiple times.
+         * Use this to change the size of the cache, or get hit/miss/eviction statistics.
+         * @return tile cache
+         */
+        ImagePyramidTileCache& getTileCache();
         void setDirtyPatch(int level, int patchIdX, int patchIdY);
         void clearDirtyPatches(std::set<std::string> patches);
         void free(ExecutionDevice::pointer device) override;
@@ -68,13 +117,16 @@ class FAST_EXPORT ImagePyramid : public SpatialDataObject {
         DataBoundingBox getTransformedBoundingBox() const override;
         DataBoundingBox getBoundingBox() const override;
     private:
+        friend class ImagePyramidAccess;
         ImagePyramid();
         std::vector<ImagePyramidLevel> m_levels;
         ImagePyramidLevel getLevelInfo(int level);
+        void createMemoryMappedLevel(ImagePyramidLevel& level, std::string directory);
 
         openslide_t* m_fileHandle = nullptr;
         TIFF* m_tiffHandle = nullptr;
         bool m_tempFile = false;
+        bool m_writable = false; // Created by FAST and written to through the main TIFF handle
         bool m_isOMETIFF = false;
         std::string m_tiffPath;
 
@@ -90,6 +142,9 @@ class FAST_EXPORT ImagePyramid : public SpatialDataObject {
         std::mutex m_dirtyPatchMutex;
         Vector3f m_spacing = Vector3f::Ones();
         std::unordered_set<std::string> m_initializedPatchList; // Keep a list of initialized patches, for tiff backend
+        // Tiles written without propagating them to the coarser levels yet, for each level
+        std::map<int, std::set<std::pair<int, int>>> m_pendingPyramidTiles;
+        std::mutex m_pendingPyramidTilesMutex;
 
         // VSI stuff
         std::ifstream* m_vsiFileHandle;
@@ -98,6 +153,25 @@ class FAST_EXPORT ImagePyramid : public SpatialDataObject {
 
         // A mutex needed to control multi-threaded reading of VSI and TIFF files
         std::mutex m_readMutex;
+
+        // Pool of extra read-only TIFF handles, so that multiple threads can read tiles concurrently
+        struct TIFFReadHandle {
+            TIFF* handle = nullptr;
+            int level = -1; // Current directory of this handle
+        };
+        bool usesTIFFReadHandles() const;
+        TIFFReadHandle acquireTIFFReadHandle();
+        void releaseTIFFReadHandle(TIFFReadHandle handle);
+        std::vector<TIFFReadHandle> m_freeTIFFReadHandles;
+        int m_openTIFFReadHandles = 0;
+        int m_maxTIFFReadHandles;
+        std::mutex m_tiffReadHandleMutex;
+        std::condition_variable m_tiffReadHandleCondition;
+
+        ImagePyramidTileCache m_tileCache;
+
+        // Raw file descriptor of the VSI ets file, used for lock-free positional reads of tiles
+        int m_vsiFileDescriptor = -1;
 };
 
 }
@@ -0,0 +1,102 @@
+#include "ImagePyramidTileCache.hpp"
+
+namespace fast {
+
+ImagePyramidTileCache::ImagePyramidTileCache(std::size_t maximumBytes) {
+    m_maximumBytes = maximumBytes;
+}
+
+uint64_t ImagePyramidTileCache::createKey(int level, int tileX, int tileY) {
+    // 8 bits for level, and 28 bits for each tile index
+    return ((uint64_t)level << 56) | (((uint64_t)tileX & 0xFFFFFFF) << 28) | ((uint64_t)tileY & 0xFFFFFFF);
+}
+
+std::shared_ptr<uchar[]> ImagePyramidTileCache::get(int level, int tileX, int tileY) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    auto it = m_lookup.find(createKey(level, tileX, tileY));
+    if(it == m_lookup.end()) {
+        ++m_misses;
+        return nullptr;
+    }
+    ++m_hits;
+    // Move to front
+    m_entries.splice(m_entries.begin(), m_entries, it->second);
+    return it->second->data;
+}
+
+void ImagePyramidTileCache::put(int level, int tileX, int tileY, std::shared_ptr<uchar[]> data, std::size_t bytes) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if(bytes > m_maximumBytes)
+        return;
+    const auto key = createKey(level, tileX, tileY);
+    auto it = m_lookup.find(key);
+    if(it != m_lookup.end()) {
+        m_bytes -= it->second->bytes;
+        m_entries.erase(it->second);
+        m_lookup.erase(it);
+    }
+    m_entries.push_front({key, std::move(data), bytes});
+    m_lookup[key] = m_entries.begin();
+    m_bytes += bytes;
+    evict();
+}
+
+void ImagePyramidTileCache::remove(int level, int tileX, int tileY) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    auto it = m_lookup.find(createKey(level, tileX, tileY));
+    if(it == m_lookup.end())
+        return;
+    m_bytes -= it->second->bytes;
+    m_entries.erase(it->second);
+    m_lookup.erase(it);
+}
+
+void ImagePyramidTileCache::clear() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_entries.clear();
+    m_lookup.clear();
+    m_bytes = 0;
+}
+
+void ImagePyramidTileCache::evict() {
+    while(m_bytes > m_maximumBytes && !m_entries.empty()) {
+        auto& entry = m_entries.back();
+        m_bytes -= entry.bytes;
+        m_lookup.erase(entry.key);
+        m_entries.pop_back();
+        ++m_evictions;
+    }
+}
+
+void ImagePyramidTileCache::setMaximumSize(std::size_t bytes) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_maximumBytes = bytes;
+    evict();
+}
+
+std::size_t ImagePyramidTileCache::getMaximumSize() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_maximumBytes;
+}
+
+std::size_t ImagePyramidTileCache::getSize() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_bytes;
+}
+
+uint64_t ImagePyramidTileCache::getHits() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_hits;
+}
+
+uint64_t ImagePyramidTileCache::getMisses() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_misses;
+}
+
+uint64_t ImagePyramidTileCache::getEvictions() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_evictions;
+}
+
+}
@@ -0,0 +1,81 @@
+#pragma once
+
+#include <FAST/Data/DataTypes.hpp>
+#include <list>
+#include <unordered_map>
+#include <mutex>
+
+namespace fast {
+
+/**
+ * @brief Least recently used cache of decoded image pyramid tiles
+ *
+ * Tiles are identified by level and tile index, and the cache is limited by the total
+ * number of bytes stored. When the limit is exceeded, the least recently used tiles are evicted.
+ * The cache is thread-safe, and is shared by all accesses of an ImagePyramid.
+ *
+ * @ingroup wsi
+ * @sa ImagePyramid
+ */
+class FAST_EXPORT ImagePyramidTileCache {
+    public:
+        /**
+         * @brief Create tile cache
+         * @param maximumBytes Maximum number of bytes to store. 0 disables the cache.
+         */
+        explicit ImagePyramidTileCache(std::size_t maximumBytes = 128*1024*1024);
+#ifndef SWIG
+        /**
+         * @brief Get a tile from the cache
+         * @return tile data, or nullptr if the tile is not in the cache
+         */
+        std::shared_ptr<uchar[]> get(int level, int tileX, int tileY);
+        /**
+         * @brief Add or replace a tile in the cache
+         * @param data Decoded tile data
+         * @param bytes Size of data in bytes
+         */
+        void put(int level, int tileX, int tileY, std::shared_ptr<uchar[]> data, std::size_t bytes);
+#endif
+        /**
+         * @brief Remove a tile from the cache, if it exists
+         */
+        void remove(int level, int tileX, int tileY);
+        /**
+         * @brief Remove all tiles from the cache
+         */
+        void clear();
+        /**
+         * @brief Set maximum number of bytes to store in the cache. 0 disables the cache.
+         * @param bytes
+         */
+        void setMaximumSize(std::size_t bytes);
+        std::size_t getMaximumSize() const;
+        /**
+         * @return Number of bytes currently stored in the cache
+         */
+        std::size_t getSize() const;
+        uint64_t getHits() const;
+        uint64_t getMisses() const;
+        uint64_t getEvictions() const;
+    private:
+        struct Entry {
+            uint64_t key;
+            std::shared_ptr<uchar[]> data;
+            std::size_t bytes;
+        };
+        static uint64_t createKey(int level, int tileX, int tileY);
+        void evict();
+
+        // Most recently used tiles are at the front of the list
+        std::list<Entry> m_entries;
+        std::unordered_map<uint64_t, std::list<Entry>::iterator> m_lookup;
+        std::size_t m_maximumBytes;
+        std::size_t m_bytes = 0;
+        uint64_t m_hits = 0;
+        uint64_t m_misses = 0;
+        uint64_t m_evictions = 0;
+        mutable std::mutex m_mutex;
+};
+
+}
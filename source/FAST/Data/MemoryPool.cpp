@@ -0,0 +1,251 @@
+#include "MemoryPool.hpp"
+#include <algorithm>
+#include <new>
+
+namespace fast {
+
+static constexpr std::size_t alignment = 64;
+
+static void* allocateAligned(std::size_t bytes) {
+    return ::operator new(bytes, std::align_val_t(alignment));
+}
+
+static void freeAligned(void* data) {
+    ::operator delete(data, std::align_val_t(alignment));
+}
+
+static std::size_t getImageSize(const cl::Image* image) {
+    return image->getImageInfo<CL_IMAGE_ELEMENT_SIZE>()*
+            image->getImageInfo<CL_IMAGE_WIDTH>()*
+            image->getImageInfo<CL_IMAGE_HEIGHT>()*
+            std::max<std::size_t>(image->getImageInfo<CL_IMAGE_DEPTH>(), 1);
+}
+
+MemoryPool* MemoryPool::getInstance() {
+    // Never deleted, since pooled OpenCL objects must not outlive the OpenCL runtime at exit
+    static MemoryPool* instance = new MemoryPool();
+    return instance;
+}
+
+std::size_t MemoryPool::getSizeClass(std::size_t bytes) {
+    // Small sizes are rounded up to the alignment, larger sizes to a quarter of
+    // the power of two below, which limits the waste to 25%
+    if(bytes <= 4096)
+        return std::max<std::size_t>((bytes + alignment - 1) / alignment, 1) * alignment;
+    std::size_t power = 4096;
+    while(power*2 < bytes)
+        power *= 2;
+    const std::size_t step = power / 4;
+    return ((bytes + step - 1) / step) * step;
+}
+
+void* MemoryPool::allocate(std::size_t bytes) {
+    const std::size_t size = getSizeClass(bytes);
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        auto it = m_hostBlocks.find(size);
+        if(it != m_hostBlocks.end() && !it->second.empty()) {
+            void* data = it->second.back();
+            it->second.pop_back();
+            m_statistics.hostCachedBytes -= size;
+            ++m_statistics.hostHits;
+            return data;
+        }
+        ++m_statistics.hostMisses;
+    }
+    return allocateAligned(size);
+}
+
+void MemoryPool::deallocate(void* data, std::size_t bytes) {
+    if(data == nullptr)
+        return;
+    const std::size_t size = getSizeClass(bytes);
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if(m_enabled && size <= m_maximumHostBytes) {
+            trimHost(m_maximumHostBytes - size);
+            m_hostBlocks[size].push_back(data);
+            m_statistics.hostCachedBytes += size;
+            return;
+        }
+    }
+    freeAligned(data);
+}
+
+void MemoryPool::trimHost(std::size_t maximumBytes) {
+    // Evict from the largest size classes first
+    for(auto it = m_hostBlocks.rbegin(); it != m_hostBlocks.rend() && m_statistics.hostCachedBytes > maximumBytes; ++it) {
+        while(!it->second.empty() && m_statistics.hostCachedBytes > maximumBytes) {
+            freeAligned(it->second.back());
+            it->second.pop_back();
+            m_statistics.hostCachedBytes -= it->first;
+        }
+    }
+}
+
+cl::Buffer* MemoryPool::allocateBuffer(std::shared_ptr<OpenCLDevice> device, std::size_t bytes) {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        auto cacheIt = m_deviceCaches.find(device);
+        if(cacheIt != m_deviceCaches.end()) {
+            auto& cache = cacheIt->second;
+            auto it = cache.buffers.find(bytes);
+            if(it != cache.buffers.end() && !it->second.empty()) {
+                cl::Buffer* buffer = it->second.back();
+                it->second.pop_back();
+                cache.bytes -= bytes;
+                m_statistics.deviceCachedBytes -= bytes;
+                ++m_statistics.deviceHits;
+                return buffer;
+            }
+        }
+        ++m_statistics.deviceMisses;
+    }
+    return new cl::Buffer(device->getContext(), CL_MEM_READ_WRITE, bytes);
+}
+
+void MemoryPool::deallocateBuffer(std::shared_ptr<OpenCLDevice> device, cl::Buffer* buffer) {
+    if(buffer == nullptr)
+        return;
+    {
+        const std::size_t bytes = buffer->getInfo<CL_MEM_SIZE>();
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if(m_enabled && bytes <= m_maximumDeviceBytes) {
+            auto& cache = m_deviceCaches[device];
+            trimDevice(cache, m_maximumDeviceBytes - bytes);
+            cache.buffers[bytes].push_back(buffer);
+            cache.bytes += bytes;
+            m_statistics.deviceCachedBytes += bytes;
+            return;
+        }
+    }
+    delete buffer;
+}
+
+std::vector<std::size_t> MemoryPool::createImageKey(int dimensions, cl::ImageFormat format, std::size_t width, std::size_t height, std::size_t depth) {
+    return {(std::size_t)dimensions, format.image_channel_order, format.image_channel_data_type, width, height, dimensions == 2 ? 1 : depth};
+}
+
+cl::Image* MemoryPool::allocateImage(std::shared_ptr<OpenCLDevice> device, int dimensions, cl::ImageFormat format, std::size_t width, std::size_t height, std::size_t depth) {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        auto cacheIt = m_deviceCaches.find(device);
+        if(cacheIt != m_deviceCaches.end()) {
+            auto& cache = cacheIt->second;
+            auto it = cache.images.find(createImageKey(dimensions, format, width, height, depth));
+            if(it != cache.images.end() && !it->second.empty()) {
+                cl::Image* image = it->second.back();
+                it->second.pop_back();
+                const std::size_t bytes = getImageSize(image);
+                cache.bytes -= bytes;
+                m_statistics.deviceCachedBytes -= bytes;
+                ++m_statistics.deviceHits;
+                return image;
+            }
+        }
+        ++m_statistics.deviceMisses;
+    }
+    if(dimensions == 2) {
+        return new cl::Image2D(device->getContext(), CL_MEM_READ_WRITE, format, width, height);
+    } else {
+        return new cl::Image3D(device->getContext(), CL_MEM_READ_WRITE, format, width, height, depth);
+    }
+}
+
+void MemoryPool::deallocateImage(std::shared_ptr<OpenCLDevice> device, cl::Image* image) {
+    if(image == nullptr)
+        return;
+    {
+        const int dimensions = image->getInfo<CL_MEM_TYPE>() == CL_MEM_OBJECT_IMAGE2D ? 2 : 3;
+        const auto key = createImageKey(dimensions,
+                image->getImageInfo<CL_IMAGE_FORMAT>(),
+                image->getImageInfo<CL_IMAGE_WIDTH>(),
+                image->getImageInfo<CL_IMAGE_HEIGHT>(),
+                image->getImageInfo<CL_IMAGE_DEPTH>());
+        const std::size_t bytes = getImageSize(image);
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if(m_enabled && bytes <= m_maximumDeviceBytes) {
+            auto& cache = m_deviceCaches[device];
+            trimDevice(cache, m_maximumDeviceBytes - bytes);
+            cache.images[key].push_back(image);
+            cache.bytes += bytes;
+            m_statistics.deviceCachedBytes += bytes;
+            return;
+        }
+    }
+    delete image;
+}
+
+void MemoryPool::trimDevice(DeviceCache& cache, std::size_t maximumBytes) {
+    for(auto it = cache.buffers.rbegin(); it != cache.buffers.rend() && cache.bytes > maximumBytes; ++it) {
+        while(!it->second.empty() && cache.bytes > maximumBytes) {
+            delete it->second.back();
+            it->second.pop_back();
+            cache.bytes -= it->first;
+            m_statistics.deviceCachedBytes -= it->first;
+        }
+    }
+    for(auto it = cache.images.begin(); it != cache.images.end() && cache.bytes > maximumBytes; ++it) {
+        while(!it->second.empty() && cache.bytes > maximumBytes) {
+            const std::size_t bytes = getImageSize(it->second.back());
+            delete it->second.back();
+            it->second.pop_back();
+            cache.bytes -= bytes;
+            m_statistics.deviceCachedBytes -= bytes;
+        }
+    }
+}
+
+void MemoryPool::setEnabled(bool enabled) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_enabled = enabled;
+    if(!enabled) {
+        trimHost(0);
+        for(auto& cache : m_deviceCaches)
+            trimDevice(cache.second, 0);
+    }
+}
+
+bool MemoryPool::isEnabled() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_enabled;
+}
+
+void MemoryPool::setMaximumHostSize(std::size_t bytes) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_maximumHostBytes = bytes;
+    trimHost(bytes);
+}
+
+std::size_t MemoryPool::getMaximumHostSize() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_maximumHostBytes;
+}
+
+void MemoryPool::setMaximumDeviceSize(std::size_t bytes) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_maximumDeviceBytes = bytes;
+    for(auto& cache : m_deviceCaches)
+        trimDevice(cache.second, bytes);
+}
+
+std::size_t MemoryPool::getMaximumDeviceSize() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_maximumDeviceBytes;
+}
+
+void MemoryPool::clear() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    trimHost(0);
+    for(auto& cache : m_deviceCaches)
+        trimDevice(cache.second, 0);
+    m_deviceCaches.clear();
+    m_hostBlocks.clear();
+}
+
+MemoryPoolStatistics MemoryPool::getStatistics() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_statistics;
+}
+
+}
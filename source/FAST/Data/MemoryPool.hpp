@@ -0,0 +1,123 @@
+#pragma once
+
+#include <FAST/ExecutionDevice.hpp>
+#include <map>
+#include <unordered_map>
+#include <vector>
+#include <mutex>
+
+namespace fast {
+
+/**
+ * @brief Statistics of the MemoryPool
+ */
+struct FAST_EXPORT MemoryPoolStatistics {
+    uint64_t hostHits = 0;
+    uint64_t hostMisses = 0;
+    std::size_t hostCachedBytes = 0;
+    uint64_t deviceHits = 0;
+    uint64_t deviceMisses = 0;
+    std::size_t deviceCachedBytes = 0;
+};
+
+/**
+ * @brief Pool of pixel buffers used by Image and Tensor
+ *
+ * Host memory is handed out in size classes, and released blocks are kept for reuse
+ * instead of being returned to the system allocator.
+ * OpenCL buffers and images are recycled per device, and reused when a new object
+ * of exactly the same size and format is requested.
+ * This avoids allocator churn when streaming many frames or patches of the same size.
+ *
+ * The amount of memory kept in the pool is limited, and the pool is thread-safe.
+ *
+ * @ingroup data
+ */
+class FAST_EXPORT MemoryPool {
+    public:
+        static MemoryPool* getInstance();
+        /**
+         * @brief Allocate a block of host memory, aligned to 64 bytes
+         * @param bytes
+         * @return pointer to uninitialized memory
+         */
+        void* allocate(std::size_t bytes);
+        /**
+         * @brief Return a block of host memory to the pool
+         * @param data Pointer returned by allocate
+         * @param bytes Same size as given to allocate
+         */
+        void deallocate(void* data, std::size_t bytes);
+        /**
+         * @brief Get an uninitialized read-write OpenCL buffer
+         * @param device
+         * @param bytes
+         */
+        cl::Buffer* allocateBuffer(std::shared_ptr<OpenCLDevice> device, std::size_t bytes);
+        /**
+         * @brief Return an OpenCL buffer to the pool. The pool takes ownership of the buffer.
+         */
+        void deallocateBuffer(std::shared_ptr<OpenCLDevice> device, cl::Buffer* buffer);
+        /**
+         * @brief Get an uninitialized read-write OpenCL image
+         * @param device
+         * @param dimensions 2 or 3
+         * @param format
+         * @param width
+         * @param height
+         * @param depth Ignored for 2D images
+         */
+        cl::Image* allocateImage(std::shared_ptr<OpenCLDevice> device, int dimensions, cl::ImageFormat format, std::size_t width, std::size_t height, std::size_t depth = 1);
+        /**
+         * @brief Return an OpenCL image to the pool. The pool takes ownership of the image.
+         */
+        void deallocateImage(std::shared_ptr<OpenCLDevice> device, cl::Image* image);
+        /**
+         * @brief Enable or disable the pool. When disabled, all memory is freed immediately.
+         * @param enabled
+         */
+        void setEnabled(bool enabled);
+        bool isEnabled() const;
+        /**
+         * @brief Set maximum number of bytes of host memory to keep in the pool
+         * @param bytes
+         */
+        void setMaximumHostSize(std::size_t bytes);
+        std::size_t getMaximumHostSize() const;
+        /**
+         * @brief Set maximum number of bytes of OpenCL memory to keep in the pool, per device
+         * @param bytes
+         */
+        void setMaximumDeviceSize(std::size_t bytes);
+        std::size_t getMaximumDeviceSize() const;
+        /**
+         * @brief Free all memory kept in the pool
+         */
+        void clear();
+        MemoryPoolStatistics getStatistics() const;
+        /**
+         * @brief Size class used for a host allocation of the given size
+         * @param bytes
+         */
+        static std::size_t getSizeClass(std::size_t bytes);
+    private:
+        MemoryPool() = default;
+        struct DeviceCache {
+            std::map<std::size_t, std::vector<cl::Buffer*>> buffers;
+            std::map<std::vector<std::size_t>, std::vector<cl::Image*>> images;
+            std::size_t bytes = 0;
+        };
+        static std::vector<std::size_t> createImageKey(int dimensions, cl::ImageFormat format, std::size_t width, std::size_t height, std::size_t depth);
+        void trimHost(std::size_t maximumBytes);
+        void trimDevice(DeviceCache& cache, std::size_t maximumBytes);
+
+        std::map<std::size_t, std::vector<void*>> m_hostBlocks;
+        std::unordered_map<std::shared_ptr<OpenCLDevice>, DeviceCache> m_deviceCaches;
+        bool m_enabled = true;
+        std::size_t m_maximumHostBytes = 1024*1024*1024;
+        std::size_t m_maximumDeviceBytes = 512*1024*1024;
+        MemoryPoolStatistics m_statistics;
+        mutable std::mutex m_mutex;
+};
+
+}
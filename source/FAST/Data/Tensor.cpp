@@ -1,15 +1,34 @@
 #include "Tensor.hpp"
 #include <FAST/Utility.hpp>
 #include <FAST/Data/Access/OpenCLBufferAccess.hpp>
+#include <FAST/Data/MemoryPool.hpp>
 
 namespace fast {
 
-void Tensor::init(std::unique_ptr<float[]> data, TensorShape shape) {
+static unique_tensor_data_ptr allocateTensorData(std::size_t size, DataType type = TYPE_FLOAT) {
+    const std::size_t bytes = size*getSizeOfDataType(type, 1);
+    return unique_tensor_data_ptr(MemoryPool::getInstance()->allocate(bytes), [bytes](void* data) {
+        MemoryPool::getInstance()->deallocate(data, bytes);
+    });
+}
+
+static void checkTensorDataType(DataType type) {
+    switch(type) {
+        fastSwitchTensorTypeMacro(return);
+        default:
+            break;
+    }
+    throw Exception("Data type " + getCTypeAsString(type) + " is not supported by Tensor");
+}
+
+void Tensor::init(unique_tensor_data_ptr data, TensorShape shape, DataType type) {
     if(shape.empty())
         throw Exception("Shape can't be empty");
     if(shape.getUnknownDimensions() > 0)
         throw Exception("Shape can't have unknown dimensions");
+    checkTensorDataType(type);
     m_data = std::move(data);
+    m_dataType = type;
     m_shape = shape;
     m_spacing = VectorXf::Ones(shape.getDimensions());
     mHostDataIsUpToDate = true;
@@ -21,7 +40,20 @@ void Tensor::init(std::unique_ptr<float[]> data, TensorShape shape) {
 }
 
 Tensor::Tensor(std::unique_ptr<float[]> data, TensorShape shape) {
-    init(std::move(data), shape);
+    init(unique_tensor_data_ptr(data.release(), [](void* data) { delete[] (float*)data; }), shape);
+}
+
+Tensor::Tensor(unique_tensor_ptr data, TensorShape shape) {
+    if(!data)
+        throw Exception("Data can't be null");
+    auto deleter = data.get_deleter();
+    init(unique_tensor_data_ptr(data.release(), [deleter](void* data) { deleter((float*)data); }), shape);
+}
+
+Tensor::Tensor(unique_tensor_data_ptr data, TensorShape shape, DataType type) {
+    if(!data)
+        throw Exception("Data can't be null");
+    init(std::move(data), shape, type);
 }
 
 Tensor::Tensor(const float* const data, TensorShape shape) {
@@ -29,29 +61,41 @@ Tensor::Tensor(const float* const data, TensorShape shape) {
         throw Exception("Shape can't be empty");
     if(shape.getUnknownDimensions() > 0)
         throw Exception("When creating a tensor, shape must be fully defined");
-    auto newData = make_uninitialized_unique<float[]>(shape.getTotalSize());
+    auto newData = allocateTensorData(shape.getTotalSize());
     std::memcpy(newData.get(), data, shape.getTotalSize()*sizeof(float));
     init(std::move(newData), shape);
 }
 
+Tensor::Tensor(const void* const data, TensorShape shape, DataType type) {
+    if(shape.empty())
+        throw Exception("Shape can't be empty");
+    if(shape.getUnknownDimensions() > 0)
+        throw Exception("When creating a tensor, shape must be fully defined");
+    checkTensorDataType(type);
+    auto newData = allocateTensorData(shape.getTotalSize(), type);
+    std::memcpy(newData.get(), data, shape.getTotalSize()*getSizeOfDataType(type, 1));
+    init(std::move(newData), shape, type);
+}
 
-Tensor::Tensor(TensorShape shape) {
+Tensor::Tensor(TensorShape shape, DataType type) {
     if(shape.empty())
         throw Exception("Shape can't be empty");
     if(shape.getUnknownDimensions() > 0)
         throw Exception("When creating a tensor, shape must be fully defined");
-    auto newData = make_uninitialized_unique<float[]>(shape.getTotalSize());
-    init(std::move(newData), shape);
+    checkTensorDataType(type);
+    auto newData = allocateTensorData(shape.getTotalSize(), type);
+    init(std::move(newData), shape, type);
 }
 
 Tensor::Tensor(std::initializer_list<float> data) {
     if(data.size() == 0)
         throw Exception("Shape can't be empty");
 
-    auto newData = make_uninitialized_unique<float[]>(data.size());
+    auto newData = allocateTensorData(data.size());
+    float* values = (float*)newData.get();
 	int i = 0;
 	for(auto item : data) {
-		newData[i] = item;
+		values[i] = item;
 		++i;
 	}
     auto shape = TensorShape({(int)data.size()});
@@ -71,6 +115,56 @@ TensorShape Tensor::getShape() const {
     return m_shape;
 }
 
+DataType Tensor::getDataType() const {
+    return m_dataType;
+}
+
+template <class T>
+static T convertTensorValue(float value) {
+    if constexpr(std::is_integral<T>::value) {
+        return saturate_cast<T>(std::round(value));
+    } else {
+        return (T)value;
+    }
+}
+
+template <class InputType, class OutputType>
+static void convertTensorData(const void* input, void* output, std::size_t size) {
+    const InputType* inputData = (const InputType*)input;
+    OutputType* outputData = (OutputType*)output;
+    for(std::size_t i = 0; i < size; ++i)
+        outputData[i] = convertTensorValue<OutputType>((float)inputData[i]);
+}
+
+template <class InputType>
+static void convertTensorData(const void* input, void* output, std::size_t size, DataType outputType) {
+    switch(outputType) {
+        fastSwitchTensorTypeMacro((convertTensorData<InputType, FAST_TYPE>(input, output, size)));
+        default:
+            break;
+    }
+}
+
+Tensor::pointer Tensor::toDataType(DataType type) {
+    if(type == m_dataType)
+        return std::static_pointer_cast<Tensor>(mPtr.lock());
+    auto tensor = Tensor::create(m_shape, type);
+    {
+        auto access = getAccess(ACCESS_READ);
+        auto outputAccess = tensor->getAccess(ACCESS_READ_WRITE);
+        switch(m_dataType) {
+            fastSwitchTensorTypeMacro(convertTensorData<FAST_TYPE>(access->get(), outputAccess->get(), m_shape.getTotalSize(), type));
+            default:
+                break;
+        }
+    }
+    tensor->setSpacing(m_spacing);
+    tensor->mergeFrameData(getFrameDataStore());
+    for(auto&& lastFrame : getLastFrame())
+        tensor->setLastFrame(lastFrame);
+    return tensor;
+}
+
 TensorAccess::pointer Tensor::getAccess(accessType type) {
     if(!isInitialized())
         throw Exception("Tensor has not been initialized.");
@@ -92,7 +186,7 @@ TensorAccess::pointer Tensor::getAccess(accessType type) {
         std::unique_lock<std::mutex> lock(mDataIsBeingAccessedMutex);
         mDataIsBeingAccessed = true;
     }
-    return std::make_unique<TensorAccess>(getHostDataPointer(), m_shape, std::static_pointer_cast<Tensor>(mPtr.lock()));
+    return std::make_unique<TensorAccess>(getHostDataPointer(), m_shape, m_dataType, std::static_pointer_cast<Tensor>(mPtr.lock()));
 }
 
 void Tensor::free(ExecutionDevice::pointer device) {
@@ -100,7 +194,9 @@ void Tensor::free(ExecutionDevice::pointer device) {
         m_data.reset();
     } else {
         auto clDevice = std::dynamic_pointer_cast<OpenCLDevice>(device);
-        delete mCLBuffers[clDevice];
+        auto buffer = mCLBuffers.find(clDevice);
+        if(buffer != mCLBuffers.end())
+            MemoryPool::getInstance()->deallocateBuffer(clDevice, buffer->second);
         mCLBuffers.erase(clDevice);
         mCLBuffersIsUpToDate.erase(clDevice);
     }
@@ -109,7 +205,7 @@ void Tensor::free(ExecutionDevice::pointer device) {
 void Tensor::freeAll() {
     m_data.reset();
     for(auto buffer : mCLBuffers) {
-        delete buffer.second;
+        MemoryPool::getInstance()->deallocateBuffer(buffer.first, buffer.second);
     }
     mCLBuffers.clear();
     mCLBuffersIsUpToDate.clear();
@@ -159,12 +255,8 @@ void Tensor::updateOpenCLBufferData(OpenCLDevice::pointer device) {
     bool updated = false;
     if(mCLBuffers.count(device) == 0) {
         // Data is not on device, create it
-        unsigned int bufferSize = getShape().getTotalSize()*4;
-        cl::Buffer * newBuffer = new cl::Buffer(
-                device->getContext(),
-                CL_MEM_READ_WRITE,
-                bufferSize
-        );
+        std::size_t bufferSize = getShape().getTotalSize()*getSizeOfDataType(m_dataType, 1);
+        cl::Buffer * newBuffer = MemoryPool::getInstance()->allocateBuffer(device, bufferSize);
 
         if(hasAnyData()) {
             mCLBuffersIsUpToDate[device] = false;
@@ -189,7 +281,7 @@ void Tensor::updateOpenCLBufferData(OpenCLDevice::pointer device) {
 }
 
 void Tensor::transferCLBufferFromHost(OpenCLDevice::pointer device) {
-    std::size_t bufferSize = m_shape.getTotalSize()*4;
+    std::size_t bufferSize = m_shape.getTotalSize()*getSizeOfDataType(m_dataType, 1);
     device->getCommandQueue().enqueueWriteBuffer(*mCLBuffers[device],
         CL_TRUE, 0, bufferSize, getHostDataPointer());
 }
@@ -197,9 +289,9 @@ void Tensor::transferCLBufferFromHost(OpenCLDevice::pointer device) {
 void Tensor::transferCLBufferToHost(OpenCLDevice::pointer device) {
 	if(!m_data) {
 		// Must allocate memory for host data
-        m_data = make_uninitialized_unique<float[]>(m_shape.getTotalSize());
+        m_data = allocateTensorData(m_shape.getTotalSize(), m_dataType);
 	}
-    std::size_t bufferSize = m_shape.getTotalSize()*4;
+    std::size_t bufferSize = m_shape.getTotalSize()*getSizeOfDataType(m_dataType, 1);
     device->getCommandQueue().enqueueReadBuffer(*mCLBuffers[device],
         CL_TRUE, 0, bufferSize, getHostDataPointer());
 }
@@ -221,7 +313,7 @@ void Tensor::updateHostData() {
     bool updated = false;
     if(!m_data) {
         // Data is not initialized, do that first
-        m_data = make_uninitialized_unique<float[]>(m_shape.getTotalSize());
+        m_data = allocateTensorData(m_shape.getTotalSize(), m_dataType);
 
         if(hasAnyData()) {
             mHostDataIsUpToDate = false;
@@ -265,6 +357,28 @@ void Tensor::deleteDimension(int i) {
     }
 }
 
+Tensor::pointer Tensor::getView(int index) {
+    if(m_shape.getDimensions() < 2)
+        throw Exception("Tensor must have at least 2 dimensions to create a view");
+    if(index < 0 || index >= m_shape[0])
+        throw Exception("Index " + std::to_string(index) + " out of bounds in Tensor::getView");
+    {
+        // Make sure host data is up to date
+        auto access = getAccess(ACCESS_READ);
+    }
+    TensorShape shape;
+    for(int i = 1; i < m_shape.getDimensions(); ++i)
+        shape.addDimension(m_shape[i]);
+    const std::size_t offset = (std::size_t)index*shape.getTotalSize()*getSizeOfDataType(m_dataType, 1);
+    // The deleter keeps this tensor, and thereby its storage, alive
+    auto self = std::static_pointer_cast<Tensor>(mPtr.lock());
+    unique_tensor_data_ptr data((uchar*)getHostDataPointer() + offset, [self](void*) {});
+    auto view = Tensor::create(std::move(data), shape, m_dataType);
+    if(m_spacing.size() == m_shape.getDimensions())
+        view->setSpacing(m_spacing.tail(shape.getDimensions()));
+    return view;
+}
+
 DataBoundingBox Tensor::getTransformedBoundingBox() const {
     auto T = SceneGraph::getEigenTransformFromNode(getSceneGraphNode());
 
@@ -282,7 +396,7 @@ DataBoundingBox Tensor::getBoundingBox() const {
     return SpatialDataObject::getBoundingBox().getTransformedBoundingBox(T);
 }
 
-float* Tensor::getHostDataPointer() {
+void* Tensor::getHostDataPointer() {
     return m_data.get();
 }
 
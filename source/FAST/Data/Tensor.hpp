@@ -5,17 +5,25 @@
 #include <FAST/Data/Access/Access.hpp>
 #include <FAST/Data/TensorShape.hpp>
 #include <unordered_map>
+#include <functional>
 
 namespace fast {
 
 class OpenCLBufferAccess;
 
+#ifndef SWIG
+using unique_tensor_ptr = std::unique_ptr<float[], std::function<void(float*)>>;
+using unique_tensor_data_ptr = std::unique_ptr<void, std::function<void(void*)>>;
+#endif
+
 /**
  * @brief N-Dimensional tensor data object
  *
  * This object represents an N-dimensional tensor.
  * The data can be stored as a C++ pointer, and as an OpenCL buffer.
- * The tensor data is stored as 32-bit floats.
+ * The tensor data is stored as 32-bit floats by default, but can also be stored as
+ * TYPE_FLOAT16, TYPE_INT8, TYPE_UINT8, TYPE_INT16, TYPE_UINT16 or TYPE_INT32, e.g. for quantized
+ * and half precision neural networks.
  *
  * @ingroup data neural-network
  */
@@ -29,6 +37,21 @@ class FAST_EXPORT Tensor : public SpatialDataObject {
          * @param shape
          */
         FAST_CONSTRUCTOR(Tensor, std::unique_ptr<float[]>, data,, TensorShape, shape,)
+        /**
+         * Create a tensor which uses external storage, such as a buffer owned by an inference engine.
+         * The deleter of data is called when the tensor no longer needs the storage.
+         * @param data
+         * @param shape
+         */
+        FAST_CONSTRUCTOR(Tensor, unique_tensor_ptr, data,, TensorShape, shape,)
+        /**
+         * Create a tensor of the given data type which uses external storage.
+         * The deleter of data is called when the tensor no longer needs the storage.
+         * @param data
+         * @param shape
+         * @param type
+         */
+        FAST_CONSTRUCTOR(Tensor, unique_tensor_data_ptr, data,, TensorShape, shape,, DataType, type,)
         /**
          * Create a 1D tensor with the provided data. Its shape will be equal to its length
          * @param data
@@ -41,17 +64,35 @@ class FAST_EXPORT Tensor : public SpatialDataObject {
          * @param shape
          */
         FAST_CONSTRUCTOR(Tensor, const float* const, data,, TensorShape, shape,)
+        /**
+         * Create a tensor of the given data type using the provided data and shape. This method will COPY the data.
+         * @param data
+         * @param shape
+         * @param type
+         */
+        FAST_CONSTRUCTOR(Tensor, const void* const, data,, TensorShape, shape,, DataType, type,)
         /**
          * Create an unitialized tensor with the provided shape
          * @param shape
+         * @param type Data type of tensor
          */
-        FAST_CONSTRUCTOR(Tensor, TensorShape, shape,)
+        FAST_CONSTRUCTOR(Tensor, TensorShape, shape,, DataType, type, = TYPE_FLOAT)
 		/**
 		 * Add a dimension of size 1 at provided position. -1 is last position.
 		 * @param position
 		 */
 		virtual void expandDims(int position = 0);
         virtual TensorShape getShape() const;
+        DataType getDataType() const;
+        /**
+         * @brief Convert this tensor to another data type
+         *
+         * Values are rounded and saturated when converting to an integer type.
+         *
+         * @param type
+         * @return new tensor, or this tensor if it already has the given data type
+         */
+        std::shared_ptr<Tensor> toDataType(DataType type);
         virtual TensorAccess::pointer getAccess(accessType type);
         virtual std::unique_ptr<OpenCLBufferAccess> getOpenCLBufferAccess(accessType type, OpenCLDevice::pointer);
         virtual void freeAll() override;
@@ -59,13 +100,25 @@ class FAST_EXPORT Tensor : public SpatialDataObject {
         virtual void setSpacing(VectorXf spacing);
         virtual VectorXf getSpacing() const;
         virtual void deleteDimension(int dimension);
+#ifndef SWIG
+        /**
+         * @brief Get a view of a sub tensor along the first dimension, such as one sample of a batch, without copying
+         *
+         * The view has the shape of this tensor without the first dimension, and shares host memory with this tensor,
+         * which is kept alive as long as the view exists. Thus changes to the data of one is visible in the other.
+         *
+         * @param index Index in the first dimension
+         * @return tensor view
+         */
+        std::shared_ptr<Tensor> getView(int index);
+#endif
 
         virtual DataBoundingBox getTransformedBoundingBox() const override;
         virtual DataBoundingBox getBoundingBox() const override;
 		virtual ~Tensor();
 
     protected:
-        void init(std::unique_ptr<float[]> data, TensorShape shape);
+        void init(unique_tensor_data_ptr data, TensorShape shape, DataType type = TYPE_FLOAT);
         Tensor() = default;
         virtual bool isInitialized();
         virtual void transferCLBufferFromHost(OpenCLDevice::pointer device);
@@ -74,9 +127,10 @@ class FAST_EXPORT Tensor : public SpatialDataObject {
         void setAllDataToOutOfDate();
         virtual bool hasAnyData();
         void updateHostData();
-        virtual float* getHostDataPointer();
+        virtual void* getHostDataPointer();
 
-        std::unique_ptr<float[]> m_data;
+        unique_tensor_data_ptr m_data;
+        DataType m_dataType = TYPE_FLOAT;
         std::unordered_map<std::shared_ptr<OpenCLDevice>, cl::Buffer*> mCLBuffers;
         std::unordered_map<std::shared_ptr<OpenCLDevice>, bool> mCLBuffersIsUpToDate;
         TensorShape m_shape;
@@ -0,0 +1,104 @@
+#include "FAST/Testing.hpp"
+#include "FAST/Data/BoundingBox.hpp"
+#include "FAST/Data/BoundingBoxGrid.hpp"
+#include <FAST/Utility.hpp>
+#include <QDir>
+#include <cstdio>
+#include <fstream>
+#include <set>
+
+using namespace fast;
+
+namespace {
+// Bounding box set of a 100x100 patch with 10 pixels overlap, thus patches are 80 pixels apart
+BoundingBoxSet::pointer createPatchBoundingBoxes(int patchX, int patchY, std::vector<std::pair<Vector2f, Vector2f>> boxes, float score) {
+    auto bbset = BoundingBoxSet::create();
+    {
+        auto access = bbset->getAccess(ACCESS_READ_WRITE);
+        for(auto box : boxes)
+            access->addBoundingBox(box.first, box.second, 1, score);
+    }
+    bbset->setFrameData("patchid-x", patchX);
+    bbset->setFrameData("patchid-y", patchY);
+    bbset->setFrameData("patch-width", 100);
+    bbset->setFrameData("patch-height", 100);
+    bbset->setFrameData("patch-overlap-x", 10);
+    bbset->setFrameData("patch-overlap-y", 10);
+    bbset->setFrameData("patch-spacing-x", 1.0f);
+    bbset->setFrameData("patch-spacing-y", 1.0f);
+    return bbset;
+}
+}
+
+TEST_CASE("Bounding box set accumulator merges duplicates across patch borders", "[fast][BoundingBoxSetAccumulator]") {
+    auto accumulator = BoundingBoxSetAccumulator::create(0.5f);
+    // Object at x 60-85, y 20-40 in the full image, which is cut by the border of the second patch
+    accumulator->setInputData(createPatchBoundingBoxes(0, 0, {{Vector2f(70, 30), Vector2f(25, 20)}, {Vector2f(20, 20), Vector2f(10, 10)}}, 0.6f));
+    accumulator->update();
+    accumulator->setInputData(createPatchBoundingBoxes(1, 0, {{Vector2f(0, 30), Vector2f(15, 20)}}, 0.8f));
+    accumulator->update();
+    CHECK(accumulator->getNrOfActiveBoundingBoxes() == 2);
+
+    // Next row of patches finalizes the bounding boxes of the first row
+    auto lastPatch = createPatchBoundingBoxes(0, 1, {{Vector2f(20, 20), Vector2f(10, 10)}}, 0.7f);
+    accumulator->setInputData(lastPatch);
+    auto result = accumulator->updateAndGetOutputData<BoundingBoxSet>();
+    CHECK(accumulator->getNrOfActiveBoundingBoxes() == 1);
+    {
+        auto access = result->getAccess(ACCESS_READ);
+        auto coordinates = access->getCoordinates();
+        auto scores = access->getScores();
+        REQUIRE(scores.size() == 2);
+        CHECK(coordinates[0] == Approx(10.0f));
+        CHECK(coordinates[1] == Approx(10.0f));
+        CHECK(scores[0] == Approx(0.6f));
+        // Merged bounding box
+        CHECK(coordinates[12] == Approx(60.0f));
+        CHECK(coordinates[13] == Approx(20.0f));
+        CHECK(coordinates[18] == Approx(85.0f));
+        CHECK(coordinates[19] == Approx(40.0f));
+        CHECK(scores[1] == Approx(0.8f));
+    }
+}
+
+TEST_CASE("Bounding box set accumulator writes finalized bounding boxes to file", "[fast][BoundingBoxSetAccumulator]") {
+    const std::string filename = join(QDir::tempPath().toStdString(), "BoundingBoxSetAccumulatorTest.csv");
+    auto accumulator = BoundingBoxSetAccumulator::create(0.5f, filename);
+    accumulator->setInputData(createPatchBoundingBoxes(0, 0, {{Vector2f(70, 30), Vector2f(25, 20)}}, 0.6f));
+    accumulator->update();
+    accumulator->setInputData(createPatchBoundingBoxes(1, 0, {{Vector2f(0, 30), Vector2f(15, 20)}}, 0.8f));
+    accumulator->update();
+    auto lastPatch = createPatchBoundingBoxes(0, 1, {{Vector2f(20, 20), Vector2f(10, 10)}}, 0.7f);
+    lastPatch->setLastFrame("test");
+    accumulator->setInputData(lastPatch);
+    auto result = accumulator->updateAndGetOutputData<BoundingBoxSet>();
+    CHECK(accumulator->getNrOfActiveBoundingBoxes() == 0);
+    CHECK(result->getAccess(ACCESS_READ)->getScores().empty());
+
+    std::vector<std::string> lines;
+    {
+        std::ifstream file(filename);
+        std::string line;
+        while(std::getline(file, line))
+            lines.push_back(line);
+    }
+    std::remove(filename.c_str());
+    REQUIRE(lines.size() == 3);
+    CHECK(lines[0] == "x,y,width,height,label,score");
+    CHECK(lines[1] == "60,20,25,20,1,0.8");
+    CHECK(lines[2] == "10,90,10,10,1,0.7");
+}
+
+TEST_CASE("Bounding box grid finds overlapping bounding boxes at negative coordinates", "[fast][BoundingBoxGrid]") {
+    BoundingBoxGrid grid(10.0f);
+    grid.insert(0, Vector2f(-25, -5), Vector2f(-15, 5));
+    grid.insert(1, Vector2f(100, 100), Vector2f(110, 110));
+    std::set<int> neighbours;
+    grid.forEachNeighbour(Vector2f(-18, 0), Vector2f(-12, 2), [&](int index) {
+        neighbours.insert(index);
+        return true;
+    });
+    CHECK(neighbours == std::set<int>({0}));
+    CHECK(intersectionOverUnion(Vector2f(0, 0), Vector2f(2, 2), Vector2f(1, 0), Vector2f(3, 2)) == Approx(2.0f/6.0f));
+    CHECK(intersectionOverMinimumArea(Vector2f(0, 0), Vector2f(2, 2), Vector2f(1, 0), Vector2f(2, 1)) == Approx(1.0f));
+}
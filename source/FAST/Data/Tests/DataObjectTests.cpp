@@ -12,6 +12,56 @@ TEST_CASE("Update timestamp on DataObject", "[fast][DataObject]") {
     CHECK(timestamp != data->getTimestamp());
 }
 
+TEST_CASE("Typed frame data on DataObject", "[fast][DataObject]") {
+    auto data = DummyDataObject::New();
+    data->setFrameData("patchid-x", 3);
+    data->setFrameData("patch-spacing-x", 0.00025f);
+    data->setFrameData("original-transform", std::vector<float>{1.0f, 0.0f, 2.5f});
+    data->setFrameData("streaming", "yes");
+
+    CHECK(data->getFrameData<int>("patchid-x") == 3);
+    CHECK(data->getFrameData<float>("patch-spacing-x") == 0.00025f);
+    CHECK(data->getFrameData<std::vector<float>>("original-transform") == std::vector<float>{1.0f, 0.0f, 2.5f});
+    // String API is still available
+    CHECK(data->getFrameData("patchid-x") == "3");
+    CHECK(data->getFrameData("streaming") == "yes");
+    CHECK(std::stof(data->getFrameData("patch-spacing-x")) == 0.00025f);
+    CHECK(data->getFrameData().size() == 4);
+    CHECK_THROWS(data->getFrameData("does-not-exist"));
+
+    // Values stored as strings can still be read as numbers
+    data->setFrameData("progress", "0.5");
+    CHECK(data->getFrameData<float>("progress") == 0.5f);
+}
+
+TEST_CASE("Frame data is shared until modified", "[fast][DataObject]") {
+    auto data = DummyDataObject::New();
+    data->setFrameData("patchid-x", 1);
+    auto data2 = DummyDataObject::New();
+    data2->mergeFrameData(data->getFrameDataStore());
+    data2->setFrameData("patchid-x", 2);
+    data2->setFrameData("patchid-y", 5);
+
+    CHECK(data->getFrameData<int>("patchid-x") == 1);
+    CHECK_FALSE(data->hasFrameData("patchid-y"));
+    CHECK(data2->getFrameData<int>("patchid-x") == 2);
+    CHECK(data2->getFrameData<int>("patchid-y") == 5);
+}
+
+TEST_CASE("Frame data lookup of unknown name does not intern it", "[fast][DataObject]") {
+    FrameData frameData;
+    frameData.set("frame-data-test-known", 1.0);
+    CHECK_FALSE(frameData.has("frame-data-test-unknown"));
+    CHECK_THROWS(frameData.get("frame-data-test-unknown"));
+    CHECK_THROWS(frameData.getInteger("frame-data-test-unknown"));
+    CHECK_THROWS(frameData.getFloat("frame-data-test-unknown"));
+    frameData.remove("frame-data-test-unknown");
+    CHECK(frameData.size() == 1);
+    // The next interned name gets the next key, thus the unknown name was not interned by the lookups above
+    const uint32_t key = FrameData::getKey("frame-data-test-next");
+    CHECK(FrameData::getKey("frame-data-test-unknown") == key + 1);
+}
+
 
 
 };
@@ -0,0 +1,111 @@
+#include <FAST/Testing.hpp>
+#include <FAST/Data/ImagePyramid.hpp>
+#include <FAST/Data/Image.hpp>
+#include <random>
+#include <algorithm>
+#include <cstdio>
+#include <tiffio.h>
+#include <QDir>
+
+using namespace fast;
+
+TEST_CASE("ImagePyramid deferred update of pyramid levels gives same result as propagating each patch", "[fast][ImagePyramid][wsi]") {
+    std::mt19937 generator(42);
+    std::uniform_int_distribution<int> distribution(0, 255);
+    for(int channels : {1, 3}) {
+        // Both memory mapped and TIFF backed pyramids
+        for(auto compression : {ImageCompression::UNSPECIFIED, ImageCompression::LZW}) {
+            auto propagated = ImagePyramid::create(8192, 8192, channels, 256, 256, "", compression);
+            auto deferred = ImagePyramid::create(8192, 8192, channels, 256, 256, "", compression);
+            REQUIRE(propagated->getNrOfLevels() > 1);
+            {
+                auto propagatedAccess = propagated->getAccess(ACCESS_READ_WRITE);
+                auto deferredAccess = deferred->getAccess(ACCESS_READ_WRITE);
+                // Write a region of 6x5 tiles which doesn't start at a tile of the next level
+                for(int y = 1; y < 6; ++y) {
+                    for(int x = 1; x < 7; ++x) {
+                        auto data = std::make_unique<uchar[]>(256*256*channels);
+                        for(int i = 0; i < 256*256*channels; ++i)
+                            data[i] = distribution(generator);
+                        auto patch = Image::create(256, 256, TYPE_UINT8, channels, std::move(data));
+                        propagatedAccess->setPatch(0, x*256, y*256, patch);
+                        deferredAccess->setPatch(0, x*256, y*256, patch, false);
+                    }
+                }
+                deferredAccess->updatePyramidLevels();
+            }
+            auto propagatedAccess = propagated->getAccess(ACCESS_READ);
+            auto deferredAccess = deferred->getAccess(ACCESS_READ);
+            for(int level = 1; level < propagated->getNrOfLevels(); ++level) {
+                auto expected = propagatedAccess->getPatchData(level, 0, 0, 1024, 1024);
+                auto result = deferredAccess->getPatchData(level, 0, 0, 1024, 1024);
+                int mismatches = 0;
+                for(int i = 0; i < 1024*1024*channels; ++i)
+                    mismatches += expected[i] != result[i];
+                CHECK(mismatches == 0);
+            }
+        }
+    }
+}
+
+TEST_CASE("Memory mapped ImagePyramid", "[fast][ImagePyramid][wsi]") {
+    auto pyramid = ImagePyramid::create(8192, 8192, 3, 256, 256);
+    CHECK(pyramid->usesMemoryMapping());
+    CHECK(!pyramid->usesTIFF());
+    CHECK(!ImagePyramid::create(8192, 8192, 3, 256, 256, "", ImageCompression::JPEG)->usesMemoryMapping());
+
+    std::mt19937 generator(42);
+    std::uniform_int_distribution<int> distribution(0, 255);
+    auto data = std::make_unique<uchar[]>(256*256*3);
+    for(int i = 0; i < 256*256*3; ++i)
+        data[i] = distribution(generator);
+    auto access = pyramid->getAccess(ACCESS_READ_WRITE);
+    access->setPatch(0, 512, 256, Image::create(256, 256, TYPE_UINT8, 3, data.get()));
+    CHECK(access->isPatchInitialized(0, 512, 256));
+    CHECK(!access->isPatchInitialized(0, 0, 0));
+    auto result = access->getPatchData(0, 512, 256, 256, 256);
+    CHECK(std::memcmp(result.get(), data.get(), 256*256*3) == 0);
+    // Tiles which are not written are zero
+    auto empty = access->getPatchData(0, 0, 0, 256, 256);
+    CHECK(std::all_of(empty.get(), empty.get() + 256*256*3, [](uchar value) { return value == 0; }));
+}
+
+TEST_CASE("ImagePyramid fills TIFF tiles which fail to decode with blank value and does not cache them", "[fast][ImagePyramid][wsi]") {
+    const std::string filename = join(QDir::tempPath().toStdString(), "FAST_corrupt_tile.tiff");
+    {
+        // Two uncompressed tiles, the second is truncated
+        TIFF* tiff = TIFFOpen(filename.c_str(), "w");
+        REQUIRE(tiff != nullptr);
+        TIFFSetField(tiff, TIFFTAG_IMAGEWIDTH, 512);
+        TIFFSetField(tiff, TIFFTAG_IMAGELENGTH, 256);
+        TIFFSetField(tiff, TIFFTAG_TILEWIDTH, 256);
+        TIFFSetField(tiff, TIFFTAG_TILELENGTH, 256);
+        TIFFSetField(tiff, TIFFTAG_SAMPLESPERPIXEL, 3);
+        TIFFSetField(tiff, TIFFTAG_BITSPERSAMPLE, 8);
+        TIFFSetField(tiff, TIFFTAG_PHOTOMETRIC, PHOTOMETRIC_RGB);
+        TIFFSetField(tiff, TIFFTAG_PLANARCONFIG, PLANARCONFIG_CONTIG);
+        TIFFSetField(tiff, TIFFTAG_COMPRESSION, COMPRESSION_NONE);
+        std::vector<uchar> tile(256*256*3, 100);
+        REQUIRE(TIFFWriteTile(tiff, tile.data(), 0, 0, 0, 0) > 0);
+        REQUIRE(TIFFWriteRawTile(tiff, 1, tile.data(), 16) > 0);
+        TIFFClose(tiff);
+    }
+    ImagePyramidLevel level;
+    level.width = 512;
+    level.height = 256;
+    auto pyramid = ImagePyramid::create(TIFFOpen(filename.c_str(), "rm"), std::vector<ImagePyramidLevel>{level}, 3);
+    {
+        auto access = pyramid->getAccess(ACCESS_READ);
+        for(int i = 0; i < 2; ++i) {
+            auto data = access->getPatchData(0, 0, 0, 512, 256);
+            for(int y = 0; y < 256; ++y) {
+                CHECK(std::all_of(&data[y*512*3], &data[(y*512 + 256)*3], [](uchar value) { return value == 100; }));
+                CHECK(std::all_of(&data[(y*512 + 256)*3], &data[(y + 1)*512*3], [](uchar value) { return value == 255; }));
+            }
+        }
+    }
+    CHECK(pyramid->getTileCache().get(0, 0, 0) != nullptr);
+    CHECK(pyramid->getTileCache().get(0, 1, 0) == nullptr);
+    pyramid.reset();
+    std::remove(filename.c_str());
+}
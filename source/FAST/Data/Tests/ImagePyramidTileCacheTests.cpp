@@ -0,0 +1,56 @@
+#include <FAST/Testing.hpp>
+#include <FAST/Data/ImagePyramidTileCache.hpp>
+
+using namespace fast;
+
+static std::shared_ptr<uchar[]> createTile(std::size_t bytes, uchar value) {
+    std::shared_ptr<uchar[]> tile(new uchar[bytes]);
+    std::memset(tile.get(), value, bytes);
+    return tile;
+}
+
+TEST_CASE("ImagePyramidTileCache get and put", "[fast][ImagePyramidTileCache][wsi]") {
+    ImagePyramidTileCache cache(1000);
+    CHECK(cache.get(0, 0, 0) == nullptr);
+    cache.put(0, 0, 0, createTile(100, 1), 100);
+    cache.put(1, 0, 0, createTile(100, 2), 100);
+    REQUIRE(cache.get(0, 0, 0) != nullptr);
+    CHECK(cache.get(0, 0, 0)[0] == 1);
+    CHECK(cache.get(1, 0, 0)[0] == 2);
+    CHECK(cache.get(0, 1, 0) == nullptr);
+    CHECK(cache.getSize() == 200);
+    CHECK(cache.getHits() == 3);
+    CHECK(cache.getMisses() == 2);
+
+    // Replace existing tile
+    cache.put(0, 0, 0, createTile(100, 3), 100);
+    CHECK(cache.get(0, 0, 0)[0] == 3);
+    CHECK(cache.getSize() == 200);
+
+    cache.remove(0, 0, 0);
+    CHECK(cache.get(0, 0, 0) == nullptr);
+    CHECK(cache.getSize() == 100);
+}
+
+TEST_CASE("ImagePyramidTileCache evicts least recently used tiles", "[fast][ImagePyramidTileCache][wsi]") {
+    ImagePyramidTileCache cache(300);
+    cache.put(0, 0, 0, createTile(100, 0), 100);
+    cache.put(0, 1, 0, createTile(100, 0), 100);
+    cache.put(0, 2, 0, createTile(100, 0), 100);
+    // Touch first tile, so that the second becomes least recently used
+    CHECK(cache.get(0, 0, 0) != nullptr);
+    cache.put(0, 3, 0, createTile(100, 0), 100);
+    CHECK(cache.getEvictions() == 1);
+    CHECK(cache.getSize() == 300);
+    CHECK(cache.get(0, 1, 0) == nullptr);
+    CHECK(cache.get(0, 0, 0) != nullptr);
+    CHECK(cache.get(0, 3, 0) != nullptr);
+
+    cache.setMaximumSize(100);
+    CHECK(cache.getSize() == 100);
+    CHECK(cache.getEvictions() == 3);
+
+    // Tiles larger than the cache are not stored
+    cache.put(0, 4, 0, createTile(200, 0), 200);
+    CHECK(cache.get(0, 4, 0) == nullptr);
+}
@@ -1346,6 +1346,43 @@ TEST_CASE("calculateAverageIntensity returns the average intensity of a 3D image
     //}
 }
 
+TEST_CASE("calculateStandardDeviationIntensity returns the std dev intensity of a 2D image stored on host" , "[fast][image]") {
+    unsigned int width = 31;
+    unsigned int height = 64;
+    unsigned int nrOfChannels = 1;
+    for(unsigned int typeNr = 0; typeNr < 5; typeNr++) {
+        DataType type = (DataType)typeNr;
+
+        // Create a data array with random data
+        void* data = allocateRandomData(width*height*nrOfChannels, type);
+
+        Image::pointer image = Image::create(width, height, type, nrOfChannels, Host::getInstance(), data);
+
+        float stddev = getStandardDeviationFromData(data, width*height*nrOfChannels, type);
+        REQUIRE_THAT(image->calculateStandardDeviationIntensity(), Catch::Matchers::WithinAbs(stddev, 0.01));
+        deleteArray(data, type);
+    }
+}
+
+TEST_CASE("Intensity statistics of image stored on host are updated when image changes" , "[fast][image]") {
+    std::vector<uchar> initialData(64*32, 2);
+    auto image = Image::create(64, 32, TYPE_UINT8, 1, Host::getInstance(), initialData.data());
+    CHECK(image->calculateMinimumIntensity() == 2);
+    CHECK(image->calculateMaximumIntensity() == 2);
+    CHECK(image->calculateAverageIntensity() == Approx(2));
+    CHECK(image->calculateStandardDeviationIntensity() == Approx(0));
+    {
+        auto access = image->getImageAccess(ACCESS_READ_WRITE);
+        uchar* data = (uchar*)access->get();
+        for(int i = 0; i < 64*32; i += 2)
+            data[i] = 4;
+    }
+    CHECK(image->calculateMinimumIntensity() == 2);
+    CHECK(image->calculateMaximumIntensity() == 4);
+    CHECK(image->calculateAverageIntensity() == Approx(3));
+    CHECK(image->calculateStandardDeviationIntensity() == Approx(1));
+}
+
 TEST_CASE("calculateMaximum/MinimumIntensity returns the maximum/minimum intensity of a 2D image stored as OpenCL image" , "[fast][image]") {
     DeviceManager* deviceManager = DeviceManager::getInstance();
     OpenCLDevice::pointer device = deviceManager->getOneOpenCLDevice();
@@ -0,0 +1,94 @@
+#include "FAST/Testing.hpp"
+#include "FAST/Data/MemoryPool.hpp"
+#include "FAST/Data/Image.hpp"
+#include "FAST/Data/Tensor.hpp"
+#include "FAST/Data/Access/ImageAccess.hpp"
+#include "FAST/DeviceManager.hpp"
+
+using namespace fast;
+
+TEST_CASE("Memory pool size classes", "[fast][MemoryPool]") {
+    CHECK(MemoryPool::getSizeClass(0) == 64);
+    CHECK(MemoryPool::getSizeClass(1) == 64);
+    CHECK(MemoryPool::getSizeClass(65) == 128);
+    CHECK(MemoryPool::getSizeClass(4096) == 4096);
+    CHECK(MemoryPool::getSizeClass(4097) == 5120);
+    CHECK(MemoryPool::getSizeClass(8192) == 8192);
+    CHECK(MemoryPool::getSizeClass(8193) == 10240);
+    for(std::size_t bytes : {100, 5000, 70000, 1000000, 12345678}) {
+        CHECK(MemoryPool::getSizeClass(bytes) >= bytes);
+        CHECK(MemoryPool::getSizeClass(bytes) <= bytes + bytes/4 + 64);
+    }
+}
+
+TEST_CASE("Memory pool reuses released host memory", "[fast][MemoryPool]") {
+    auto pool = MemoryPool::getInstance();
+    pool->clear();
+    void* first = pool->allocate(100000);
+    pool->deallocate(first, 100000);
+    const auto before = pool->getStatistics();
+    CHECK(before.hostCachedBytes >= 100000);
+    void* second = pool->allocate(99000); // Same size class
+    CHECK(second == first);
+    CHECK(pool->getStatistics().hostHits == before.hostHits + 1);
+    CHECK(((std::size_t)second % 64) == 0);
+    pool->deallocate(second, 99000);
+    pool->clear();
+    CHECK(pool->getStatistics().hostCachedBytes == 0);
+}
+
+TEST_CASE("Memory pool respects maximum host size", "[fast][MemoryPool]") {
+    auto pool = MemoryPool::getInstance();
+    pool->clear();
+    const auto maximum = pool->getMaximumHostSize();
+    pool->setMaximumHostSize(1024*1024);
+    void* first = pool->allocate(800*1024);
+    void* second = pool->allocate(800*1024);
+    pool->deallocate(first, 800*1024);
+    pool->deallocate(second, 800*1024);
+    CHECK(pool->getStatistics().hostCachedBytes <= 1024*1024);
+    pool->setMaximumHostSize(maximum);
+    pool->clear();
+}
+
+TEST_CASE("Memory pool disabled frees memory immediately", "[fast][MemoryPool]") {
+    auto pool = MemoryPool::getInstance();
+    pool->clear();
+    pool->setEnabled(false);
+    void* data = pool->allocate(4096);
+    pool->deallocate(data, 4096);
+    CHECK(pool->getStatistics().hostCachedBytes == 0);
+    pool->setEnabled(true);
+}
+
+TEST_CASE("Streaming images of same size reuse pooled host memory", "[fast][MemoryPool][image]") {
+    auto pool = MemoryPool::getInstance();
+    pool->clear();
+    {
+        auto image = Image::create(256, 256, TYPE_UINT8, 1);
+        image->fill(0);
+        auto access = image->getImageAccess(ACCESS_READ);
+    }
+    const auto before = pool->getStatistics();
+    for(int i = 0; i < 10; ++i) {
+        auto image = Image::create(256, 256, TYPE_UINT8, 1);
+        image->fill(i);
+        auto access = image->getImageAccess(ACCESS_READ);
+        CHECK(access->getScalar(Vector2i(10, 10)) == i);
+    }
+    const auto after = pool->getStatistics();
+    CHECK(after.hostMisses == before.hostMisses);
+    CHECK(after.hostHits >= before.hostHits + 10);
+    CHECK(after.deviceMisses == before.deviceMisses);
+}
+
+TEST_CASE("Tensor host data is allocated from memory pool", "[fast][MemoryPool][tensor]") {
+    auto pool = MemoryPool::getInstance();
+    pool->clear();
+    {
+        auto tensor = Tensor::create(TensorShape({64, 64}));
+    }
+    const auto before = pool->getStatistics();
+    auto tensor = Tensor::create(TensorShape({64, 64}));
+    CHECK(pool->getStatistics().hostHits == before.hostHits + 1);
+}
@@ -0,0 +1,99 @@
+#include "FAST/Testing.hpp"
+#include "FAST/Data/Tensor.hpp"
+
+using namespace fast;
+
+TEST_CASE("Tensor with external storage calls deleter when deleted", "[fast][tensor]") {
+    std::vector<float> storage = {1, 2, 3, 4, 5, 6};
+    bool released = false;
+    {
+        unique_tensor_ptr data(storage.data(), [&released](float*) { released = true; });
+        auto tensor = Tensor::create(std::move(data), TensorShape({2, 3}));
+        auto access = tensor->getAccess(ACCESS_READ);
+        CHECK(access->getRawData() == storage.data());
+        CHECK_FALSE(released);
+    }
+    CHECK(released);
+}
+
+TEST_CASE("Tensor view shares data with tensor", "[fast][tensor]") {
+    auto tensor = Tensor::create(TensorShape({3, 2, 2}));
+    {
+        auto access = tensor->getAccess(ACCESS_READ_WRITE);
+        float* data = access->getRawData();
+        for(int i = 0; i < 12; ++i)
+            data[i] = i;
+    }
+    auto view = tensor->getView(1);
+    REQUIRE(view->getShape().getDimensions() == 2);
+    CHECK(view->getShape()[0] == 2);
+    CHECK(view->getShape()[1] == 2);
+    {
+        auto access = view->getAccess(ACCESS_READ);
+        const float* data = access->getRawData();
+        for(int i = 0; i < 4; ++i)
+            CHECK(data[i] == 4 + i);
+    }
+    CHECK_THROWS(tensor->getView(3));
+
+    // View keeps the storage alive
+    std::weak_ptr<Tensor> weakTensor = tensor;
+    tensor.reset();
+    CHECK_FALSE(weakTensor.expired());
+    {
+        auto access = view->getAccess(ACCESS_READ);
+        CHECK(access->getRawData()[3] == 7);
+    }
+    view.reset();
+    CHECK(weakTensor.expired());
+}
+
+TEST_CASE("Tensor of other data types", "[fast][tensor]") {
+    auto tensor = Tensor::create(TensorShape({2, 3}), TYPE_UINT8);
+    CHECK(tensor->getDataType() == TYPE_UINT8);
+    {
+        auto access = tensor->getAccess(ACCESS_READ_WRITE);
+        CHECK(access->getDataType() == TYPE_UINT8);
+        CHECK_THROWS(access->getRawData());
+        uchar* data = (uchar*)access->get();
+        for(int i = 0; i < 6; ++i)
+            data[i] = i*50;
+    }
+    auto view = tensor->getView(1);
+    CHECK(view->getDataType() == TYPE_UINT8);
+    {
+        auto access = view->getAccess(ACCESS_READ);
+        CHECK(((uchar*)access->get())[0] == 150);
+    }
+
+    auto floatTensor = tensor->toDataType(TYPE_FLOAT);
+    CHECK(floatTensor->getDataType() == TYPE_FLOAT);
+    CHECK(floatTensor->toDataType(TYPE_FLOAT) == floatTensor);
+    {
+        auto access = floatTensor->getAccess(ACCESS_READ);
+        CHECK(access->getRawData()[5] == 250.0f);
+    }
+}
+
+TEST_CASE("Tensor data type conversion rounds and saturates", "[fast][tensor]") {
+    auto tensor = Tensor::create({-1.0f, 0.4f, 0.6f, 300.0f, 1.5f});
+    auto uint8Tensor = tensor->toDataType(TYPE_UINT8);
+    {
+        auto access = uint8Tensor->getAccess(ACCESS_READ);
+        const uchar* data = (const uchar*)access->get();
+        CHECK(data[0] == 0);
+        CHECK(data[1] == 0);
+        CHECK(data[2] == 1);
+        CHECK(data[3] == 255);
+        CHECK(data[4] == 2);
+    }
+    auto halfTensor = tensor->toDataType(TYPE_FLOAT16);
+    {
+        auto access = halfTensor->getAccess(ACCESS_READ);
+        const float16* data = (const float16*)access->get();
+        CHECK((float)data[0] == -1.0f);
+        CHECK((float)data[1] == Approx(0.4f).margin(1e-3));
+        CHECK((float)data[3] == 300.0f);
+        CHECK((float)data[4] == 1.5f);
+    }
+}
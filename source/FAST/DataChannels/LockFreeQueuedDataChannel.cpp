@@ -0,0 +1,215 @@
+#include "LockFreeQueuedDataChannel.hpp"
+#include <chrono>
+#include <thread>
+
+namespace fast {
+
+namespace {
+/**
+ * Spin first, then yield, and finally sleep while waiting, so that short waits are cheap
+ * and long waits do not occupy a CPU core.
+ */
+class Backoff {
+    public:
+        void wait() {
+            if(m_iteration < 64) {
+                ++m_iteration;
+            } else if(m_iteration < 128) {
+                ++m_iteration;
+                std::this_thread::yield();
+            } else {
+                std::this_thread::sleep_for(std::chrono::microseconds(100));
+            }
+        }
+    private:
+        int m_iteration = 0;
+};
+
+uint64_t microsecondsSince(std::chrono::high_resolution_clock::time_point start) {
+    return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::high_resolution_clock::now() - start).count();
+}
+}
+
+// The ring buffer is the bounded queue by Dmitry Vyukov, where each cell has a sequence number
+// telling whether it is ready to be written or read. It is used with a single producer and a single consumer,
+// but the producer may also remove the oldest frame when the queue policy is DropOldest.
+bool LockFreeQueuedDataChannel::tryEnqueue(DataObject::pointer& data) {
+    std::size_t position = m_enqueuePosition.load(std::memory_order_relaxed);
+    Cell* cell;
+    while(true) {
+        cell = &m_cells[position % m_capacity];
+        const std::size_t sequence = cell->sequence.load(std::memory_order_acquire);
+        const auto difference = (std::ptrdiff_t)sequence - (std::ptrdiff_t)position;
+        if(difference == 0) {
+            if(m_enqueuePosition.compare_exchange_weak(position, position + 1, std::memory_order_relaxed))
+                break;
+        } else if(difference < 0) {
+            return false; // Full
+        } else {
+            position = m_enqueuePosition.load(std::memory_order_relaxed);
+        }
+    }
+    cell->data = std::move(data);
+    cell->sequence.store(position + 1, std::memory_order_release);
+    return true;
+}
+
+bool LockFreeQueuedDataChannel::tryDequeue(DataObject::pointer& data) {
+    std::size_t position = m_dequeuePosition.load(std::memory_order_relaxed);
+    Cell* cell;
+    while(true) {
+        cell = &m_cells[position % m_capacity];
+        const std::size_t sequence = cell->sequence.load(std::memory_order_acquire);
+        const auto difference = (std::ptrdiff_t)sequence - (std::ptrdiff_t)(position + 1);
+        if(difference == 0) {
+            if(m_dequeuePosition.compare_exchange_weak(position, position + 1, std::memory_order_relaxed))
+                break;
+        } else if(difference < 0) {
+            return false; // Empty
+        } else {
+            position = m_dequeuePosition.load(std::memory_order_relaxed);
+        }
+    }
+    data = std::move(cell->data);
+    cell->data.reset();
+    cell->sequence.store(position + m_capacity, std::memory_order_release);
+    return true;
+}
+
+void LockFreeQueuedDataChannel::throwIfStopped() {
+    // If stop is signaled, throw an exception to stop the entire computation thread
+    if(m_stopped) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        throw ThreadStopped(m_errorMessage);
+    }
+}
+
+void LockFreeQueuedDataChannel::addFrame(DataObject::pointer data) {
+    throwIfStopped();
+
+    if(!tryEnqueue(data)) {
+        if(m_policy == QueuePolicy::DropNewest) {
+            ++m_droppedFrames;
+            return;
+        }
+        const auto start = std::chrono::high_resolution_clock::now();
+        Backoff backoff;
+        while(!tryEnqueue(data)) {
+            if(m_policy == QueuePolicy::DropOldest) {
+                // If this fails, the consumer got the frame first, and there is room now
+                DataObject::pointer oldest;
+                if(tryDequeue(oldest))
+                    ++m_droppedFrames;
+            } else {
+                throwIfStopped();
+                backoff.wait();
+            }
+        }
+        if(m_policy == QueuePolicy::Block)
+            m_producerWaitTime += microsecondsSince(start);
+    }
+
+    const int size = getSize();
+    int maximum = m_maximumOccupancy.load();
+    while(size > maximum && !m_maximumOccupancy.compare_exchange_weak(maximum, size)) {}
+}
+
+DataObject::pointer LockFreeQueuedDataChannel::getNextDataFrame() {
+    throwIfStopped();
+
+    if(m_hasFront) {
+        // getFrame has already taken the frame out of the queue
+        auto data = std::move(m_front);
+        m_front.reset();
+        m_hasFront = false;
+        return data;
+    }
+
+    DataObject::pointer data;
+    if(!tryDequeue(data)) {
+        const auto start = std::chrono::high_resolution_clock::now();
+        Backoff backoff;
+        while(!tryDequeue(data)) {
+            throwIfStopped();
+            backoff.wait();
+        }
+        m_consumerWaitTime += microsecondsSince(start);
+    }
+
+    return data;
+}
+
+int LockFreeQueuedDataChannel::getSize() {
+    const std::size_t dequeuePosition = m_dequeuePosition.load();
+    const std::size_t enqueuePosition = m_enqueuePosition.load();
+    return (int)(enqueuePosition - dequeuePosition) + (m_hasFront ? 1 : 0);
+}
+
+void LockFreeQueuedDataChannel::setMaximumNumberOfFrames(uint frames) {
+    if(getSize() > 0)
+        throw Exception("Have to call setMaximumNumberOfFrames before executing pipeline");
+    if(frames == 0)
+        throw Exception("Maximum number of frames in a queued data channel must be larger than 0");
+    m_capacity = frames;
+    m_cells = std::make_unique<Cell[]>(m_capacity);
+    for(std::size_t i = 0; i < m_capacity; ++i)
+        m_cells[i].sequence.store(i, std::memory_order_relaxed);
+    m_enqueuePosition = 0;
+    m_dequeuePosition = 0;
+}
+
+int LockFreeQueuedDataChannel::getMaximumNumberOfFrames() const {
+    return m_capacity;
+}
+
+void LockFreeQueuedDataChannel::setQueuePolicy(QueuePolicy policy) {
+    m_policy = policy;
+}
+
+QueuePolicy LockFreeQueuedDataChannel::getQueuePolicy() const {
+    return m_policy;
+}
+
+void LockFreeQueuedDataChannel::stop(std::string errorMessage) {
+    // Any producer or consumer waiting will see this flag and throw
+    DataChannel::stop(errorMessage);
+    m_stopped = true;
+}
+
+bool LockFreeQueuedDataChannel::hasCurrentData() {
+    if(m_hasFront)
+        return true;
+    if(tryDequeue(m_front)) {
+        m_hasFront = true;
+        return true;
+    }
+    return false;
+}
+
+DataObject::pointer LockFreeQueuedDataChannel::getFrame() {
+    if(!hasCurrentData())
+        throw Exception("No frames available in getFrame");
+    return m_front;
+}
+
+uint64_t LockFreeQueuedDataChannel::getDroppedFrames() const {
+    return m_droppedFrames;
+}
+
+int LockFreeQueuedDataChannel::getMaximumOccupancy() const {
+    return m_maximumOccupancy;
+}
+
+double LockFreeQueuedDataChannel::getProducerWaitTime() const {
+    return m_producerWaitTime / 1000.0;
+}
+
+double LockFreeQueuedDataChannel::getConsumerWaitTime() const {
+    return m_consumerWaitTime / 1000.0;
+}
+
+LockFreeQueuedDataChannel::LockFreeQueuedDataChannel() {
+    setMaximumNumberOfFrames(50);
+}
+
+}
@@ -0,0 +1,114 @@
+#pragma once
+
+#include <FAST/DataChannels/DataChannel.hpp>
+#include <atomic>
+#include <vector>
+
+namespace fast {
+
+/**
+ * @brief Defines what a queued data channel does when the queue is full
+ */
+enum class QueuePolicy {
+    Block, // The producer waits until there is space in the queue
+    DropOldest, // The oldest frame in the queue is removed to make room for the new frame
+    DropNewest // The new frame is discarded
+};
+
+/**
+ * This queued data channel implements the producer-consumer task
+ * using a bounded lock-free ring buffer. Producer and consumer only wait
+ * when the queue is full or empty, and then spin and yield instead of
+ * using kernel level synchronization.
+ * It can be used on the output data channels of streamers when streaming mode is
+ * PROCESS_ALL_FRAMES, and supports different policies for when the queue is full.
+ */
+class FAST_EXPORT LockFreeQueuedDataChannel : public DataChannel {
+    FAST_OBJECT(LockFreeQueuedDataChannel)
+    public:
+        /**
+         * Add frame to the data channel. This call will block
+         * if the buffer is full and the queue policy is Block.
+         */
+        void addFrame(DataObject::pointer data) override;
+
+        /**
+         * @return the number of frames stored in this DataChannel
+         */
+        int getSize() override;
+
+        /**
+         * Set the maximum nr of frames that can be stored in this data channel
+         */
+        void setMaximumNumberOfFrames(uint frames) override;
+
+        int getMaximumNumberOfFrames() const override;
+
+        /**
+         * Set what to do when a frame is added and the queue is full
+         * @param policy
+         */
+        void setQueuePolicy(QueuePolicy policy);
+        QueuePolicy getQueuePolicy() const;
+
+        /**
+         * @brief This will unblock if this DataChannel is currently blocking. Used to stop a pipeline.
+         * @param Error message to supply.
+         */
+        void stop(std::string errorMessage) override;
+
+        // TODO consider removing, it is equal to getSize() > 0 atm
+        bool hasCurrentData() override;
+
+        /**
+         * Get current frame, throws if current frame is not available.
+         * Must be called from the consumer thread.
+         */
+        DataObject::pointer getFrame() override;
+
+        /**
+         * @return the number of frames discarded because the queue was full
+         */
+        uint64_t getDroppedFrames() const;
+        /**
+         * @return the highest number of frames stored in the queue at the same time
+         */
+        int getMaximumOccupancy() const;
+        /**
+         * @return total time in milliseconds the producer has waited for a full queue
+         */
+        double getProducerWaitTime() const;
+        /**
+         * @return total time in milliseconds the consumer has waited for an empty queue
+         */
+        double getConsumerWaitTime() const;
+    protected:
+        struct Cell {
+            std::atomic<std::size_t> sequence;
+            DataObject::pointer data;
+        };
+        bool tryEnqueue(DataObject::pointer& data);
+        bool tryDequeue(DataObject::pointer& data);
+        void throwIfStopped();
+
+        std::unique_ptr<Cell[]> m_cells;
+        std::size_t m_capacity = 0;
+        alignas(64) std::atomic<std::size_t> m_enqueuePosition = {0};
+        alignas(64) std::atomic<std::size_t> m_dequeuePosition = {0};
+        // Frame taken out of the queue by getFrame, but not yet returned by getNextDataFrame
+        DataObject::pointer m_front;
+        std::atomic_bool m_hasFront = {false};
+        std::atomic_bool m_stopped = {false};
+        QueuePolicy m_policy = QueuePolicy::Block;
+
+        std::atomic<uint64_t> m_droppedFrames = {0};
+        std::atomic_int m_maximumOccupancy = {0};
+        std::atomic<uint64_t> m_producerWaitTime = {0}; // microseconds
+        std::atomic<uint64_t> m_consumerWaitTime = {0}; // microseconds
+
+        DataObject::pointer getNextDataFrame() override;
+        LockFreeQueuedDataChannel();
+
+};
+
+}
@@ -30,7 +30,8 @@ void HDF5TensorExporter::execute() {
 	if(m_filename.empty())
 		throw Exception("HDF5TensorExporter needs a filename to be set.");
 
-	auto tensor = getInputData<Tensor>();
+	// Tensors are stored as float, thus half precision and quantized tensors are converted first
+	auto tensor = getInputData<Tensor>()->toDataType(TYPE_FLOAT);
 
 	auto shape = tensor->getShape();
 	if(shape.getUnknownDimensions() > 0)
@@ -5,6 +5,7 @@
 #include <FAST/Algorithms/ImagePatch/PatchGenerator.hpp>
 #include <FAST/Exporters/ImageExporter.hpp>
 #include <utility>
+#include <sstream>
 
 namespace fast {
 
@@ -47,14 +48,17 @@ void ImagePyramidPatchExporter::execute() {
 
 void ImagePyramidPatchExporter::exportPatch(std::shared_ptr<Image> patch) {
     auto level = patch->getFrameData("patch-level");
-    auto patchX = std::stoi(patch->getFrameData("patchid-x"));
-    auto patchY = std::stoi(patch->getFrameData("patchid-y"));
-    auto patchWidth = std::stoi(patch->getFrameData("patch-width"));
-    auto patchHeight = std::stoi(patch->getFrameData("patch-height"));
-    auto patchOverlapX = std::stoi(patch->getFrameData("patch-overlap-x"));
-    auto patchOverlapY = std::stoi(patch->getFrameData("patch-overlap-y"));
-    auto spacingX = patch->getFrameData("patch-spacing-x");
-    auto spacingY = patch->getFrameData("patch-spacing-y");
+    auto patchX = patch->getFrameData<int>("patchid-x");
+    auto patchY = patch->getFrameData<int>("patchid-y");
+    auto patchWidth = patch->getFrameData<int>("patch-width");
+    auto patchHeight = patch->getFrameData<int>("patch-height");
+    auto patchOverlapX = patch->getFrameData<int>("patch-overlap-x");
+    auto patchOverlapY = patch->getFrameData<int>("patch-overlap-y");
+    // Spacing of WSIs can be very small, use fixed precision to avoid rounding in the file name
+    std::ostringstream spacingStream;
+    spacingStream.precision(32);
+    spacingStream << std::fixed << patch->getFrameData<double>("patch-spacing-x") << "_" << patch->getFrameData<double>("patch-spacing-y");
+    auto spacing = spacingStream.str();
     auto totalWidth = patch->getFrameData("original-width");
     auto totalHeight = patch->getFrameData("original-height");
     // Calculate offset
@@ -62,7 +66,7 @@ void ImagePyramidPatchExporter::exportPatch(std::shared_ptr<Image> patch) {
     auto y = patchY*(patchHeight - patchOverlapY*2) + patchOverlapY;
     auto width = patch->getWidth() - patchOverlapX*2;
     auto height = patch->getHeight() - patchOverlapY*2;
-    std::string patchName = "patch_" + totalWidth + "_" + totalHeight + "_" + level + "_" + std::to_string(x) + "_" + std::to_string(y) + "_" + spacingX + "_" + spacingY + ".png";
+    std::string patchName = "patch_" + totalWidth + "_" + totalHeight + "_" + level + "_" + std::to_string(x) + "_" + std::to_string(y) + "_" + spacing + ".png";
     if(patchOverlapX > 0 || patchOverlapY > 0) {
         // Crop image first to deal with overlap
         patch = patch->crop(Vector2i(patchOverlapX, patchOverlapY), Vector2i(width, height));
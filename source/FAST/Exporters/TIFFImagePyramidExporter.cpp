@@ -1,8 +1,8 @@
 #include <tiffio.h>
 #include <FAST/Data/ImagePyramid.hpp>
 #include <FAST/Data/Image.hpp>
-#include <FAST/Algorithms/ImagePatch/PatchGenerator.hpp>
 #include <QFile>
+#include <jpeglib.h>
 #include "TIFFImagePyramidExporter.hpp"
 
 
@@ -12,6 +12,149 @@ void fast::TIFFImagePyramidExporter::loadAttributes() {
     FileExporter::loadAttributes();
 }
 
+namespace {
+
+void jpegCompressErrorExit(j_common_ptr cinfo) {
+    char message[JMSG_LENGTH_MAX];
+    (*(cinfo->err->format_message))(cinfo, message);
+    throw Exception("JPEG compression error: " + std::string(message));
+}
+
+/**
+ * Compress a tile to a complete JPEG stream, which is a valid TIFF JPEG tile.
+ * Like libtiff, RGB is stored without conversion to YCbCr to match the RGB photometric interpretation.
+ */
+std::vector<uchar> compressJPEG(const uchar* data, int width, int height, int channels, int quality) {
+    jpeg_compress_struct cinfo;
+    jpeg_error_mgr jerr;
+    cinfo.err = jpeg_std_error(&jerr);
+    jerr.error_exit = jpegCompressErrorExit;
+    unsigned char* buffer = nullptr;
+    unsigned long size = 0;
+    jpeg_create_compress(&cinfo);
+    try {
+        jpeg_mem_dest(&cinfo, &buffer, &size);
+        cinfo.image_width = width;
+        cinfo.image_height = height;
+        cinfo.input_components = channels;
+        cinfo.in_color_space = channels == 1 ? JCS_GRAYSCALE : JCS_RGB;
+        jpeg_set_defaults(&cinfo);
+        jpeg_set_colorspace(&cinfo, cinfo.in_color_space);
+        jpeg_set_quality(&cinfo, quality, TRUE);
+        jpeg_start_compress(&cinfo, TRUE);
+        while(cinfo.next_scanline < cinfo.image_height) {
+            JSAMPROW row = (JSAMPROW)&data[(std::size_t)cinfo.next_scanline*width*channels];
+            jpeg_write_scanlines(&cinfo, &row, 1);
+        }
+        jpeg_finish_compress(&cinfo);
+    } catch(...) {
+        jpeg_destroy_compress(&cinfo);
+        std::free(buffer);
+        throw;
+    }
+    jpeg_destroy_compress(&cinfo);
+    std::vector<uchar> result(buffer, buffer + size);
+    std::free(buffer);
+    return result;
+}
+
+/**
+ * LZW compression of a tile, as done by libtiff: MSB first codes of 9-12 bits, which grow one code
+ * early, starting with a clear code and ending with an end of information code.
+ */
+std::vector<uchar> compressLZW(const uchar* data, std::size_t size) {
+    const int clearCode = 256;
+    const int endOfInformationCode = 257;
+    const int firstCode = 258;
+    const int maxCode = 4095;
+    // Hash table of (prefix code, byte) -> code, with linear probing
+    const int hashSize = 9001;
+    std::vector<int32_t> keys(hashSize, -1);
+    std::vector<uint16_t> codes(hashSize);
+
+    std::vector<uchar> output;
+    output.reserve(size / 2 + 16);
+    uint64_t bits = 0;
+    int nrOfBits = 0;
+    int codeSize = 9;
+    int maxCodeForSize = 511;
+    int nextCode = firstCode;
+    auto put = [&](int code) {
+        bits = (bits << codeSize) | code;
+        nrOfBits += codeSize;
+        while(nrOfBits >= 8) {
+            output.push_back((uchar)((bits >> (nrOfBits - 8)) & 0xff));
+            nrOfBits -= 8;
+        }
+        bits &= (1 << nrOfBits) - 1;
+    };
+    auto reset = [&]() {
+        std::fill(keys.begin(), keys.end(), -1);
+        nextCode = firstCode;
+    };
+    // Called after a code has been added to the table
+    auto codeAdded = [&]() {
+        if(nextCode == maxCode - 1) {
+            // Table is full, emit clear code and start again
+            put(clearCode);
+            reset();
+            codeSize = 9;
+            maxCodeForSize = 511;
+        } else if(nextCode > maxCodeForSize) {
+            ++codeSize;
+            maxCodeForSize = (1 << codeSize) - 1;
+        }
+    };
+
+    put(clearCode);
+    if(size > 0) {
+        int prefix = data[0];
+        for(std::size_t i = 1; i < size; ++i) {
+            const int value = data[i];
+            const int32_t key = (prefix << 8) | value;
+            int hash = key % hashSize;
+            while(keys[hash] != -1 && keys[hash] != key)
+                hash = hash + 1 == hashSize ? 0 : hash + 1;
+            if(keys[hash] == key) {
+                prefix = codes[hash];
+                continue;
+            }
+            put(prefix);
+            prefix = value;
+            keys[hash] = key;
+            codes[hash] = nextCode++;
+            codeAdded();
+        }
+        put(prefix);
+        ++nextCode;
+        if(nextCode == maxCode - 1) {
+            put(clearCode);
+            codeSize = 9;
+        } else if(nextCode > maxCodeForSize) {
+            ++codeSize;
+        }
+    }
+    put(endOfInformationCode);
+    if(nrOfBits > 0)
+        output.push_back((uchar)((bits << (8 - nrOfBits)) & 0xff));
+    return output;
+}
+
+std::vector<uchar> compressTile(const uchar* data, int width, int height, int channels, ImageCompression compression) {
+    switch(compression) {
+        case ImageCompression::JPEG:
+            return compressJPEG(data, width, height, channels, 75);
+        case ImageCompression::LZW:
+            return compressLZW(data, (std::size_t)width*height*channels);
+        case ImageCompression::RAW:
+            return std::vector<uchar>(data, data + (std::size_t)width*height*channels);
+        default:
+            throw NotImplementedException();
+    }
+}
+
+}
+
 void TIFFImagePyramidExporter::execute() {
     if(m_filename.empty())
         throw Exception("Must set filename in TIFFImagePyramidExporter");
@@ -21,21 +164,35 @@ void TIFFImagePyramidExporter::execute() {
     if(imagePyramid == nullptr) {
         reportInfo() << "Data given to TIFFImagePyramidExporter was an Image, not an ImagePyramid, converting ..." << reportEnd();
         auto image = std::dynamic_pointer_cast<Image>(input);
-        imagePyramid = ImagePyramid::create(image->getWidth(), image->getHeight(), image->getNrOfChannels(), 256, 256);
+        if(image->getDataType() != TYPE_UINT8)
+            throw Exception("TIFFImagePyramidExporter only supports images of type uint8");
+        const int channels = image->getNrOfChannels();
+        imagePyramid = ImagePyramid::create(image->getWidth(), image->getHeight(), channels, 256, 256);
         imagePyramid->setSpacing(image->getSpacing());
         SceneGraph::setParentNode(imagePyramid, image);
         auto access = imagePyramid->getAccess(ACCESS_READ_WRITE);
+        auto imageAccess = image->getImageAccess(ACCESS_READ);
+        const auto imageData = (const uchar*)imageAccess->get();
+        // Copy tiles directly from the image on the host, padded to the full tile size.
+        // The coarser levels are built once at the end.
+        auto tile = std::make_unique<uchar[]>(256*256*channels);
         for(int y = 0; y < image->getHeight(); y += 256) {
             for(int x = 0; x < image->getWidth(); x += 256) {
-                auto width = std::min(image->getWidth() - x - 1, 256);
-                auto height = std::min(image->getHeight() - y - 1, 256);
-                access->setPatch(0, x, y, image->crop(Vector2i(x, y), Vector2i(width, height)));
+                const int width = std::min(image->getWidth() - x, 256);
+                const int height = std::min(image->getHeight() - y, 256);
+                if(width < 256 || height < 256)
+                    std::memset(tile.get(), channels >= 3 ? 255 : 0, 256*256*channels);
+                for(int row = 0; row < height; ++row)
+                    std::memcpy(&tile[row*256*channels], &imageData[((std::size_t)(y + row)*image->getWidth() + x)*channels], width*channels);
+                access->setPatch(0, x, y, Image::create(256, 256, TYPE_UINT8, channels, tile.get()), false);
             }
         }
+        access->updatePyramidLevels();
     }
 
     if(imagePyramid->usesTIFF()) {
         // If image pyramid is using TIFF backend. It is already stored on disk, we just need to copy it..
+        // This copies the compressed tiles verbatim.
         if(fileExists(m_filename)) {
             // If destination file already exists, we have to remove the existing file, or copy will not run.
             QFile::remove(m_filename.c_str());
@@ -43,7 +200,7 @@ void TIFFImagePyramidExporter::execute() {
         QFile::copy(imagePyramid->getTIFFPath().c_str(), m_filename.c_str());
         return;
     }
-    // If not, we need to do a patch based copy
+    // If not, we need to do a tile based copy
 
     const Vector3f spacing = imagePyramid->getSpacing();
 
@@ -61,17 +218,19 @@ void TIFFImagePyramidExporter::execute() {
 
     uint photometric = PHOTOMETRIC_RGB;
     uint bitsPerSample = 8;
-    uint samplesPerPixel = 3; // RGBA image pyramid is converted to RGB with getPatchAsImage
+    uint samplesPerPixel = 3; // RGBA image pyramid is converted to RGB
     if(imagePyramid->getNrOfChannels() == 1) {
         photometric = PHOTOMETRIC_MINISBLACK; // Photometric mask causes crash..
         samplesPerPixel = 1;
     }
+    const int inputChannels = imagePyramid->getNrOfChannels();
 
-    auto tiff = TIFFOpen(m_filename.c_str(), "w8");
+    auto tiff = TIFFOpen(m_filename.c_str(), "w8"); // BigTIFF
     if(tiff == nullptr) {
         throw Exception("Unable to open file " + m_filename + " in TIFFImagePyramidExporter");
     }
 
+    auto access = imagePyramid->getAccess(ACCESS_READ);
     // For each level, we need to 1) write fields, 2) write tiles
     // We have to go from highest res level first
     for(int level = 0; level < imagePyramid->getNrOfLevels(); ++level) {
@@ -106,10 +265,14 @@ void TIFFImagePyramidExporter::execute() {
                 break;
         }
 
-        TIFFSetField(tiff, TIFFTAG_TILEWIDTH, imagePyramid->getLevelTileWidth(level));
-        TIFFSetField(tiff, TIFFTAG_TILELENGTH, imagePyramid->getLevelTileHeight(level));
-        TIFFSetField(tiff, TIFFTAG_IMAGEWIDTH, imagePyramid->getLevelWidth(level));
-        TIFFSetField(tiff, TIFFTAG_IMAGELENGTH, imagePyramid->getLevelHeight(level));
+        const int tileWidth = imagePyramid->getLevelTileWidth(level);
+        const int tileHeight = imagePyramid->getLevelTileHeight(level);
+        const int levelWidth = imagePyramid->getLevelWidth(level);
+        const int levelHeight = imagePyramid->getLevelHeight(level);
+        TIFFSetField(tiff, TIFFTAG_TILEWIDTH, tileWidth);
+        TIFFSetField(tiff, TIFFTAG_TILELENGTH, tileHeight);
+        TIFFSetField(tiff, TIFFTAG_IMAGEWIDTH, levelWidth);
+        TIFFSetField(tiff, TIFFTAG_IMAGELENGTH, levelHeight);
         if(spacing.x() != 1 && spacing.y() != 1) { // Spacing == 1 means not set.
             TIFFSetField(tiff, TIFFTAG_RESOLUTIONUNIT, RESUNIT_CENTIMETER);
             float scaleX = (float) imagePyramid->getFullWidth() / imagePyramid->getLevelWidth(level);
@@ -120,49 +283,69 @@ void TIFFImagePyramidExporter::execute() {
                          1.0f / (spacing.y() / 10) * scaleY); // Convert to cm, and adjust for level
         }
 
-        std::cout << "starting patch gen" << std::endl;
-        auto generator = PatchGenerator::New();
-        generator->setInputData(imagePyramid);
-        generator->setPatchLevel(level);
-        generator->setPatchSize(imagePyramid->getLevelTileWidth(level), imagePyramid->getLevelTileHeight(level));
-        auto stream = DataStream(generator);
-
-        Image::pointer image;
-        int counter = 0;
-        while(!stream.isDone()) {
-            image = stream.getNextFrame<Image>();
-
-            // Write tile to tiff level
-            if(image->getWidth() != imagePyramid->getLevelTileWidth(level) || image->getHeight() != imagePyramid->getLevelTileHeight(level)) {
-                // Have to pad the image, TIFF expects all tiles to be equal
-                // TODO improve
-                auto paddedImage = Image::create(imagePyramid->getLevelTileWidth(level), imagePyramid->getLevelTileHeight(level), image->getDataType(), image->getNrOfChannels());
-                if(imagePyramid->getNrOfChannels() >= 3) {
-                    paddedImage->fill(255);
-                } else {
-                    paddedImage->fill(0);
-                }
-                auto device = std::dynamic_pointer_cast<OpenCLDevice>(getMainDevice());
-                {
-                    auto dest = paddedImage->getOpenCLImageAccess(ACCESS_READ_WRITE, device);
-                    auto src = image->getOpenCLImageAccess(ACCESS_READ, device);
-                    device->getCommandQueue().enqueueCopyImage(*src->get2DImage(), *dest->get2DImage(),
-                                                               createOrigoRegion(), createOrigoRegion(),
-                                                               createRegion(image->getSize()));
-                    device->getCommandQueue().finish();
+        // Tiles are read and compressed in parallel, then written in order by this thread
+        const int tilesX = std::ceil((float)levelWidth / tileWidth);
+        const int tilesY = std::ceil((float)levelHeight / tileHeight);
+        const int nrOfTiles = tilesX*tilesY;
+        const int batchSize = 256;
+        for(int start = 0; start < nrOfTiles; start += batchSize) {
+            const int end = std::min(start + batchSize, nrOfTiles);
+            std::vector<std::vector<uchar>> compressedTiles(end - start);
+            std::exception_ptr exception;
+            mRuntimeManager->startRegularTimer("TIFF compress");
+            #pragma omp parallel for schedule(dynamic)
+            for(int i = start; i < end; ++i) {
+                // Exceptions can't leave an OpenMP loop, rethrow the first one after the loop
+                try {
+                    const int x = (i % tilesX)*tileWidth;
+                    const int y = (i / tilesX)*tileHeight;
+                    const int width = std::min(tileWidth, levelWidth - x);
+                    const int height = std::min(tileHeight, levelHeight - y);
+                    auto data = access->getPatchData(level, x, y, width, height);
+                    // TIFF expects all tiles to have the same size, pad tiles at the edge. RGBA/BGRA is converted to RGB.
+                    auto tile = std::make_unique<uchar[]>((std::size_t)tileWidth*tileHeight*samplesPerPixel);
+                    if(width < tileWidth || height < tileHeight)
+                        std::memset(tile.get(), samplesPerPixel == 3 ? 255 : 0, (std::size_t)tileWidth*tileHeight*samplesPerPixel);
+                    for(int row = 0; row < height; ++row) {
+                        const uchar* inputRow = &data[(std::size_t)row*width*inputChannels];
+                        uchar* outputRow = &tile[(std::size_t)row*tileWidth*samplesPerPixel];
+                        if(inputChannels == samplesPerPixel) {
+                            std::memcpy(outputRow, inputRow, width*samplesPerPixel);
+                        } else if(imagePyramid->isBGRA()) {
+                            for(int px = 0; px < width; ++px) {
+                                outputRow[px*3 + 0] = inputRow[px*4 + 2];
+                                outputRow[px*3 + 1] = inputRow[px*4 + 1];
+                                outputRow[px*3 + 2] = inputRow[px*4 + 0];
+                            }
+                        } else {
+                            for(int px = 0; px < width; ++px) {
+                                for(int c = 0; c < 3; ++c)
+                                    outputRow[px*3 + c] = inputRow[px*inputChannels + c];
+                            }
+                        }
+                    }
+                    compressedTiles[i - start] = compressTile(tile.get(), tileWidth, tileHeight, samplesPerPixel, compression);
+                } catch(...) {
+                    #pragma omp critical
+                    if(!exception)
+                        exception = std::current_exception();
                 }
-                if(image->isLastFrame())
-                    paddedImage->setLastFrame("PatchGenerator");
-                image = paddedImage;
             }
-            auto data = image->getImageAccess(ACCESS_READ)->get();
-            std::size_t byteSize = getSizeOfDataType(image->getDataType(), image->getNrOfChannels())*image->getNrOfVoxels();
+            mRuntimeManager->stopRegularTimer("TIFF compress");
+            if(exception) {
+                TIFFClose(tiff);
+                std::rethrow_exception(exception);
+            }
             mRuntimeManager->startRegularTimer("TIFF write");
-            TIFFWriteEncodedTile(tiff, counter, data, byteSize);
+            for(int i = start; i < end; ++i) {
+                auto& compressedTile = compressedTiles[i - start];
+                if(TIFFWriteRawTile(tiff, i, compressedTile.data(), compressedTile.size()) < 0) {
+                    TIFFClose(tiff);
+                    throw Exception("Failed to write tile to " + m_filename + " in TIFFImagePyramidExporter");
+                }
+            }
             mRuntimeManager->stopRegularTimer("TIFF write");
-            ++counter;
-            mRuntimeManager->printAll();
-        } while(!image->isLastFrame());
+        }
 
         TIFFWriteDirectory(tiff);
     }
@@ -11,6 +11,9 @@
 #include <FAST/Algorithms/ImagePatch/PatchStitcher.hpp>
 #include <FAST/Importers/TIFFImagePyramidImporter.hpp>
 #include <FAST/Algorithms/TissueSegmentation/TissueSegmentation.hpp>
+#include <atomic>
+#include <cstdio>
+#include <thread>
 
 using namespace fast;
 
@@ -32,6 +35,45 @@ TEST_CASE("TIFFImagePyramidExporter", "[fast][TIFFImagePyramidExporter][wsi][vis
     exporter->getAllRuntimes()->printAll();
 }
 
+TEST_CASE("Concurrent tile reading of TIFF image pyramid", "[fast][TIFFImagePyramidExporter][TIFFImagePyramidImporter][wsi]") {
+    auto importer = WholeSlideImageImporter::create(Config::getTestDataPath() + "/WSI/A05.svs");
+    auto exporter = TIFFImagePyramidExporter::create("image-pyramid-concurrent-test.tiff")
+            ->connect(importer);
+    exporter->run();
+
+    auto wsi = TIFFImagePyramidImporter::create("image-pyramid-concurrent-test.tiff")->runAndGetOutputData<ImagePyramid>();
+    const int level = wsi->getNrOfLevels()-1;
+    const int tilesX = wsi->getLevelTilesX(level);
+    const int tilesY = wsi->getLevelTilesY(level);
+
+    // Read all tiles through the single shared handle first
+    wsi->setMaximumNumberOfReadHandles(0);
+    std::vector<std::unique_ptr<uchar[]>> reference;
+    {
+        auto access = wsi->getAccess(ACCESS_READ);
+        for(int i = 0; i < tilesX*tilesY; ++i)
+            reference.push_back(access->getPatch(level, i % tilesX, i / tilesX).data);
+    }
+
+    // Then read the same tiles concurrently using the handle pool
+    wsi->setMaximumNumberOfReadHandles(4);
+    std::atomic_int mismatches(0);
+    std::vector<std::thread> threads;
+    for(int t = 0; t < 4; ++t) {
+        threads.emplace_back([&, t]() {
+            auto access = wsi->getAccess(ACCESS_READ);
+            for(int i = t; i < tilesX*tilesY; i += 4) {
+                auto patch = access->getPatch(level, i % tilesX, i / tilesX);
+                if(std::memcmp(patch.data.get(), reference[i].get(), patch.width*patch.height*wsi->getNrOfChannels()) != 0)
+                    ++mismatches;
+            }
+        });
+    }
+    for(auto& thread : threads)
+        thread.join();
+    CHECK(mismatches == 0);
+}
+
 TEST_CASE("TIFFImagePyramidExporter segmentation2", "[fast][TIFFImagePyramidExporter][wsi][visual]") {
     auto importer = WholeSlideImageImporter::create(Config::getTestDataPath() + "/WSI/A05.svs");
     //importer->setFilename("/home/smistad/Downloads/OS-1.tiff");
@@ -114,4 +156,73 @@ TEST_CASE("TIFFImagePyramidExporter segmentation", "[fast][TIFFImagePyramidExpor
     window->set2DMode();
     window->start();
     exporter->getAllRuntimes()->printAll();
-}*/
\ No newline at end of file
+}*/
+TEST_CASE("TIFFImagePyramidExporter with parallel tile compression is lossless with LZW", "[fast][TIFFImagePyramidExporter]") {
+    for(int channels : {1, 3}) {
+        // Image which is not a multiple of the tile size
+        const int width = 1000;
+        const int height = 700;
+        auto data = std::make_unique<uchar[]>(width*height*channels);
+        for(int i = 0; i < width*height*channels; ++i)
+            data[i] = (uchar)((i / channels) % width + (i / (width*channels))*3 + i % channels);
+        auto image = Image::create(width, height, TYPE_UINT8, channels, data.get());
+
+        const std::string filename = "image-pyramid-lzw-test-" + std::to_string(channels) + ".tiff";
+        TIFFImagePyramidExporter::create(filename, ImageCompression::LZW)->connect(image)->run();
+
+        auto wsi = TIFFImagePyramidImporter::create(filename)->runAndGetOutputData<ImagePyramid>();
+        REQUIRE(wsi->getFullWidth() == width);
+        REQUIRE(wsi->getFullHeight() == height);
+        REQUIRE(wsi->getNrOfChannels() == channels);
+        auto access = wsi->getAccess(ACCESS_READ);
+        auto result = access->getPatchData(0, 0, 0, width, height);
+        CHECK(std::memcmp(result.get(), data.get(), width*height*channels) == 0);
+        std::remove(filename.c_str());
+    }
+}
+
+TEST_CASE("TIFFImagePyramidExporter compresses tiles of non-TIFF image pyramid", "[fast][TIFFImagePyramidExporter][wsi]") {
+    // OpenSlide image pyramids are not TIFF backed, thus all tiles are read, converted from BGRA to RGB and compressed
+    auto wsi = WholeSlideImageImporter::create(Config::getTestDataPath() + "/WSI/A05.svs")->runAndGetOutputData<ImagePyramid>();
+    REQUIRE_FALSE(wsi->usesTIFF());
+    const int inputChannels = wsi->getNrOfChannels();
+    for(auto compression : {ImageCompression::LZW, ImageCompression::JPEG}) {
+        const std::string filename = std::string("image-pyramid-") + (compression == ImageCompression::LZW ? "lzw" : "jpeg") + "-wsi-test.tiff";
+        TIFFImagePyramidExporter::create(filename, compression)->connect(wsi)->run();
+
+        auto result = TIFFImagePyramidImporter::create(filename)->runAndGetOutputData<ImagePyramid>();
+        REQUIRE(result->getNrOfLevels() == wsi->getNrOfLevels());
+        REQUIRE(result->getNrOfChannels() == 3);
+        auto inputAccess = wsi->getAccess(ACCESS_READ);
+        auto resultAccess = result->getAccess(ACCESS_READ);
+        // Compare the entire lowest resolution level, and a region spanning several tiles of the highest resolution level
+        for(int level : {result->getNrOfLevels() - 1, 0}) {
+            REQUIRE(result->getLevelWidth(level) == wsi->getLevelWidth(level));
+            REQUIRE(result->getLevelHeight(level) == wsi->getLevelHeight(level));
+            const int width = std::min(wsi->getLevelWidth(level), 1000);
+            const int height = std::min(wsi->getLevelHeight(level), 1000);
+            const int x = (wsi->getLevelWidth(level) - width) / 2;
+            const int y = (wsi->getLevelHeight(level) - height) / 2;
+            auto input = inputAccess->getPatchData(level, x, y, width, height);
+            auto output = resultAccess->getPatchData(level, x, y, width, height);
+            std::size_t mismatches = 0;
+            double difference = 0.0;
+            for(int i = 0; i < width*height; ++i) {
+                for(int c = 0; c < 3; ++c) {
+                    const int inputChannel = wsi->isBGRA() ? 2 - c : c;
+                    const int diff = std::abs((int)input[i*inputChannels + inputChannel] - (int)output[i*3 + c]);
+                    if(diff != 0)
+                        ++mismatches;
+                    difference += diff;
+                }
+            }
+            if(compression == ImageCompression::LZW) {
+                CHECK(mismatches == 0);
+            } else {
+                // JPEG is lossy
+                CHECK(difference / (width*height*3) < 8.0);
+            }
+        }
+        std::remove(filename.c_str());
+    }
+}
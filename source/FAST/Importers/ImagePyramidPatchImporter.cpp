@@ -80,8 +80,9 @@ void ImagePyramidPatchImporter::execute() {
             throw Exception("Incorrect position retrieved from filename :" + patchFilename);
         const auto endX = startX + patch->getWidth();
         const auto endY = startY + patch->getHeight();
-        outputAccess->setPatch(0, startX, startY, patch);
+        outputAccess->setPatch(0, startX, startY, patch, false);
     }
+    outputAccess->updatePyramidLevels();
 
     addOutputData(0, pyramid);
 }
@@ -279,7 +279,7 @@ void WholeSlideImageImporter::readVSI(std::string filename) {
         levelList.push_back(levelData);
     }
 
-    auto image = ImagePyramid::create(stream, tiles, levelList, compressionFormat);
+    auto image = ImagePyramid::create(stream, tiles, levelList, compressionFormat, etsFilename);
 
     addOutputData(0, image);
 }
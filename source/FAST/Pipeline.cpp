@@ -1,6 +1,7 @@
 #include "Pipeline.hpp"
 #include "FAST/Config.hpp"
 #include "ProcessObject.hpp"
+#include "PipelineExecutor.hpp"
 #include <QDirIterator>
 #include <fstream>
 #include <QLabel>
@@ -516,7 +517,7 @@ DataObject::pointer Pipeline::getPipelineOutputData(std::string name, std::funct
             data = PO->runAndGetOutputData(port);
             if(progressFunction != nullptr) {
                 // Report progress
-                progressFunction(std::stof(data->getFrameData("progress")));
+                progressFunction(data->getFrameData<float>("progress"));
             }
         } while(!data->isLastFrame());
     }
@@ -543,7 +544,7 @@ std::map<std::string, DataObject::pointer> Pipeline::getAllPipelineOutputData(st
                 result[name] = PO->runAndGetOutputData(output.second, executeToken);
                 if(progressFunction != nullptr) {
                     // Report progress
-                    progressFunction(std::stof(result[name]->getFrameData("progress")));
+                    progressFunction(result[name]->getFrameData<float>("progress"));
                 }
             } while(!result[name]->isLastFrame());
         }
@@ -579,26 +580,36 @@ Pipeline Pipeline::fromDataHub(std::string itemID, std::map<std::string, std::st
     return Pipeline(join(hub.getStorageDirectory(), itemID, "pipeline.fpl"), variables);
 }
 
-std::map<std::string, DataObject::pointer> Pipeline::run(std::map<std::string, std::shared_ptr<DataObject>> inputData, std::map<std::string, std::shared_ptr<ProcessObject>> processObjects, bool visualization) {
+std::map<std::string, DataObject::pointer> Pipeline::run(std::map<std::string, std::shared_ptr<DataObject>> inputData, std::map<std::string, std::shared_ptr<ProcessObject>> processObjects, bool visualization, bool concurrent) {
     std::cout << "Pipeline execution started." << std::endl;
     if(!isParsed())
         parse(inputData, processObjects, visualization);
 
+    std::vector<std::shared_ptr<ProcessObject>> exporters;
     for(auto PO : getProcessObjects()) {
         if(std::dynamic_pointer_cast<Exporter>(PO.second) != nullptr) {
             // PO is an exporter, run it.
             Reporter::info() << "Found exporter " << PO.first << " (" << PO.second->getNameOfClass() << ") in pipeline, running..." << Reporter::end();
-            PO.second->run();
+            if(concurrent) {
+                exporters.push_back(PO.second);
+            } else {
+                PO.second->run();
+            }
         }
     }
 
     std::map<std::string, std::shared_ptr<DataObject>> data;
     if(!m_views.empty()) {
+        if(concurrent && !exporters.empty())
+            PipelineExecutor::create()->update(exporters);
         auto window = MultiViewWindow::create(0);
         for(auto&& view : getViews())
             window->addView(view);
+        window->getComputationThread()->setConcurrentExecution(concurrent);
         window->run(); // Visualize and block here
         data = getAllPipelineOutputData();
+    } else if(concurrent) {
+        data = getAllPipelineOutputDataConcurrently(exporters);
     } else {
         data = getAllPipelineOutputData();
     }
@@ -607,6 +618,36 @@ std::map<std::string, DataObject::pointer> Pipeline::run(std::map<std::string, s
     return data;
 }
 
+std::map<std::string, DataObject::pointer> Pipeline::getAllPipelineOutputDataConcurrently(std::vector<std::shared_ptr<ProcessObject>> exporters) {
+    // Run exporters and all pipeline outputs together, until all outputs are no longer in progress
+    std::vector<std::shared_ptr<ProcessObject>> targets = exporters;
+    std::map<std::string, DataChannel::pointer> ports;
+    for(auto [name, output] : m_pipelineOutputData) {
+        auto PO = getProcessObject(output.first);
+        ports[name] = PO->getOutputPort(output.second);
+        targets.push_back(PO);
+    }
+    if(targets.empty())
+        return {};
+
+    std::map<std::string, DataObject::pointer> result;
+    auto executor = PipelineExecutor::create();
+    executor->run(targets, 0, [&](int executeToken) {
+        bool finished = true;
+        for(auto&& port : ports) {
+            auto& data = result[port.first];
+            if(data && data->hasFrameData("progress") && data->isLastFrame())
+                continue;
+            data = port.second->getNextFrame();
+            if(data->hasFrameData("progress") && !data->isLastFrame())
+                finished = false;
+        }
+        return !finished;
+    });
+
+    return result;
+}
+
 bool Pipeline::hasWindow() {
     return m_window != nullptr;
 }
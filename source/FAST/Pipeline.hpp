@@ -99,12 +99,15 @@ class FAST_EXPORT  Pipeline {
          * @param inputData Input data objects
          * @param processObjects Process objects to connect to this pipeline
          * @param visualization If false parse will ignore any renderers and views
+         * @param concurrent Execute independent branches of the pipeline concurrently, and let
+         *      consecutive frames overlap, using a PipelineExecutor.
          * @return pipeline output data
          */
         std::map<std::string, DataObject::pointer> run(
                 DataMap inputData = DataMap(),
                 ProcessObjectMap processObjects = ProcessObjectMap(),
-                bool visualization = true
+                bool visualization = true,
+                bool concurrent = false
         );
 
         /**
@@ -173,6 +176,7 @@ class FAST_EXPORT  Pipeline {
                 std::string objectID,
                 int& lineNr
         );
+        std::map<std::string, DataObject::pointer> getAllPipelineOutputDataConcurrently(std::vector<std::shared_ptr<ProcessObject>> exporters);
 };
 
 /**
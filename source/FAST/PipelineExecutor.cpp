@@ -0,0 +1,267 @@
+#include "PipelineExecutor.hpp"
+#include "FAST/ProcessObject.hpp"
+#include <algorithm>
+#include <atomic>
+#include <deque>
+#include <limits>
+#include <thread>
+#include <unordered_map>
+
+namespace fast {
+
+/**
+ * Thread pool where each worker has its own task queue. Tasks submitted from a worker are put in
+ * its own queue, and idle workers steal tasks from the other queues.
+ */
+class WorkStealingThreadPool {
+    public:
+        explicit WorkStealingThreadPool(int threads) {
+            for(int i = 0; i < threads; ++i)
+                m_queues.push_back(std::make_unique<Queue>());
+            for(int i = 0; i < threads; ++i)
+                m_threads.emplace_back(&WorkStealingThreadPool::work, this, i);
+        }
+        void submit(std::function<void()> task) {
+            int index = m_workerIndex;
+            if(index < 0 || m_workerPool != this)
+                index = m_nextQueue++ % m_queues.size();
+            {
+                std::lock_guard<std::mutex> lock(m_queues[index]->mutex);
+                m_queues[index]->tasks.push_back(std::move(task));
+            }
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                ++m_pendingTasks;
+            }
+            m_condition.notify_one();
+        }
+        int getNumberOfThreads() const {
+            return m_threads.size();
+        }
+        ~WorkStealingThreadPool() {
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                m_stop = true;
+            }
+            m_condition.notify_all();
+            for(auto& thread : m_threads)
+                thread.join();
+        }
+    private:
+        struct Queue {
+            std::mutex mutex;
+            std::deque<std::function<void()>> tasks;
+        };
+        bool tryGetTask(int index, std::function<void()>& task) {
+            // Newest task from own queue first, then oldest task from the other queues
+            {
+                std::lock_guard<std::mutex> lock(m_queues[index]->mutex);
+                if(!m_queues[index]->tasks.empty()) {
+                    task = std::move(m_queues[index]->tasks.back());
+                    m_queues[index]->tasks.pop_back();
+                    return true;
+                }
+            }
+            for(int i = 1; i < (int)m_queues.size(); ++i) {
+                auto& queue = m_queues[(index + i) % m_queues.size()];
+                std::lock_guard<std::mutex> lock(queue->mutex);
+                if(!queue->tasks.empty()) {
+                    task = std::move(queue->tasks.front());
+                    queue->tasks.pop_front();
+                    return true;
+                }
+            }
+            return false;
+        }
+        void work(int index) {
+            m_workerIndex = index;
+            m_workerPool = this;
+            while(true) {
+                {
+                    std::unique_lock<std::mutex> lock(m_mutex);
+                    m_condition.wait(lock, [this]() { return m_stop || m_pendingTasks > 0; });
+                    if(m_stop)
+                        return;
+                    --m_pendingTasks;
+                }
+                // A task is reserved for this worker, but it may be in any queue
+                std::function<void()> task;
+                while(!tryGetTask(index, task))
+                    std::this_thread::yield();
+                task();
+            }
+        }
+
+        std::vector<std::unique_ptr<Queue>> m_queues;
+        std::vector<std::thread> m_threads;
+        std::atomic_uint m_nextQueue = {0};
+        int m_pendingTasks = 0;
+        bool m_stop = false;
+        std::mutex m_mutex;
+        std::condition_variable m_condition;
+        static thread_local int m_workerIndex;
+        static thread_local WorkStealingThreadPool* m_workerPool;
+};
+
+thread_local int WorkStealingThreadPool::m_workerIndex = -1;
+thread_local WorkStealingThreadPool* WorkStealingThreadPool::m_workerPool = nullptr;
+
+PipelineExecutor::PipelineExecutor(int threads) {
+    if(threads <= 0)
+        threads = std::max<int>(std::thread::hardware_concurrency(), 2);
+    m_threadPool = std::make_unique<WorkStealingThreadPool>(threads);
+}
+
+PipelineExecutor::~PipelineExecutor() = default;
+
+int PipelineExecutor::getNumberOfThreads() const {
+    return m_threadPool->getNumberOfThreads();
+}
+
+bool PipelineExecutor::canStart(int index) const {
+    const Node& node = m_nodes[index];
+    if(node.running || m_exception || node.finishedFrames >= m_frames)
+        return false;
+    // All parents must have finished the frame, and all children must be done with the previous frame,
+    // since the output of the previous frame is replaced when this node executes.
+    for(int parent : node.parents) {
+        if(m_nodes[parent].finishedFrames <= node.finishedFrames)
+            return false;
+    }
+    for(int child : node.children) {
+        if(m_nodes[child].finishedFrames < node.finishedFrames)
+            return false;
+    }
+    return true;
+}
+
+void PipelineExecutor::scheduleReadyNodes(const std::vector<int>& candidates) {
+    for(int index : candidates) {
+        if(!canStart(index))
+            continue;
+        m_nodes[index].running = true;
+        ++m_runningNodes;
+        m_threadPool->submit([this, index]() {
+            executeNode(index);
+        });
+    }
+}
+
+void PipelineExecutor::executeNode(int index) {
+    std::shared_ptr<ProcessObject> processObject;
+    int frame;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        processObject = m_nodes[index].processObject;
+        frame = m_nodes[index].finishedFrames;
+    }
+
+    bool continueRunning = true;
+    std::exception_ptr exception;
+    try {
+        if(processObject) {
+            processObject->updateWithoutParents(m_firstExecuteToken + frame);
+        } else {
+            continueRunning = m_frameFinished(m_firstExecuteToken + frame);
+        }
+    } catch(...) {
+        exception = std::current_exception();
+    }
+
+    bool stopPipeline = false;
+    std::vector<std::shared_ptr<ProcessObject>> targets;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        Node& node = m_nodes[index];
+        node.running = false;
+        --m_runningNodes;
+        if(exception) {
+            if(!m_exception) {
+                // Stop the pipeline, so that process objects blocking on input data in other threads return
+                m_exception = exception;
+                stopPipeline = m_runningNodes > 0;
+                for(int target : m_nodes.back().parents)
+                    targets.push_back(m_nodes[target].processObject);
+            }
+        } else {
+            ++node.finishedFrames;
+            if(!continueRunning)
+                m_frames = std::min(m_frames, node.finishedFrames);
+            std::vector<int> candidates = {index};
+            candidates.insert(candidates.end(), node.parents.begin(), node.parents.end());
+            candidates.insert(candidates.end(), node.children.begin(), node.children.end());
+            scheduleReadyNodes(candidates);
+        }
+        if(m_runningNodes == 0)
+            m_finishedCondition.notify_all();
+    }
+    if(stopPipeline) {
+        for(auto& target : targets)
+            target->stopPipeline();
+    }
+}
+
+void PipelineExecutor::update(const std::vector<std::shared_ptr<ProcessObject>>& processObjects, int executeToken) {
+    execute(processObjects, executeToken, 1, [](int) { return false; });
+}
+
+void PipelineExecutor::run(const std::vector<std::shared_ptr<ProcessObject>>& processObjects, int firstExecuteToken, std::function<bool(int)> frameFinished) {
+    execute(processObjects, firstExecuteToken, std::numeric_limits<int>::max(), std::move(frameFinished));
+}
+
+void PipelineExecutor::execute(const std::vector<std::shared_ptr<ProcessObject>>& processObjects, int firstExecuteToken, int frames, std::function<bool(int)> frameFinished) {
+    std::lock_guard<std::mutex> runLock(m_runMutex);
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_frames = frames;
+    m_firstExecuteToken = firstExecuteToken;
+    m_frameFinished = std::move(frameFinished);
+    m_exception = nullptr;
+    m_runningNodes = 0;
+
+    // Build dependency graph of the process objects and all their parents
+    m_nodes.clear();
+    std::unordered_map<ProcessObject*, int> indices;
+    std::function<int(std::shared_ptr<ProcessObject>)> addNode = [&](std::shared_ptr<ProcessObject> processObject) -> int {
+        auto it = indices.find(processObject.get());
+        if(it != indices.end())
+            return it->second;
+        std::vector<int> parents;
+        for(auto&& input : processObject->mInputConnections) {
+            const int parent = addNode(input.second->getProcessObject());
+            if(std::find(parents.begin(), parents.end(), parent) == parents.end())
+                parents.push_back(parent);
+        }
+        const int index = m_nodes.size();
+        Node node;
+        node.processObject = processObject;
+        node.parents = parents;
+        m_nodes.push_back(node);
+        for(int parent : parents)
+            m_nodes[parent].children.push_back(index);
+        indices[processObject.get()] = index;
+        return index;
+    };
+    Node frameFinishedNode;
+    for(auto&& processObject : processObjects) {
+        const int index = addNode(processObject);
+        if(std::find(frameFinishedNode.parents.begin(), frameFinishedNode.parents.end(), index) == frameFinishedNode.parents.end())
+            frameFinishedNode.parents.push_back(index);
+    }
+    const int frameFinishedIndex = m_nodes.size();
+    for(int parent : frameFinishedNode.parents)
+        m_nodes[parent].children.push_back(frameFinishedIndex);
+    m_nodes.push_back(frameFinishedNode);
+
+    std::vector<int> candidates;
+    for(int i = 0; i < (int)m_nodes.size(); ++i)
+        candidates.push_back(i);
+    scheduleReadyNodes(candidates);
+    m_finishedCondition.wait(lock, [this]() { return m_runningNodes == 0; });
+
+    m_nodes.clear();
+    m_frameFinished = nullptr;
+    if(m_exception)
+        std::rethrow_exception(m_exception);
+}
+
+}
@@ -0,0 +1,86 @@
+#pragma once
+
+#include <FAST/Object.hpp>
+#include <functional>
+#include <condition_variable>
+#include <exception>
+#include <mutex>
+#include <vector>
+
+namespace fast {
+
+class ProcessObject;
+class WorkStealingThreadPool;
+
+/**
+ * @brief Executes a pipeline of process objects concurrently
+ *
+ * ProcessObject::update() updates all parents recursively on the calling thread, thus independent branches
+ * of a pipeline run one after another. This executor instead builds the dependency graph of the given process objects
+ * and all their parents, and executes process objects on a work-stealing thread pool as soon as
+ * all their parents are done. Execute tokens and last frame semantics are the same as for ProcessObject::update().
+ *
+ * When running several frames with run(), a process object may start on the next frame as soon as its parents
+ * have finished that frame and its children are done with the previous frame. Thus stages of consecutive
+ * frames overlap.
+ *
+ * Process objects executing concurrently must not share state, except through their data channels.
+ *
+ * @sa Pipeline::run ComputationThread::setConcurrentExecution
+ */
+class FAST_EXPORT PipelineExecutor : public Object {
+    FAST_OBJECT_V4(PipelineExecutor)
+    public:
+        /**
+         * @brief Create executor
+         * @param threads Number of worker threads. If 0, the number of hardware threads is used.
+         */
+        FAST_CONSTRUCTOR(PipelineExecutor, int, threads, = 0)
+        /**
+         * @brief Update the process objects and all their parents once.
+         * Blocks until done. Any exception thrown by a process object is rethrown here.
+         * @param processObjects
+         * @param executeToken Negative value means that the execute token is disabled.
+         */
+        void update(const std::vector<std::shared_ptr<ProcessObject>>& processObjects, int executeToken = -1);
+#ifndef SWIG
+        /**
+         * @brief Update the process objects and all their parents repeatedly, with an incrementing execute token.
+         * Blocks until done. Any exception thrown by a process object is rethrown here.
+         * @param processObjects
+         * @param firstExecuteToken Execute token of first frame
+         * @param frameFinished Called with the execute token when all the given process objects have finished a frame.
+         *      The process objects will not start on the next frame until this function has returned.
+         *      Return false to stop.
+         */
+        void run(const std::vector<std::shared_ptr<ProcessObject>>& processObjects, int firstExecuteToken, std::function<bool(int)> frameFinished);
+#endif
+        int getNumberOfThreads() const;
+        ~PipelineExecutor();
+    private:
+        struct Node {
+            std::shared_ptr<ProcessObject> processObject; // nullptr for the node calling frameFinished
+            std::vector<int> parents;
+            std::vector<int> children;
+            int finishedFrames = 0;
+            bool running = false;
+        };
+        void execute(const std::vector<std::shared_ptr<ProcessObject>>& processObjects, int firstExecuteToken, int frames, std::function<bool(int)> frameFinished);
+        bool canStart(int index) const;
+        void scheduleReadyNodes(const std::vector<int>& candidates);
+        void executeNode(int index);
+
+        std::unique_ptr<WorkStealingThreadPool> m_threadPool;
+        std::vector<Node> m_nodes;
+        std::function<bool(int)> m_frameFinished;
+        int m_firstExecuteToken = 0;
+        int m_frames = 0;
+        int m_runningNodes = 0;
+        std::exception_ptr m_exception;
+        std::mutex m_mutex;
+        // Held while executing, since only one pipeline can be executed at a time
+        std::mutex m_runMutex;
+        std::condition_variable m_finishedCondition;
+};
+
+}
@@ -4,6 +4,7 @@
 #include "FAST/Streamers/Streamer.hpp"
 #include <unordered_set>
 #include <FAST/DataChannels/QueuedDataChannel.hpp>
+#include <FAST/DataChannels/LockFreeQueuedDataChannel.hpp>
 #include <FAST/DataChannels/NewestFrameDataChannel.hpp>
 #include <FAST/DataChannels/StaticDataChannel.hpp>
 
@@ -26,11 +27,17 @@ static bool isStreamer(ProcessObject* po) {
 
 void ProcessObject::update(int executeToken) {
     // Call update on all parents
+    for(auto parent : mInputConnections)
+        parent.second->getProcessObject()->update(executeToken);
+
+    updateWithoutParents(executeToken);
+}
+
+void ProcessObject::updateWithoutParents(int executeToken) {
     bool newInputData = false;
     bool inputMarkedAsLastFrame = false;
     for(auto parent : mInputConnections) {
         auto port = parent.second;
-        port->getProcessObject()->update(executeToken);
 
         if(mLastProcessed.count(parent.first) > 0) {
             // Compare the last processed data with the new data for this data port
@@ -133,9 +140,16 @@ DataChannel::pointer ProcessObject::getOutputPort(uint portID) {
     // Create DataChannel, and it to list and return it
     DataChannel::pointer dataChannel;
     if(isStreamer(this)) {
-        auto streamingMode = std::dynamic_pointer_cast<Streamer>(mPtr.lock())->getStreamingMode();
+        auto streamer = std::dynamic_pointer_cast<Streamer>(mPtr.lock());
+        auto streamingMode = streamer->getStreamingMode();
         if(streamingMode == StreamingMode::ProcessAllFrames) {
-            dataChannel = QueuedDataChannel::New();
+            if(streamer->getLockFreeQueue() || streamer->getQueuePolicy() != QueuePolicy::Block) {
+                auto queue = LockFreeQueuedDataChannel::New();
+                queue->setQueuePolicy(streamer->getQueuePolicy());
+                dataChannel = queue;
+            } else {
+                dataChannel = QueuedDataChannel::New();
+            }
             if(m_maximumNrOfFrames > 0)
                 dataChannel->setMaximumNumberOfFrames(m_maximumNrOfFrames);
         } else if(streamingMode == StreamingMode::NewestFrameOnly) {
@@ -187,8 +201,7 @@ void ProcessObject::addOutputData(uint portID, DataObject::pointer data, bool pr
         }
     }
     if(propagateFrameData)
-        for(auto&& frameData : m_frameData)
-            data->setFrameData(frameData.first, frameData.second);
+        data->mergeFrameData(m_frameData);
 
     // Add to current data for this port
     mOutputPorts[portID].currentData = data;
@@ -19,6 +19,7 @@ namespace fast {
 
 class OpenCLProgram;
 class ProcessObject;
+class PipelineExecutor;
 
 /**
  * @defgroup segmentation Segmentation
@@ -181,6 +182,13 @@ class FAST_EXPORT  ProcessObject : public AttributeObject {
         // An integer id which act as a token of when this PO last executed
         int m_lastExecuteToken = -1;
 
+        /**
+         * Update this PO only, assuming all its parents have already been updated.
+         * Executes the PO if it is modified or has new input data.
+         * @param executeToken
+         */
+        void updateWithoutParents(int executeToken);
+
         // Pure virtual method for executing the pipeline object
         virtual void execute()=0;
         virtual void preExecute();
@@ -244,7 +252,7 @@ class FAST_EXPORT  ProcessObject : public AttributeObject {
 
         // Frame data
         // Similar to metadata, only this is transferred from input to output
-        std::unordered_map<std::string, std::string> m_frameData;
+        FrameData m_frameData;
         // Indicates whether this data object is the last frame in a stream, and if so, the name of the stream
         std::unordered_set<std::string> m_lastFrame;
 
@@ -253,6 +261,7 @@ class FAST_EXPORT  ProcessObject : public AttributeObject {
 
         std::mutex m_mutex;
 
+        friend class PipelineExecutor;
 };
 
 template<class DataType>
@@ -282,8 +291,7 @@ std::shared_ptr<DataType> ProcessObject::getInputData(uint portID) {
     // Store frame data for this input data so it can be added to output data later
     for(auto&& lastFrame : data->getLastFrame())
         m_lastFrame.insert(lastFrame);
-    for(auto&& frameData : data->getFrameData())
-        m_frameData[frameData.first] = frameData.second;
+    m_frameData.merge(data->getFrameDataStore());
 
     return convertedData;
 }
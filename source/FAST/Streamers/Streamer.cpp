@@ -30,7 +30,7 @@ Streamer::Streamer() {
     m_firstFrameIsInserted = false;
     m_streamIsStarted = false;
     m_stop = false;
-    m_frameData["streaming"] = "yes";
+    m_frameData.set("streaming", "yes");
 }
 
 void Streamer::stop() {
@@ -60,6 +60,22 @@ void Streamer::setStreamingMode(StreamingMode mode) {
     m_streamingMode = mode;
 }
 
+void Streamer::setLockFreeQueue(bool lockFree) {
+    m_lockFreeQueue = lockFree;
+}
+
+bool Streamer::getLockFreeQueue() const {
+    return m_lockFreeQueue;
+}
+
+void Streamer::setQueuePolicy(QueuePolicy policy) {
+    m_queuePolicy = policy;
+}
+
+QueuePolicy Streamer::getQueuePolicy() const {
+    return m_queuePolicy;
+}
+
 DataChannel::pointer Streamer::getOutputPort(uint portID) {
     if(m_outputPOs.count(portID) == 0) {
         auto channel = ProcessObject::getOutputPort(portID);
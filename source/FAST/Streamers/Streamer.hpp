@@ -3,6 +3,7 @@
 #include <FAST/ProcessObject.hpp>
 #include "FAST/Data/DataTypes.hpp"
 #include "FAST/Exception.hpp"
+#include <FAST/DataChannels/LockFreeQueuedDataChannel.hpp>
 #include <thread>
 
 namespace fast {
@@ -55,6 +56,23 @@ class FAST_EXPORT Streamer : public ProcessObject {
         void setStreamingMode(StreamingMode mode);
         StreamingMode getStreamingMode() const;
 
+        /**
+         * Use a lock-free ring buffer instead of a semaphore protected queue for the output data channels
+         * when streaming mode is ProcessAllFrames. The size of the queue is set with setMaximumNrOfFrames.
+         * Must be called before the output ports are connected.
+         * @param lockFree
+         */
+        void setLockFreeQueue(bool lockFree);
+        bool getLockFreeQueue() const;
+        /**
+         * Set what to do when the output queue is full when streaming mode is ProcessAllFrames.
+         * The DropOldest and DropNewest policies imply a lock-free queue.
+         * Must be called before the output ports are connected.
+         * @param policy
+         */
+        void setQueuePolicy(QueuePolicy policy);
+        QueuePolicy getQueuePolicy() const;
+
         virtual DataChannel::pointer getOutputPort(uint portID = 0) override;
     protected:
         /**
@@ -81,6 +99,8 @@ class FAST_EXPORT Streamer : public ProcessObject {
         bool m_streamIsStarted = false;
         bool m_stop = false;
         StreamingMode m_streamingMode = StreamingMode::ProcessAllFrames;
+        bool m_lockFreeQueue = false;
+        QueuePolicy m_queuePolicy = QueuePolicy::Block;
 
         std::mutex m_firstFrameMutex;
         std::mutex m_stopMutex;
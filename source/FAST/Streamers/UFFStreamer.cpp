@@ -475,10 +475,10 @@ void UFFStreamer::generateStream() {
         float newXSpacing = (stopX - startX) / (m_scanConverter->getWidth() - 1); //Subtract 1 because num spaces is 1 less than num elements
         float newYSpacing = (stopY - startY) / (m_scanConverter->getHeight() - 1);
 
-        image->setFrameData("startRadius", std::to_string(startRadius));
-        image->setFrameData("stopRadius", std::to_string(stopRadius));
-        image->setFrameData("startTheta", std::to_string(startTheta));
-        image->setFrameData("stopTheta", std::to_string(stopTheta));
+        image->setFrameData("startRadius", startRadius);
+        image->setFrameData("stopRadius", stopRadius);
+        image->setFrameData("startTheta", startTheta);
+        image->setFrameData("stopTheta", stopTheta);
 
         Image::pointer resultImage;
         if(m_doScanConversion) {
@@ -496,7 +496,7 @@ void UFFStreamer::generateStream() {
                 //resultImage = image;
                 // This is a hack to make UFFStreamer work with InterleavePlayback
                 resultImage = image->copy(getMainDevice());
-                resultImage->setFrameData(image->getFrameData());
+                resultImage->mergeFrameData(image->getFrameDataStore());
                 if(image->isLastFrame())
                     resultImage->setLastFrame("UFFStreamer");
             } else {
@@ -1,5 +1,7 @@
 #include <FAST/Testing.hpp>
 #include "DummyObjects.hpp"
+#include <FAST/DataChannels/LockFreeQueuedDataChannel.hpp>
+#include <FAST/PipelineExecutor.hpp>
 
 using namespace fast;
 
@@ -27,6 +29,91 @@ TEST_CASE("Simple pipeline with stream", "[process_all_frames][ProcessObject][fa
     CHECK(timestep == 20);
 }
 
+TEST_CASE("Simple pipeline with stream and lock-free queue", "[process_all_frames][ProcessObject][fast]") {
+    auto streamer = DummyStreamer::New();
+    streamer->setSleepTime(10);
+    streamer->setTotalFrames(20);
+    streamer->setLockFreeQueue(true);
+    streamer->setMaximumNrOfFrames(4);
+
+    auto po = DummyProcessObject::New();
+    po->setInputConnection(streamer->getOutputPort());
+
+    auto port = po->getOutputPort();
+    port->setMaximumNumberOfFrames(1);
+
+    bool lastFrame = false;
+    int timestep = 0;
+    while(!lastFrame) {
+        po->update();
+        auto image = port->getNextFrame<DummyDataObject>();
+        lastFrame = image->isLastFrame();
+        CHECK(image->getID() == timestep);
+        timestep++;
+    }
+    CHECK(timestep == 20);
+}
+
+static DummyDataObject::pointer createDummyFrame(uint ID) {
+    auto data = DummyDataObject::New();
+    data->create(ID);
+    return data;
+}
+
+TEST_CASE("Lock-free queued data channel keeps frame order", "[LockFreeQueuedDataChannel][fast]") {
+    auto channel = LockFreeQueuedDataChannel::New();
+    channel->setMaximumNumberOfFrames(3);
+    std::thread producer([channel]() {
+        for(uint i = 0; i < 1000; ++i)
+            channel->addFrame(createDummyFrame(i));
+    });
+    for(uint i = 0; i < 1000; ++i) {
+        if(i % 100 == 0) { // getFrame should not remove the frame
+            while(!channel->hasCurrentData())
+                std::this_thread::yield();
+            CHECK(std::static_pointer_cast<DummyDataObject>(channel->getFrame())->getID() == i);
+        }
+        CHECK(channel->getNextFrame<DummyDataObject>()->getID() == i);
+    }
+    producer.join();
+    CHECK(channel->getSize() == 0);
+    CHECK(channel->getDroppedFrames() == 0);
+    CHECK(channel->getMaximumOccupancy() > 0);
+}
+
+TEST_CASE("Lock-free queued data channel drop policies", "[LockFreeQueuedDataChannel][fast]") {
+    auto channel = LockFreeQueuedDataChannel::New();
+    channel->setMaximumNumberOfFrames(2);
+    SECTION("drop newest") {
+        channel->setQueuePolicy(QueuePolicy::DropNewest);
+        for(uint i = 0; i < 5; ++i)
+            channel->addFrame(createDummyFrame(i));
+        CHECK(channel->getSize() == 2);
+        CHECK(channel->getDroppedFrames() == 3);
+        CHECK(channel->getNextFrame<DummyDataObject>()->getID() == 0);
+        CHECK(channel->getNextFrame<DummyDataObject>()->getID() == 1);
+    }
+    SECTION("drop oldest") {
+        channel->setQueuePolicy(QueuePolicy::DropOldest);
+        for(uint i = 0; i < 5; ++i)
+            channel->addFrame(createDummyFrame(i));
+        CHECK(channel->getSize() == 2);
+        CHECK(channel->getDroppedFrames() == 3);
+        CHECK(channel->getNextFrame<DummyDataObject>()->getID() == 3);
+        CHECK(channel->getNextFrame<DummyDataObject>()->getID() == 4);
+    }
+}
+
+TEST_CASE("Lock-free queued data channel unblocks on stop", "[LockFreeQueuedDataChannel][fast]") {
+    auto channel = LockFreeQueuedDataChannel::New();
+    std::thread stopper([channel]() {
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        channel->stop("stopped");
+    });
+    CHECK_THROWS_AS(channel->getNextFrame(), ThreadStopped);
+    stopper.join();
+}
+
 TEST_CASE("Two step pipeline with stream", "[two_step][process_all_frames][ProcessObject][fast]") {
     auto streamer = DummyStreamer::New();
     streamer->setSleepTime(10);
@@ -52,6 +139,63 @@ TEST_CASE("Two step pipeline with stream", "[two_step][process_all_frames][Proce
     CHECK(timestep == 20);
 }
 
+TEST_CASE("Pipeline executor with two branches and stream", "[PipelineExecutor][process_all_frames][ProcessObject][fast]") {
+    auto streamer = DummyStreamer::New();
+    streamer->setSleepTime(10);
+    streamer->setTotalFrames(20);
+
+    auto po1 = DummyProcessObject::New();
+    po1->setInputConnection(streamer->getOutputPort());
+    auto po2 = DummyProcessObject::New();
+    po2->setInputConnection(po1->getOutputPort());
+    auto po3 = DummyProcessObject::New();
+    po3->setInputConnection(po1->getOutputPort());
+    auto port2 = po2->getOutputPort();
+    auto port3 = po3->getOutputPort();
+
+    // Catch is not thread-safe, so results are checked after running
+    std::vector<int> executeTokens;
+    std::vector<int> IDs2;
+    std::vector<int> IDs3;
+    auto executor = PipelineExecutor::create(4);
+    executor->run({po2, po3}, 0, [&](int executeToken) {
+        auto data2 = port2->getNextFrame<DummyDataObject>();
+        auto data3 = port3->getNextFrame<DummyDataObject>();
+        executeTokens.push_back(executeToken);
+        IDs2.push_back(data2->getID());
+        IDs3.push_back(data3->getID());
+        return !data2->isLastFrame();
+    });
+    REQUIRE(executeTokens.size() == 20);
+    for(int i = 0; i < 20; ++i) {
+        CHECK(executeTokens[i] == i);
+        CHECK(IDs2[i] == i);
+        CHECK(IDs3[i] == i);
+    }
+}
+
+TEST_CASE("Pipeline executor update with static data", "[PipelineExecutor][ProcessObject][fast]") {
+    auto data = DummyDataObject::New();
+    data->create(3);
+    auto po1 = DummyProcessObject::New();
+    po1->setInputData(data);
+    auto po2 = DummyProcessObject::New();
+    po2->setInputConnection(po1->getOutputPort());
+    auto port = po2->getOutputPort();
+
+    auto executor = PipelineExecutor::create();
+    executor->update({po2}, 1);
+    CHECK(po1->hasExecuted());
+    CHECK(po2->hasExecuted());
+    CHECK(port->getNextFrame<DummyDataObject>()->getID() == 3);
+
+    // Same execute token should not execute again
+    po1->setHasExecuted(false);
+    po1->setIsModified();
+    executor->update({po2}, 1);
+    CHECK_FALSE(po1->hasExecuted());
+}
+
 TEST_CASE("Simple pipeline with stream NEWEST_FRAME_ONLY", "[ProcessObject][fast][newest_frame_only]") {
     auto streamer = DummyStreamer::New();
     streamer->setStreamingMode(StreamingMode::NewestFrameOnly);
@@ -0,0 +1,268 @@
+#include <FAST/Tools/CommandLineParser.hpp>
+#include <FAST/Algorithms/NeuralNetwork/InferenceEngineManager.hpp>
+#include <FAST/Utility.hpp>
+#include <FASTVersion.hpp>
+#include <QJsonDocument>
+#include <QJsonArray>
+#include <QJsonObject>
+#include <chrono>
+#include <deque>
+#include <fstream>
+#include <random>
+
+using namespace fast;
+
+typedef std::chrono::high_resolution_clock Clock;
+
+static double milliseconds(Clock::time_point start, Clock::time_point end) {
+    return std::chrono::duration<double, std::milli>(end - start).count();
+}
+
+static std::vector<int> parseIntegerList(std::string value) {
+    std::vector<int> result;
+    for(auto&& token : split(value, ","))
+        result.push_back(std::stoi(token));
+    return result;
+}
+
+// Parse list of shapes without batch dimension, such as 256x256x3,512x512x3
+static std::vector<TensorShape> parseShapeList(std::string value) {
+    std::vector<TensorShape> result;
+    for(auto&& token : split(value, ",")) {
+        TensorShape shape;
+        for(auto&& size : split(token, "x"))
+            shape.addDimension(std::stoi(size));
+        result.push_back(shape);
+    }
+    return result;
+}
+
+static QJsonObject getLatencyStatistics(std::vector<double> latencies) {
+    QJsonObject result;
+    if(latencies.empty())
+        return result;
+    std::sort(latencies.begin(), latencies.end());
+    auto percentile = [&latencies](double p) {
+        return latencies[(std::size_t)std::round(p / 100.0 * (latencies.size() - 1))];
+    };
+    double sum = 0.0;
+    for(double latency : latencies)
+        sum += latency;
+    result["mean"] = sum / latencies.size();
+    result["min"] = latencies.front();
+    result["max"] = latencies.back();
+    result["p50"] = percentile(50);
+    result["p95"] = percentile(95);
+    result["p99"] = percentile(99);
+    return result;
+}
+
+struct Configuration {
+    std::string engine;
+    std::string filename;
+    InferenceDeviceType device;
+    int batchSize;
+    int requestsInFlight;
+    TensorShape shape; // Input shape without batch dimension, empty means the shape of the model
+};
+
+static QJsonObject runBenchmark(const Configuration& configuration, int warmUpIterations, int iterations) {
+    QJsonObject result;
+    result["engine"] = configuration.engine.c_str();
+    result["model"] = configuration.filename.c_str();
+    result["batch-size"] = configuration.batchSize;
+    result["requests-in-flight"] = configuration.requestsInFlight;
+
+    // Get names and shapes of input nodes
+    auto engine = InferenceEngineManager::loadEngine(configuration.engine);
+    engine->setFilename(configuration.filename);
+    engine->setDeviceType(configuration.device);
+    engine->load();
+    auto inputNodes = engine->getInputNodes();
+
+    // Load engine again with the benchmark configuration
+    engine = InferenceEngineManager::loadEngine(configuration.engine);
+    engine->setFilename(configuration.filename);
+    engine->setDeviceType(configuration.device);
+    engine->setMaxBatchSize(configuration.batchSize);
+    engine->setMaxRequestsInFlight(configuration.requestsInFlight);
+    QJsonObject inputShapes;
+    for(auto&& node : inputNodes) {
+        TensorShape shape = node.second.shape;
+        if(!configuration.shape.empty()) {
+            shape = TensorShape({-1});
+            for(int size : configuration.shape.getAll())
+                shape.addDimension(size);
+        }
+        shape[0] = configuration.batchSize;
+        for(int size : shape.getAll()) {
+            if(size <= 0)
+                throw Exception("Input node " + node.first + " has unknown shape " + shape.toString() + ", specify the input shape");
+        }
+        engine->addInputNode(NeuralNetworkNode(node.first, node.second.type, shape, node.second.id));
+        inputShapes[node.first.c_str()] = shape.toString().c_str();
+    }
+    result["input-shapes"] = inputShapes;
+
+    auto start = Clock::now();
+    engine->load();
+    result["load-time"] = milliseconds(start, Clock::now());
+    start = Clock::now();
+    engine->warmUp({configuration.batchSize}, warmUpIterations);
+    result["warm-up-time"] = milliseconds(start, Clock::now());
+
+    // Synthetic 8 bit images as input data
+    std::map<std::string, std::shared_ptr<Tensor>> syntheticData;
+    std::mt19937 generator(42);
+    std::uniform_int_distribution<int> distribution(0, 255);
+    for(auto&& node : engine->getInputNodes()) {
+        auto tensor = Tensor::create(node.second.shape, TYPE_UINT8);
+        auto access = tensor->getAccess(ACCESS_READ_WRITE);
+        auto data = (uchar*)access->get();
+        for(int i = 0; i < node.second.shape.getTotalSize(); ++i)
+            data[i] = distribution(generator);
+        syntheticData[node.first] = tensor;
+    }
+
+    std::vector<double> preprocessing, inference, postprocessing;
+    std::deque<std::pair<int, Clock::time_point>> requests;
+    double checksum = 0.0;
+    // Wait for the oldest request and process its output
+    auto waitForRequest = [&]() {
+        engine->wait(requests.front().first);
+        const auto inferenceEnd = Clock::now();
+        inference.push_back(milliseconds(requests.front().second, inferenceEnd));
+        requests.pop_front();
+        // Postprocessing: argmax over the last dimension of each output on the host
+        for(auto&& node : engine->getOutputNodes()) {
+            auto tensor = engine->getOutputData(node.first)->toDataType(TYPE_FLOAT);
+            const auto shape = tensor->getShape();
+            const int channels = shape[shape.getDimensions() - 1];
+            const int size = shape.getTotalSize() / channels;
+            auto access = tensor->getAccess(ACCESS_READ);
+            const float* data = access->getRawData();
+            for(int i = 0; i < size; ++i)
+                checksum += std::max_element(&data[i*channels], &data[(i + 1)*channels]) - &data[i*channels];
+        }
+        postprocessing.push_back(milliseconds(inferenceEnd, Clock::now()));
+    };
+
+    start = Clock::now();
+    for(int iteration = 0; iteration < iterations; ++iteration) {
+        // Preprocessing: conversion of the 8 bit images to the data type of the model, and normalization
+        const auto preprocessingStart = Clock::now();
+        for(auto&& node : engine->getInputNodes()) {
+            auto tensor = syntheticData[node.first]->toDataType(node.second.dataType);
+            if(node.second.dataType == TYPE_FLOAT) {
+                auto access = tensor->getAccess(ACCESS_READ_WRITE);
+                float* data = access->getRawData();
+                const int size = tensor->getShape().getTotalSize();
+                for(int i = 0; i < size; ++i)
+                    data[i] /= 255.0f;
+            }
+            engine->setInputData(node.first, tensor);
+        }
+        const auto inferenceStart = Clock::now();
+        preprocessing.push_back(milliseconds(preprocessingStart, inferenceStart));
+        requests.push_back({engine->submit(), inferenceStart});
+        if((int)requests.size() >= engine->getMaxRequestsInFlight())
+            waitForRequest();
+    }
+    while(!requests.empty())
+        waitForRequest();
+    const double total = milliseconds(start, Clock::now());
+
+    result["iterations"] = iterations;
+    result["total-time"] = total;
+    result["throughput"] = (double)iterations*configuration.batchSize / (total / 1000.0);
+    result["preprocessing"] = getLatencyStatistics(preprocessing);
+    result["inference"] = getLatencyStatistics(inference);
+    result["postprocessing"] = getLatencyStatistics(postprocessing);
+    result["checksum"] = checksum;
+    return result;
+}
+
+int main(int argc, char** argv) {
+    CommandLineParser parser("FAST Inference Benchmark",
+            "Benchmark inference engines on a neural network model with synthetic input data. "
+            "Reports throughput, and latency of preprocessing, inference and postprocessing as JSON.");
+    parser.addPositionVariable(1, "model-filename", true, "Neural network model file. If an engine does not support its format, a file with the same name and the preferred extension of the engine is used.");
+    parser.addVariable("engines", "", "Comma separated list of inference engines. Default is all available engines supporting the model.");
+    parser.addChoice("device", {"any", "cpu", "gpu"}, "any", "Device type to run inference on");
+    parser.addVariable("batch-sizes", "1", "Comma separated list of batch sizes");
+    parser.addVariable("requests-in-flight", "1", "Comma separated list of max number of inference requests in flight. The engines divide their threads among the requests.");
+    parser.addVariable("input-shapes", "", "Comma separated list of input shapes without batch dimension, such as 256x256x3,512x512x3. Default is the shape of the model.");
+    parser.addVariable("iterations", "100", "Number of inferences for each configuration");
+    parser.addVariable("warm-up", "10", "Number of warm up inferences for each configuration");
+    parser.addVariable("output", "", "Filename of JSON output. Default is standard output.");
+    parser.parse(argc, argv);
+    Reporter::setGlobalReportMethod(Reporter::INFO, Reporter::NONE);
+
+    const std::string filename = parser.get("model-filename");
+    std::vector<std::string> engines;
+    if(parser.get("engines").empty()) {
+        engines = InferenceEngineManager::getEngineList();
+    } else {
+        engines = split(parser.get("engines"), ",");
+    }
+    const std::map<std::string, InferenceDeviceType> devices = {
+        {"any", InferenceDeviceType::ANY},
+        {"cpu", InferenceDeviceType::CPU},
+        {"gpu", InferenceDeviceType::GPU},
+    };
+    const auto batchSizes = parseIntegerList(parser.get("batch-sizes"));
+    const auto requestsInFlight = parseIntegerList(parser.get("requests-in-flight"));
+    auto shapes = parseShapeList(parser.get("input-shapes"));
+    if(shapes.empty())
+        shapes.push_back(TensorShape());
+
+    QJsonArray results;
+    bool failed = false;
+    for(auto&& name : engines) {
+        // Find model file with a format the engine supports
+        auto engine = InferenceEngineManager::loadEngine(name);
+        std::string engineFilename = filename;
+        if(!engine->isModelFormatSupported(getModelFormat(filename))) {
+            engineFilename = filename.substr(0, filename.rfind('.')) + "." + getModelFileExtension(engine->getPreferredModelFormat());
+            if(!fileExists(engineFilename)) {
+                Reporter::warning() << "Skipping inference engine " << name << ", since it does not support the format of the model" << Reporter::end();
+                continue;
+            }
+        }
+        for(auto&& shape : shapes) {
+            for(int batchSize : batchSizes) {
+                for(int requests : requestsInFlight) {
+                    Configuration configuration = {name, engineFilename, devices.at(parser.get("device")), batchSize, requests, shape};
+                    QJsonObject result;
+                    try {
+                        result = runBenchmark(configuration, parser.get<int>("warm-up"), parser.get<int>("iterations"));
+                    } catch(std::exception& e) {
+                        result["engine"] = name.c_str();
+                        result["model"] = engineFilename.c_str();
+                        result["batch-size"] = batchSize;
+                        result["requests-in-flight"] = requests;
+                        result["error"] = e.what();
+                        failed = true;
+                    }
+                    result["device"] = parser.get("device").c_str();
+                    results.append(result);
+                }
+            }
+        }
+    }
+
+    QJsonObject output;
+    output["fast-version"] = getVersion().c_str();
+    output["results"] = results;
+    const auto json = QJsonDocument(output).toJson().toStdString();
+    if(parser.gotValue("output")) {
+        std::ofstream file(parser.get("output"));
+        if(!file.is_open())
+            throw Exception("Unable to open file " + parser.get("output"));
+        file << json;
+    } else {
+        std::cout << json;
+    }
+
+    return failed ? 1 : 0;
+}
@@ -8,6 +8,7 @@ int main(int argc, char** argv) {
     CommandLineParser parser("FAST Pipeline Executor", "Use this tool to execute pipelines described in text files", true);
     parser.addPositionVariable(1, "pipeline-filename", false, "Pipeline filename");
     parser.addVariable("datahub", false, "Download and run a pipeline from DataHub by specifying the item id. Example: --datahub item-unique-id");
+    parser.addOption("concurrent", "Execute independent branches of the pipeline concurrently");
 
     parser.parse(argc, argv);
 
@@ -30,7 +31,7 @@ int main(int argc, char** argv) {
             if (pipeline.hasWindow()) {
                 pipeline.getWindow()->run();
             } else {
-                pipeline.run({}, {}, true);
+                pipeline.run({}, {}, true, parser.getOption("concurrent"));
             }
         } else {
             auto gui = GUI::New();
@@ -50,6 +51,6 @@ int main(int argc, char** argv) {
             throw Exception("You must supply a pipeline filename or datahub item id");
         }
         auto pipeline = Pipeline(filename, parser.getVariables());
-        pipeline.run({}, {}, false);
+        pipeline.run({}, {}, false, parser.getOption("concurrent"));
     }
 }
\ No newline at end of file
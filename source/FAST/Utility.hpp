@@ -5,6 +5,8 @@
 #include <functional>
 #include <cctype>
 #include <locale>
+#include <limits>
+#include <type_traits>
 
 // This file contains a set of utility functions
 
@@ -58,6 +60,24 @@ T sign(T value) {
     }
 }
 
+/**
+ * Convert a floating point value to type T. If T is an integer type, the value is
+ * clamped to the range of T first, same as OpenCL does when writing to integer images.
+ * @tparam T output type
+ * @param value
+ * @return value as type T
+ */
+template<class T>
+T saturate_cast(float value) {
+    if constexpr(std::is_integral<T>::value) {
+        if(value <= (float)std::numeric_limits<T>::lowest())
+            return std::numeric_limits<T>::lowest();
+        if(value >= (float)std::numeric_limits<T>::max())
+            return std::numeric_limits<T>::max();
+    }
+    return (T)value;
+}
+
 FAST_EXPORT unsigned int getPowerOfTwoSize(unsigned int size);
 FAST_EXPORT void* allocateDataArray(unsigned int voxels, DataType type, unsigned int nrOfComponents);
 template <class T>
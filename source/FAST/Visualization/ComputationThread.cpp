@@ -40,10 +40,12 @@ void ComputationThread::run() {
 		bool canUpdate = false;
         std::vector<View*> mViews;
         std::vector<std::shared_ptr<ProcessObject>> processObjects;
+        std::shared_ptr<PipelineExecutor> executor;
         {
             std::unique_lock<std::mutex> lock(mUpdateThreadMutex); // this locks the mutex
             mViews = getViews();
             processObjects = getProcessObjects();
+            executor = m_executor;
             if(mStop)
                 break;
             if(processObjects.size() > 0)
@@ -61,8 +63,11 @@ void ComputationThread::run() {
 		bool isStreaming = false;
 		bool isDone = true;
         try {
+            if(executor)
+                executor->update(processObjects, executeToken);
             for(auto po : processObjects) {
-                po->update(executeToken);
+                if(!executor)
+                    po->update(executeToken);
                 for(int i = 0; i < po->getNrOfInputConnections(); ++i) {
                     try {
                         auto inputData = po->getInputPort(i)->getFrame();
@@ -275,6 +280,19 @@ void ComputationThread::setPipeline(const Pipeline &pipeline) {
     m_signalFinished = true;
 }
 
+void ComputationThread::setConcurrentExecution(bool concurrent, int threads) {
+    std::lock_guard<std::mutex> lock(mUpdateThreadMutex);
+    if(concurrent) {
+        m_executor = PipelineExecutor::create(threads);
+    } else {
+        m_executor.reset();
+    }
+}
+
+bool ComputationThread::getConcurrentExecution() const {
+    return m_executor != nullptr;
+}
+
 void ComputationThread::reset() {
     std::lock_guard<std::mutex> lock(mUpdateThreadMutex);
     m_signalFinished = true;
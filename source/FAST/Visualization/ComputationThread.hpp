@@ -7,6 +7,7 @@
 #include <condition_variable>
 #include <vector>
 #include <FAST/Pipeline.hpp>
+#include <FAST/PipelineExecutor.hpp>
 
 
 namespace fast {
@@ -50,6 +51,14 @@ class FAST_EXPORT ComputationThread : public QObject, public Object {
          */
         void setPipeline(const Pipeline& pipeline);
         void reset();
+        /**
+         * @brief Update independent branches of the process objects concurrently using a PipelineExecutor.
+         * Renderers are still updated on this thread.
+         * @param concurrent
+         * @param threads Number of worker threads. If 0, the number of hardware threads is used.
+         */
+        void setConcurrentExecution(bool concurrent, int threads = 0);
+        bool getConcurrentExecution() const;
     public Q_SLOTS:
         void run();
     Q_SIGNALS:
@@ -78,6 +87,7 @@ class FAST_EXPORT ComputationThread : public QObject, public Object {
 
         std::vector<View*> m_views;
         std::vector<std::shared_ptr<ProcessObject>> m_processObjects;
+        std::shared_ptr<PipelineExecutor> m_executor;
 
         bool mStop = false;
         bool m_signalFinished = true;
@@ -136,8 +136,9 @@ void HeatmapRenderer::draw(Matrix4f perspectiveMatrix, Matrix4f viewingMatrix, f
         const int height = input->getShape()[0];
 
         // Run kernel to fill the texture
-
-        auto access = input->getOpenCLBufferAccess(ACCESS_READ, device);
+        // The kernel reads floats, thus half precision and quantized tensors are converted first
+        auto floatInput = input->toDataType(TYPE_FLOAT);
+        auto access = floatInput->getOpenCLBufferAccess(ACCESS_READ, device);
 
         if(mTexturesToRender.count(inputNr) > 0) {
             // Delete old texture